@@ -23,8 +23,13 @@ enum class ErrorCode : uint8_t {
   E_GRAPH_TYPE_MAX_NUMBER,
   E_GRAPH_UNEXISTING_OBJECT,
 
+  //PARSING ERRORS
+  E_PARSE_INVALID_VALUE,
+  E_PARSE_OUT_OF_RANGE,
+
   //LOADER ERRORS
-//  E_LOADER_UNEXPECTED_END_OF_STREAM,
+  E_LOADER_INVALID_VALUE,
+  E_LOADER_INVALID_NUM_COLUMNS,
 
   // STORAGE ERRORS
   E_STORAGE_INVALID_PATH,
@@ -35,10 +40,36 @@ enum class ErrorCode : uint8_t {
   E_STORAGE_OUT_OF_BOUNDS_READ,
   E_STORAGE_OUT_OF_BOUNDS_WRITE,
   E_STORAGE_CRITICAL_ERROR,
+  E_STORAGE_INVALID_SNAPSHOT,
+  E_STORAGE_INVALID_SECTION,
+  E_STORAGE_UNEXISTING_SECTION,
+  E_STORAGE_INVALID_EDGE,
 
   // BUFFER POOL ERRORS
   E_BUFPOOL_OUT_OF_MEMORY,
-  E_BUFPOOL_PAGE_NOT_PRESENT
+  E_BUFPOOL_PAGE_NOT_PRESENT,
+
+  // HEAP FILE ERRORS
+  E_HEAP_INVALID_RECORD,
+  E_HEAP_RECORD_TOO_LARGE,
+
+  // STRING POOL ERRORS
+  E_STRING_POOL_FULL,
+
+  // ROUTING ERRORS
+  E_ROUTING_INVALID_NODE,
+  E_ROUTING_INVALID_EDGE,
+  E_ROUTING_INVALID_WEIGHT,
+  E_ROUTING_METRIC_SIZE_MISSMATCH,
+  E_ROUTING_UNEXISTING_METRIC,
+  E_ROUTING_INVALID_METRIC_FILE,
+  E_ROUTING_INVALID_DIMACS_FILE,
+  E_ROUTING_MISSING_COORDINATES,
+  E_ROUTING_INVALID_PATTERN,
+
+  // QUERY ERRORS
+  E_QUERY_INVALID_COLUMN,
+  E_QUERY_INVALID_TYPE
 };
 
 /** 
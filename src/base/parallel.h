@@ -0,0 +1,79 @@
+
+
+
+#ifndef _BASE_PARALLEL_H_
+#define _BASE_PARALLEL_H_
+
+#include "../base/platform.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Gets the number of threads to use when the caller does not specify it
+ **/
+inline uint32_t defaultNumThreads() noexcept {
+  const uint32_t hardware = std::thread::hardware_concurrency();
+  return hardware > 0 ? hardware : 1;
+}
+
+/**
+ * Applies a function to each index in [begin, end) using several threads.
+ * Indices are handed out in chunks of grainSize from a shared counter, so
+ * unbalanced work is distributed dynamically. When a single thread is
+ * requested, or the range fits in a chunk, the function is run in the calling
+ * thread.
+ * @param in begin The first index
+ * @param in end One past the last index
+ * @param in numThreads The number of threads to use
+ * @param in grainSize The number of consecutive indices processed at once
+ * @param in f The function to apply. Receives the index and the thread number.
+ **/
+template<typename F>
+void parallelFor( const uint64_t begin,
+                  const uint64_t end,
+                  const uint32_t numThreads,
+                  const uint64_t grainSize,
+                  F f ) noexcept {
+  if( begin >= end ) {
+    return;
+  }
+  const uint64_t grain = std::max<uint64_t>(grainSize, 1);
+  if( numThreads <= 1 || end - begin <= grain ) {
+    for( uint64_t i = begin; i < end; ++i ) {
+      f(i, 0);
+    }
+    return;
+  }
+
+  std::atomic<uint64_t> next(begin);
+  auto worker = [&]( const uint32_t thread ) {
+    while( true ) {
+      const uint64_t first = next.fetch_add(grain);
+      if( first >= end ) {
+        break;
+      }
+      const uint64_t last = std::min(first + grain, end);
+      for( uint64_t i = first; i < last; ++i ) {
+        f(i, thread);
+      }
+    }
+  };
+
+  const uint32_t threads = static_cast<uint32_t>(std::min<uint64_t>(numThreads, (end - begin + grain - 1) / grain));
+  std::vector<std::thread> pool;
+  for( uint32_t t = 1; t < threads; ++t ) {
+    pool.emplace_back(worker, t);
+  }
+  worker(0);
+  for( std::thread& thread : pool ) {
+    thread.join();
+  }
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _BASE_PARALLEL_H_ */
@@ -0,0 +1,160 @@
+
+
+
+#ifndef _BASE_PROFILING_H_
+#define _BASE_PROFILING_H_
+
+#include "../base/platform.h"
+#include <chrono>
+
+/**
+ * Wraps a profiling statement so it is removed at compile time when
+ * profiling is disabled (SMILE_ENABLE_PROFILING not defined).
+ **/
+#if defined(SMILE_ENABLE_PROFILING)
+#define SMILE_PROFILE( statement ) statement
+#else
+#define SMILE_PROFILE( statement )
+#endif
+
+/**
+ * Increments a counter of a QueryStats pointer, if not null
+ **/
+#define SMILE_PROFILE_COUNT( stats, counter ) SMILE_PROFILE( if( (stats) != nullptr ) { ++(stats)->counter; } )
+
+SMILE_NS_BEGIN
+
+enum class QueryPhase : uint8_t {
+  E_INIT = 0,
+  E_BOUNDS,
+  E_SEARCH,
+  E_UNPACK,
+  E_NUM_PHASES
+};
+
+/**
+ * Counters of the work done by a query. A query only fills them when it is
+ * given a QueryStats object, so collecting them can be enabled for a sample
+ * of the queries.
+ **/
+struct QueryStats {
+  /**
+   * Number of nodes (or labels) extracted from the queue
+   */
+  uint64_t  m_nodesSettled  = 0;
+
+  /**
+   * Number of edges (or arcs) relaxed
+   */
+  uint64_t  m_edgesRelaxed  = 0;
+
+  /**
+   * Number of insertions into the queue
+   */
+  uint64_t  m_heapPushes    = 0;
+
+  /**
+   * Number of extractions from the queue
+   */
+  uint64_t  m_heapPops      = 0;
+
+  /**
+   * Number of decrease key operations on the queue
+   */
+  uint64_t  m_heapDecreases = 0;
+
+  /**
+   * Number of Buffer Pool pages pinned or allocated
+   */
+  uint64_t  m_pagesTouched  = 0;
+
+  /**
+   * Number of Buffer Pool pages that had to be read from storage
+   */
+  uint64_t  m_pageMisses    = 0;
+
+  /**
+   * Time spent in each phase, in nanoseconds
+   */
+  uint64_t  m_phaseTimes[static_cast<uint32_t>(QueryPhase::E_NUM_PHASES)] = {0, 0, 0, 0};
+
+  /**
+   * Sets all the counters to zero
+   **/
+  void reset() noexcept {
+    *this = QueryStats();
+  }
+};
+
+/**
+ * Adds the time elapsed between its construction and destruction to a phase
+ * of a QueryStats object. Does nothing if the stats pointer is null or
+ * profiling is disabled.
+ **/
+class ScopedPhaseTimer {
+  public:
+    SMILE_NON_COPYABLE(ScopedPhaseTimer);
+
+    ScopedPhaseTimer( QueryStats* stats, const QueryPhase phase ) noexcept
+#if defined(SMILE_ENABLE_PROFILING)
+      : p_stats(stats), m_phase(phase) {
+      if( p_stats != nullptr ) {
+        m_start = std::chrono::steady_clock::now();
+      }
+    }
+#else
+    {}
+#endif
+
+    ~ScopedPhaseTimer() noexcept {
+#if defined(SMILE_ENABLE_PROFILING)
+      if( p_stats != nullptr ) {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start;
+        p_stats->m_phaseTimes[static_cast<uint32_t>(m_phase)] +=
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+      }
+#endif
+    }
+
+  private:
+#if defined(SMILE_ENABLE_PROFILING)
+    QueryStats*                           p_stats;
+    QueryPhase                            m_phase;
+    std::chrono::steady_clock::time_point m_start;
+#endif
+};
+
+/**
+ * Decides which queries are profiled: one out of every m_period queries.
+ * Not thread safe; each thread should use its own sampler.
+ **/
+class QuerySampler {
+  public:
+    QuerySampler( const uint32_t period ) noexcept :
+      m_period(period) {
+    }
+
+    /**
+     * Tells if the next query should be profiled
+     **/
+    bool sample() noexcept {
+#if defined(SMILE_ENABLE_PROFILING)
+      if( m_period == 0 ) {
+        return false;
+      }
+      if( ++m_count >= m_period ) {
+        m_count = 0;
+        return true;
+      }
+#endif
+      return false;
+    }
+
+  private:
+    uint32_t  m_period;
+    uint32_t  m_count = 0;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _BASE_PROFILING_H_ */
@@ -0,0 +1,78 @@
+
+
+
+#include "string_pool.h"
+#include <functional>
+
+SMILE_NS_BEGIN
+
+StringPool::StringPool() noexcept :
+  m_shards(new Shard[kNumShards]) {
+  for( uint32_t s = 0; s < kNumShards; ++s ) {
+    for( uint32_t i = 0; i < kNumSegments; ++i ) {
+      m_shards[s].m_segments[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+}
+
+StringPool::~StringPool() noexcept {
+  for( uint32_t s = 0; s < kNumShards; ++s ) {
+    for( uint32_t i = 0; i < kNumSegments; ++i ) {
+      delete [] m_shards[s].m_segments[i].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+StringPool& StringPool::global() noexcept {
+  static StringPool pool;
+  return pool;
+}
+
+strid_t StringPool::intern( const std::string& value ) noexcept {
+  const size_t hash = std::hash<std::string>()(value);
+  const uint32_t shardIndex = static_cast<uint32_t>(hash >> 7) & kShardMask;
+  Shard& shard = m_shards[shardIndex];
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+  auto it = shard.m_codes.find(value);
+  if( it != shard.m_codes.end() ) {
+    return it->second;
+  }
+  const uint32_t index = shard.m_size;
+  if( index >= (1U << (32 - kShardBits)) - 1 ) {
+    return kInvalidStringId;
+  }
+  const strid_t code = (index << kShardBits) | shardIndex;
+  it = shard.m_codes.emplace(value, code).first;
+  uint32_t segment;
+  uint32_t offset;
+  locate(index, &segment, &offset);
+  const std::string** strings = shard.m_segments[segment].load(std::memory_order_relaxed);
+  if( strings == nullptr ) {
+    strings = new const std::string*[1ULL << (segment + kFirstSegmentBits)];
+  }
+  // The keys of the map are stable, so the segment points to them. The
+  // segment is published after the string, for lock free readers.
+  strings[offset] = &it->first;
+  shard.m_segments[segment].store(strings, std::memory_order_release);
+  ++shard.m_size;
+  return code;
+}
+
+strid_t StringPool::find( const std::string& value ) const noexcept {
+  const size_t hash = std::hash<std::string>()(value);
+  const Shard& shard = m_shards[static_cast<uint32_t>(hash >> 7) & kShardMask];
+  std::lock_guard<std::mutex> lock(shard.m_mutex);
+  auto it = shard.m_codes.find(value);
+  return it != shard.m_codes.end() ? it->second : kInvalidStringId;
+}
+
+uint64_t StringPool::size() const noexcept {
+  uint64_t total = 0;
+  for( uint32_t s = 0; s < kNumShards; ++s ) {
+    std::lock_guard<std::mutex> lock(m_shards[s].m_mutex);
+    total += m_shards[s].m_size;
+  }
+  return total;
+}
+
+SMILE_NS_END
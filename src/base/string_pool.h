@@ -0,0 +1,121 @@
+
+
+
+#ifndef _BASE_STRING_POOL_H_
+#define _BASE_STRING_POOL_H_
+
+#include "base.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+SMILE_NS_BEGIN
+
+/**
+ * Code of an interned string
+ **/
+using strid_t = uint32_t;
+
+/**
+ * Invalid string code
+ **/
+constexpr strid_t kInvalidStringId = UINT32_MAX;
+
+/**
+ * Interns strings to 32 bit codes. Equal strings always get the same code,
+ * so strings can be stored and compared as codes. The pool is split into
+ * shards, chosen by the hash of the string, each with its own lock, so
+ * threads interning different strings rarely contend. Getting the string of
+ * a code does not lock. Interned strings are never released.
+ **/
+class StringPool {
+    SMILE_NON_COPYABLE(StringPool);
+  public:
+    StringPool() noexcept;
+    ~StringPool() noexcept;
+
+    /**
+     * Gets the pool shared by the whole process
+     **/
+    static StringPool& global() noexcept;
+
+    /**
+     * Interns a string
+     * @param in value The string
+     * @return The code of the string, or kInvalidStringId if the string is
+     * new and its shard has no codes left
+     **/
+    strid_t intern( const std::string& value ) noexcept;
+
+    /**
+     * Interns a string
+     * @param in data The characters of the string
+     * @param in length The number of characters
+     * @return The code of the string, or kInvalidStringId if the string is
+     * new and its shard has no codes left
+     **/
+    strid_t intern( const char* data, const size_t length ) noexcept {
+      return intern(std::string(data, length));
+    }
+
+    /**
+     * Gets the code of a string without interning it
+     * @param in value The string
+     * @return The code, or kInvalidStringId if the string is not interned
+     **/
+    strid_t find( const std::string& value ) const noexcept;
+
+    /**
+     * Gets the string of a code. The code must have been returned by this
+     * pool. The reference is valid as long as the pool.
+     **/
+    const std::string& get( const strid_t code ) const noexcept {
+      const Shard& shard = m_shards[code & kShardMask];
+      const uint32_t index = code >> kShardBits;
+      uint32_t segment;
+      uint32_t offset;
+      locate(index, &segment, &offset);
+      return *shard.m_segments[segment].load(std::memory_order_acquire)[offset];
+    }
+
+    /**
+     * Gets the number of interned strings
+     **/
+    uint64_t size() const noexcept;
+
+  private:
+
+    static constexpr uint32_t kShardBits = 4;
+    static constexpr uint32_t kNumShards = 1 << kShardBits;
+    static constexpr uint32_t kShardMask = kNumShards - 1;
+
+    // The strings of a shard are addressed through segments of doubling
+    // size, which are never moved, so readers need no lock
+    static constexpr uint32_t kFirstSegmentBits = 6;
+    static constexpr uint32_t kNumSegments = 32 - kShardBits;
+
+    struct Shard {
+      mutable std::mutex                                  m_mutex;
+      std::unordered_map<std::string, strid_t>            m_codes;
+      std::atomic<const std::string**>                    m_segments[kNumSegments];
+      uint32_t                                            m_size = 0;
+    };
+
+    /**
+     * Gets the segment of the string of a shard, and its offset in it
+     **/
+    static void locate( const uint32_t index, uint32_t* segment, uint32_t* offset ) noexcept {
+      const uint64_t position = static_cast<uint64_t>(index) + (1ULL << kFirstSegmentBits);
+      const uint32_t bits = 63 - __builtin_clzll(position);
+      *segment = bits - kFirstSegmentBits;
+      *offset = static_cast<uint32_t>(position - (1ULL << bits));
+    }
+
+    std::unique_ptr<Shard[]> m_shards;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _BASE_STRING_POOL_H_ */
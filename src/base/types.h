@@ -34,7 +34,7 @@ struct timestamp {
   }
 
   bool operator>=(const timestamp& t)  const noexcept {
-    return val <= t.val;
+    return val >= t.val;
   }
 
   bool operator<(const timestamp& t)  const noexcept {
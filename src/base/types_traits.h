@@ -3,9 +3,9 @@
 #ifndef _BASE_TYPES_TRAITS_H_
 #define _BASE_TYPES_TRAITS_H_ 
 
-#include <base/platform.h>
+#include "../base/platform.h"
 
-SPA_BENCH_NS_BEGIN
+SMILE_NS_BEGIN
 
 /**
  * Trait for supported types 
@@ -75,6 +75,6 @@ struct is_supported<timestamp> {
   static const AttributeDataType type = AttributeDataType::E_TIMESTAMP;
 };
 
-SPA_BENCH_NS_END
+SMILE_NS_END
 
 #endif /* ifndef _TYPES_UTILS_H_H */
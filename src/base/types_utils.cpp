@@ -1,9 +1,17 @@
 
 
 
+
+
+
 #include "../base/types_utils.h"
-#include <boost/date_time.hpp>
-namespace bt = boost::posix_time;
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <locale.h>
 
 SMILE_NS_BEGIN
 
@@ -14,75 +22,407 @@ bool parseBool( const std::string& value ) {
   return true;
 }
 
-int32_t parseInt32( const std::string& value ) {
-  std::size_t numread;
-  const auto num = static_cast<int32_t>(std::stoi(value,&numread));
-  if(numread != value.length()) {
+/**
+ * Parses a string with a range parser, reporting the errors in stderr
+ **/
+template<typename T, typename P>
+static T parseString( const std::string& value, P p ) {
+  T num = T();
+  if(p(value.data(), value.data() + value.length(), &num) != ErrorCode::E_NO_ERROR) {
     std::cerr << "WARNING: processing of value " << value << " was not correct :" << num << std::endl;
   }
   return num;
 }
 
+int32_t parseInt32( const std::string& value ) {
+  return parseString<int32_t>(value, [](const char* b, const char* e, int32_t* v) { return parseInt32(b, e, v); });
+}
+
 int64_t parseInt64( const std::string& value ){
+  return parseString<int64_t>(value, [](const char* b, const char* e, int64_t* v) { return parseInt64(b, e, v); });
+}
 
-  std::size_t numread;
-  const auto num = static_cast<int64_t>(std::stol(value,&numread));
-  if(numread != value.length()) {
-    std::cerr << "WARNING: processing of value " << value << " was not correct :" << num << std::endl;
+uint32_t parseUInt32( const std::string& value ) {
+  return parseString<uint32_t>(value, [](const char* b, const char* e, uint32_t* v) { return parseUInt32(b, e, v); });
+}
+
+uint64_t parseUInt64( const std::string& value ){
+  return parseString<uint64_t>(value, [](const char* b, const char* e, uint64_t* v) { return parseUInt64(b, e, v); });
+}
+
+float parseFloat(const std::string& value ){
+  return parseString<float>(value, [](const char* b, const char* e, float* v) { return parseFloat(b, e, v); });
+}
+
+double parseDouble(const std::string& value ){
+  return parseString<double>(value, [](const char* b, const char* e, double* v) { return parseDouble(b, e, v); });
+}
+
+timestamp parseTimestamp( const std::string& value ) {
+  timestamp time{0};
+  if(parseTimestamp(value.data(), value.data() + value.length(), &time) != ErrorCode::E_NO_ERROR) {
+    std::cerr << "WARNING: error parsing timestamp: " << value << std::endl;
   }
-  return num;
+  return time;
 }
 
-uint32_t parseUInt32( const std::string& value ) {
-  std::size_t numread;
-  const auto num = static_cast<uint32_t>(std::stoul(value,&numread));
-  if(numread != value.length()) {
-    std::cerr << "WARNING: processing of value " << value << " was not correct :" << num << std::endl;
+/** RANGE PARSING FUNCTIONS **/
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define SMILE_SWAR_DIGITS
+#endif
+
+#if defined(SMILE_SWAR_DIGITS)
+/**
+ * Tells if the 8 characters packed in a word are decimal digits
+ **/
+static inline bool isEightDigits( const uint64_t chars ) noexcept {
+  return ((chars & 0xF0F0F0F0F0F0F0F0) |
+          (((chars + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+/**
+ * Converts 8 decimal digits packed in a word (first digit in the lowest byte)
+ * with three multiplications, instead of one per digit
+ **/
+static inline uint64_t parseEightDigits( uint64_t chars ) noexcept {
+  const uint64_t mask = 0x000000FF000000FF;
+  const uint64_t mul1 = 100 + (1000000ULL << 32);
+  const uint64_t mul2 = 1 + (10000ULL << 32);
+  chars -= 0x3030303030303030;
+  chars = (chars * 10) + (chars >> 8);
+  return (((chars & mask) * mul1) + (((chars >> 16) & mask) * mul2)) >> 32;
+}
+#endif
+
+/**
+ * Parses a non empty range of decimal digits. Blocks of 8 digits are
+ * converted at once.
+ **/
+static ErrorCode parseDigits( const char* begin, const char* end, const uint64_t max, uint64_t* value ) noexcept {
+  if(begin == end) {
+    return ErrorCode::E_PARSE_INVALID_VALUE;
   }
-  return num;
+  uint64_t result = 0;
+  bool overflow = false;
+  const char* c = begin;
+#if defined(SMILE_SWAR_DIGITS)
+  while(end - c >= 8) {
+    uint64_t chars;
+    memcpy(&chars, c, sizeof(chars));
+    if(!isEightDigits(chars)) {
+      break;
+    }
+    overflow |= __builtin_mul_overflow(result, 100000000ULL, &result);
+    overflow |= __builtin_add_overflow(result, parseEightDigits(chars), &result);
+    c += 8;
+  }
+#endif
+  for(; c != end; ++c) {
+    const uint64_t digit = static_cast<uint64_t>(static_cast<uint8_t>(*c)) - '0';
+    if(digit > 9) {
+      return ErrorCode::E_PARSE_INVALID_VALUE;
+    }
+    overflow |= __builtin_mul_overflow(result, 10ULL, &result);
+    overflow |= __builtin_add_overflow(result, digit, &result);
+  }
+  if(overflow || result > max) {
+    return ErrorCode::E_PARSE_OUT_OF_RANGE;
+  }
+  *value = result;
+  return ErrorCode::E_NO_ERROR;
 }
 
-uint64_t parseUInt64( const std::string& value ){ 
-  std::size_t numread;
-  const auto num = static_cast<uint64_t>(std::stoull(value,&numread));
-  if(numread != value.length()) {
-    std::cerr << "WARNING: processing of value " << value << " was not correct :" << num << std::endl;
+template<typename T>
+static ErrorCode parseUnsigned( const char* begin, const char* end, T* value ) noexcept {
+  uint64_t result;
+  const ErrorCode error = parseDigits(begin, end, std::numeric_limits<T>::max(), &result);
+  if(error == ErrorCode::E_NO_ERROR) {
+    *value = static_cast<T>(result);
   }
-  return num;
+  return error;
 }
 
-float parseFloat(const std::string& value ){
-  std::size_t numread;
-  const auto num = static_cast<float>(std::stof(value,&numread));
-  if(numread != value.length()) {
-    std::cerr << "WARNING: processing of value " << value << " was not correct :" << num << std::endl;
+template<typename T>
+static ErrorCode parseSigned( const char* begin, const char* end, T* value ) noexcept {
+  const bool negative = begin != end && *begin == '-';
+  if(begin != end && (*begin == '-' || *begin == '+')) {
+    ++begin;
   }
-  return num;
+  const uint64_t max = static_cast<uint64_t>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+  uint64_t result;
+  const ErrorCode error = parseDigits(begin, end, max, &result);
+  if(error == ErrorCode::E_NO_ERROR) {
+    *value = negative ? static_cast<T>(0 - result) : static_cast<T>(result);
+  }
+  return error;
 }
 
-double parseDouble(const std::string& value ){
-  std::size_t numread;
-  const auto num = static_cast<float>(std::stod(value,&numread));
-  if(numread != value.length()) {
-    std::cerr << "WARNING: processing of value " << value << " was not correct :" << num << std::endl;
+ErrorCode parseBool( const char* begin, const char* end, bool* value ) noexcept {
+  const uint64_t length = static_cast<uint64_t>(end - begin);
+  if((length == 4 && memcmp(begin, "true", 4) == 0) || (length == 1 && *begin == '1')) {
+    *value = true;
+    return ErrorCode::E_NO_ERROR;
   }
-  return num;
+  if((length == 5 && memcmp(begin, "false", 5) == 0) || (length == 1 && *begin == '0')) {
+    *value = false;
+    return ErrorCode::E_NO_ERROR;
+  }
+  return ErrorCode::E_PARSE_INVALID_VALUE;
 }
 
-std::locale locale(std::locale::classic(), new bt::time_input_facet("%Y-%m-%dT%H:%M:%S%F+0000"));
-bt::ptime timet_start(boost::gregorian::date(1970,1,1));
+ErrorCode parseInt32( const char* begin, const char* end, int32_t* value ) noexcept {
+  return parseSigned(begin, end, value);
+}
 
-timestamp parseTimestamp( const std::string& value ) {
-  /*bt::ptime pt;
-  std::istringstream is(value);
-  is.imbue(locale);
-  is >> pt;
-  if(pt == bt::ptime()) std::cout << "WARNING: error parsing timestmap: " << value << " " << pt << std::endl;
-  bt::time_duration diff = pt - timet_start;
-  auto time =  static_cast<uint64_t>(diff.ticks()/bt::time_duration::rep_type::ticks_per_second);
-  */
-  return timestamp{0};
+ErrorCode parseInt64( const char* begin, const char* end, int64_t* value ) noexcept {
+  return parseSigned(begin, end, value);
 }
 
-SMILE_NS_END
+ErrorCode parseUInt32( const char* begin, const char* end, uint32_t* value ) noexcept {
+  return parseUnsigned(begin, end, value);
+}
+
+ErrorCode parseUInt64( const char* begin, const char* end, uint64_t* value ) noexcept {
+  return parseUnsigned(begin, end, value);
+}
+
+/**
+ * Decimal number split into its digits and its exponent
+ **/
+struct DecimalNumber {
+  bool      m_negative  = false;
+  uint64_t  m_mantissa  = 0;
+  int64_t   m_exponent  = 0;
+  bool      m_truncated = false;
+};
+
+/**
+ * Scans a decimal number [+-]digits[.digits][(e|E)[+-]digits]. At most 19
+ * significant digits are kept in the mantissa.
+ * @return false if the range is not in this format
+ **/
+static bool scanDecimal( const char* begin, const char* end, DecimalNumber* number ) noexcept {
+  const char* c = begin;
+  if(c != end && (*c == '-' || *c == '+')) {
+    number->m_negative = *c == '-';
+    ++c;
+  }
+  uint32_t numSignificant = 0;
+  bool anyDigit = false;
+  bool fraction = false;
+  for(; c != end; ++c) {
+    if(*c == '.' && !fraction) {
+      fraction = true;
+      continue;
+    }
+    const uint32_t digit = static_cast<uint32_t>(static_cast<uint8_t>(*c)) - '0';
+    if(digit > 9) {
+      break;
+    }
+    anyDigit = true;
+    if(numSignificant < 19) {
+      number->m_mantissa = number->m_mantissa*10 + digit;
+      numSignificant += number->m_mantissa != 0 ? 1 : 0;
+      number->m_exponent -= fraction ? 1 : 0;
+    } else {
+      number->m_truncated |= digit != 0;
+      number->m_exponent += fraction ? 0 : 1;
+    }
+  }
+  if(!anyDigit) {
+    return false;
+  }
+  if(c != end && (*c == 'e' || *c == 'E')) {
+    ++c;
+    const bool negative = c != end && *c == '-';
+    if(c != end && (*c == '-' || *c == '+')) {
+      ++c;
+    }
+    if(c == end) {
+      return false;
+    }
+    int64_t exponent = 0;
+    for(; c != end; ++c) {
+      const uint32_t digit = static_cast<uint32_t>(static_cast<uint8_t>(*c)) - '0';
+      if(digit > 9) {
+        return false;
+      }
+      exponent = std::min<int64_t>(exponent*10 + digit, 1000000);
+    }
+    number->m_exponent += negative ? -exponent : exponent;
+  }
+  return c == end;
+}
+
+/**
+ * Gets the C locale, so the fallback does not depend on the locale of the
+ * process
+ **/
+static locale_t cLocale() noexcept {
+  static const locale_t locale = newlocale(LC_ALL_MASK, "C", static_cast<locale_t>(0));
+  return locale;
+}
+
+/**
+ * Parses a number with strtod_l or strtof_l in the C locale, for the cases
+ * the fast path does not handle (too many digits, large exponents...). Only
+ * the grammar of the fast path is accepted: leading spaces, infinities, NaNs
+ * and hexadecimal numbers are rejected. The range is copied to a buffer in
+ * the stack to terminate it.
+ **/
+template<typename T, typename F>
+static ErrorCode parseRealFallback( const char* begin, const char* end, F f, T* value ) noexcept {
+  DecimalNumber number;
+  if(!scanDecimal(begin, end, &number)) {
+    return ErrorCode::E_PARSE_INVALID_VALUE;
+  }
+  char buffer[128];
+  const uint64_t length = static_cast<uint64_t>(end - begin);
+  const locale_t locale = cLocale();
+  if(length >= sizeof(buffer) || locale == static_cast<locale_t>(0)) {
+    return ErrorCode::E_PARSE_INVALID_VALUE;
+  }
+  memcpy(buffer, begin, length);
+  buffer[length] = '\0';
+  char* last = nullptr;
+  errno = 0;
+  const T result = f(buffer, &last, locale);
+  if(last != buffer + length) {
+    return ErrorCode::E_PARSE_INVALID_VALUE;
+  }
+  if(errno == ERANGE && std::isinf(result)) {
+    return ErrorCode::E_PARSE_OUT_OF_RANGE;
+  }
+  *value = result;
+  return ErrorCode::E_NO_ERROR;
+}
+
+/**
+ * Powers of ten exactly representable as a double
+ **/
+static const double kExactPowers[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
 
+ErrorCode parseDouble( const char* begin, const char* end, double* value ) noexcept {
+  // Clinger's fast path: if the mantissa and the power of ten are exact
+  // doubles, a single multiplication or division is correctly rounded.
+  DecimalNumber number;
+  if(scanDecimal(begin, end, &number) && !number.m_truncated &&
+     number.m_mantissa <= (1ULL << 53) && number.m_exponent >= -22 && number.m_exponent <= 22) {
+    double result = static_cast<double>(number.m_mantissa);
+    result = number.m_exponent < 0 ? result / kExactPowers[-number.m_exponent] : result * kExactPowers[number.m_exponent];
+    *value = number.m_negative ? -result : result;
+    return ErrorCode::E_NO_ERROR;
+  }
+  return parseRealFallback(begin, end, [](const char* str, char** last, locale_t locale) { return strtod_l(str, last, locale); }, value);
+}
+
+ErrorCode parseFloat( const char* begin, const char* end, float* value ) noexcept {
+  // Same as parseDouble, with the limits of single precision
+  DecimalNumber number;
+  if(scanDecimal(begin, end, &number) && !number.m_truncated &&
+     number.m_mantissa <= (1ULL << 24) && number.m_exponent >= -10 && number.m_exponent <= 10) {
+    float result = static_cast<float>(number.m_mantissa);
+    const float power = static_cast<float>(kExactPowers[number.m_exponent < 0 ? -number.m_exponent : number.m_exponent]);
+    result = number.m_exponent < 0 ? result / power : result * power;
+    *value = number.m_negative ? -result : result;
+    return ErrorCode::E_NO_ERROR;
+  }
+  return parseRealFallback(begin, end, [](const char* str, char** last, locale_t locale) { return strtof_l(str, last, locale); }, value);
+}
+
+/**
+ * Parses two decimal digits
+ **/
+static inline bool parseTwoDigits( const char* c, uint32_t* value ) noexcept {
+  const uint32_t high = static_cast<uint32_t>(static_cast<uint8_t>(c[0])) - '0';
+  const uint32_t low = static_cast<uint32_t>(static_cast<uint8_t>(c[1])) - '0';
+  *value = high*10 + low;
+  return high <= 9 && low <= 9;
+}
+
+/**
+ * Computes the number of days between 1970-01-01 and a date of the
+ * proleptic Gregorian calendar
+ **/
+static int64_t daysFromCivil( int64_t year, const uint32_t month, const uint32_t day ) noexcept {
+  year -= month <= 2 ? 1 : 0;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const uint32_t yearOfEra = static_cast<uint32_t>(year - era*400);
+  const uint32_t dayOfYear = (153*(month > 2 ? month - 3 : month + 9) + 2)/5 + day - 1;
+  const uint32_t dayOfEra = yearOfEra*365 + yearOfEra/4 - yearOfEra/100 + dayOfYear;
+  return era*146097 + static_cast<int64_t>(dayOfEra) - 719468;
+}
+
+ErrorCode parseTimestamp( const char* begin, const char* end, timestamp* value ) noexcept {
+  const uint64_t length = static_cast<uint64_t>(end - begin);
+  if(length < 10 || begin[4] != '-') {
+    return parseDigits(begin, end, std::numeric_limits<uint64_t>::max(), &value->val);
+  }
+
+  uint32_t century, year, month, day;
+  if(!parseTwoDigits(begin, &century) || !parseTwoDigits(begin + 2, &year) ||
+     !parseTwoDigits(begin + 5, &month) || !parseTwoDigits(begin + 8, &day) || begin[7] != '-') {
+    return ErrorCode::E_PARSE_INVALID_VALUE;
+  }
+  year += century*100;
+  static const uint32_t kDaysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  if(month < 1 || month > 12 || day < 1 || day > kDaysInMonth[month-1] + (month == 2 && leap ? 1 : 0)) {
+    return ErrorCode::E_PARSE_INVALID_VALUE;
+  }
+
+  uint32_t hours = 0, minutes = 0, seconds = 0;
+  int64_t offset = 0;
+  const char* c = begin + 10;
+  if(c != end) {
+    if(length < 19 || (*c != 'T' && *c != ' ') || c[3] != ':' || c[6] != ':' ||
+       !parseTwoDigits(c + 1, &hours) || !parseTwoDigits(c + 4, &minutes) || !parseTwoDigits(c + 7, &seconds) ||
+       hours > 23 || minutes > 59 || seconds > 60) {
+      return ErrorCode::E_PARSE_INVALID_VALUE;
+    }
+    c += 9;
+    if(c != end && *c == '.') {
+      ++c;
+      const char* fraction = c;
+      while(c != end && static_cast<uint32_t>(static_cast<uint8_t>(*c)) - '0' <= 9) {
+        ++c;
+      }
+      if(c == fraction) {
+        return ErrorCode::E_PARSE_INVALID_VALUE;
+      }
+    }
+    if(c != end && *c == 'Z') {
+      ++c;
+    } else if(c != end && (*c == '+' || *c == '-')) {
+      const int64_t sign = *c == '+' ? 1 : -1;
+      ++c;
+      uint32_t offsetHours, offsetMinutes;
+      if(end - c < 4 || !parseTwoDigits(c, &offsetHours)) {
+        return ErrorCode::E_PARSE_INVALID_VALUE;
+      }
+      c += 2;
+      c += *c == ':' ? 1 : 0;
+      if(end - c < 2 || !parseTwoDigits(c, &offsetMinutes) || offsetHours > 23 || offsetMinutes > 59) {
+        return ErrorCode::E_PARSE_INVALID_VALUE;
+      }
+      c += 2;
+      offset = sign*(offsetHours*3600 + offsetMinutes*60);
+    }
+    if(c != end) {
+      return ErrorCode::E_PARSE_INVALID_VALUE;
+    }
+  }
+
+  const int64_t time = daysFromCivil(year, month, day)*86400 + hours*3600 + minutes*60 + seconds - offset;
+  if(time < 0) {
+    return ErrorCode::E_PARSE_OUT_OF_RANGE;
+  }
+  value->val = static_cast<uint64_t>(time);
+  return ErrorCode::E_NO_ERROR;
+}
+
+SMILE_NS_END
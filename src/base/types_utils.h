@@ -5,6 +5,7 @@
 #define _BASE_TYPES_UTILS_H_ value
 
 #include "../base/types.h"
+#include "../base/error.h"
 
 SMILE_NS_BEGIN
 
@@ -17,9 +18,38 @@ float parseFloat(const std::string& value );
 double parseDouble(const std::string& value );
 timestamp parseTimestamp(const std::string& value);
 
+/**
+ * Range parsers. They parse the characters in [begin, end), which do not need
+ * to be null terminated, do not allocate memory and do not depend on the
+ * locale. The whole range must be a valid value. Reals must match
+ * [+-]digits[.digits][(e|E)[+-]digits]: spaces, infinities, NaNs and
+ * hexadecimal numbers are rejected.
+ * @param in begin The first character
+ * @param in end One past the last character
+ * @param out value The parsed value. Unchanged on error.
+ * @return E_PARSE_INVALID_VALUE if the range is not a valid value of the type
+ * and E_PARSE_OUT_OF_RANGE if it does not fit in the type
+ **/
+ErrorCode parseBool( const char* begin, const char* end, bool* value ) noexcept;
+ErrorCode parseInt32( const char* begin, const char* end, int32_t* value ) noexcept;
+ErrorCode parseInt64( const char* begin, const char* end, int64_t* value ) noexcept;
+ErrorCode parseUInt32( const char* begin, const char* end, uint32_t* value ) noexcept;
+ErrorCode parseUInt64( const char* begin, const char* end, uint64_t* value ) noexcept;
+ErrorCode parseFloat( const char* begin, const char* end, float* value ) noexcept;
+ErrorCode parseDouble( const char* begin, const char* end, double* value ) noexcept;
+
+/**
+ * Parses an ISO-8601 timestamp into seconds since the epoch. The accepted
+ * format is YYYY-MM-DD[(T| )hh:mm:ss[.fraction]][Z|(+|-)hh[:]mm], where the
+ * fraction of second is truncated. A plain integer is taken as a number of
+ * seconds since the epoch.
+ **/
+ErrorCode parseTimestamp( const char* begin, const char* end, timestamp* value ) noexcept;
+
 template<typename T>
 struct parser {
   static T parse( const std::string& str );
+  static ErrorCode parse( const char* begin, const char* end, T* value ) noexcept;
 };
 
 template<>
@@ -27,6 +57,10 @@ struct parser<bool> {
   static bool parse( const std::string& str ) {
     return parseBool(str);
   }
+
+  static ErrorCode parse( const char* begin, const char* end, bool* value ) noexcept {
+    return parseBool(begin, end, value);
+  }
 };
 
 template<>
@@ -34,6 +68,10 @@ struct parser<uint32_t> {
   static uint32_t parse( const std::string& str ) {
     return parseUInt32(str);
   }
+
+  static ErrorCode parse( const char* begin, const char* end, uint32_t* value ) noexcept {
+    return parseUInt32(begin, end, value);
+  }
 };
 
 template<>
@@ -41,6 +79,10 @@ struct parser<int32_t> {
   static int32_t parse( const std::string& str ) {
     return parseInt32(str);
   }
+
+  static ErrorCode parse( const char* begin, const char* end, int32_t* value ) noexcept {
+    return parseInt32(begin, end, value);
+  }
 };
 
 template<>
@@ -48,6 +90,10 @@ struct parser<uint64_t> {
   static uint64_t parse( const std::string& str ) {
     return parseUInt64(str);
   }
+
+  static ErrorCode parse( const char* begin, const char* end, uint64_t* value ) noexcept {
+    return parseUInt64(begin, end, value);
+  }
 };
 
 template<>
@@ -55,6 +101,10 @@ struct parser<int64_t> {
   static int64_t parse( const std::string& str ) {
     return parseInt64(str);
   }
+
+  static ErrorCode parse( const char* begin, const char* end, int64_t* value ) noexcept {
+    return parseInt64(begin, end, value);
+  }
 };
 
 template<>
@@ -62,6 +112,10 @@ struct parser<float> {
   static float parse( const std::string& str ) {
     return parseFloat(str);
   }
+
+  static ErrorCode parse( const char* begin, const char* end, float* value ) noexcept {
+    return parseFloat(begin, end, value);
+  }
 };
 
 template<>
@@ -69,6 +123,10 @@ struct parser<double> {
   static double parse( const std::string& str ) {
     return parseDouble(str);
   }
+
+  static ErrorCode parse( const char* begin, const char* end, double* value ) noexcept {
+    return parseDouble(begin, end, value);
+  }
 };
 
 template<>
@@ -76,6 +134,11 @@ struct parser<std::string> {
   static std::string parse( const std::string& str ) {
     return str;
   }
+
+  static ErrorCode parse( const char* begin, const char* end, std::string* value ) noexcept {
+    value->assign(begin, end);
+    return ErrorCode::E_NO_ERROR;
+  }
 };
 
 template<>
@@ -83,6 +146,10 @@ struct parser<timestamp> {
   static timestamp parse( const std::string& str ) {
     return parseTimestamp(str);
   }
+
+  static ErrorCode parse( const char* begin, const char* end, timestamp* value ) noexcept {
+    return parseTimestamp(begin, end, value);
+  }
 };
 
 SMILE_NS_END
@@ -0,0 +1,552 @@
+
+
+
+#ifndef _DATA_BITMAP_H_
+#define _DATA_BITMAP_H_
+
+#include "../base/platform.h"
+#include "cursor.h"
+#include "types.h"
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+SMILE_NS_BEGIN
+
+/**
+ * Compressed bitmap over the oid space. The space is split into chunks of
+ * 2^16 oids, and each non empty chunk is stored in a container: a sorted
+ * array of the low 16 bits of its oids when it holds few of them, or a
+ * dense bitset of 1024 words otherwise. Set algebra works container by
+ * container, so sparse and dense results both cost a few memory passes.
+ **/
+class Bitmap {
+  public:
+    Bitmap() noexcept = default;
+    ~Bitmap() noexcept = default;
+    Bitmap( const Bitmap& ) = default;
+    Bitmap& operator=( const Bitmap& ) = default;
+    Bitmap( Bitmap&& ) noexcept = default;
+    Bitmap& operator=( Bitmap&& ) noexcept = default;
+
+    /**
+     * Adds an oid. Adding oids in increasing order appends to the last
+     * container.
+     **/
+    void add( const oid_t oid ) noexcept {
+      const uint64_t key = oid >> 16;
+      const uint16_t low = static_cast<uint16_t>(oid);
+      Container* container = nullptr;
+      if( !m_containers.empty() && m_containers.back().m_key == key ) {
+        container = &m_containers.back();
+      } else {
+        auto it = lowerBound(key);
+        if( it == m_containers.end() || it->m_key != key ) {
+          it = m_containers.insert(it, Container());
+          it->m_key = key;
+        }
+        container = &(*it);
+      }
+      container->add(low);
+    }
+
+    /**
+     * Checks whether an oid is set
+     **/
+    bool contains( const oid_t oid ) const noexcept {
+      auto it = lowerBound(oid >> 16);
+      return it != m_containers.end() && it->m_key == (oid >> 16) && it->contains(static_cast<uint16_t>(oid));
+    }
+
+    /**
+     * Gets the number of oids set
+     **/
+    uint64_t count() const noexcept {
+      uint64_t total = 0;
+      for( const Container& container : m_containers ) {
+        total += container.m_cardinality;
+      }
+      return total;
+    }
+
+    bool empty() const noexcept {
+      return m_containers.empty();
+    }
+
+    void clear() noexcept {
+      m_containers.clear();
+    }
+
+    /**
+     * Keeps the oids also set in another bitmap
+     **/
+    void intersect( const Bitmap& other ) noexcept {
+      std::vector<Container> result;
+      auto a = m_containers.begin();
+      auto b = other.m_containers.begin();
+      while( a != m_containers.end() && b != other.m_containers.end() ) {
+        if( a->m_key < b->m_key ) {
+          ++a;
+        } else if( b->m_key < a->m_key ) {
+          ++b;
+        } else {
+          a->intersect(*b);
+          if( a->m_cardinality > 0 ) {
+            result.push_back(std::move(*a));
+          }
+          ++a;
+          ++b;
+        }
+      }
+      m_containers.swap(result);
+    }
+
+    /**
+     * Adds the oids set in another bitmap
+     **/
+    void unite( const Bitmap& other ) noexcept {
+      std::vector<Container> result;
+      result.reserve(m_containers.size() + other.m_containers.size());
+      auto a = m_containers.begin();
+      auto b = other.m_containers.begin();
+      while( a != m_containers.end() || b != other.m_containers.end() ) {
+        if( b == other.m_containers.end() || (a != m_containers.end() && a->m_key < b->m_key) ) {
+          result.push_back(std::move(*a++));
+        } else if( a == m_containers.end() || b->m_key < a->m_key ) {
+          result.push_back(*b++);
+        } else {
+          a->unite(*b);
+          result.push_back(std::move(*a));
+          ++a;
+          ++b;
+        }
+      }
+      m_containers.swap(result);
+    }
+
+    /**
+     * Removes the oids set in another bitmap
+     **/
+    void subtract( const Bitmap& other ) noexcept {
+      std::vector<Container> result;
+      auto b = other.m_containers.begin();
+      for( Container& a : m_containers ) {
+        while( b != other.m_containers.end() && b->m_key < a.m_key ) {
+          ++b;
+        }
+        if( b != other.m_containers.end() && b->m_key == a.m_key ) {
+          a.subtract(*b);
+        }
+        if( a.m_cardinality > 0 ) {
+          result.push_back(std::move(a));
+        }
+      }
+      m_containers.swap(result);
+    }
+
+    /**
+     * Replaces the bitmap by the oids of [0, universe) it does not contain
+     * @param in universe The number of oids of the space
+     **/
+    void complement( const uint64_t universe ) noexcept {
+      std::vector<Container> result;
+      auto it = m_containers.begin();
+      const uint64_t numChunks = (universe + 0xFFFF) >> 16;
+      for( uint64_t key = 0; key < numChunks; ++key ) {
+        Container container;
+        if( it != m_containers.end() && it->m_key == key ) {
+          container = std::move(*it++);
+        }
+        container.m_key = key;
+        const uint64_t last = std::min<uint64_t>(universe - (key << 16), 1 << 16);
+        container.complement(static_cast<uint32_t>(last));
+        if( container.m_cardinality > 0 ) {
+          result.push_back(std::move(container));
+        }
+      }
+      m_containers.swap(result);
+    }
+
+    /**
+     * Appends the oids set, in increasing order
+     * @param out oids The vector where the oids are appended
+     **/
+    void toOids( std::vector<oid_t>* oids ) const noexcept {
+      oids->reserve(oids->size() + count());
+      for( const Container& container : m_containers ) {
+        const oid_t base = container.m_key << 16;
+        if( container.isDense() ) {
+          for( uint32_t w = 0; w < kContainerWords; ++w ) {
+            uint64_t bits = container.m_words[w];
+            while( bits != 0 ) {
+              oids->push_back(base + 64*w + __builtin_ctzll(bits));
+              bits &= bits - 1;
+            }
+          }
+        } else {
+          for( const uint16_t low : container.m_array ) {
+            oids->push_back(base + low);
+          }
+        }
+      }
+    }
+
+    /**
+     * Sets the oids produced by a cursor
+     * @param in cursor The cursor to drain
+     **/
+    void addAll( ICursor* cursor ) noexcept {
+      oid_t batch[kCursorBatchSize];
+      uint32_t count = 0;
+      while( (count = cursor->next(batch, kCursorBatchSize)) > 0 ) {
+        for( uint32_t i = 0; i < count; ++i ) {
+          add(batch[i]);
+        }
+      }
+    }
+
+  private:
+    friend class BitmapCursor;
+
+    // Number of words of a dense container
+    static constexpr uint32_t kContainerWords = 1024;
+
+    // Containers with more oids are dense
+    static constexpr uint32_t kMaxArraySize = 4096;
+
+    struct Container {
+      uint64_t              m_key = 0;
+      uint32_t              m_cardinality = 0;
+      std::vector<uint16_t> m_array;
+      std::vector<uint64_t> m_words;
+
+      bool isDense() const noexcept {
+        return !m_words.empty();
+      }
+
+      bool contains( const uint16_t low ) const noexcept {
+        if( isDense() ) {
+          return (m_words[low >> 6] >> (low & 63)) & 1;
+        }
+        return std::binary_search(m_array.begin(), m_array.end(), low);
+      }
+
+      void add( const uint16_t low ) noexcept {
+        if( isDense() ) {
+          const uint64_t bit = 1ULL << (low & 63);
+          m_cardinality += (m_words[low >> 6] & bit) == 0 ? 1 : 0;
+          m_words[low >> 6] |= bit;
+          return;
+        }
+        if( m_array.empty() || m_array.back() < low ) {
+          m_array.push_back(low);
+        } else {
+          auto it = std::lower_bound(m_array.begin(), m_array.end(), low);
+          if( *it == low ) {
+            return;
+          }
+          m_array.insert(it, low);
+        }
+        ++m_cardinality;
+        if( m_cardinality > kMaxArraySize ) {
+          toDense();
+        }
+      }
+
+      void toDense() noexcept {
+        m_words.assign(kContainerWords, 0);
+        for( const uint16_t low : m_array ) {
+          m_words[low >> 6] |= 1ULL << (low & 63);
+        }
+        m_array.clear();
+        m_array.shrink_to_fit();
+      }
+
+      /**
+       * Recounts a dense container and turns it into an array if it became
+       * sparse
+       **/
+      void normalize() noexcept {
+        m_cardinality = popcount(m_words.data());
+        if( m_cardinality <= kMaxArraySize ) {
+          m_array.clear();
+          m_array.reserve(m_cardinality);
+          for( uint32_t w = 0; w < kContainerWords; ++w ) {
+            uint64_t bits = m_words[w];
+            while( bits != 0 ) {
+              m_array.push_back(static_cast<uint16_t>(64*w + __builtin_ctzll(bits)));
+              bits &= bits - 1;
+            }
+          }
+          m_words.clear();
+          m_words.shrink_to_fit();
+        }
+      }
+
+      void intersect( const Container& other ) noexcept {
+        if( isDense() && other.isDense() ) {
+          combine<E_AND>(m_words.data(), other.m_words.data());
+          normalize();
+        } else if( isDense() ) {
+          std::vector<uint16_t> result;
+          for( const uint16_t low : other.m_array ) {
+            if( contains(low) ) {
+              result.push_back(low);
+            }
+          }
+          setArray(std::move(result));
+        } else if( other.isDense() ) {
+          auto last = std::remove_if(m_array.begin(), m_array.end(), [&]( const uint16_t low ) {
+            return !other.contains(low);
+          });
+          m_array.erase(last, m_array.end());
+          m_cardinality = static_cast<uint32_t>(m_array.size());
+        } else {
+          std::vector<uint16_t> result;
+          std::set_intersection(m_array.begin(), m_array.end(), other.m_array.begin(), other.m_array.end(),
+                                std::back_inserter(result));
+          setArray(std::move(result));
+        }
+      }
+
+      void unite( const Container& other ) noexcept {
+        if( !isDense() && !other.isDense() && m_cardinality + other.m_cardinality <= kMaxArraySize ) {
+          std::vector<uint16_t> result;
+          std::set_union(m_array.begin(), m_array.end(), other.m_array.begin(), other.m_array.end(),
+                         std::back_inserter(result));
+          setArray(std::move(result));
+          return;
+        }
+        if( !isDense() ) {
+          toDense();
+        }
+        if( other.isDense() ) {
+          combine<E_OR>(m_words.data(), other.m_words.data());
+        } else {
+          for( const uint16_t low : other.m_array ) {
+            m_words[low >> 6] |= 1ULL << (low & 63);
+          }
+        }
+        normalize();
+      }
+
+      void subtract( const Container& other ) noexcept {
+        if( isDense() && other.isDense() ) {
+          combine<E_AND_NOT>(m_words.data(), other.m_words.data());
+          normalize();
+        } else if( isDense() ) {
+          for( const uint16_t low : other.m_array ) {
+            m_words[low >> 6] &= ~(1ULL << (low & 63));
+          }
+          normalize();
+        } else if( other.isDense() ) {
+          auto last = std::remove_if(m_array.begin(), m_array.end(), [&]( const uint16_t low ) {
+            return other.contains(low);
+          });
+          m_array.erase(last, m_array.end());
+          m_cardinality = static_cast<uint32_t>(m_array.size());
+        } else {
+          std::vector<uint16_t> result;
+          std::set_difference(m_array.begin(), m_array.end(), other.m_array.begin(), other.m_array.end(),
+                              std::back_inserter(result));
+          setArray(std::move(result));
+        }
+      }
+
+      /**
+       * Complements the container within its first last oids
+       **/
+      void complement( const uint32_t last ) noexcept {
+        if( !isDense() ) {
+          toDense();
+        }
+        combine<E_NOT>(m_words.data(), m_words.data());
+        // Clears the bits past the end of the universe
+        for( uint32_t bit = last; bit < (1 << 16); ) {
+          if( bit % 64 == 0 ) {
+            m_words[bit >> 6] = 0;
+            bit += 64;
+          } else {
+            m_words[bit >> 6] &= ~(1ULL << (bit & 63));
+            ++bit;
+          }
+        }
+        normalize();
+      }
+
+      void setArray( std::vector<uint16_t>&& array ) noexcept {
+        m_array = std::move(array);
+        m_words.clear();
+        m_cardinality = static_cast<uint32_t>(m_array.size());
+      }
+    };
+
+    enum Operation {
+      E_AND,
+      E_OR,
+      E_AND_NOT,
+      E_NOT
+    };
+
+    /**
+     * Combines two dense containers word by word, into the first one
+     **/
+    template<Operation operation>
+    static void combine( uint64_t* a, const uint64_t* b ) noexcept {
+      uint32_t w = 0;
+#if defined(__SSE2__)
+      const __m128i ones = _mm_set1_epi32(-1);
+      for( ; w < kContainerWords; w += 2 ) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + w));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + w));
+        __m128i r;
+        switch( operation ) {
+          case E_AND:
+            r = _mm_and_si128(x, y);
+            break;
+          case E_OR:
+            r = _mm_or_si128(x, y);
+            break;
+          case E_AND_NOT:
+            r = _mm_andnot_si128(y, x);
+            break;
+          case E_NOT:
+            r = _mm_xor_si128(x, ones);
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a + w), r);
+      }
+#endif
+      for( ; w < kContainerWords; ++w ) {
+        switch( operation ) {
+          case E_AND:
+            a[w] &= b[w];
+            break;
+          case E_OR:
+            a[w] |= b[w];
+            break;
+          case E_AND_NOT:
+            a[w] &= ~b[w];
+            break;
+          case E_NOT:
+            a[w] = ~a[w];
+            break;
+        }
+      }
+    }
+
+    static uint32_t popcount( const uint64_t* words ) noexcept {
+      uint32_t total = 0;
+      for( uint32_t w = 0; w < kContainerWords; ++w ) {
+        total += static_cast<uint32_t>(__builtin_popcountll(words[w]));
+      }
+      return total;
+    }
+
+    std::vector<Container>::const_iterator lowerBound( const uint64_t key ) const noexcept {
+      return std::lower_bound(m_containers.begin(), m_containers.end(), key,
+                              []( const Container& container, const uint64_t k ) {
+        return container.m_key < k;
+      });
+    }
+
+    std::vector<Container>::iterator lowerBound( const uint64_t key ) noexcept {
+      return std::lower_bound(m_containers.begin(), m_containers.end(), key,
+                              []( const Container& container, const uint64_t k ) {
+        return container.m_key < k;
+      });
+    }
+
+    std::vector<Container> m_containers;
+};
+
+/**
+ * Produces the oids set in a bitmap, in increasing order
+ **/
+class BitmapCursor : public ICursor {
+    SMILE_NON_COPYABLE(BitmapCursor);
+  public:
+    /**
+     * @param in bitmap The bitmap. Must outlive the cursor.
+     **/
+    explicit BitmapCursor( const Bitmap* bitmap ) noexcept :
+      p_bitmap(bitmap) {
+      start();
+    }
+
+    /**
+     * @param in bitmap The bitmap, owned by the cursor
+     **/
+    explicit BitmapCursor( Bitmap&& bitmap ) noexcept :
+      m_owned(std::move(bitmap)),
+      p_bitmap(&m_owned) {
+      start();
+    }
+    virtual ~BitmapCursor() noexcept = default;
+
+    uint32_t next( oid_t* oids, const uint32_t capacity ) noexcept override {
+      const std::vector<Bitmap::Container>& containers = p_bitmap->m_containers;
+      uint32_t count = 0;
+      while( count < capacity && m_container < containers.size() ) {
+        const Bitmap::Container& container = containers[m_container];
+        const oid_t base = container.m_key << 16;
+        if( container.isDense() ) {
+          while( count < capacity ) {
+            if( m_bits == 0 ) {
+              if( ++m_position >= Bitmap::kContainerWords ) {
+                break;
+              }
+              m_bits = container.m_words[m_position];
+              continue;
+            }
+            oids[count++] = base + 64*m_position + __builtin_ctzll(m_bits);
+            m_bits &= m_bits - 1;
+          }
+          if( m_position < Bitmap::kContainerWords ) {
+            continue;
+          }
+        } else {
+          const uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(capacity - count, container.m_array.size() - m_position));
+          for( uint32_t i = 0; i < n; ++i ) {
+            oids[count++] = base + container.m_array[m_position + i];
+          }
+          m_position += n;
+          if( m_position < container.m_array.size() ) {
+            continue;
+          }
+        }
+        ++m_container;
+        start();
+      }
+      return count;
+    }
+
+  private:
+
+    /**
+     * Positions the cursor at the beginning of the current container
+     **/
+    void start() noexcept {
+      m_position = 0;
+      m_bits = 0;
+      const std::vector<Bitmap::Container>& containers = p_bitmap->m_containers;
+      if( m_container < containers.size() && containers[m_container].isDense() ) {
+        m_bits = containers[m_container].m_words[0];
+      }
+    }
+
+    Bitmap          m_owned;
+    const Bitmap*   p_bitmap;
+    uint64_t        m_container = 0;
+    uint64_t        m_position = 0;
+    uint64_t        m_bits = 0;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _DATA_BITMAP_H_ */
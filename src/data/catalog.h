@@ -0,0 +1,332 @@
+
+
+
+#ifndef _DATA_CATALOG_H_
+#define _DATA_CATALOG_H_
+
+#include "../base/platform.h"
+#include "../base/error.h"
+#include "../base/string_pool.h"
+#include "../base/types_traits.h"
+#include "table.h"
+#include "types.h"
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Resolved reference to an attribute of a type
+ **/
+struct AttributeRef {
+  typeid_t      m_type      = 0;
+  attributeid_t m_attribute = 0;
+};
+
+struct AttributeDescriptor {
+  std::string       m_name;
+  strid_t           m_nameId;
+  attributeid_t     m_id;
+  AttributeDataType m_dataType;
+  bool              m_indexed;
+};
+
+struct TypeDescriptor {
+  std::string                       m_name;
+  strid_t                           m_nameId;
+  typeid_t                          m_id;
+  bool                              m_isEdgeType;
+  Direction                         m_direction;
+  std::vector<AttributeDescriptor>  m_attributes;
+};
+
+/**
+ * Catalog of the node and edge types and their attributes. Types and
+ * attributes are stored in dense arrays indexed by typeid_t and
+ * attributeid_t, together with the table of each attribute. Names are
+ * interned in the global StringPool and looked up by code. Names are
+ * resolved to ids once, when a load or a query is set up, and the hot paths
+ * then index the arrays or keep the resolved table pointers: a BulkLoader
+ * bound to a type appends to the tables of its attributes, and the scans and
+ * predicates of a query take the tables returned by resolveTable.
+ **/
+class Catalog {
+    SMILE_NON_COPYABLE(Catalog);
+  public:
+    Catalog() noexcept = default;
+    ~Catalog() noexcept = default;
+
+    /**
+     * Adds a node type
+     * @param in name The name of the type
+     * @param out type The id of the type
+     * @return E_GRAPH_EXISTING_TYPE if a type with the name exists,
+     * E_GRAPH_TYPE_MAX_NUMBER if there are too many types and
+     * E_STRING_POOL_FULL if the name cannot be interned
+     **/
+    ErrorCode addNodeType( const std::string& name, typeid_t* type ) noexcept {
+      return addType(name, false, Direction::E_UNDIRECTED, type);
+    }
+
+    /**
+     * Adds an edge type
+     * @param in name The name of the type
+     * @param in direction Whether the edges are directed
+     * @param out type The id of the type
+     * @return E_GRAPH_EXISTING_TYPE if a type with the name exists,
+     * E_GRAPH_TYPE_MAX_NUMBER if there are too many types and
+     * E_STRING_POOL_FULL if the name cannot be interned
+     **/
+    ErrorCode addEdgeType( const std::string& name, const Direction direction, typeid_t* type ) noexcept {
+      return addType(name, true, direction, type);
+    }
+
+    /**
+     * Adds an attribute to a type, and creates its table
+     * @param in type The id of the type
+     * @param in name The name of the attribute
+     * @param in dataType The data type of the attribute
+     * @param in indexed Whether the attribute is indexed
+     * @param out attribute The id of the attribute
+     * @return E_GRAPH_INVALID_TYPE if the type does not exist,
+     * E_GRAPH_EXISTING_ATTRIBUTE_TYPE if the type has an attribute with the
+     * name, E_GRAPH_ATTRIUTE_MAX_NUMBER if it has too many attributes and
+     * E_STRING_POOL_FULL if the name cannot be interned
+     **/
+    ErrorCode addAttribute( const typeid_t type,
+                            const std::string& name,
+                            const AttributeDataType dataType,
+                            const bool indexed,
+                            attributeid_t* attribute ) noexcept {
+      if( type >= m_types.size() ) {
+        return ErrorCode::E_GRAPH_INVALID_TYPE;
+      }
+      Entry& entry = m_types[type];
+      const strid_t nameId = StringPool::global().intern(name);
+      if( nameId == kInvalidStringId ) {
+        return ErrorCode::E_STRING_POOL_FULL;
+      }
+      if( entry.m_attributeNames.find(nameId) != entry.m_attributeNames.end() ) {
+        return ErrorCode::E_GRAPH_EXISTING_ATTRIBUTE_TYPE;
+      }
+      if( entry.m_descriptor.m_attributes.size() > std::numeric_limits<attributeid_t>::max() ) {
+        return ErrorCode::E_GRAPH_ATTRIUTE_MAX_NUMBER;
+      }
+      const attributeid_t id = static_cast<attributeid_t>(entry.m_descriptor.m_attributes.size());
+      entry.m_descriptor.m_attributes.push_back(AttributeDescriptor{name, nameId, id, dataType, indexed});
+      entry.m_attributeNames.emplace(nameId, id);
+      entry.m_tables.emplace_back(createTable(dataType));
+      *attribute = id;
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Resolves the name of a type
+     * @return E_GRAPH_INVALID_TYPE if no type has the name
+     **/
+    ErrorCode findType( const std::string& name, typeid_t* type ) const noexcept {
+      return findType(StringPool::global().find(name), type);
+    }
+
+    /**
+     * Resolves the interned name of a type
+     * @return E_GRAPH_INVALID_TYPE if no type has the name
+     **/
+    ErrorCode findType( const strid_t name, typeid_t* type ) const noexcept {
+      auto it = m_typeNames.find(name);
+      if( it == m_typeNames.end() ) {
+        return ErrorCode::E_GRAPH_INVALID_TYPE;
+      }
+      *type = it->second;
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Resolves the names of a type and one of its attributes
+     * @param in typeName The name of the type
+     * @param in attributeName The name of the attribute
+     * @param out ref The resolved attribute
+     * @return E_GRAPH_INVALID_TYPE if no type has the name and
+     * E_GRAPH_UNEXISTING_ATTRIBUTE_TYPE if the type has no attribute with
+     * the name
+     **/
+    ErrorCode resolve( const std::string& typeName,
+                       const std::string& attributeName,
+                       AttributeRef* ref ) const noexcept {
+      const StringPool& pool = StringPool::global();
+      return resolve(pool.find(typeName), pool.find(attributeName), ref);
+    }
+
+    /**
+     * Resolves the interned names of a type and one of its attributes
+     **/
+    ErrorCode resolve( const strid_t typeName,
+                       const strid_t attributeName,
+                       AttributeRef* ref ) const noexcept {
+      typeid_t type;
+      const ErrorCode error = findType(typeName, &type);
+      if( error != ErrorCode::E_NO_ERROR ) {
+        return error;
+      }
+      const Entry& entry = m_types[type];
+      auto it = entry.m_attributeNames.find(attributeName);
+      if( it == entry.m_attributeNames.end() ) {
+        return ErrorCode::E_GRAPH_UNEXISTING_ATTRIBUTE_TYPE;
+      }
+      ref->m_type = type;
+      ref->m_attribute = it->second;
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Resolves an attribute and gets its table, checking its data type
+     * @param in typeName The name of the type
+     * @param in attributeName The name of the attribute
+     * @param out table The table of the attribute
+     * @return The errors of resolve, and
+     * E_GRAPH_ATTRIBUTE_DATA_TYPE_MISSMATCH if T is not the data type of the
+     * attribute
+     **/
+    template<typename T>
+    ErrorCode resolveTable( const std::string& typeName,
+                            const std::string& attributeName,
+                            ITypedTable<T>** table ) noexcept {
+      AttributeRef ref;
+      const ErrorCode error = resolve(typeName, attributeName, &ref);
+      if( error != ErrorCode::E_NO_ERROR ) {
+        return error;
+      }
+      if( attribute(ref).m_dataType != is_supported<T>::type ) {
+        return ErrorCode::E_GRAPH_ATTRIBUTE_DATA_TYPE_MISSMATCH;
+      }
+      *table = this->table<T>(ref);
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Resolves an attribute and gets its table for reading, as the scans and
+     * the predicates of a query take it
+     **/
+    template<typename T>
+    ErrorCode resolveTable( const std::string& typeName,
+                            const std::string& attributeName,
+                            const ITypedTable<T>** table ) const noexcept {
+      AttributeRef ref;
+      const ErrorCode error = resolve(typeName, attributeName, &ref);
+      if( error != ErrorCode::E_NO_ERROR ) {
+        return error;
+      }
+      if( attribute(ref).m_dataType != is_supported<T>::type ) {
+        return ErrorCode::E_GRAPH_ATTRIBUTE_DATA_TYPE_MISSMATCH;
+      }
+      *table = this->table<T>(ref);
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Gets the number of types
+     **/
+    uint32_t numTypes() const noexcept {
+      return static_cast<uint32_t>(m_types.size());
+    }
+
+    /**
+     * Gets a type. The id must be valid.
+     **/
+    const TypeDescriptor& type( const typeid_t type ) const noexcept {
+      return m_types[type].m_descriptor;
+    }
+
+    /**
+     * Gets an attribute. The reference must be valid.
+     **/
+    const AttributeDescriptor& attribute( const AttributeRef& ref ) const noexcept {
+      return m_types[ref.m_type].m_descriptor.m_attributes[ref.m_attribute];
+    }
+
+    /**
+     * Gets the table of an attribute, indexed by the local id of the
+     * objects. The reference must be valid and T its data type.
+     **/
+    template<typename T>
+    ITypedTable<T>* table( const AttributeRef& ref ) noexcept {
+      assert(attribute(ref).m_dataType == is_supported<T>::type && "Data type of the attribute mismatch");
+      return static_cast<ITypedTable<T>*>(m_types[ref.m_type].m_tables[ref.m_attribute].get());
+    }
+
+    template<typename T>
+    const ITypedTable<T>* table( const AttributeRef& ref ) const noexcept {
+      assert(attribute(ref).m_dataType == is_supported<T>::type && "Data type of the attribute mismatch");
+      return static_cast<const ITypedTable<T>*>(m_types[ref.m_type].m_tables[ref.m_attribute].get());
+    }
+
+  private:
+
+    struct Entry {
+      TypeDescriptor                                  m_descriptor;
+      std::unordered_map<strid_t, attributeid_t>      m_attributeNames;
+      std::vector<std::unique_ptr<IBaseTable>>        m_tables;
+    };
+
+    ErrorCode addType( const std::string& name,
+                       const bool isEdgeType,
+                       const Direction direction,
+                       typeid_t* type ) noexcept {
+      const strid_t nameId = StringPool::global().intern(name);
+      if( nameId == kInvalidStringId ) {
+        return ErrorCode::E_STRING_POOL_FULL;
+      }
+      if( m_typeNames.find(nameId) != m_typeNames.end() ) {
+        return ErrorCode::E_GRAPH_EXISTING_TYPE;
+      }
+      if( m_types.size() > std::numeric_limits<typeid_t>::max() ) {
+        return ErrorCode::E_GRAPH_TYPE_MAX_NUMBER;
+      }
+      const typeid_t id = static_cast<typeid_t>(m_types.size());
+      m_types.emplace_back();
+      Entry& entry = m_types.back();
+      entry.m_descriptor.m_name = name;
+      entry.m_descriptor.m_nameId = nameId;
+      entry.m_descriptor.m_id = id;
+      entry.m_descriptor.m_isEdgeType = isEdgeType;
+      entry.m_descriptor.m_direction = direction;
+      m_typeNames.emplace(nameId, id);
+      *type = id;
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    static IBaseTable* createTable( const AttributeDataType dataType ) noexcept {
+      switch( dataType ) {
+        case AttributeDataType::E_BOOL:
+          return new Table<bool>();
+        case AttributeDataType::E_INT:
+          return new Table<int32_t>();
+        case AttributeDataType::E_UNSIGNED_INT:
+          return new Table<uint32_t>();
+        case AttributeDataType::E_LONG:
+          return new Table<int64_t>();
+        case AttributeDataType::E_UNSIGNED_LONG:
+          return new Table<uint64_t>();
+        case AttributeDataType::E_FLOAT:
+          return new Table<float>();
+        case AttributeDataType::E_DOUBLE:
+          return new Table<double>();
+        case AttributeDataType::E_STRING:
+          return new Table<std::string>();
+        case AttributeDataType::E_TIMESTAMP:
+          return new Table<timestamp>();
+      }
+      return nullptr;
+    }
+
+    std::vector<Entry>                          m_types;
+    std::unordered_map<strid_t, typeid_t>       m_typeNames;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _DATA_CATALOG_H_ */
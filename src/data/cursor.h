@@ -0,0 +1,250 @@
+
+
+
+#ifndef _DATA_CURSOR_H_
+#define _DATA_CURSOR_H_
+
+#include "../base/platform.h"
+#include "table.h"
+#include "types.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Number of oids requested per batch by the cursor helpers
+ **/
+constexpr uint32_t kCursorBatchSize = 1024;
+
+/**
+ * Invalid object identifier
+ **/
+constexpr oid_t kInvalidOid = UINT64_MAX;
+
+/**
+ * Pull based cursor over the oids produced by a selection. Oids are produced
+ * lazily, one batch at a time, so consumers that stop early (point lookups,
+ * limits) do not pay for the rest of the selection.
+ **/
+class ICursor {
+  public:
+    virtual ~ICursor() noexcept = default;
+
+    /**
+     * Produces the next batch of oids
+     * @param out oids The buffer where the oids are written
+     * @param in capacity The maximum number of oids to write
+     * @return The number of oids written. 0 if the cursor is exhausted.
+     **/
+    virtual uint32_t next( oid_t* oids, const uint32_t capacity ) noexcept = 0;
+};
+
+/**
+ * Scans an attribute column, whose rows are indexed by oid, and produces the
+ * oids whose value satisfies a condition. The condition is evaluated inside
+ * the scan, so no intermediate result is built.
+ **/
+template<typename T>
+class ScanCursor : public ICursor {
+    SMILE_NON_COPYABLE(ScanCursor);
+  public:
+    /**
+     * @param in column The column to scan. Must outlive the cursor.
+     * @param in condition The condition values are compared with
+     * @param in value The value to compare to
+     * @param in first The first oid to scan
+     * @param in last The oid after the last one to scan. Clamped to the
+     * column size.
+     **/
+    ScanCursor( const ITypedTable<T>* column,
+                const Condition condition,
+                const T& value,
+                const oid_t first = 0,
+                const oid_t last = kInvalidOid ) noexcept :
+      p_column(column),
+      m_condition(condition),
+      m_value(value),
+      m_position(first),
+      m_end(std::min<oid_t>(last, column->size())) {
+    }
+    virtual ~ScanCursor() noexcept = default;
+
+    uint32_t next( oid_t* oids, const uint32_t capacity ) noexcept override {
+      uint32_t count = 0;
+      for( ; m_position < m_end && count < capacity; ++m_position ) {
+        if( compareValues(p_column->get(m_position), m_value, m_condition) ) {
+          oids[count++] = m_position;
+        }
+      }
+      return count;
+    }
+
+  private:
+    const ITypedTable<T>* p_column;
+    Condition             m_condition;
+    T                     m_value;
+    oid_t                 m_position;
+    oid_t                 m_end;
+};
+
+/**
+ * Produces oids stored in a vector, such as the elements of an Index entry,
+ * without copying them. The cursor can also own the vector, for oids that
+ * are computed when the cursor is opened.
+ **/
+class VectorCursor : public ICursor {
+    SMILE_NON_COPYABLE(VectorCursor);
+  public:
+    /**
+     * @param in oids The oids to produce. Must outlive the cursor.
+     **/
+    explicit VectorCursor( const std::vector<oid_t>* oids ) noexcept :
+      p_oids(oids) {
+    }
+
+    /**
+     * @param in oids The oids to produce, owned by the cursor
+     **/
+    explicit VectorCursor( std::vector<oid_t>&& oids ) noexcept :
+      m_owned(std::move(oids)),
+      p_oids(&m_owned) {
+    }
+    virtual ~VectorCursor() noexcept = default;
+
+    uint32_t next( oid_t* oids, const uint32_t capacity ) noexcept override {
+      const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(capacity, p_oids->size() - m_position));
+      std::copy(p_oids->begin() + m_position, p_oids->begin() + m_position + count, oids);
+      m_position += count;
+      return count;
+    }
+
+  private:
+    std::vector<oid_t>        m_owned;
+    const std::vector<oid_t>* p_oids;
+    uint64_t                  m_position = 0;
+};
+
+/**
+ * Keeps the oids of another cursor whose value in a column satisfies a
+ * condition. Used to push the remaining predicates of a conjunction down to
+ * the cursor that drives the selection.
+ **/
+template<typename T>
+class FilterCursor : public ICursor {
+    SMILE_NON_COPYABLE(FilterCursor);
+  public:
+    FilterCursor( std::unique_ptr<ICursor> child,
+                  const ITypedTable<T>* column,
+                  const Condition condition,
+                  const T& value ) noexcept :
+      p_child(std::move(child)),
+      p_column(column),
+      m_condition(condition),
+      m_value(value) {
+    }
+    virtual ~FilterCursor() noexcept = default;
+
+    uint32_t next( oid_t* oids, const uint32_t capacity ) noexcept override {
+      // Filtered in place: pull until at least one oid survives
+      uint32_t count = 0;
+      while( count == 0 ) {
+        const uint32_t pulled = p_child->next(oids, capacity);
+        if( pulled == 0 ) {
+          return 0;
+        }
+        for( uint32_t i = 0; i < pulled; ++i ) {
+          const oid_t oid = oids[i];
+          if( oid < p_column->size() && compareValues(p_column->get(oid), m_value, m_condition) ) {
+            oids[count++] = oid;
+          }
+        }
+      }
+      return count;
+    }
+
+  private:
+    std::unique_ptr<ICursor>  p_child;
+    const ITypedTable<T>*     p_column;
+    Condition                 m_condition;
+    T                         m_value;
+};
+
+/**
+ * Produces at most a given number of oids of another cursor. The child is
+ * never asked for more oids than the remaining limit, so scans stop as soon
+ * as the limit is reached.
+ **/
+class LimitCursor : public ICursor {
+    SMILE_NON_COPYABLE(LimitCursor);
+  public:
+    LimitCursor( std::unique_ptr<ICursor> child, const uint64_t limit ) noexcept :
+      p_child(std::move(child)),
+      m_remaining(limit) {
+    }
+    virtual ~LimitCursor() noexcept = default;
+
+    uint32_t next( oid_t* oids, const uint32_t capacity ) noexcept override {
+      if( m_remaining == 0 ) {
+        return 0;
+      }
+      const uint32_t count = p_child->next(oids, static_cast<uint32_t>(std::min<uint64_t>(capacity, m_remaining)));
+      m_remaining -= count;
+      return count;
+    }
+
+  private:
+    std::unique_ptr<ICursor>  p_child;
+    uint64_t                  m_remaining;
+};
+
+/**
+ * Gets the first oid produced by a cursor
+ * @param in cursor The cursor
+ * @return The first oid, or kInvalidOid if the cursor produces nothing
+ **/
+inline oid_t firstOid( ICursor* cursor ) noexcept {
+  oid_t oid = kInvalidOid;
+  cursor->next(&oid, 1);
+  return oid;
+}
+
+/**
+ * Drains a cursor into a table
+ * @param in cursor The cursor to drain
+ * @param out table The table where the oids are appended
+ * @return The number of oids appended
+ **/
+inline uint64_t materialize( ICursor* cursor, ITypedTable<oid_t>* table ) noexcept {
+  oid_t batch[kCursorBatchSize];
+  uint64_t total = 0;
+  uint32_t count = 0;
+  while( (count = cursor->next(batch, kCursorBatchSize)) > 0 ) {
+    table->appendBulk(batch, count);
+    total += count;
+  }
+  return total;
+}
+
+/**
+ * Drains a cursor into a vector
+ * @param in cursor The cursor to drain
+ * @param out oids The vector where the oids are appended
+ * @return The number of oids appended
+ **/
+inline uint64_t materialize( ICursor* cursor, std::vector<oid_t>* oids ) noexcept {
+  const uint64_t first = oids->size();
+  uint32_t count = 0;
+  do {
+    const uint64_t size = oids->size();
+    oids->resize(size + kCursorBatchSize);
+    count = cursor->next(oids->data() + size, kCursorBatchSize);
+    oids->resize(size + count);
+  } while( count > 0 );
+  return oids->size() - first;
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _DATA_CURSOR_H_ */
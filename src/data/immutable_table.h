@@ -0,0 +1,123 @@
+
+
+
+#ifndef _IMMUTABLE_TABLE_H_
+#define _IMMUTABLE_TABLE_H_
+
+#include "../base/platform.h"
+#include "../storage/snapshot.h"
+#include "table.h"
+#include <type_traits>
+
+SMILE_NS_BEGIN
+
+/**
+ * Read only table over an array it does not own, such as a section of a
+ * memory mapped Snapshot. The array must outlive the table.
+ **/
+template<typename T>
+class ImmutableTable : public ITypedTable<T> {
+    SMILE_NON_COPYABLE(ImmutableTable);
+  public:
+    ImmutableTable( const T* data, const uint64_t size ) noexcept :
+      p_data(data),
+      m_size(size) {
+    }
+    virtual ~ImmutableTable() noexcept = default;
+
+    void append(const T&) noexcept override {
+      std::cerr << "WARNING: append on an ImmutableTable should never be called" << std::endl;
+    }
+
+    void appendBulk(const T*, const uint64_t) noexcept override {
+      std::cerr << "WARNING: appendBulk on an ImmutableTable should never be called" << std::endl;
+    }
+
+    void foreach( std::function<void(const T&)> f ) const noexcept override {
+      for(uint64_t i = 0; i < m_size; ++i) {
+        f(p_data[i]);
+      }
+    }
+
+    uint64_t size() const noexcept override {
+      return m_size;
+    }
+
+    uint64_t getCapacity() const noexcept override {
+      return m_size;
+    }
+
+    T get(const uint64_t index) const noexcept override {
+      return p_data[index];
+    }
+
+    void getBulk(const uint64_t first, const uint64_t count, T* vals) const noexcept override {
+      std::copy(p_data + first, p_data + first + count, vals);
+    }
+
+    /**
+     * Gets the elements of the table
+     **/
+    const T* data() const noexcept {
+      return p_data;
+    }
+
+  private:
+    const T*  p_data;
+    uint64_t  m_size;
+};
+
+/**
+ * Writes the elements of a table into a section of a snapshot
+ * @param in writer The snapshot being written
+ * @param in name The name of the section
+ * @param in table The table to write
+ **/
+template<typename T>
+ErrorCode storeTable( SnapshotWriter* writer, const std::string& name, const ITypedTable<T>& table ) noexcept {
+  static_assert(std::is_trivially_copyable<T>::value, "Only tables of trivially copyable types can be stored");
+  ErrorCode error = writer->beginSection(name, sizeof(T));
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  std::vector<T> buffer;
+  buffer.reserve(minCapacity);
+  table.foreach([&]( const T& value ) {
+    buffer.push_back(value);
+    if( buffer.size() == minCapacity && error == ErrorCode::E_NO_ERROR ) {
+      error = writer->append(buffer.data(), buffer.size()*sizeof(T));
+      buffer.clear();
+    }
+  });
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = writer->append(buffer.data(), buffer.size()*sizeof(T));
+  }
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  return writer->endSection();
+}
+
+/**
+ * Opens a table stored in a snapshot, without copying its elements
+ * @param in snapshot The snapshot. Must outlive the table.
+ * @param in name The name of the section
+ * @param out table The table
+ * @return E_STORAGE_UNEXISTING_SECTION if there is no such section and
+ * E_STORAGE_INVALID_SECTION if its elements are not of type T
+ **/
+template<typename T>
+ErrorCode openTable( const Snapshot& snapshot, const std::string& name, std::unique_ptr<ImmutableTable<T>>* table ) noexcept {
+  const T* data = nullptr;
+  uint64_t count = 0;
+  const ErrorCode error = snapshot.section(name, &data, &count);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  table->reset(new ImmutableTable<T>(data, count));
+  return ErrorCode::E_NO_ERROR;
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _IMMUTABLE_TABLE_H_ */
@@ -4,6 +4,7 @@
 #define _INDEX_H_
 
 #include <base/platform.h>
+#include "types.h"
 #include <map>
 #include <vector>
 #include <utility>
@@ -35,6 +36,52 @@ class Index : public IBaseIndex {
       return m_data[attribute];
     }
 
+    /**
+     * Gets the elements whose attribute value satisfies a condition. Elements
+     * are appended by increasing attribute value.
+     * @param in condition The condition attribute values are compared with
+     * @param in attribute The value to compare to
+     * @param out elements The vector where the elements are appended
+     */
+    void getElements( const Condition condition,
+                      const AttributeType& attribute,
+                      std::vector<KeyType>* elements ) const noexcept {
+      auto first = m_data.begin();
+      auto last = m_data.end();
+      switch( condition ) {
+        case Condition::E_EQUALS:
+          first = m_data.lower_bound(attribute);
+          last = m_data.upper_bound(attribute);
+          break;
+        case Condition::E_GREATER:
+          first = m_data.upper_bound(attribute);
+          break;
+        case Condition::E_GREATER_EQUALS:
+          first = m_data.lower_bound(attribute);
+          break;
+        case Condition::E_SMALLER:
+          last = m_data.lower_bound(attribute);
+          break;
+        case Condition::E_SMALLER_EQUALS:
+          last = m_data.upper_bound(attribute);
+          break;
+        case Condition::E_DIFFERENT:
+          break;
+      }
+      for( ; first != last; ++first ) {
+        if( condition != Condition::E_DIFFERENT || first->first != attribute ) {
+          elements->insert(elements->end(), first->second.begin(), first->second.end());
+        }
+      }
+    }
+
+    /**
+     * Gets the number of distinct attribute values
+     */
+    uint64_t size() const noexcept {
+      return m_data.size();
+    }
+
     /** 
      * Inserts an element into the index
      * */
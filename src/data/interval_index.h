@@ -0,0 +1,311 @@
+
+
+
+#ifndef _DATA_INTERVAL_INDEX_H_
+#define _DATA_INTERVAL_INDEX_H_
+
+#include "../base/platform.h"
+#include "table.h"
+#include "types.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Number of inserted intervals kept unsorted before they are indexed
+ **/
+constexpr uint32_t kIntervalBufferSize = 256;
+
+/**
+ * Number of rows read at once from the columns an index is built from
+ **/
+constexpr uint64_t kIntervalBuildBlock = 4096;
+
+/**
+ * Validity interval [m_start, m_end) of an object
+ **/
+template<typename T>
+struct TimeInterval {
+  T     m_start;
+  T     m_end;
+  oid_t m_oid;
+};
+
+/**
+ * Static interval tree. Intervals are sorted by start, and the sorted array
+ * is read as an implicit binary search tree: the node at index i, at the
+ * level given by the number of trailing ones of i, has its children at i -
+ * 2^(level-1) and i + 2^(level-1). Each node keeps the largest end of its
+ * subtree, so subtrees ending before a query are skipped.
+ **/
+template<typename T>
+class IntervalRun {
+  public:
+    /**
+     * Indexes intervals sorted by start
+     **/
+    explicit IntervalRun( std::vector<TimeInterval<T>>&& intervals ) noexcept :
+      m_intervals(std::move(intervals)),
+      m_max(m_intervals.size()),
+      m_numLevels(0) {
+      while( (uint64_t(2) << m_numLevels) <= m_intervals.size() ) {
+        ++m_numLevels;
+      }
+      if( !m_intervals.empty() ) {
+        T max = T();
+        buildMax(root(), m_numLevels, &max);
+      }
+    }
+
+    /**
+     * Calls a function with the intervals overlapping a query. Intervals
+     * overlap if they end after from and startsBefore accepts their start;
+     * startsBefore must accept a prefix of the starts.
+     **/
+    template<typename StartsBefore, typename F>
+    void query( const T& from, StartsBefore startsBefore, F f ) const noexcept {
+      if( !m_intervals.empty() ) {
+        visit(root(), m_numLevels, from, startsBefore, f);
+      }
+    }
+
+    uint64_t size() const noexcept {
+      return m_intervals.size();
+    }
+
+    std::vector<TimeInterval<T>>& intervals() noexcept {
+      return m_intervals;
+    }
+
+  private:
+
+    uint64_t root() const noexcept {
+      return (uint64_t(1) << m_numLevels) - 1;
+    }
+
+    /**
+     * Computes the largest end of the subtrees. Nodes past the last interval
+     * have no value, but may have children with one.
+     * @return Whether the subtree has intervals
+     **/
+    bool buildMax( const uint64_t node, const uint32_t level, T* max ) noexcept {
+      const uint64_t size = m_intervals.size();
+      if( node - ((uint64_t(1) << level) - 1) >= size ) {
+        return false;
+      }
+      bool found = node < size;
+      if( found ) {
+        *max = m_intervals[node].m_end;
+      }
+      if( level > 0 ) {
+        const uint64_t half = uint64_t(1) << (level - 1);
+        T child = T();
+        if( buildMax(node - half, level - 1, &child) ) {
+          *max = found ? std::max(*max, child) : child;
+          found = true;
+        }
+        if( buildMax(node + half, level - 1, &child) ) {
+          *max = found ? std::max(*max, child) : child;
+          found = true;
+        }
+      }
+      if( node < size ) {
+        m_max[node] = *max;
+      }
+      return found;
+    }
+
+    template<typename StartsBefore, typename F>
+    void visit( const uint64_t node,
+                const uint32_t level,
+                const T& from,
+                StartsBefore& startsBefore,
+                F& f ) const noexcept {
+      const uint64_t size = m_intervals.size();
+      const uint64_t first = node - ((uint64_t(1) << level) - 1);
+      if( first >= size ) {
+        return;
+      }
+      if( level <= 2 ) {
+        // Small subtrees are scanned
+        const uint64_t last = std::min(node + (uint64_t(1) << level), size);
+        for( uint64_t i = first; i < last && startsBefore(m_intervals[i].m_start); ++i ) {
+          if( from < m_intervals[i].m_end ) {
+            f(m_intervals[i]);
+          }
+        }
+        return;
+      }
+      const uint64_t half = uint64_t(1) << (level - 1);
+      if( node - half >= size || from < m_max[node - half] ) {
+        visit(node - half, level - 1, from, startsBefore, f);
+      }
+      if( node >= size || !startsBefore(m_intervals[node].m_start) ) {
+        return;
+      }
+      if( from < m_intervals[node].m_end ) {
+        f(m_intervals[node]);
+      }
+      if( node + half >= size || from < m_max[node + half] ) {
+        visit(node + half, level - 1, from, startsBefore, f);
+      }
+    }
+
+    std::vector<TimeInterval<T>>  m_intervals;
+    std::vector<T>                m_max;
+    uint32_t                      m_numLevels;
+};
+
+/**
+ * Index of the validity intervals [start, end) of objects, given by a pair of
+ * timestamp attributes. Answers stabbing queries (intervals containing a
+ * time) and overlap queries (intervals intersecting a window) in logarithmic
+ * time plus the size of the result. Empty intervals are not indexed.
+ *
+ * Bulk built intervals form a single static interval tree. Inserted
+ * intervals are buffered and then indexed in runs whose sizes are distinct
+ * powers of two: a new run is merged with the runs not larger than it, as in
+ * a binary counter, so inserts cost a logarithmic amortized time and queries
+ * visit a logarithmic number of runs.
+ **/
+template<typename T>
+class IntervalIndex {
+    SMILE_NON_COPYABLE(IntervalIndex);
+  public:
+    IntervalIndex() noexcept = default;
+    ~IntervalIndex() noexcept = default;
+
+    /**
+     * Indexes intervals, replacing the indexed ones
+     * @param in intervals The intervals
+     **/
+    void build( std::vector<TimeInterval<T>> intervals ) noexcept {
+      m_runs.clear();
+      m_buffer.clear();
+      intervals.erase(std::remove_if(intervals.begin(), intervals.end(), []( const TimeInterval<T>& interval ) {
+        return !(interval.m_start < interval.m_end);
+      }), intervals.end());
+      sortByStart(&intervals);
+      if( !intervals.empty() ) {
+        m_runs.emplace_back(new IntervalRun<T>(std::move(intervals)));
+      }
+    }
+
+    /**
+     * Indexes the intervals given by two columns indexed by oid, replacing
+     * the indexed ones
+     * @param in starts The start of the interval of each oid
+     * @param in ends The end of the interval of each oid. Must have the size
+     * of starts.
+     **/
+    void build( const ITypedTable<T>& starts, const ITypedTable<T>& ends ) noexcept {
+      const uint64_t size = starts.size();
+      std::vector<TimeInterval<T>> intervals(size);
+      std::unique_ptr<T[]> buffer(new T[kIntervalBuildBlock]);
+      for( uint64_t first = 0; first < size; first += kIntervalBuildBlock ) {
+        const uint64_t count = std::min(kIntervalBuildBlock, size - first);
+        starts.getBulk(first, count, buffer.get());
+        for( uint64_t i = 0; i < count; ++i ) {
+          intervals[first + i].m_start = buffer[i];
+          intervals[first + i].m_oid = first + i;
+        }
+        ends.getBulk(first, count, buffer.get());
+        for( uint64_t i = 0; i < count; ++i ) {
+          intervals[first + i].m_end = buffer[i];
+        }
+      }
+      build(std::move(intervals));
+    }
+
+    /**
+     * Inserts the interval of an object
+     * @param in start The start of the interval
+     * @param in end The end of the interval, excluded
+     * @param in oid The object
+     **/
+    void insert( const T& start, const T& end, const oid_t oid ) noexcept {
+      if( !(start < end) ) {
+        return;
+      }
+      m_buffer.push_back(TimeInterval<T>{start, end, oid});
+      if( m_buffer.size() < kIntervalBufferSize ) {
+        return;
+      }
+      std::vector<TimeInterval<T>> intervals;
+      intervals.swap(m_buffer);
+      sortByStart(&intervals);
+      while( !m_runs.empty() && m_runs.back()->size() <= intervals.size() ) {
+        std::vector<TimeInterval<T>>& run = m_runs.back()->intervals();
+        std::vector<TimeInterval<T>> merged(run.size() + intervals.size());
+        std::merge(run.begin(), run.end(), intervals.begin(), intervals.end(), merged.begin(), startsBefore);
+        intervals.swap(merged);
+        m_runs.pop_back();
+      }
+      m_runs.emplace_back(new IntervalRun<T>(std::move(intervals)));
+    }
+
+    /**
+     * Gets the objects whose interval contains a time
+     * @param in time The time
+     * @param out oids The vector where the oids are appended
+     **/
+    void stab( const T& time, std::vector<oid_t>* oids ) const noexcept {
+      query(time, [&]( const T& start ) { return !(time < start); }, oids);
+    }
+
+    /**
+     * Gets the objects whose interval overlaps a window [from, to)
+     * @param in from The start of the window
+     * @param in to The end of the window, excluded
+     * @param out oids The vector where the oids are appended
+     **/
+    void overlap( const T& from, const T& to, std::vector<oid_t>* oids ) const noexcept {
+      query(from, [&]( const T& start ) { return start < to; }, oids);
+    }
+
+    /**
+     * Gets the number of indexed intervals
+     **/
+    uint64_t size() const noexcept {
+      uint64_t size = m_buffer.size();
+      for( const std::unique_ptr<IntervalRun<T>>& run : m_runs ) {
+        size += run->size();
+      }
+      return size;
+    }
+
+  private:
+
+    static bool startsBefore( const TimeInterval<T>& a, const TimeInterval<T>& b ) noexcept {
+      return a.m_start < b.m_start;
+    }
+
+    static void sortByStart( std::vector<TimeInterval<T>>* intervals ) noexcept {
+      std::sort(intervals->begin(), intervals->end(), startsBefore);
+    }
+
+    template<typename StartsBefore>
+    void query( const T& from, StartsBefore startsBefore, std::vector<oid_t>* oids ) const noexcept {
+      auto append = [&]( const TimeInterval<T>& interval ) {
+        oids->push_back(interval.m_oid);
+      };
+      for( const std::unique_ptr<IntervalRun<T>>& run : m_runs ) {
+        run->query(from, startsBefore, append);
+      }
+      for( const TimeInterval<T>& interval : m_buffer ) {
+        if( startsBefore(interval.m_start) && from < interval.m_end ) {
+          append(interval);
+        }
+      }
+    }
+
+    // Runs by decreasing size
+    std::vector<std::unique_ptr<IntervalRun<T>>>  m_runs;
+    std::vector<TimeInterval<T>>                  m_buffer;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _DATA_INTERVAL_INDEX_H_ */
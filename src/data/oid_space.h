@@ -0,0 +1,259 @@
+
+
+
+#ifndef _DATA_OID_SPACE_H_
+#define _DATA_OID_SPACE_H_
+
+#include "../base/platform.h"
+#include "../base/error.h"
+#include "cursor.h"
+#include "table.h"
+#include "types.h"
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Oids carry the type of their object in their most significant bits, and a
+ * dense per type local id in the rest. The oids of a type are therefore a
+ * contiguous range, and type checks are range comparisons.
+ **/
+constexpr uint32_t  kOidTypeShift = 8*(sizeof(oid_t) - sizeof(typeid_t));
+constexpr oid_t     kOidLocalMask = (oid_t(1) << kOidTypeShift) - 1;
+constexpr uint32_t  kMaxNumTypes  = std::numeric_limits<typeid_t>::max() + 1;
+
+inline oid_t makeOid( const typeid_t type, const uint64_t local ) noexcept {
+  return (static_cast<oid_t>(type) << kOidTypeShift) | local;
+}
+
+inline typeid_t oidType( const oid_t oid ) noexcept {
+  return static_cast<typeid_t>(oid >> kOidTypeShift);
+}
+
+inline uint64_t oidLocal( const oid_t oid ) noexcept {
+  return oid & kOidLocalMask;
+}
+
+/**
+ * Range [m_first, m_last) of oids
+ **/
+struct OidRange {
+  oid_t m_first = 0;
+  oid_t m_last  = 0;
+
+  uint64_t size() const noexcept {
+    return m_last - m_first;
+  }
+
+  bool contains( const oid_t oid ) const noexcept {
+    return oid >= m_first && oid < m_last;
+  }
+};
+
+/**
+ * Allocates oids from a separate dense id space per type
+ **/
+class OidSpace {
+  public:
+    OidSpace() noexcept :
+      m_counts(kMaxNumTypes, 0) {
+    }
+    ~OidSpace() noexcept = default;
+
+    /**
+     * Allocates a range of consecutive oids of a type
+     * @param in type The type of the objects
+     * @param in count The number of oids to allocate
+     * @param out range The allocated oids
+     * @return E_GRAPH_TYPE_MAX_NUMBER if the id space of the type is
+     * exhausted
+     **/
+    ErrorCode allocate( const typeid_t type, const uint64_t count, OidRange* range ) noexcept {
+      uint64_t& allocated = m_counts[type];
+      if( count > kOidLocalMask + 1 - allocated ) {
+        return ErrorCode::E_GRAPH_TYPE_MAX_NUMBER;
+      }
+      range->m_first = makeOid(type, allocated);
+      range->m_last = range->m_first + count;
+      allocated += count;
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Allocates an oid of a type
+     * @param in type The type of the object
+     * @param out oid The allocated oid
+     * @return E_GRAPH_TYPE_MAX_NUMBER if the id space of the type is
+     * exhausted
+     **/
+    ErrorCode allocate( const typeid_t type, oid_t* oid ) noexcept {
+      OidRange range;
+      const ErrorCode error = allocate(type, 1, &range);
+      *oid = range.m_first;
+      return error;
+    }
+
+    /**
+     * Gets the range of the oids allocated to a type
+     **/
+    OidRange range( const typeid_t type ) const noexcept {
+      OidRange range;
+      range.m_first = makeOid(type, 0);
+      range.m_last = range.m_first + m_counts[type];
+      return range;
+    }
+
+    /**
+     * Gets the number of oids allocated to a type
+     **/
+    uint64_t count( const typeid_t type ) const noexcept {
+      return m_counts[type];
+    }
+
+    /**
+     * Checks whether an oid has been allocated
+     **/
+    bool exists( const oid_t oid ) const noexcept {
+      return oidLocal(oid) < m_counts[oidType(oid)];
+    }
+
+  private:
+    std::vector<uint64_t> m_counts;
+};
+
+/**
+ * Produces all the oids of a range
+ **/
+class RangeCursor : public ICursor {
+    SMILE_NON_COPYABLE(RangeCursor);
+  public:
+    explicit RangeCursor( const OidRange& range ) noexcept :
+      m_range(range) {
+    }
+    virtual ~RangeCursor() noexcept = default;
+
+    uint32_t next( oid_t* oids, const uint32_t capacity ) noexcept override {
+      const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(capacity, m_range.size()));
+      for( uint32_t i = 0; i < count; ++i ) {
+        oids[i] = m_range.m_first + i;
+      }
+      m_range.m_first += count;
+      return count;
+    }
+
+  private:
+    OidRange  m_range;
+};
+
+/**
+ * Translates the local ids produced by a cursor over a type partition into
+ * oids of the type
+ **/
+class TypeCursor : public ICursor {
+    SMILE_NON_COPYABLE(TypeCursor);
+  public:
+    TypeCursor( std::unique_ptr<ICursor> child, const typeid_t type ) noexcept :
+      p_child(std::move(child)),
+      m_base(makeOid(type, 0)) {
+    }
+    virtual ~TypeCursor() noexcept = default;
+
+    uint32_t next( oid_t* oids, const uint32_t capacity ) noexcept override {
+      const uint32_t count = p_child->next(oids, capacity);
+      for( uint32_t i = 0; i < count; ++i ) {
+        oids[i] += m_base;
+      }
+      return count;
+    }
+
+  private:
+    std::unique_ptr<ICursor>  p_child;
+    oid_t                     m_base;
+};
+
+/**
+ * Attribute partitioned by type: the values of each type are stored in
+ * their own table, indexed by local id. Scans of a type only read its
+ * partition, sequentially.
+ **/
+template<typename T>
+class PartitionedTable {
+    SMILE_NON_COPYABLE(PartitionedTable);
+  public:
+    PartitionedTable() noexcept :
+      m_partitions(kMaxNumTypes) {
+    }
+    ~PartitionedTable() noexcept = default;
+
+    /**
+     * Sets the value of the next object of a type. Objects of a type must
+     * be set in the order their oids were allocated.
+     * @param in oid The oid of the object
+     * @param in value The value of the attribute
+     * @return E_GRAPH_UNEXISTING_OBJECT if the oid is not the next one of
+     * its type
+     **/
+    ErrorCode append( const oid_t oid, const T& value ) noexcept {
+      std::unique_ptr<Table<T>>& partition = m_partitions[oidType(oid)];
+      if( !partition ) {
+        partition.reset(new Table<T>());
+      }
+      if( oidLocal(oid) != partition->size() ) {
+        return ErrorCode::E_GRAPH_UNEXISTING_OBJECT;
+      }
+      partition->append(value);
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Gets the value of an object
+     * @param in oid The oid of the object
+     * @param out value The value of the attribute
+     * @return E_GRAPH_UNEXISTING_OBJECT if the object has no value
+     **/
+    ErrorCode get( const oid_t oid, T* value ) const noexcept {
+      const Table<T>* partition = m_partitions[oidType(oid)].get();
+      if( partition == nullptr || oidLocal(oid) >= partition->size() ) {
+        return ErrorCode::E_GRAPH_UNEXISTING_OBJECT;
+      }
+      *value = partition->get(oidLocal(oid));
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Gets the partition of a type, indexed by local id
+     * @return The partition, or nullptr if no object of the type has a value
+     **/
+    const ITypedTable<T>* partition( const typeid_t type ) const noexcept {
+      return m_partitions[type].get();
+    }
+
+    /**
+     * Opens a scan of the objects of a type whose value satisfies a
+     * condition
+     * @param in type The type of the objects
+     * @param in condition The condition values are compared with
+     * @param in value The value to compare to
+     * @return The cursor over the oids of the objects
+     **/
+    std::unique_ptr<ICursor> scan( const typeid_t type,
+                                   const Condition condition,
+                                   const T& value ) const noexcept {
+      const Table<T>* partition = m_partitions[type].get();
+      if( partition == nullptr ) {
+        return std::unique_ptr<ICursor>(new RangeCursor(OidRange()));
+      }
+      std::unique_ptr<ICursor> scan(new ScanCursor<T>(partition, condition, value));
+      return std::unique_ptr<ICursor>(new TypeCursor(std::move(scan), type));
+    }
+
+  private:
+    std::vector<std::unique_ptr<Table<T>>> m_partitions;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _DATA_OID_SPACE_H_ */
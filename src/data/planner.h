@@ -0,0 +1,373 @@
+
+
+
+#ifndef _DATA_PLANNER_H_
+#define _DATA_PLANNER_H_
+
+#include "../base/platform.h"
+#include "bitmap.h"
+#include "cursor.h"
+#include "index.h"
+#include "statistics.h"
+#include "table.h"
+#include "types.h"
+#include "zone_map.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+enum class AccessPath {
+  E_FULL_SCAN,
+  E_ZONE_MAP_SCAN,
+  E_HASH_INDEX,
+  E_ORDERED_INDEX,
+  E_BITMAP_INTERSECTION
+};
+
+enum class IndexKind {
+  E_NONE,
+  E_HASH,
+  E_ORDERED
+};
+
+/**
+ * Relative costs of the operations of a selection, in units of a sequential
+ * row comparison
+ **/
+struct CostModel {
+  /**
+   * Cost of comparing a row during a scan
+   */
+  double  m_scanRowCost     = 1.0;
+
+  /**
+   * Cost of fetching and comparing the value of an oid produced by another
+   * access path
+   */
+  double  m_fetchRowCost    = 4.0;
+
+  /**
+   * Cost of looking up a key in an index
+   */
+  double  m_indexProbeCost  = 50.0;
+
+  /**
+   * Cost of reading an oid from an index entry
+   */
+  double  m_indexRowCost    = 1.0;
+
+  /**
+   * Cost of setting or intersecting the bit of a row in a bitmap
+   */
+  double  m_bitmapRowCost   = 1.0/64.0;
+};
+
+/**
+ * A condition on an attribute, together with the access structures
+ * available to evaluate it
+ **/
+class IPredicate {
+  public:
+    virtual ~IPredicate() noexcept = default;
+
+    /**
+     * Gets the number of rows of the attribute
+     **/
+    virtual uint64_t numRows() const noexcept = 0;
+
+    /**
+     * Estimates the fraction of rows satisfying the predicate
+     **/
+    virtual double selectivity() const noexcept = 0;
+
+    /**
+     * Gets the fraction of rows a zone map pruned scan reads, or a negative
+     * value if the attribute has no zone map
+     **/
+    virtual double zoneFraction() const noexcept = 0;
+
+    /**
+     * Gets the kind of index that can evaluate the predicate. Hash indexes
+     * only evaluate equalities, and no index evaluates inequalities.
+     **/
+    virtual IndexKind indexKind() const noexcept = 0;
+
+    /**
+     * Opens a scan of the attribute, optionally pruned by its zone map
+     **/
+    virtual std::unique_ptr<ICursor> scan( const bool pruned ) const noexcept = 0;
+
+    /**
+     * Gets the oids satisfying the predicate from the index
+     * @param out oids The vector where the oids are appended
+     **/
+    virtual void lookup( std::vector<oid_t>* oids ) const noexcept = 0;
+
+    /**
+     * Keeps the oids of a cursor satisfying the predicate
+     **/
+    virtual std::unique_ptr<ICursor> filter( std::unique_ptr<ICursor> child ) const noexcept = 0;
+};
+
+/**
+ * Predicate on a column, indexed by oid. Without statistics, textbook
+ * default selectivities are assumed.
+ **/
+template<typename T>
+class ColumnPredicate : public IPredicate {
+    SMILE_NON_COPYABLE(ColumnPredicate);
+  public:
+    /**
+     * @param in column The column. Must outlive the predicate.
+     * @param in condition The condition values are compared with
+     * @param in value The value to compare to
+     * @param in statistics The statistics of the column, or nullptr
+     * @param in zoneMap The zone map of the column, or nullptr
+     * @param in index The index of the column, or nullptr
+     * @param in indexKind How the index is organized
+     **/
+    ColumnPredicate( const ITypedTable<T>* column,
+                     const Condition condition,
+                     const T& value,
+                     const AttributeStatistics* statistics = nullptr,
+                     const ZoneMap<T>* zoneMap = nullptr,
+                     const Index<T, oid_t>* index = nullptr,
+                     const IndexKind indexKind = IndexKind::E_ORDERED ) noexcept :
+      p_column(column),
+      m_condition(condition),
+      m_value(value),
+      p_statistics(statistics),
+      p_zoneMap(zoneMap),
+      p_index(index),
+      m_indexKind(index != nullptr ? indexKind : IndexKind::E_NONE) {
+    }
+    virtual ~ColumnPredicate() noexcept = default;
+
+    uint64_t numRows() const noexcept override {
+      return p_column->size();
+    }
+
+    double selectivity() const noexcept override {
+      if( p_statistics != nullptr ) {
+        return p_statistics->selectivity(m_condition, StatisticsTraits<T>::toDouble(m_value));
+      }
+      switch( m_condition ) {
+        case Condition::E_EQUALS:
+          return 0.005;
+        case Condition::E_DIFFERENT:
+          return 0.995;
+        default:
+          return 1.0 / 3.0;
+      }
+    }
+
+    double zoneFraction() const noexcept override {
+      if( p_zoneMap == nullptr ) {
+        return -1.0;
+      }
+      // The rows appended after the zone map was built are always read
+      const uint64_t numRows = p_column->size();
+      if( numRows == 0 ) {
+        return 1.0;
+      }
+      const uint64_t covered = std::min(p_zoneMap->numRows(), numRows);
+      const double fraction = p_zoneMap->candidateFraction(m_condition, m_value);
+      return (fraction * covered + (numRows - covered)) / numRows;
+    }
+
+    IndexKind indexKind() const noexcept override {
+      if( m_indexKind == IndexKind::E_HASH && m_condition != Condition::E_EQUALS ) {
+        return IndexKind::E_NONE;
+      }
+      return m_condition == Condition::E_DIFFERENT ? IndexKind::E_NONE : m_indexKind;
+    }
+
+    std::unique_ptr<ICursor> scan( const bool pruned ) const noexcept override {
+      if( pruned && p_zoneMap != nullptr ) {
+        return std::unique_ptr<ICursor>(new ZoneMapCursor<T>(p_column, p_zoneMap, m_condition, m_value));
+      }
+      return std::unique_ptr<ICursor>(new ScanCursor<T>(p_column, m_condition, m_value));
+    }
+
+    void lookup( std::vector<oid_t>* oids ) const noexcept override {
+      p_index->getElements(m_condition, m_value, oids);
+    }
+
+    std::unique_ptr<ICursor> filter( std::unique_ptr<ICursor> child ) const noexcept override {
+      return std::unique_ptr<ICursor>(new FilterCursor<T>(std::move(child), p_column, m_condition, m_value));
+    }
+
+  private:
+    const ITypedTable<T>*       p_column;
+    Condition                   m_condition;
+    T                           m_value;
+    const AttributeStatistics*  p_statistics;
+    const ZoneMap<T>*           p_zoneMap;
+    const Index<T, oid_t>*      p_index;
+    IndexKind                   m_indexKind;
+};
+
+/**
+ * Plan of a conjunctive selection: the access path producing the candidate
+ * oids from one or more driving predicates, and the remaining predicates,
+ * applied as filters by increasing selectivity.
+ **/
+struct SelectionPlan {
+  AccessPath            m_path = AccessPath::E_FULL_SCAN;
+  std::vector<uint32_t> m_drivers;
+  std::vector<uint32_t> m_filters;
+
+  /**
+   * Estimated cost and number of resulting rows
+   **/
+  double                m_cost = 0.0;
+  double                m_rows = 0.0;
+};
+
+/**
+ * Chooses the cheapest plan of a conjunction of predicates on attributes of
+ * the same rows. Every access path applicable to each predicate is costed
+ * (full scan, zone map pruned scan, index lookup), and also the intersection
+ * of the index results of the most selective indexed predicates as bitmaps.
+ * The rest of the predicates are evaluated by increasing selectivity on the
+ * candidates of the access path.
+ * @param in predicates The predicates of the conjunction. Must not be empty.
+ * @param in model The costs of the operations
+ * @return The plan with the smallest estimated cost
+ **/
+inline SelectionPlan planSelection( const std::vector<const IPredicate*>& predicates,
+                                    const CostModel& model = CostModel() ) noexcept {
+  assert(!predicates.empty() && "A selection needs at least a predicate");
+  const uint32_t numPredicates = static_cast<uint32_t>(predicates.size());
+  const double numRows = static_cast<double>(predicates[0]->numRows());
+  std::vector<double> selectivities(numPredicates);
+  std::vector<uint32_t> bySelectivity(numPredicates);
+  for( uint32_t i = 0; i < numPredicates; ++i ) {
+    selectivities[i] = predicates[i]->selectivity();
+    bySelectivity[i] = i;
+  }
+  std::stable_sort(bySelectivity.begin(), bySelectivity.end(), [&]( const uint32_t a, const uint32_t b ) {
+    return selectivities[a] < selectivities[b];
+  });
+
+  SelectionPlan best;
+  best.m_cost = std::numeric_limits<double>::infinity();
+  // Completes a plan with the filters of the predicates not driving it
+  auto consider = [&]( const AccessPath path,
+                       const std::vector<uint32_t>& drivers,
+                       double cost,
+                       double rows ) {
+    std::vector<uint32_t> filters;
+    for( const uint32_t predicate : bySelectivity ) {
+      if( std::find(drivers.begin(), drivers.end(), predicate) == drivers.end() ) {
+        cost += rows * model.m_fetchRowCost;
+        rows *= selectivities[predicate];
+        filters.push_back(predicate);
+      }
+    }
+    if( cost < best.m_cost ) {
+      best.m_path = path;
+      best.m_drivers = drivers;
+      best.m_filters = std::move(filters);
+      best.m_cost = cost;
+      best.m_rows = rows;
+    }
+  };
+
+  for( const uint32_t i : bySelectivity ) {
+    const IPredicate* predicate = predicates[i];
+    const double rows = numRows * selectivities[i];
+    consider(AccessPath::E_FULL_SCAN, {i}, numRows * model.m_scanRowCost, rows);
+    const double zoneFraction = predicate->zoneFraction();
+    if( zoneFraction >= 0.0 ) {
+      consider(AccessPath::E_ZONE_MAP_SCAN, {i}, numRows * zoneFraction * model.m_scanRowCost, rows);
+    }
+    const IndexKind indexKind = predicate->indexKind();
+    if( indexKind != IndexKind::E_NONE ) {
+      consider(indexKind == IndexKind::E_HASH ? AccessPath::E_HASH_INDEX : AccessPath::E_ORDERED_INDEX,
+               {i}, model.m_indexProbeCost + rows * model.m_indexRowCost, rows);
+    }
+  }
+
+  // Intersections of the k most selective indexed predicates, k >= 2
+  std::vector<uint32_t> drivers;
+  double cost = 0.0;
+  double rows = numRows;
+  for( const uint32_t i : bySelectivity ) {
+    if( predicates[i]->indexKind() == IndexKind::E_NONE ) {
+      continue;
+    }
+    drivers.push_back(i);
+    cost += model.m_indexProbeCost + numRows * selectivities[i] * model.m_indexRowCost +
+            numRows * model.m_bitmapRowCost;
+    rows *= selectivities[i];
+    if( drivers.size() >= 2 ) {
+      consider(AccessPath::E_BITMAP_INTERSECTION, drivers, cost, rows);
+    }
+  }
+  return best;
+}
+
+/**
+ * Opens a cursor evaluating a selection plan
+ * @param in plan The plan, computed by planSelection
+ * @param in predicates The predicates the plan was computed for. Must
+ * outlive the cursor.
+ * @return The cursor over the oids satisfying all the predicates
+ **/
+inline std::unique_ptr<ICursor> openSelection( const SelectionPlan& plan,
+                                               const std::vector<const IPredicate*>& predicates ) noexcept {
+  std::unique_ptr<ICursor> cursor;
+  const IPredicate* driver = predicates[plan.m_drivers[0]];
+  switch( plan.m_path ) {
+    case AccessPath::E_FULL_SCAN:
+    case AccessPath::E_ZONE_MAP_SCAN:
+      cursor = driver->scan(plan.m_path == AccessPath::E_ZONE_MAP_SCAN);
+      break;
+    case AccessPath::E_HASH_INDEX:
+    case AccessPath::E_ORDERED_INDEX: {
+      std::vector<oid_t> oids;
+      driver->lookup(&oids);
+      cursor.reset(new VectorCursor(std::move(oids)));
+      break;
+    }
+    case AccessPath::E_BITMAP_INTERSECTION: {
+      Bitmap result;
+      Bitmap bitmap;
+      std::vector<oid_t> oids;
+      bool first = true;
+      for( const uint32_t index : plan.m_drivers ) {
+        oids.clear();
+        predicates[index]->lookup(&oids);
+        // Sorted oids are appended to the containers of the bitmap
+        std::sort(oids.begin(), oids.end());
+        Bitmap& target = first ? result : bitmap;
+        target.clear();
+        for( const oid_t oid : oids ) {
+          target.add(oid);
+        }
+        if( !first ) {
+          result.intersect(bitmap);
+        }
+        first = false;
+        if( result.empty() ) {
+          break;
+        }
+      }
+      cursor.reset(new BitmapCursor(std::move(result)));
+      break;
+    }
+  }
+  for( const uint32_t index : plan.m_filters ) {
+    cursor = predicates[index]->filter(std::move(cursor));
+  }
+  return cursor;
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _DATA_PLANNER_H_ */
@@ -0,0 +1,466 @@
+
+
+
+#ifndef _DATA_STATISTICS_H_
+#define _DATA_STATISTICS_H_
+
+#include "../base/platform.h"
+#include "table.h"
+#include "types.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+struct StatisticsConfig {
+  /**
+   * Number of buckets of the equi-depth histogram
+   */
+  uint32_t  m_numBuckets      = 64;
+
+  /**
+   * Maximum number of most common values kept
+   */
+  uint32_t  m_numMostCommon   = 16;
+
+  /**
+   * Number of values kept in the reservoir sample the histogram and the most
+   * common values are computed from. Attributes with fewer rows are exact.
+   */
+  uint32_t  m_sampleSize      = 64*1024;
+
+  /**
+   * Base 2 logarithm of the number of HyperLogLog registers
+   */
+  uint32_t  m_precision       = 12;
+
+  /**
+   * Seed of the reservoir sampling
+   */
+  uint64_t  m_seed            = 0;
+};
+
+/**
+ * Mixes the bits of a 64 bit value (SplitMix64 finalizer)
+ **/
+inline uint64_t mixStatisticsHash( uint64_t x ) noexcept {
+  x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ULL;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/**
+ * Maps the values of an attribute type to the domain statistics are kept in.
+ * Numeric, boolean and timestamp values are ordered as doubles; strings only
+ * get row and distinct counts.
+ **/
+template<typename T>
+struct StatisticsTraits {
+  static constexpr bool ordered = true;
+
+  static double toDouble( const T& value ) noexcept {
+    return static_cast<double>(value);
+  }
+
+  static uint64_t hash( const T& value ) noexcept {
+    const double real = toDouble(value);
+    uint64_t bits;
+    memcpy(&bits, &real, sizeof(bits));
+    return mixStatisticsHash(bits);
+  }
+};
+
+template<>
+struct StatisticsTraits<timestamp> {
+  static constexpr bool ordered = true;
+
+  static double toDouble( const timestamp& value ) noexcept {
+    return static_cast<double>(value.val);
+  }
+
+  static uint64_t hash( const timestamp& value ) noexcept {
+    return mixStatisticsHash(value.val);
+  }
+};
+
+template<>
+struct StatisticsTraits<std::string> {
+  static constexpr bool ordered = false;
+
+  static double toDouble( const std::string& ) noexcept {
+    return 0.0;
+  }
+
+  // FNV-1a, so estimates are the same across runs and platforms
+  static uint64_t hash( const std::string& value ) noexcept {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for( const char c : value ) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ULL;
+    }
+    return mixStatisticsHash(hash);
+  }
+};
+
+/**
+ * HyperLogLog sketch of the number of distinct values of a multiset. Uses
+ * 2^precision one byte registers, with a standard error of about
+ * 1.04/sqrt(2^precision). Sketches of disjoint parts of a column can be
+ * merged.
+ **/
+class HyperLogLog {
+  public:
+    /**
+     * @param in precision Base 2 logarithm of the number of registers, in
+     * [4, 18]
+     **/
+    explicit HyperLogLog( const uint32_t precision = 12 ) noexcept :
+      m_precision(std::min<uint32_t>(std::max<uint32_t>(precision, 4), 18)),
+      m_registers(1ULL << m_precision, 0) {
+    }
+
+    /**
+     * Adds a hashed value
+     * @param in hash The 64 bit hash of the value
+     **/
+    void add( const uint64_t hash ) noexcept {
+      const uint64_t index = hash >> (64 - m_precision);
+      // Rank of the first set bit of the remaining bits. The sentinel bit
+      // bounds the rank when all of them are zero.
+      const uint64_t rest = (hash << m_precision) | (1ULL << (m_precision - 1));
+      const uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+      m_registers[index] = std::max(m_registers[index], rank);
+    }
+
+    /**
+     * Merges a sketch with the same precision into this one
+     **/
+    void merge( const HyperLogLog& other ) noexcept {
+      assert(other.m_precision == m_precision && "Merged sketches must have the same precision");
+      for( size_t i = 0; i < m_registers.size(); ++i ) {
+        m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+      }
+    }
+
+    /**
+     * Estimates the number of distinct values added
+     **/
+    double estimate() const noexcept {
+      const double m = static_cast<double>(m_registers.size());
+      double sum = 0.0;
+      uint64_t zeros = 0;
+      for( const uint8_t rank : m_registers ) {
+        sum += std::ldexp(1.0, -rank);
+        zeros += rank == 0 ? 1 : 0;
+      }
+      const double alpha = 0.7213 / (1.0 + 1.079 / m);
+      const double raw = alpha * m * m / sum;
+      // Linear counting is more accurate for small cardinalities
+      if( raw <= 2.5 * m && zeros > 0 ) {
+        return m * std::log(m / static_cast<double>(zeros));
+      }
+      return raw;
+    }
+
+  private:
+    uint32_t              m_precision;
+    std::vector<uint8_t>  m_registers;
+};
+
+/**
+ * Statistics of an attribute: row count, distinct count, bounds, an
+ * equi-depth histogram and the most common values, used to estimate the
+ * selectivity of conditions.
+ **/
+struct AttributeStatistics {
+
+  /**
+   * Number of rows of the attribute
+   **/
+  uint64_t                            m_numRows = 0;
+
+  /**
+   * Estimated number of distinct values
+   **/
+  double                              m_numDistinct = 0.0;
+
+  /**
+   * Whether the values are ordered. Unordered attributes (strings) have no
+   * bounds, histogram nor most common values.
+   **/
+  bool                                m_ordered = true;
+
+  /**
+   * Smallest and largest value
+   **/
+  double                              m_min = 0.0;
+  double                              m_max = 0.0;
+
+  /**
+   * Histogram bucket bounds: bucket i holds the values in (m_bounds[i],
+   * m_bounds[i+1]], the first one also m_bounds[0]. m_cumulative[i] is the
+   * fraction of rows with a value smaller or equal to m_bounds[i].
+   **/
+  std::vector<double>                 m_bounds;
+  std::vector<double>                 m_cumulative;
+
+  /**
+   * Most common values and the fraction of rows holding each of them, by
+   * decreasing frequency
+   **/
+  std::vector<std::pair<double, double>> m_mostCommon;
+
+  /**
+   * Estimates the fraction of rows whose value satisfies a condition
+   * @param in condition The condition values are compared with
+   * @param in value The value to compare to
+   * @return The estimated selectivity, in [0, 1]
+   **/
+  double selectivity( const Condition condition, const double value ) const noexcept {
+    if( m_numRows == 0 ) {
+      return 0.0;
+    }
+    double result = 0.0;
+    switch( condition ) {
+      case Condition::E_EQUALS:
+        result = equals(value);
+        break;
+      case Condition::E_DIFFERENT:
+        result = 1.0 - equals(value);
+        break;
+      case Condition::E_SMALLER:
+        result = smaller(value);
+        break;
+      case Condition::E_SMALLER_EQUALS:
+        result = smaller(value) + equals(value);
+        break;
+      case Condition::E_GREATER:
+        result = 1.0 - smaller(value) - equals(value);
+        break;
+      case Condition::E_GREATER_EQUALS:
+        result = 1.0 - smaller(value);
+        break;
+    }
+    return std::min(std::max(result, 0.0), 1.0);
+  }
+
+  /**
+   * Estimates the number of rows whose value satisfies a condition
+   **/
+  double cardinality( const Condition condition, const double value ) const noexcept {
+    return selectivity(condition, value) * static_cast<double>(m_numRows);
+  }
+
+  /**
+   * Estimates the fraction of rows equal to a value. Values that are not
+   * among the most common ones share the remaining rows uniformly.
+   **/
+  double equals( const double value ) const noexcept {
+    const double distinct = std::max(m_numDistinct, 1.0);
+    if( !m_ordered ) {
+      return 1.0 / distinct;
+    }
+    if( value < m_min || value > m_max ) {
+      return 0.0;
+    }
+    double common = 0.0;
+    for( const std::pair<double, double>& entry : m_mostCommon ) {
+      if( entry.first == value ) {
+        return entry.second;
+      }
+      common += entry.second;
+    }
+    const double others = distinct - static_cast<double>(m_mostCommon.size());
+    if( others < 1.0 ) {
+      return 0.0;
+    }
+    return std::max(1.0 - common, 0.0) / others;
+  }
+
+  /**
+   * Estimates the fraction of rows smaller than a value, interpolating
+   * linearly inside the histogram buckets. Without a histogram (unordered
+   * attributes) a third of the rows is assumed.
+   **/
+  double smaller( const double value ) const noexcept {
+    if( !m_ordered ) {
+      return 1.0 / 3.0;
+    }
+    if( m_bounds.empty() || value <= m_min ) {
+      return 0.0;
+    }
+    if( value > m_max ) {
+      return 1.0;
+    }
+    const size_t bucket = std::lower_bound(m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin();
+    const double lower = m_bounds[bucket - 1];
+    const double upper = m_bounds[bucket];
+    if( value == upper ) {
+      // The rows equal to the bound are not smaller than it
+      return std::max(m_cumulative[bucket - 1], m_cumulative[bucket] - equals(value));
+    }
+    return m_cumulative[bucket - 1] + (m_cumulative[bucket] - m_cumulative[bucket - 1]) * (value - lower) / (upper - lower);
+  }
+};
+
+/**
+ * Collects the statistics of an attribute from a stream of values. Keeps a
+ * HyperLogLog sketch of all the values and a uniform reservoir sample, from
+ * which the histogram and the most common values are computed. Memory is
+ * bounded by the sample size.
+ **/
+template<typename T>
+class StatisticsBuilder {
+  public:
+    explicit StatisticsBuilder( const StatisticsConfig& config = StatisticsConfig() ) noexcept :
+      m_config(config),
+      m_sketch(config.m_precision),
+      m_state(config.m_seed) {
+    }
+
+    /**
+     * Adds a value
+     **/
+    void add( const T& value ) noexcept {
+      m_sketch.add(StatisticsTraits<T>::hash(value));
+      ++m_numRows;
+      if( !StatisticsTraits<T>::ordered ) {
+        return;
+      }
+      const double real = StatisticsTraits<T>::toDouble(value);
+      if( m_sample.size() < m_config.m_sampleSize ) {
+        m_sample.push_back(real);
+        return;
+      }
+      // Algorithm R: the value replaces a sampled one with probability
+      // sampleSize / numRows
+      const uint64_t slot = next() % m_numRows;
+      if( slot < m_sample.size() ) {
+        m_sample[slot] = real;
+      }
+    }
+
+    /**
+     * Computes the statistics of the values added so far
+     * @param out statistics The computed statistics
+     **/
+    void finish( AttributeStatistics* statistics ) noexcept {
+      *statistics = AttributeStatistics();
+      statistics->m_numRows = m_numRows;
+      statistics->m_ordered = StatisticsTraits<T>::ordered;
+      statistics->m_numDistinct = std::min(m_sketch.estimate(), static_cast<double>(m_numRows));
+      if( m_sample.empty() ) {
+        return;
+      }
+      std::vector<double> sample(m_sample);
+      std::sort(sample.begin(), sample.end());
+      const double n = static_cast<double>(sample.size());
+      statistics->m_min = sample.front();
+      statistics->m_max = sample.back();
+      if( m_numRows == sample.size() ) {
+        // The sample is exact, so the distinct count is too
+        uint64_t distinct = 1;
+        for( size_t i = 1; i < sample.size(); ++i ) {
+          distinct += sample[i] != sample[i-1] ? 1 : 0;
+        }
+        statistics->m_numDistinct = static_cast<double>(distinct);
+      }
+
+      // Equi-depth histogram: bounds at evenly spaced ranks of the sample.
+      // The cumulative fraction counts all the values equal to a bound, so
+      // duplicated values are not split across buckets.
+      const uint32_t numBuckets = std::max<uint32_t>(m_config.m_numBuckets, 1);
+      statistics->m_bounds.push_back(sample.front());
+      statistics->m_cumulative.push_back(upperFraction(sample, sample.front()));
+      for( uint32_t i = 1; i <= numBuckets; ++i ) {
+        const size_t rank = std::min<size_t>(static_cast<size_t>(n * i / numBuckets), sample.size()) - 1;
+        const double bound = sample[rank];
+        if( bound > statistics->m_bounds.back() ) {
+          statistics->m_bounds.push_back(bound);
+          statistics->m_cumulative.push_back(upperFraction(sample, bound));
+        }
+      }
+
+      // Most common values: the runs of the sorted sample longer than the
+      // average frequency
+      std::vector<std::pair<double, double>> runs;
+      const double average = n / std::max(statistics->m_numDistinct, 1.0);
+      for( size_t i = 0; i < sample.size(); ) {
+        size_t j = i + 1;
+        while( j < sample.size() && sample[j] == sample[i] ) {
+          ++j;
+        }
+        const double count = static_cast<double>(j - i);
+        if( count > 1.0 && count > average ) {
+          runs.emplace_back(sample[i], count / n);
+        }
+        i = j;
+      }
+      std::stable_sort(runs.begin(), runs.end(), []( const std::pair<double, double>& a,
+                                                     const std::pair<double, double>& b ) {
+        return a.second > b.second;
+      });
+      if( runs.size() > m_config.m_numMostCommon ) {
+        runs.resize(m_config.m_numMostCommon);
+      }
+      statistics->m_mostCommon = std::move(runs);
+    }
+
+  private:
+
+    /**
+     * Fraction of a sorted sample smaller or equal to a value
+     **/
+    static double upperFraction( const std::vector<double>& sample, const double value ) noexcept {
+      const size_t count = std::upper_bound(sample.begin(), sample.end(), value) - sample.begin();
+      return static_cast<double>(count) / static_cast<double>(sample.size());
+    }
+
+    uint64_t next() noexcept {
+      m_state += 0x9E3779B97F4A7C15ULL;
+      return mixStatisticsHash(m_state);
+    }
+
+    StatisticsConfig    m_config;
+    HyperLogLog         m_sketch;
+    std::vector<double> m_sample;
+    uint64_t            m_numRows = 0;
+    uint64_t            m_state;
+};
+
+/**
+ * Collects the statistics of a column on demand. Values are read a block at
+ * a time with bulk gets.
+ * @param in table The column
+ * @param out statistics The statistics of the column
+ * @param in config The configuration of the statistics
+ **/
+template<typename T>
+void collectStatistics( const ITypedTable<T>& table,
+                        AttributeStatistics* statistics,
+                        const StatisticsConfig& config = StatisticsConfig() ) noexcept {
+  constexpr uint64_t kBlockSize = 1024;
+  StatisticsBuilder<T> builder(config);
+  std::unique_ptr<T[]> block(new T[kBlockSize]);
+  const uint64_t size = table.size();
+  for( uint64_t first = 0; first < size; first += kBlockSize ) {
+    const uint64_t count = std::min(kBlockSize, size - first);
+    table.getBulk(first, count, block.get());
+    for( uint64_t i = 0; i < count; ++i ) {
+      builder.add(block[i]);
+    }
+  }
+  builder.finish(statistics);
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _DATA_STATISTICS_H_ */
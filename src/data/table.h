@@ -3,11 +3,12 @@
 #ifndef _TABLE_H_
 #define _TABLE_H_
 
-#include <base/platform.h>
+#include "../base/platform.h"
 #include <vector>
 #include <memory>
 #include <functional>
 #include <array>
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -35,6 +36,13 @@ class ITypedTable : public IBaseTable {
      * */
     virtual void append(const T& val) noexcept = 0;
 
+    /**
+     * Appends a range of elements to the table
+     * @param[in] vals The elements to append
+     * @param[in] count The number of elements to append
+     * */
+    virtual void appendBulk(const T* vals, const uint64_t count) noexcept = 0;
+
     /**
      * Applies a function to each element of the ImmutableTable 
      * @param[in] f The function to apply
@@ -55,6 +63,19 @@ class ITypedTable : public IBaseTable {
      * Gets the nth element of the table
      **/
     virtual T get(const uint64_t index) const noexcept = 0;
+
+    /**
+     * Copies a range of elements into a buffer. Tables override it to copy
+     * whole blocks instead of calling get on each element.
+     * @param[in] first The index of the first element to copy
+     * @param[in] count The number of elements to copy
+     * @param[out] vals The buffer where the elements are copied
+     * */
+    virtual void getBulk(const uint64_t first, const uint64_t count, T* vals) const noexcept {
+      for(uint64_t i = 0; i < count; ++i) {
+        vals[i] = get(first + i);
+      }
+    }
 };
 
 /**
@@ -84,6 +105,12 @@ class FixedLengthTable : public ITypedTable<T> {
       m_size+=1;
     }
 
+    void appendBulk(const T* vals, const uint64_t count) noexcept override {
+      assert(m_size + count <= minCapacity);
+      std::copy(vals, vals + count, m_data.begin() + m_size);
+      m_size+=count;
+    }
+
     void foreach( std::function<void(const T&)> f ) const noexcept override {
       for(uint32_t i = 0; i < m_size; ++i) {
         f(m_data[i]);
@@ -102,6 +129,10 @@ class FixedLengthTable : public ITypedTable<T> {
       return m_data[index];
     }
 
+    void getBulk(const uint64_t first, const uint64_t count, T* vals) const noexcept override {
+      std::copy(m_data.begin() + first, m_data.begin() + first + count, vals);
+    }
+
   private:
     uint32_t                    m_size = 0;
     std::array<T,minCapacity>   m_data;
@@ -121,6 +152,10 @@ class OneElementTable : public ITypedTable<T> {
       std::cerr << "WARNING: append on a OneElementTable should never be called" << std::endl; 
     }
 
+    void appendBulk(const T* vals, const uint64_t count) noexcept override {
+      std::cerr << "WARNING: appendBulk on a OneElementTable should never be called" << std::endl; 
+    }
+
     void foreach( std::function<void(const T&)> f ) const noexcept override {
       f(m_val);
     }
@@ -195,6 +230,31 @@ class Table : public ITypedTable<T> {
       }
     }
 
+    /**
+     * Appends a range of elements, filling each block with a single call
+     * instead of appending the elements one by one.
+     **/
+    void appendBulk(const T* vals, const uint64_t count) noexcept override {
+      uint64_t remaining = count;
+      while(remaining > 0) {
+        const uint64_t available = m_blocks[m_currentBlock]->getCapacity() - m_blocks[m_currentBlock]->size();
+        if(available == 0) {
+          if(m_currentBlock+1 < kArity) {
+            m_currentBlock+=1;
+            m_blocks[m_currentBlock] = createTable(m_blockCapacity);
+          } else {
+            grow();
+          }
+          continue;
+        }
+        const uint64_t n = std::min(available, remaining);
+        m_blocks[m_currentBlock]->appendBulk(vals, n);
+        m_size+=n;
+        vals+=n;
+        remaining-=n;
+      }
+    }
+
     void foreach( std::function<void(const T&)> f ) const noexcept override {
       for(uint32_t i = 0; i <= m_currentBlock; ++i) {
         m_blocks[i]->foreach(f);
@@ -215,6 +275,20 @@ class Table : public ITypedTable<T> {
       return m_blocks[block]->get( offset );
     }
 
+    void getBulk(const uint64_t first, const uint64_t count, T* vals) const noexcept override {
+      uint64_t index = first;
+      uint64_t remaining = count;
+      while(remaining > 0) {
+        const uint32_t block = index / m_blockCapacity;
+        const uint64_t offset = index % m_blockCapacity;
+        const uint64_t n = std::min(m_blockCapacity - offset, remaining);
+        m_blocks[block]->getBulk(offset, n, vals);
+        vals+=n;
+        index+=n;
+        remaining-=n;
+      }
+    }
+
   private:
 
     /**
@@ -237,7 +311,7 @@ class Table : public ITypedTable<T> {
     void grow() noexcept {
       Table* t = new Table(std::move(*this));
       for(uint32_t i = 0; i < kArity; ++i) {
-        m_blocks[i];
+        m_blocks[i] = nullptr;
       }
       m_blocks[0] = std::shared_ptr<ITypedTable<T>>(t);
       m_size = m_blocks[0]->size();
@@ -3,6 +3,7 @@
 #include <data/types.h>
 #include <data/graph.h>
 #include <data/immutable_table.h>
+#include <data/cursor.h>
 #include <base/types_utils.h>
 
 SPA_BENCH_NS_BEGIN
@@ -27,7 +28,10 @@ void AttributeTypeInfo<T>::setAttribute( Graph& graph, oid_t oid, const std::str
 
 template<typename T>
 oid_t AttributeTypeInfo<T>::getOid( Graph& graph, const std::string& value ) const noexcept {
-  return graph.select(m_typeName, m_attributeName, Condition::E_EQUALS, parser<T>::parse(value))->get(0);
+  // Only the first match is needed: pull it from the selection cursor
+  // instead of materializing the whole selection
+  std::unique_ptr<ICursor> cursor = graph.select(m_typeName, m_attributeName, Condition::E_EQUALS, parser<T>::parse(value));
+  return firstOid(cursor.get());
 };
 
 AttributeTypeInfo<bool> boolInfo("test","test",false,false,0);
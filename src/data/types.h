@@ -3,11 +3,12 @@
 #ifndef _DATA_TYPES_H_
 #define _DATA_TYPES_H_
 
-#include <base/platform.h>
+#include "../base/platform.h"
+#include "../base/types_traits.h"
 #include <cstdint>
 #include <vector>
 #include <string> 
-#include <set>
+#include <memory>
 
 SMILE_NS_BEGIN
 
@@ -73,17 +74,19 @@ struct AttributeTypeInfo : public IAttributeTypeInfo {
 };
 
 
+// Attributes are indexed by their attributeid_t. Names are resolved to ids
+// once, through the Catalog, instead of on every access.
 struct NodeTypeInfo {
     std::string                                                 m_name;
     typeid_t                                                    m_typeId;
-    std::set<std::shared_ptr<IAttributeTypeInfo>>               m_attributes;
+    std::vector<std::shared_ptr<IAttributeTypeInfo>>            m_attributes;
 };
 
 struct EdgeTypeInfo {
     std::string                                                 m_name;
     Direction                                                   m_direction;
     typeid_t                                                    m_typeId;
-    std::set<std::shared_ptr<IAttributeTypeInfo>>               m_attributes;
+    std::vector<std::shared_ptr<IAttributeTypeInfo>>            m_attributes;
 };
 
 struct Edge {
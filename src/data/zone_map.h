@@ -0,0 +1,179 @@
+
+
+
+#ifndef _DATA_ZONE_MAP_H_
+#define _DATA_ZONE_MAP_H_
+
+#include "../base/platform.h"
+#include "cursor.h"
+#include "table.h"
+#include "types.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Default number of rows summarized by each zone of a zone map
+ **/
+constexpr uint64_t kZoneSize = 4096;
+
+/**
+ * Smallest and largest value of each zone (fixed range of rows) of a column.
+ * Zones whose bounds cannot satisfy a condition are skipped by scans.
+ **/
+template<typename T>
+class ZoneMap {
+    SMILE_NON_COPYABLE(ZoneMap);
+  public:
+    /**
+     * @param in zoneSize The number of rows of each zone
+     **/
+    explicit ZoneMap( const uint64_t zoneSize = kZoneSize ) noexcept :
+      m_zoneSize(std::max<uint64_t>(zoneSize, 1)) {
+    }
+    ~ZoneMap() noexcept = default;
+
+    /**
+     * Computes the bounds of the zones of a column, replacing the previous
+     * ones. Values are read a zone at a time with bulk gets.
+     * @param in column The column
+     **/
+    void build( const ITypedTable<T>& column ) noexcept {
+      m_min.clear();
+      m_max.clear();
+      m_numRows = column.size();
+      std::unique_ptr<T[]> zone(new T[m_zoneSize]);
+      for( uint64_t first = 0; first < m_numRows; first += m_zoneSize ) {
+        const uint64_t count = std::min(m_zoneSize, m_numRows - first);
+        column.getBulk(first, count, zone.get());
+        const auto bounds = std::minmax_element(zone.get(), zone.get() + count);
+        m_min.push_back(*bounds.first);
+        m_max.push_back(*bounds.second);
+      }
+    }
+
+    /**
+     * Checks whether some value of a zone may satisfy a condition
+     * @param in zone The index of the zone
+     * @param in condition The condition values are compared with
+     * @param in value The value to compare to
+     **/
+    bool mayMatch( const uint64_t zone, const Condition condition, const T& value ) const noexcept {
+      const T& min = m_min[zone];
+      const T& max = m_max[zone];
+      switch( condition ) {
+        case Condition::E_EQUALS:
+          return !(value < min) && !(max < value);
+        case Condition::E_DIFFERENT:
+          return min != value || max != value;
+        case Condition::E_GREATER:
+          return value < max;
+        case Condition::E_GREATER_EQUALS:
+          return !(max < value);
+        case Condition::E_SMALLER:
+          return min < value;
+        case Condition::E_SMALLER_EQUALS:
+          return !(value < min);
+      }
+      return true;
+    }
+
+    /**
+     * Gets the fraction of the zones that may satisfy a condition, or 1.0 if
+     * the map has no zones and so cannot prune anything
+     **/
+    double candidateFraction( const Condition condition, const T& value ) const noexcept {
+      if( m_min.empty() ) {
+        return 1.0;
+      }
+      uint64_t candidates = 0;
+      for( uint64_t zone = 0; zone < m_min.size(); ++zone ) {
+        candidates += mayMatch(zone, condition, value) ? 1 : 0;
+      }
+      return static_cast<double>(candidates) / static_cast<double>(m_min.size());
+    }
+
+    uint64_t numZones() const noexcept {
+      return m_min.size();
+    }
+
+    uint64_t zoneSize() const noexcept {
+      return m_zoneSize;
+    }
+
+    /**
+     * Gets the number of rows of the column when the zone map was built
+     **/
+    uint64_t numRows() const noexcept {
+      return m_numRows;
+    }
+
+  private:
+    uint64_t        m_zoneSize;
+    uint64_t        m_numRows = 0;
+    std::vector<T>  m_min;
+    std::vector<T>  m_max;
+};
+
+/**
+ * Scans a column like ScanCursor, skipping the zones that cannot contain a
+ * value satisfying the condition. Rows appended after the zone map was built
+ * are always scanned.
+ **/
+template<typename T>
+class ZoneMapCursor : public ICursor {
+    SMILE_NON_COPYABLE(ZoneMapCursor);
+  public:
+    /**
+     * @param in column The column to scan. Must outlive the cursor.
+     * @param in zoneMap The zone map of the column. Must outlive the cursor.
+     * @param in condition The condition values are compared with
+     * @param in value The value to compare to
+     **/
+    ZoneMapCursor( const ITypedTable<T>* column,
+                   const ZoneMap<T>* zoneMap,
+                   const Condition condition,
+                   const T& value ) noexcept :
+      p_column(column),
+      p_zoneMap(zoneMap),
+      m_condition(condition),
+      m_value(value),
+      m_end(column->size()) {
+    }
+    virtual ~ZoneMapCursor() noexcept = default;
+
+    uint32_t next( oid_t* oids, const uint32_t capacity ) noexcept override {
+      const uint64_t zoneSize = p_zoneMap->zoneSize();
+      uint32_t count = 0;
+      while( m_position < m_end && count < capacity ) {
+        const uint64_t zone = m_position / zoneSize;
+        // A zone is only skipped if no row was appended to it after the zone
+        // map was built
+        if( m_position % zoneSize == 0 &&
+            std::min(m_position + zoneSize, m_end) <= p_zoneMap->numRows() &&
+            !p_zoneMap->mayMatch(zone, m_condition, m_value) ) {
+          m_position += zoneSize;
+          continue;
+        }
+        if( compareValues(p_column->get(m_position), m_value, m_condition) ) {
+          oids[count++] = m_position;
+        }
+        ++m_position;
+      }
+      return count;
+    }
+
+  private:
+    const ITypedTable<T>* p_column;
+    const ZoneMap<T>*     p_zoneMap;
+    Condition             m_condition;
+    T                     m_value;
+    oid_t                 m_position = 0;
+    oid_t                 m_end;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _DATA_ZONE_MAP_H_ */
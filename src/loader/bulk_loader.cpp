@@ -0,0 +1,203 @@
+
+
+
+#include "bulk_loader.h"
+#include "../base/parallel.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+BulkLoader::BulkLoader( const std::vector<AttributeDataType>& schema,
+                        const BulkLoaderConfig& config ) noexcept :
+  m_config(config) {
+  for( const AttributeDataType type : schema ) {
+    IColumnLoader* column = nullptr;
+    switch( type ) {
+      case AttributeDataType::E_BOOL:
+        column = new ColumnLoader<bool>(config.m_statistics);
+        break;
+      case AttributeDataType::E_INT:
+        column = new ColumnLoader<int32_t>(config.m_statistics);
+        break;
+      case AttributeDataType::E_UNSIGNED_INT:
+        column = new ColumnLoader<uint32_t>(config.m_statistics);
+        break;
+      case AttributeDataType::E_LONG:
+        column = new ColumnLoader<int64_t>(config.m_statistics);
+        break;
+      case AttributeDataType::E_UNSIGNED_LONG:
+        column = new ColumnLoader<uint64_t>(config.m_statistics);
+        break;
+      case AttributeDataType::E_FLOAT:
+        column = new ColumnLoader<float>(config.m_statistics);
+        break;
+      case AttributeDataType::E_DOUBLE:
+        column = new ColumnLoader<double>(config.m_statistics);
+        break;
+      case AttributeDataType::E_STRING:
+        if( config.m_internStrings ) {
+          column = new InternedColumnLoader(config.m_statistics);
+        } else {
+          column = new ColumnLoader<std::string>(config.m_statistics);
+        }
+        break;
+      case AttributeDataType::E_TIMESTAMP:
+        column = new ColumnLoader<timestamp>(config.m_statistics);
+        break;
+    }
+    m_columns.emplace_back(column);
+  }
+}
+
+ErrorCode BulkLoader::load( const std::string& path ) noexcept {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if( fd < 0 ) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  struct stat status;
+  if( fstat(fd, &status) != 0 ) {
+    close(fd);
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  const uint64_t size = static_cast<uint64_t>(status.st_size);
+  if( size == 0 ) {
+    close(fd);
+    return ErrorCode::E_NO_ERROR;
+  }
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if( data == MAP_FAILED ) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  madvise(data, size, MADV_SEQUENTIAL);
+
+  const char* begin = static_cast<const char*>(data);
+  const char* end = begin + size;
+  if( m_config.m_skipHeader ) {
+    const char* newline = static_cast<const char*>(memchr(begin, '\n', size));
+    begin = newline != nullptr ? newline + 1 : end;
+  }
+  std::vector<std::pair<const char*, const char*>> chunks;
+  split(begin, end, &chunks);
+
+  const uint32_t numChunks = static_cast<uint32_t>(chunks.size());
+  for( std::unique_ptr<IColumnLoader>& column : m_columns ) {
+    column->reset(numChunks);
+  }
+  std::vector<ErrorCode> errors(numChunks, ErrorCode::E_NO_ERROR);
+  std::vector<uint64_t> numRows(numChunks, 0);
+  parallelFor(0, numChunks, m_config.m_numThreads, 1,
+              [&]( const uint64_t chunk, const uint32_t ) {
+    errors[chunk] = parse(static_cast<uint32_t>(chunk), chunks[chunk].first, chunks[chunk].second, &numRows[chunk]);
+  });
+  munmap(data, size);
+
+  for( const ErrorCode error : errors ) {
+    if( error != ErrorCode::E_NO_ERROR ) {
+      for( std::unique_ptr<IColumnLoader>& column : m_columns ) {
+        column->reset(0);
+      }
+      return error;
+    }
+  }
+
+  // Each column is appended to its own table, so columns are independent
+  parallelFor(0, m_columns.size(), m_config.m_numThreads, 1,
+              [&]( const uint64_t column, const uint32_t ) {
+    m_columns[column]->flush(m_config.m_collectStatistics);
+  });
+  for( const uint64_t rows : numRows ) {
+    m_numRows += rows;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode BulkLoader::bind( Catalog* catalog,
+                            const std::string& typeName,
+                            const std::vector<std::string>& attributeNames ) noexcept {
+  if( attributeNames.size() != m_columns.size() ) {
+    return ErrorCode::E_LOADER_INVALID_NUM_COLUMNS;
+  }
+  // All the names are resolved and checked before any column is bound
+  std::vector<AttributeRef> refs(m_columns.size());
+  for( uint32_t i = 0; i < m_columns.size(); ++i ) {
+    const ErrorCode error = catalog->resolve(typeName, attributeNames[i], &refs[i]);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+    if( catalog->attribute(refs[i]).m_dataType != m_columns[i]->type() || m_columns[i]->interned() ) {
+      return ErrorCode::E_GRAPH_ATTRIBUTE_DATA_TYPE_MISSMATCH;
+    }
+    // Columns are flushed concurrently, so each needs its own table
+    for( uint32_t j = 0; j < i; ++j ) {
+      if( refs[j].m_attribute == refs[i].m_attribute ) {
+        return ErrorCode::E_GRAPH_EXISTING_ATTRIBUTE_TYPE;
+      }
+    }
+  }
+  for( uint32_t i = 0; i < m_columns.size(); ++i ) {
+    m_columns[i]->bind(catalog, refs[i]);
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+void BulkLoader::split( const char* begin,
+                        const char* end,
+                        std::vector<std::pair<const char*, const char*>>* chunks ) const noexcept {
+  const uint64_t chunkSize = std::max<uint64_t>(m_config.m_chunkSize, 1);
+  while( begin < end ) {
+    const char* last = end;
+    if( static_cast<uint64_t>(end - begin) > chunkSize ) {
+      const char* newline = static_cast<const char*>(memchr(begin + chunkSize, '\n', end - begin - chunkSize));
+      last = newline != nullptr ? newline + 1 : end;
+    }
+    chunks->emplace_back(begin, last);
+    begin = last;
+  }
+}
+
+ErrorCode BulkLoader::parse( const uint32_t chunk,
+                             const char* begin,
+                             const char* end,
+                             uint64_t* numRows ) noexcept {
+  const uint32_t numColumns = static_cast<uint32_t>(m_columns.size());
+  uint64_t rows = 0;
+  while( begin < end ) {
+    const char* newline = static_cast<const char*>(memchr(begin, '\n', end - begin));
+    const char* lineEnd = newline != nullptr ? newline : end;
+    const char* next = newline != nullptr ? newline + 1 : end;
+    if( lineEnd > begin && *(lineEnd - 1) == '\r' ) {
+      --lineEnd;
+    }
+    if( lineEnd == begin ) {
+      begin = next;
+      continue;
+    }
+
+    const char* field = begin;
+    for( uint32_t column = 0; column < numColumns; ++column ) {
+      if( field > lineEnd ) {
+        return ErrorCode::E_LOADER_INVALID_NUM_COLUMNS;
+      }
+      const char* separator = static_cast<const char*>(memchr(field, m_config.m_separator, lineEnd - field));
+      const char* fieldEnd = separator != nullptr ? separator : lineEnd;
+      if( !m_columns[column]->parse(chunk, field, fieldEnd) ) {
+        return ErrorCode::E_LOADER_INVALID_VALUE;
+      }
+      field = fieldEnd + 1;
+    }
+    if( field <= lineEnd ) {
+      return ErrorCode::E_LOADER_INVALID_NUM_COLUMNS;
+    }
+    ++rows;
+    begin = next;
+  }
+  *numRows = rows;
+  return ErrorCode::E_NO_ERROR;
+}
+
+SMILE_NS_END
@@ -0,0 +1,398 @@
+
+
+
+#ifndef _SMILE_LOADER_BULK_LOADER_H_
+#define _SMILE_LOADER_BULK_LOADER_H_
+
+#include "../base/base.h"
+#include "../base/string_pool.h"
+#include "../base/types_traits.h"
+#include "../base/types_utils.h"
+#include "../data/catalog.h"
+#include "../data/statistics.h"
+#include "../data/table.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+struct BulkLoaderConfig {
+  /**
+   * Character separating the fields of a row
+   */
+  char      m_separator   = ',';
+
+  /**
+   * Whether the first line of each file is a header to skip
+   */
+  bool      m_skipHeader  = false;
+
+  /**
+   * Number of threads parsing the chunks of a file
+   */
+  uint32_t  m_numThreads  = 1;
+
+  /**
+   * Approximate size in bytes of the chunks a file is split into
+   */
+  uint64_t  m_chunkSize   = 8*1024*1024;
+
+  /**
+   * Whether the statistics of each column are collected while loading
+   */
+  bool              m_collectStatistics = false;
+
+  /**
+   * Whether string columns are loaded as codes of the global StringPool
+   * instead of as strings
+   */
+  bool              m_internStrings = false;
+
+  /**
+   * The configuration of the collected statistics
+   */
+  StatisticsConfig  m_statistics;
+};
+
+/**
+ * Column of a BulkLoader. Values are parsed into a buffer per chunk, which
+ * are appended in file order to the table of the column once all the chunks
+ * of a file have been parsed.
+ **/
+class IColumnLoader {
+  public:
+    virtual ~IColumnLoader() noexcept = default;
+
+    /**
+     * Gets the data type of the column
+     **/
+    virtual AttributeDataType type() const noexcept = 0;
+
+    /**
+     * Whether the column holds string codes instead of strings
+     **/
+    virtual bool interned() const noexcept {
+      return false;
+    }
+
+    /**
+     * Discards the buffered values and prepares a buffer for each chunk
+     **/
+    virtual void reset( const uint32_t numChunks ) noexcept = 0;
+
+    /**
+     * Parses a field into the buffer of a chunk. Different chunks can be
+     * parsed concurrently.
+     * @return false if the field is not a valid value
+     **/
+    virtual bool parse( const uint32_t chunk, const char* begin, const char* end ) noexcept = 0;
+
+    /**
+     * Appends the buffered values of all the chunks to the table and releases
+     * the buffers
+     * @param in statistics Whether the appended values are added to the
+     * statistics of the column
+     **/
+    virtual void flush( const bool statistics ) noexcept = 0;
+
+    /**
+     * Gets the statistics of the values loaded so far, if collected
+     **/
+    virtual const AttributeStatistics& statistics() const noexcept = 0;
+
+    /**
+     * Appends the values to the table of an attribute of a catalog instead
+     * of the table of the column. The attribute must have the data type of
+     * the column.
+     **/
+    virtual void bind( Catalog* catalog, const AttributeRef& ref ) noexcept = 0;
+};
+
+template<typename T>
+class ColumnLoader : public IColumnLoader {
+  public:
+    SMILE_NON_COPYABLE(ColumnLoader);
+
+    explicit ColumnLoader( const StatisticsConfig& config = StatisticsConfig() ) noexcept :
+      m_builder(config) {
+    }
+    virtual ~ColumnLoader() noexcept = default;
+
+    AttributeDataType type() const noexcept override {
+      return is_supported<T>::type;
+    }
+
+    void reset( const uint32_t numChunks ) noexcept override {
+      m_chunks.clear();
+      m_chunks.resize(numChunks);
+    }
+
+    bool parse( const uint32_t chunk, const char* begin, const char* end ) noexcept override {
+      T value;
+      if( parser<T>::parse(begin, end, &value) != ErrorCode::E_NO_ERROR ) {
+        return false;
+      }
+      m_chunks[chunk].push_back(std::move(value));
+      return true;
+    }
+
+    void flush( const bool statistics ) noexcept override {
+      for( ChunkBuffer& chunk : m_chunks ) {
+        p_table->appendBulk(chunk.data(), chunk.size());
+        // The values are added while still in cache, instead of rescanning
+        // the table afterwards
+        if( statistics ) {
+          const T* values = chunk.data();
+          for( uint64_t i = 0; i < chunk.size(); ++i ) {
+            m_builder.add(values[i]);
+          }
+        }
+      }
+      m_chunks.clear();
+      if( statistics ) {
+        m_builder.finish(&m_statistics);
+      }
+    }
+
+    const AttributeStatistics& statistics() const noexcept override {
+      return m_statistics;
+    }
+
+    void bind( Catalog* catalog, const AttributeRef& ref ) noexcept override {
+      p_table = catalog->table<T>(ref);
+    }
+
+    /**
+     * Gets the table with the values loaded so far. Empty if the column is
+     * bound to a catalog.
+     **/
+    const Table<T>& table() const noexcept {
+      return m_table;
+    }
+
+    /**
+     * Whether the values are appended to the table of a catalog
+     **/
+    bool bound() const noexcept {
+      return p_table != &m_table;
+    }
+
+  protected:
+
+    /**
+     * Growable array of values. Unlike std::vector, it also gives access to
+     * the contiguous storage of bool values.
+     **/
+    class ChunkBuffer {
+      public:
+        void push_back( T&& value ) noexcept {
+          if( m_size == m_capacity ) {
+            m_capacity = m_capacity == 0 ? 1024 : 2*m_capacity;
+            std::unique_ptr<T[]> data(new T[m_capacity]);
+            std::move(p_data.get(), p_data.get() + m_size, data.get());
+            p_data = std::move(data);
+          }
+          p_data[m_size] = std::move(value);
+          ++m_size;
+        }
+
+        const T* data() const noexcept {
+          return p_data.get();
+        }
+
+        uint64_t size() const noexcept {
+          return m_size;
+        }
+
+      private:
+        std::unique_ptr<T[]>  p_data;
+        uint64_t              m_size = 0;
+        uint64_t              m_capacity = 0;
+    };
+
+    Table<T>                  m_table;
+    ITypedTable<T>*           p_table = &m_table;
+    std::vector<ChunkBuffer>  m_chunks;
+    StatisticsBuilder<T>      m_builder;
+    AttributeStatistics       m_statistics;
+};
+
+/**
+ * String column loaded as the codes of the strings in the global
+ * StringPool. Chunks intern their strings concurrently.
+ **/
+class InternedColumnLoader : public ColumnLoader<strid_t> {
+  public:
+    SMILE_NON_COPYABLE(InternedColumnLoader);
+
+    explicit InternedColumnLoader( const StatisticsConfig& config = StatisticsConfig() ) noexcept :
+      ColumnLoader<strid_t>(config) {
+    }
+    virtual ~InternedColumnLoader() noexcept = default;
+
+    AttributeDataType type() const noexcept override {
+      return AttributeDataType::E_STRING;
+    }
+
+    bool interned() const noexcept override {
+      return true;
+    }
+
+    bool parse( const uint32_t chunk, const char* begin, const char* end ) noexcept override {
+      strid_t code = StringPool::global().intern(begin, end - begin);
+      if( code == kInvalidStringId ) {
+        return false;
+      }
+      m_chunks[chunk].push_back(std::move(code));
+      return true;
+    }
+};
+
+/**
+ * Loads delimiter separated files (CSV, edge lists...) into one columnar
+ * Table per column. Files are memory mapped and split into newline aligned
+ * chunks that are parsed in parallel, each one into its own buffers. Once a
+ * file is parsed, the buffers are appended to the tables in file order with
+ * bulk appends, one column per thread.
+ **/
+class BulkLoader {
+  public:
+    SMILE_NON_COPYABLE(BulkLoader);
+
+    /**
+     * @param in schema The data type of each column
+     * @param in config The configuration of the loader
+     **/
+    BulkLoader( const std::vector<AttributeDataType>& schema,
+                const BulkLoaderConfig& config = BulkLoaderConfig() ) noexcept;
+    ~BulkLoader() noexcept = default;
+
+    /**
+     * Loads the rows of a file, appending them to the rows loaded before.
+     * Empty lines are skipped. If the file contains an invalid row, no row of
+     * the file is loaded.
+     * @param in path The path of the file
+     * @return E_STORAGE_INVALID_PATH if the file cannot be opened,
+     * E_LOADER_INVALID_NUM_COLUMNS if a row does not have a field per column
+     * and E_LOADER_INVALID_VALUE if a field is not a valid value of its
+     * column type
+     **/
+    ErrorCode load( const std::string& path ) noexcept;
+
+    /**
+     * Binds the columns to attributes of a type of a catalog. The names are
+     * resolved once here, and the following loads append each column
+     * directly to the table of its attribute. The attributes of the type
+     * that are not bound do not grow. Must be called before the first load.
+     * @param in catalog The catalog. Must outlive the loader.
+     * @param in typeName The name of the type
+     * @param in attributeNames The name of the attribute of each column
+     * @return The errors of Catalog::resolve, E_LOADER_INVALID_NUM_COLUMNS if
+     * there is not one attribute per column,
+     * E_GRAPH_EXISTING_ATTRIBUTE_TYPE if an attribute is bound twice and
+     * E_GRAPH_ATTRIBUTE_DATA_TYPE_MISSMATCH if a column does not have the
+     * data type of its attribute or holds string codes. No column is bound
+     * on error.
+     **/
+    ErrorCode bind( Catalog* catalog,
+                    const std::string& typeName,
+                    const std::vector<std::string>& attributeNames ) noexcept;
+
+    /**
+     * Gets the number of rows loaded
+     **/
+    uint64_t numRows() const noexcept {
+      return m_numRows;
+    }
+
+    /**
+     * Gets the number of columns
+     **/
+    uint32_t numColumns() const noexcept {
+      return static_cast<uint32_t>(m_columns.size());
+    }
+
+    /**
+     * Gets the table of a column
+     * @param in index The index of the column
+     * @return The table, or nullptr if the index is out of bounds, T is not
+     * the type of the column, the column holds string codes or it is bound
+     * to a catalog
+     **/
+    template<typename T>
+    const Table<T>* column( const uint32_t index ) const noexcept {
+      if( index >= m_columns.size() ||
+          m_columns[index]->type() != is_supported<T>::type ||
+          m_columns[index]->interned() ) {
+        return nullptr;
+      }
+      const ColumnLoader<T>* column = static_cast<const ColumnLoader<T>*>(m_columns[index].get());
+      return column->bound() ? nullptr : &column->table();
+    }
+
+    /**
+     * Gets the table of codes of a string column loaded with m_internStrings
+     * @param in index The index of the column
+     * @return The table, or nullptr if the index is out of bounds or the
+     * column is not an interned string column
+     **/
+    const Table<strid_t>* internedColumn( const uint32_t index ) const noexcept {
+      if( index >= m_columns.size() || !m_columns[index]->interned() ) {
+        return nullptr;
+      }
+      return &static_cast<const InternedColumnLoader*>(m_columns[index].get())->table();
+    }
+
+    /**
+     * Gets the statistics of a column, collected while loading
+     * @param in index The index of the column
+     * @return The statistics, or nullptr if the index is out of bounds or
+     * statistics are not collected
+     **/
+    const AttributeStatistics* statistics( const uint32_t index ) const noexcept {
+      if( index >= m_columns.size() || !m_config.m_collectStatistics ) {
+        return nullptr;
+      }
+      return &m_columns[index]->statistics();
+    }
+
+  private:
+
+    /**
+     * Splits a buffer into newline aligned chunks
+     * @param in begin The first character of the buffer
+     * @param in end One past the last character of the buffer
+     * @param out chunks The first and one past the last character of each
+     * chunk
+     **/
+    void split( const char* begin,
+                const char* end,
+                std::vector<std::pair<const char*, const char*>>* chunks ) const noexcept;
+
+    /**
+     * Parses the rows of a chunk into the buffers of the columns
+     * @param in chunk The index of the chunk
+     * @param in begin The first character of the chunk
+     * @param in end One past the last character of the chunk
+     * @param out numRows The number of rows of the chunk
+     **/
+    ErrorCode parse( const uint32_t chunk,
+                     const char* begin,
+                     const char* end,
+                     uint64_t* numRows ) noexcept;
+
+    // The configuration of the loader
+    BulkLoaderConfig                            m_config;
+
+    // The columns
+    std::vector<std::unique_ptr<IColumnLoader>> m_columns;
+
+    // The number of rows loaded
+    uint64_t                                    m_numRows = 0;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_LOADER_BULK_LOADER_H_ */
@@ -38,6 +38,8 @@ ErrorCode BufferPool::alloc( BufferHandler* bufferHandler ) noexcept {
 	m_descriptors[bId].m_dirty = 0;
 	m_descriptors[bId].m_pageId = pId;
 
+	SMILE_PROFILE(++m_stats.m_pagesTouched);
+
 	// Set BufferHandler for the allocated buffer.
 	bufferHandler->m_buffer 	= getBuffer(bId);
 	bufferHandler->m_pId 		= pId;
@@ -61,7 +63,7 @@ ErrorCode BufferPool::release( const pageId_t& pId ) noexcept {
 
 		// If the buffer is dirty we must store it to disk.
 		if( m_descriptors[bId].m_dirty ) {
-			ErrorCode error = p_storage->write(getBuffer(bId), m_descriptors[bId].m_pageId);
+			ErrorCode error = writeBuffer(bId);
 			if ( error != ErrorCode::E_NO_ERROR ) {
 				return error;
 			}
@@ -104,6 +106,7 @@ ErrorCode BufferPool::pin( const pageId_t& pId, BufferHandler* bufferHandler ) n
 		}
 
 		m_bufferToPageMap[pId] = bId;
+		SMILE_PROFILE(++m_stats.m_pageMisses);
 
 		m_descriptors[bId].m_referenceCount = 1;
 		m_descriptors[bId].m_usageCount = 1;
@@ -118,6 +121,7 @@ ErrorCode BufferPool::pin( const pageId_t& pId, BufferHandler* bufferHandler ) n
 
 	// Fill the remaining buffer descriptor fields.
 	m_descriptors[bId].m_pageId = pId;
+	SMILE_PROFILE(++m_stats.m_pagesTouched);
 	
 	// Set BufferHandler for the pinned buffer.
 	bufferHandler->m_buffer 	= getBuffer(bId);
@@ -146,7 +150,7 @@ ErrorCode BufferPool::checkpoint() noexcept {
 	// Look for dirty Buffer Pool slots and flush them to disk.
 	for (int bId = 0; bId < m_allocationTable.size(); ++bId) {
 		if (m_allocationTable.test(bId) && m_descriptors[bId].m_dirty) {
-			ErrorCode error = p_storage->write(getBuffer(bId), m_descriptors[bId].m_pageId);
+			ErrorCode error = writeBuffer(bId);
 			if ( error != ErrorCode::E_NO_ERROR ) {
 				return error;
 			}
@@ -167,6 +171,14 @@ void BufferPool::setPageDirty( const pageId_t& pId ) noexcept {
 	}
 }
 
+void BufferPool::setWriteHook( PageWriteHook hook ) noexcept {
+	m_writeHook = std::move(hook);
+}
+
+const BufferPoolStats& BufferPool::stats() const noexcept {
+	return m_stats;
+}
+
 char* BufferPool::getBuffer( const bufferId_t& bId ) noexcept {
 	char* buffer = p_pool + (p_storage->getPageSize()*bId);
 	return buffer;
@@ -200,7 +212,7 @@ ErrorCode BufferPool::getEmptySlot( bufferId_t* bId ) noexcept {
 
 				// If the buffer is dirty we must store it to disk.
 				if( m_descriptors[*bId].m_dirty ) {
-					ErrorCode error = p_storage->write(getBuffer(*bId), m_descriptors[*bId].m_pageId);
+					ErrorCode error = writeBuffer(*bId);
 					if ( error != ErrorCode::E_NO_ERROR ) {
 						return error;
 					}
@@ -230,5 +242,18 @@ ErrorCode BufferPool::getEmptySlot( bufferId_t* bId ) noexcept {
 	return ErrorCode::E_NO_ERROR;
 }
 
+ErrorCode BufferPool::writeBuffer( const bufferId_t& bId ) noexcept {
+	ErrorCode error = p_storage->write(getBuffer(bId), m_descriptors[bId].m_pageId);
+	if ( error != ErrorCode::E_NO_ERROR ) {
+		return error;
+	}
+
+	if ( m_writeHook ) {
+		m_writeHook(m_descriptors[bId].m_pageId, getBuffer(bId));
+	}
+
+	return ErrorCode::E_NO_ERROR;
+}
+
 SMILE_NS_END
 
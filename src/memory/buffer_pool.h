@@ -4,8 +4,10 @@
 #ifndef _MEMORY_BUFFER_POOL_H_
 #define _MEMORY_BUFFER_POOL_H_
 
+#include <functional>
 #include <map>
 #include "../base/platform.h"
+#include "../base/profiling.h"
 #include "../storage/file_storage.h"
 #include "types.h"
 #include "boost/dynamic_bitset.hpp"
@@ -37,6 +39,19 @@ struct BufferHandler {
     bufferId_t      m_bId;
 };
 
+struct BufferPoolStats {
+    /**
+     * Number of pages pinned or allocated.
+     */
+    uint64_t    m_pagesTouched  = 0;
+
+    /**
+     * Number of pinned pages that were not in the Buffer Pool and had to be
+     * read from storage.
+     */
+    uint64_t    m_pageMisses    = 0;
+};
+
 struct bufferDescriptor {
     /**
      * Number of current references of the page.
@@ -59,6 +74,12 @@ struct bufferDescriptor {
     pageId_t    m_pageId        = 0;
 };
 
+/**
+ * Function called with the id and the content of each dirty page written to
+ * the storage.
+ */
+using PageWriteHook = std::function<void(const pageId_t, const char*)>;
+
 class BufferPool {
 
   public:
@@ -118,6 +139,24 @@ class BufferPool {
      */
     void setPageDirty( const pageId_t& pId ) noexcept;
 
+    /**
+     * Sets the function called after a dirty page is written to the storage,
+     * on checkpoint, release or eviction. The content of the page is final at
+     * that point, so it can be used to rebuild the in memory summaries of the
+     * page, such as its Bloom filter.
+     * 
+     * @param hook The function, or nullptr to remove it.
+     */
+    void setWriteHook( PageWriteHook hook ) noexcept;
+
+    /**
+     * Gets the access counters of the Buffer Pool. They are only updated when
+     * profiling is enabled at compile time.
+     * 
+     * @return The counters accumulated since the creation of the pool.
+     */
+    const BufferPoolStats& stats() const noexcept;
+
   private:
 
     /**
@@ -137,6 +176,14 @@ class BufferPool {
      */
     ErrorCode getEmptySlot( bufferId_t* bId ) noexcept;
 
+    /**
+     * Writes the page of a dirty buffer slot to the storage and calls the
+     * write hook.
+     * 
+     * @param bId bufferId_t of the slot to write.
+     */
+    ErrorCode writeBuffer( const bufferId_t& bId ) noexcept;
+
     /**
      * The file storage where this buffer pool will be persisted.
      **/
@@ -166,6 +213,43 @@ class BufferPool {
      * Next victim to test during Clock Sweep.
      */
     uint64_t m_nextCSVictim;
+
+    /**
+     * Access counters.
+     */
+    BufferPoolStats m_stats;
+
+    /**
+     * Function called after dirty pages are written.
+     */
+    PageWriteHook m_writeHook;
+};
+
+/**
+ * Adds the Buffer Pool accesses done between its construction and destruction
+ * to a QueryStats object. Does nothing if the stats pointer is null.
+ */
+class ScopedBufferPoolProfile {
+  public:
+    SMILE_NON_COPYABLE(ScopedBufferPoolProfile);
+
+    ScopedBufferPoolProfile( const BufferPool* pool, QueryStats* stats ) noexcept :
+      p_pool(pool),
+      p_stats(stats),
+      m_start(pool->stats()) {
+    }
+
+    ~ScopedBufferPoolProfile() noexcept {
+      if( p_stats != nullptr ) {
+        p_stats->m_pagesTouched += p_pool->stats().m_pagesTouched - m_start.m_pagesTouched;
+        p_stats->m_pageMisses += p_pool->stats().m_pageMisses - m_start.m_pageMisses;
+      }
+    }
+
+  private:
+    const BufferPool*   p_pool;
+    QueryStats*         p_stats;
+    BufferPoolStats     m_start;
 };
 
 SMILE_NS_END
@@ -0,0 +1,282 @@
+
+
+
+#include "heap_file.h"
+#include <cstring>
+
+SMILE_NS_BEGIN
+
+/**
+ * Stores a record id in a page
+ **/
+static void encodeRecordId( const RecordId& rid, char* data ) noexcept {
+  memcpy(data, &rid.m_page, sizeof(pageId_t));
+  memcpy(data + sizeof(pageId_t), &rid.m_slot, sizeof(uint32_t));
+}
+
+/**
+ * Loads a record id stored in a page
+ **/
+static RecordId decodeRecordId( const char* data ) noexcept {
+  RecordId rid;
+  memcpy(&rid.m_page, data, sizeof(pageId_t));
+  memcpy(&rid.m_slot, data + sizeof(pageId_t), sizeof(uint32_t));
+  return rid;
+}
+
+HeapFile::HeapFile( FileStorage* storage, BufferPool* pool ) noexcept :
+  p_pool(pool),
+  m_pageSize(storage->getPageSize()) {
+}
+
+ErrorCode HeapFile::open( const std::vector<pageId_t>& pages ) noexcept {
+  m_pages.clear();
+  m_pageIndex.clear();
+  m_freeSpace.clear();
+  m_freePages.clear();
+  for( const pageId_t pId : pages ) {
+    BufferHandler handler;
+    const ErrorCode error = p_pool->pin(pId, &handler);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+    const uint32_t index = static_cast<uint32_t>(m_pages.size());
+    const uint32_t freeSpace = SlottedPage(handler.m_buffer, m_pageSize).freeSpace();
+    m_pages.push_back(pId);
+    m_pageIndex[pId] = index;
+    m_freeSpace.push_back(freeSpace);
+    m_freePages.insert(std::make_pair(freeSpace, index));
+    p_pool->unpin(pId);
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode HeapFile::insert( const char* record, const uint32_t size, RecordId* rid ) noexcept {
+  if( size > maxRecordSize() ) {
+    return ErrorCode::E_HEAP_RECORD_TOO_LARGE;
+  }
+  return place(record, size, 0, rid);
+}
+
+ErrorCode HeapFile::read( const RecordId& rid, std::vector<char>* record ) noexcept {
+  BufferHandler handler;
+  uint32_t index;
+  ErrorCode error = pinPage(rid.m_page, &handler, &index);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  SlottedPage page(handler.m_buffer, m_pageSize);
+  const char* data;
+  uint32_t size;
+  uint32_t flags;
+  if( !page.get(rid.m_slot, &data, &size, &flags) || (flags & kSlotMoved) ) {
+    p_pool->unpin(rid.m_page);
+    return ErrorCode::E_HEAP_INVALID_RECORD;
+  }
+  if( flags & kSlotForwarded ) {
+    const RecordId target = decodeRecordId(data);
+    p_pool->unpin(rid.m_page);
+    BufferHandler targetHandler;
+    error = pinPage(target.m_page, &targetHandler, &index);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+    SlottedPage(targetHandler.m_buffer, m_pageSize).get(target.m_slot, &data, &size, &flags);
+    record->assign(data + kRecordIdSize, data + size);
+    p_pool->unpin(target.m_page);
+    return ErrorCode::E_NO_ERROR;
+  }
+  record->assign(data, data + size);
+  p_pool->unpin(rid.m_page);
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode HeapFile::update( const RecordId& rid, const char* record, const uint32_t size ) noexcept {
+  if( size > maxRecordSize() ) {
+    return ErrorCode::E_HEAP_RECORD_TOO_LARGE;
+  }
+  BufferHandler handler;
+  uint32_t index;
+  ErrorCode error = pinPage(rid.m_page, &handler, &index);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  SlottedPage page(handler.m_buffer, m_pageSize);
+  const char* data;
+  uint32_t oldSize;
+  uint32_t flags;
+  if( !page.get(rid.m_slot, &data, &oldSize, &flags) || (flags & kSlotMoved) ) {
+    p_pool->unpin(rid.m_page);
+    return ErrorCode::E_HEAP_INVALID_RECORD;
+  }
+  const bool forwarded = (flags & kSlotForwarded) != 0;
+  const RecordId oldTarget = forwarded ? decodeRecordId(data) : RecordId{0, 0};
+
+  // Records go back to their home slot whenever it has room for them
+  if( page.update(rid.m_slot, record, size, 0) ) {
+    touch(index, page);
+    p_pool->unpin(rid.m_page);
+    return forwarded ? eraseMoved(oldTarget) : ErrorCode::E_NO_ERROR;
+  }
+
+  if( forwarded ) {
+    BufferHandler targetHandler;
+    uint32_t targetIndex;
+    error = pinPage(oldTarget.m_page, &targetHandler, &targetIndex);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      p_pool->unpin(rid.m_page);
+      return error;
+    }
+    SlottedPage targetPage(targetHandler.m_buffer, m_pageSize);
+    m_moved.resize(kRecordIdSize + size);
+    encodeRecordId(rid, m_moved.data());
+    memcpy(m_moved.data() + kRecordIdSize, record, size);
+    const bool updated = targetPage.update(oldTarget.m_slot, m_moved.data(), kRecordIdSize + size, kSlotMoved);
+    if( updated ) {
+      touch(targetIndex, targetPage);
+    }
+    p_pool->unpin(oldTarget.m_page);
+    if( updated ) {
+      p_pool->unpin(rid.m_page);
+      return ErrorCode::E_NO_ERROR;
+    }
+  }
+
+  // The record is moved to another page before its old copy is deleted, so
+  // the home slot always points to a valid copy
+  RecordId target;
+  error = placeMoved(rid, record, size, &target);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    p_pool->unpin(rid.m_page);
+    return error;
+  }
+  char stub[kRecordIdSize];
+  encodeRecordId(target, stub);
+  page.update(rid.m_slot, stub, kRecordIdSize, kSlotForwarded);
+  touch(index, page);
+  p_pool->unpin(rid.m_page);
+  return forwarded ? eraseMoved(oldTarget) : ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode HeapFile::erase( const RecordId& rid ) noexcept {
+  BufferHandler handler;
+  uint32_t index;
+  const ErrorCode error = pinPage(rid.m_page, &handler, &index);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  SlottedPage page(handler.m_buffer, m_pageSize);
+  const char* data;
+  uint32_t size;
+  uint32_t flags;
+  if( !page.get(rid.m_slot, &data, &size, &flags) || (flags & kSlotMoved) ) {
+    p_pool->unpin(rid.m_page);
+    return ErrorCode::E_HEAP_INVALID_RECORD;
+  }
+  const bool forwarded = (flags & kSlotForwarded) != 0;
+  const RecordId target = forwarded ? decodeRecordId(data) : RecordId{0, 0};
+  page.erase(rid.m_slot);
+  touch(index, page);
+  p_pool->unpin(rid.m_page);
+  return forwarded ? eraseMoved(target) : ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode HeapFile::scan( const RecordScanFunction& f ) noexcept {
+  for( const pageId_t pId : m_pages ) {
+    BufferHandler handler;
+    const ErrorCode error = p_pool->pin(pId, &handler);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+    SlottedPage page(handler.m_buffer, m_pageSize);
+    for( uint32_t slot = 0; slot < page.numSlots(); ++slot ) {
+      const char* data;
+      uint32_t size;
+      uint32_t flags;
+      // Forwarded slots are skipped, their record is found in its new page
+      if( !page.get(slot, &data, &size, &flags) || (flags & kSlotForwarded) ) {
+        continue;
+      }
+      if( flags & kSlotMoved ) {
+        f(decodeRecordId(data), data + kRecordIdSize, size - kRecordIdSize);
+      } else {
+        f(RecordId{pId, slot}, data, size);
+      }
+    }
+    p_pool->unpin(pId);
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode HeapFile::pinPage( const pageId_t page, BufferHandler* handler, uint32_t* index ) noexcept {
+  auto it = m_pageIndex.find(page);
+  if( it == m_pageIndex.end() ) {
+    return ErrorCode::E_HEAP_INVALID_RECORD;
+  }
+  *index = it->second;
+  return p_pool->pin(page, handler);
+}
+
+ErrorCode HeapFile::place( const char* record, const uint32_t size, const uint32_t flags, RecordId* rid ) noexcept {
+  // Best fit: the page with the least free space that has room for the
+  // record and a new slot
+  const uint32_t needed = SlottedPage::footprint(size) + sizeof(Slot);
+  auto it = m_freePages.lower_bound(std::make_pair(needed, 0u));
+  BufferHandler handler;
+  uint32_t index;
+  if( it != m_freePages.end() ) {
+    index = it->second;
+    const ErrorCode error = p_pool->pin(m_pages[index], &handler);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+  } else {
+    const ErrorCode error = p_pool->alloc(&handler);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+    SlottedPage(handler.m_buffer, m_pageSize).init();
+    index = static_cast<uint32_t>(m_pages.size());
+    m_pages.push_back(handler.m_pId);
+    m_pageIndex[handler.m_pId] = index;
+    m_freeSpace.push_back(SlottedPage::capacity(m_pageSize) + sizeof(Slot));
+    m_freePages.insert(std::make_pair(m_freeSpace.back(), index));
+  }
+  SlottedPage page(handler.m_buffer, m_pageSize);
+  uint32_t slot;
+  page.insert(record, size, flags, &slot);
+  touch(index, page);
+  *rid = RecordId{m_pages[index], slot};
+  p_pool->unpin(m_pages[index]);
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode HeapFile::placeMoved( const RecordId& home, const char* record, const uint32_t size, RecordId* rid ) noexcept {
+  m_moved.resize(kRecordIdSize + size);
+  encodeRecordId(home, m_moved.data());
+  memcpy(m_moved.data() + kRecordIdSize, record, size);
+  return place(m_moved.data(), kRecordIdSize + size, kSlotMoved, rid);
+}
+
+ErrorCode HeapFile::eraseMoved( const RecordId& rid ) noexcept {
+  BufferHandler handler;
+  uint32_t index;
+  const ErrorCode error = pinPage(rid.m_page, &handler, &index);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  SlottedPage page(handler.m_buffer, m_pageSize);
+  page.erase(rid.m_slot);
+  touch(index, page);
+  p_pool->unpin(rid.m_page);
+  return ErrorCode::E_NO_ERROR;
+}
+
+void HeapFile::touch( const uint32_t index, const SlottedPage& page ) noexcept {
+  m_freePages.erase(std::make_pair(m_freeSpace[index], index));
+  m_freeSpace[index] = page.freeSpace();
+  m_freePages.insert(std::make_pair(m_freeSpace[index], index));
+  p_pool->setPageDirty(m_pages[index]);
+}
+
+SMILE_NS_END
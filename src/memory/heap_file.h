@@ -0,0 +1,168 @@
+
+
+
+#ifndef _MEMORY_HEAP_FILE_H_
+#define _MEMORY_HEAP_FILE_H_
+
+#include "../base/platform.h"
+#include "../base/error.h"
+#include "../storage/file_storage.h"
+#include "buffer_pool.h"
+#include "slotted_page.h"
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Identifier of a record of a heap file. It does not change when the record
+ * is updated, even if the record is moved to another page.
+ **/
+struct RecordId {
+  pageId_t  m_page;
+  uint32_t  m_slot;
+};
+
+/**
+ * Size of a record id stored in a page
+ **/
+constexpr uint32_t kRecordIdSize = sizeof(pageId_t) + sizeof(uint32_t);
+
+static_assert(kRecordIdSize <= kMinRecordSpace, "A forwarding record id must fit the space of any record");
+
+/**
+ * Function called for each record of a scan, with the record id, the record
+ * and its size. The record points into a pinned page, valid during the call.
+ **/
+using RecordScanFunction = std::function<void(const RecordId&, const char*, uint32_t)>;
+
+/**
+ * Unordered file of variable size records, stored in slotted pages of the
+ * Buffer Pool. The free space of the pages is kept in memory, and records are
+ * inserted in the fullest page that fits them. A record that grows past the
+ * free space of its page is moved to another page, and its slot is replaced
+ * by the id of its new location, so record ids stay valid.
+ **/
+class HeapFile {
+    SMILE_NON_COPYABLE(HeapFile);
+  public:
+    /**
+     * @param in storage The storage of the Buffer Pool
+     * @param in pool The Buffer Pool the pages are pinned from
+     **/
+    HeapFile( FileStorage* storage, BufferPool* pool ) noexcept;
+    ~HeapFile() noexcept = default;
+
+    /**
+     * Opens a heap file stored in the given pages, rebuilding the free space
+     * of each one
+     * @param in pages The pages of the file, as returned by pages()
+     **/
+    ErrorCode open( const std::vector<pageId_t>& pages ) noexcept;
+
+    /**
+     * Inserts a record
+     * @param in record The record
+     * @param in size The size of the record. At most maxRecordSize().
+     * @param out rid The id of the record
+     **/
+    ErrorCode insert( const char* record, const uint32_t size, RecordId* rid ) noexcept;
+
+    /**
+     * Reads a record
+     * @param in rid The id of the record
+     * @param out record The content of the record
+     **/
+    ErrorCode read( const RecordId& rid, std::vector<char>* record ) noexcept;
+
+    /**
+     * Replaces the content of a record
+     * @param in rid The id of the record
+     * @param in record The new content of the record
+     * @param in size The new size of the record. At most maxRecordSize().
+     **/
+    ErrorCode update( const RecordId& rid, const char* record, const uint32_t size ) noexcept;
+
+    /**
+     * Deletes a record
+     * @param in rid The id of the record
+     **/
+    ErrorCode erase( const RecordId& rid ) noexcept;
+
+    /**
+     * Calls a function for each record of the file, page by page
+     * @param in f The function
+     **/
+    ErrorCode scan( const RecordScanFunction& f ) noexcept;
+
+    /**
+     * Gets the pages of the file
+     **/
+    const std::vector<pageId_t>& pages() const noexcept {
+      return m_pages;
+    }
+
+    /**
+     * Gets the size of the largest record. Records must leave room for the id
+     * of their home slot, in case they are moved.
+     **/
+    uint32_t maxRecordSize() const noexcept {
+      return SlottedPage::capacity(m_pageSize) - kRecordIdSize;
+    }
+
+  private:
+
+    /**
+     * Pins a page of the file
+     * @param in page The page
+     * @param out handler The handler of the pinned page
+     * @param out index The index of the page in m_pages
+     **/
+    ErrorCode pinPage( const pageId_t page, BufferHandler* handler, uint32_t* index ) noexcept;
+
+    /**
+     * Inserts a record in the fullest page with room for it, allocating a new
+     * page if none has
+     * @param in record The record
+     * @param in size The size of the record
+     * @param in flags The flags of the slot of the record
+     * @param out rid The id of the record
+     **/
+    ErrorCode place( const char* record, const uint32_t size, const uint32_t flags, RecordId* rid ) noexcept;
+
+    /**
+     * Inserts a record moved from its home slot, prefixed with the home slot
+     **/
+    ErrorCode placeMoved( const RecordId& home, const char* record, const uint32_t size, RecordId* rid ) noexcept;
+
+    /**
+     * Deletes a record moved from its home slot
+     **/
+    ErrorCode eraseMoved( const RecordId& rid ) noexcept;
+
+    /**
+     * Updates the free space of a page after a change, and sets it dirty
+     **/
+    void touch( const uint32_t index, const SlottedPage& page ) noexcept;
+
+    BufferPool*                                   p_pool;
+    uint32_t                                      m_pageSize;
+
+    // The pages of the file, and their index in m_pages
+    std::vector<pageId_t>                         m_pages;
+    std::unordered_map<pageId_t, uint32_t>        m_pageIndex;
+
+    // The free space of each page, and the pages sorted by free space
+    std::vector<uint32_t>                         m_freeSpace;
+    std::set<std::pair<uint32_t, uint32_t>>       m_freePages;
+
+    // Buffer of the records moved to another page
+    std::vector<char>                             m_moved;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _MEMORY_HEAP_FILE_H_ */
@@ -0,0 +1,121 @@
+
+
+
+#include "slotted_page.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+void SlottedPage::init() noexcept {
+  SlottedPageHeader* h = header();
+  h->m_numSlots = 0;
+  h->m_dataStart = m_pageSize;
+  h->m_holeBytes = 0;
+  h->m_reserved = 0;
+}
+
+bool SlottedPage::insert( const char* record, const uint32_t size, const uint32_t flags, uint32_t* slot ) noexcept {
+  SlottedPageHeader* h = header();
+  // Free slots are reused before the directory grows
+  uint32_t free = 0;
+  while( free < h->m_numSlots && slots()[free].m_offset != 0 ) {
+    ++free;
+  }
+  const uint32_t slotSpace = free == h->m_numSlots ? sizeof(Slot) : 0;
+  if( footprint(size) + slotSpace > freeSpace() ) {
+    return false;
+  }
+  if( slotSpace > 0 ) {
+    if( contiguousSpace() < sizeof(Slot) ) {
+      compact();
+    }
+    slots()[h->m_numSlots++] = Slot{0, 0};
+  }
+  const uint32_t offset = allocate(footprint(size));
+  memcpy(p_data + offset, record, size);
+  slots()[free] = Slot{offset, size | flags};
+  *slot = free;
+  return true;
+}
+
+bool SlottedPage::get( const uint32_t slot, const char** record, uint32_t* size, uint32_t* flags ) const noexcept {
+  if( slot >= numSlots() || slots()[slot].m_offset == 0 ) {
+    return false;
+  }
+  const Slot& entry = slots()[slot];
+  *record = p_data + entry.m_offset;
+  *size = entry.m_size & kSlotSizeMask;
+  *flags = entry.m_size & ~kSlotSizeMask;
+  return true;
+}
+
+bool SlottedPage::update( const uint32_t slot, const char* record, const uint32_t size, const uint32_t flags ) noexcept {
+  Slot& entry = slots()[slot];
+  const uint32_t oldSpace = footprint(entry.m_size & kSlotSizeMask);
+  const uint32_t newSpace = footprint(size);
+  if( newSpace <= oldSpace ) {
+    memcpy(p_data + entry.m_offset, record, size);
+    header()->m_holeBytes += oldSpace - newSpace;
+    entry.m_size = size | flags;
+    return true;
+  }
+  if( newSpace > freeSpace() + oldSpace ) {
+    return false;
+  }
+  // The old space becomes a hole, reclaimed by the compaction if needed
+  header()->m_holeBytes += oldSpace;
+  entry.m_offset = 0;
+  const uint32_t offset = allocate(newSpace);
+  memcpy(p_data + offset, record, size);
+  slots()[slot] = Slot{offset, size | flags};
+  return true;
+}
+
+void SlottedPage::erase( const uint32_t slot ) noexcept {
+  SlottedPageHeader* h = header();
+  Slot& entry = slots()[slot];
+  h->m_holeBytes += footprint(entry.m_size & kSlotSizeMask);
+  entry = Slot{0, 0};
+  // Free slots at the end of the directory are returned to the free space
+  while( h->m_numSlots > 0 && slots()[h->m_numSlots - 1].m_offset == 0 ) {
+    --h->m_numSlots;
+  }
+}
+
+void SlottedPage::compact() noexcept {
+  SlottedPageHeader* h = header();
+  std::vector<uint32_t> order;
+  for( uint32_t slot = 0; slot < h->m_numSlots; ++slot ) {
+    if( slots()[slot].m_offset != 0 ) {
+      order.push_back(slot);
+    }
+  }
+  // Records are moved towards the end of the page from the last one, so a
+  // record never overwrites one not moved yet
+  std::sort(order.begin(), order.end(), [&]( const uint32_t a, const uint32_t b ) {
+    return slots()[a].m_offset > slots()[b].m_offset;
+  });
+  uint32_t end = m_pageSize;
+  for( const uint32_t slot : order ) {
+    Slot& entry = slots()[slot];
+    const uint32_t space = footprint(entry.m_size & kSlotSizeMask);
+    end -= space;
+    memmove(p_data + end, p_data + entry.m_offset, space);
+    entry.m_offset = end;
+  }
+  h->m_dataStart = end;
+  h->m_holeBytes = 0;
+}
+
+uint32_t SlottedPage::allocate( const uint32_t size ) noexcept {
+  if( contiguousSpace() < size ) {
+    compact();
+  }
+  SlottedPageHeader* h = header();
+  h->m_dataStart -= size;
+  return h->m_dataStart;
+}
+
+SMILE_NS_END
@@ -0,0 +1,191 @@
+
+
+
+#ifndef _MEMORY_SLOTTED_PAGE_H_
+#define _MEMORY_SLOTTED_PAGE_H_
+
+#include "../base/platform.h"
+
+SMILE_NS_BEGIN
+
+/**
+ * Flag of a slot whose record was moved to another page. The slot holds the
+ * id of the record at its new location.
+ **/
+constexpr uint32_t kSlotForwarded = 1u << 31;
+
+/**
+ * Flag of a record moved from another page. The record starts with the id of
+ * the slot it was moved from.
+ **/
+constexpr uint32_t kSlotMoved     = 1u << 30;
+
+/**
+ * Mask of the size bits of a slot
+ **/
+constexpr uint32_t kSlotSizeMask  = kSlotMoved - 1;
+
+/**
+ * Smallest space taken by a record in a page, so that any record can be
+ * replaced by a forwarding record id
+ **/
+constexpr uint32_t kMinRecordSpace = 12;
+
+struct SlottedPageHeader {
+  // The number of slots of the directory, free ones included
+  uint32_t  m_numSlots;
+
+  // The offset of the lowest record. Records are stored from the end of the
+  // page towards the slot directory.
+  uint32_t  m_dataStart;
+
+  // The bytes of the records area not used by any record
+  uint32_t  m_holeBytes;
+
+  uint32_t  m_reserved;
+};
+
+struct Slot {
+  // The offset of the record in the page. 0 if the slot is free.
+  uint32_t  m_offset;
+
+  // The size of the record, and the kSlotForwarded and kSlotMoved flags
+  uint32_t  m_size;
+};
+
+/**
+ * View of a page as a slotted page: a header, followed by a directory of
+ * slots that grows forwards, and records packed from the end of the page
+ * backwards. Records are addressed by their slot, which does not change when
+ * the records are moved within the page, so the holes left by deleted or
+ * shrunk records are reclaimed by compacting the page in place.
+ **/
+class SlottedPage {
+  public:
+    /**
+     * @param in data The page. Must outlive the view.
+     * @param in pageSize The size of the page in bytes
+     **/
+    SlottedPage( char* data, const uint32_t pageSize ) noexcept :
+      p_data(data),
+      m_pageSize(pageSize) {
+    }
+    ~SlottedPage() noexcept = default;
+
+    /**
+     * Formats the page as an empty slotted page
+     **/
+    void init() noexcept;
+
+    /**
+     * Gets the size of the largest record an empty page stores
+     **/
+    static uint32_t capacity( const uint32_t pageSize ) noexcept {
+      return pageSize - sizeof(SlottedPageHeader) - sizeof(Slot);
+    }
+
+    /**
+     * Gets the space a record takes in a page, without its slot
+     **/
+    static uint32_t footprint( const uint32_t size ) noexcept {
+      return size < kMinRecordSpace ? kMinRecordSpace : size;
+    }
+
+    /**
+     * Gets the number of slots of the directory, free ones included
+     **/
+    uint32_t numSlots() const noexcept {
+      return header()->m_numSlots;
+    }
+
+    /**
+     * Gets the free bytes of the page, once compacted. Inserting a record
+     * also needs a slot, unless a free one is reused.
+     **/
+    uint32_t freeSpace() const noexcept {
+      return contiguousSpace() + header()->m_holeBytes;
+    }
+
+    /**
+     * Inserts a record, compacting the page if the free space is fragmented
+     * @param in record The record
+     * @param in size The size of the record
+     * @param in flags The flags of the slot
+     * @param out slot The slot of the record
+     * @return false if the page has no room for the record
+     **/
+    bool insert( const char* record, const uint32_t size, const uint32_t flags, uint32_t* slot ) noexcept;
+
+    /**
+     * Gets a record
+     * @param in slot The slot of the record
+     * @param out record The record, pointing into the page
+     * @param out size The size of the record
+     * @param out flags The flags of the slot
+     * @return false if the slot is free or out of the directory
+     **/
+    bool get( const uint32_t slot, const char** record, uint32_t* size, uint32_t* flags ) const noexcept;
+
+    /**
+     * Replaces a record, keeping its slot. The record is overwritten in place
+     * if it does not grow, and moved within the page otherwise.
+     * @param in slot The slot of the record. Must be used.
+     * @param in record The new record. Must not point into the page.
+     * @param in size The size of the new record
+     * @param in flags The new flags of the slot
+     * @return false if the page has no room for the record, which is then
+     * left unchanged
+     **/
+    bool update( const uint32_t slot, const char* record, const uint32_t size, const uint32_t flags ) noexcept;
+
+    /**
+     * Deletes a record and frees its slot
+     * @param in slot The slot of the record. Must be used.
+     **/
+    void erase( const uint32_t slot ) noexcept;
+
+    /**
+     * Moves the records to the end of the page, so that all the free space
+     * is contiguous
+     **/
+    void compact() noexcept;
+
+  private:
+
+    SlottedPageHeader* header() noexcept {
+      return reinterpret_cast<SlottedPageHeader*>(p_data);
+    }
+
+    const SlottedPageHeader* header() const noexcept {
+      return reinterpret_cast<const SlottedPageHeader*>(p_data);
+    }
+
+    Slot* slots() noexcept {
+      return reinterpret_cast<Slot*>(p_data + sizeof(SlottedPageHeader));
+    }
+
+    const Slot* slots() const noexcept {
+      return reinterpret_cast<const Slot*>(p_data + sizeof(SlottedPageHeader));
+    }
+
+    /**
+     * Gets the bytes between the slot directory and the records
+     **/
+    uint32_t contiguousSpace() const noexcept {
+      const SlottedPageHeader* h = header();
+      return h->m_dataStart - sizeof(SlottedPageHeader) - h->m_numSlots*sizeof(Slot);
+    }
+
+    /**
+     * Allocates the space of a record at the start of the records area,
+     * compacting the page if needed. The page must have room for it.
+     **/
+    uint32_t allocate( const uint32_t size ) noexcept;
+
+    char*     p_data;
+    uint32_t  m_pageSize;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _MEMORY_SLOTTED_PAGE_H_ */
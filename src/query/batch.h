@@ -0,0 +1,242 @@
+
+
+
+#ifndef _QUERY_BATCH_H_
+#define _QUERY_BATCH_H_
+
+#include "../base/base.h"
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Number of rows of a batch. With 8 byte values a column of a batch takes
+ * 8KB, so the few columns an operator works on at once stay in the L1/L2
+ * caches.
+ **/
+constexpr uint32_t kBatchSize = 1024;
+
+/**
+ * Types of the values processed by the operators. Integral attributes (bool,
+ * integers and timestamps) are widened to E_INT and floating point attributes
+ * to E_REAL when they are scanned.
+ **/
+enum class ValueType {
+  E_INT,
+  E_REAL
+};
+
+/**
+ * A constant used in predicates and expressions
+ **/
+struct Value {
+  ValueType m_type;
+  int64_t   m_int;
+  double    m_real;
+
+  static Value integer( const int64_t value ) noexcept {
+    return Value{ValueType::E_INT, value, static_cast<double>(value)};
+  }
+
+  static Value real( const double value ) noexcept {
+    return Value{ValueType::E_REAL, static_cast<int64_t>(value), value};
+  }
+};
+
+/**
+ * A column of a batch. Only the array of its type is used.
+ **/
+struct Vector {
+  ValueType             m_type = ValueType::E_INT;
+  std::vector<int64_t>  m_ints;
+  std::vector<double>   m_reals;
+
+  /**
+   * Sets the type of the vector and makes room for a batch
+   **/
+  void reset( const ValueType type ) noexcept {
+    m_type = type;
+    if( type == ValueType::E_INT ) {
+      m_ints.resize(kBatchSize);
+    } else {
+      m_reals.resize(kBatchSize);
+    }
+  }
+};
+
+/**
+ * A batch of rows, stored by column
+ **/
+class Batch {
+  public:
+    Batch() noexcept = default;
+    ~Batch() noexcept = default;
+
+    /**
+     * Sets the column types of the batch and empties it
+     **/
+    void reset( const std::vector<ValueType>& types ) noexcept {
+      m_columns.resize(types.size());
+      for( size_t i = 0; i < types.size(); ++i ) {
+        m_columns[i].reset(types[i]);
+      }
+      m_size = 0;
+    }
+
+    uint32_t size() const noexcept {
+      return m_size;
+    }
+
+    void setSize( const uint32_t size ) noexcept {
+      m_size = size;
+    }
+
+    uint32_t numColumns() const noexcept {
+      return static_cast<uint32_t>(m_columns.size());
+    }
+
+    Vector& column( const uint32_t i ) noexcept {
+      return m_columns[i];
+    }
+
+    const Vector& column( const uint32_t i ) const noexcept {
+      return m_columns[i];
+    }
+
+    int64_t* ints( const uint32_t i ) noexcept {
+      return m_columns[i].m_ints.data();
+    }
+
+    const int64_t* ints( const uint32_t i ) const noexcept {
+      return m_columns[i].m_ints.data();
+    }
+
+    double* reals( const uint32_t i ) noexcept {
+      return m_columns[i].m_reals.data();
+    }
+
+    const double* reals( const uint32_t i ) const noexcept {
+      return m_columns[i].m_reals.data();
+    }
+
+  private:
+    std::vector<Vector> m_columns;
+    uint32_t            m_size = 0;
+};
+
+/**
+ * Growable column storage used by the operators that have to keep their
+ * input, such as the build side of a join or the input of a sort
+ **/
+class BatchBuffer {
+  public:
+    BatchBuffer() noexcept = default;
+    ~BatchBuffer() noexcept = default;
+
+    /**
+     * Sets the column types of the buffer and empties it
+     **/
+    void reset( const std::vector<ValueType>& types ) noexcept {
+      m_columns.assign(types.size(), Vector());
+      for( size_t i = 0; i < types.size(); ++i ) {
+        m_columns[i].m_type = types[i];
+      }
+      m_size = 0;
+    }
+
+    /**
+     * Appends the rows of a batch
+     **/
+    void append( const Batch& batch ) noexcept {
+      for( uint32_t i = 0; i < m_columns.size(); ++i ) {
+        Vector& column = m_columns[i];
+        if( column.m_type == ValueType::E_INT ) {
+          column.m_ints.insert(column.m_ints.end(), batch.ints(i), batch.ints(i) + batch.size());
+        } else {
+          column.m_reals.insert(column.m_reals.end(), batch.reals(i), batch.reals(i) + batch.size());
+        }
+      }
+      m_size += batch.size();
+    }
+
+    /**
+     * Copies a set of rows into consecutive columns of a batch
+     * @param in rows The rows to copy
+     * @param in count The number of rows
+     * @param out batch The batch. Its size is not modified.
+     * @param in firstColumn The column of the batch where the first column
+     * of the buffer is copied
+     **/
+    void gather( const uint64_t* rows, const uint32_t count, Batch* batch, const uint32_t firstColumn ) const noexcept {
+      for( uint32_t i = 0; i < m_columns.size(); ++i ) {
+        const Vector& column = m_columns[i];
+        if( column.m_type == ValueType::E_INT ) {
+          int64_t* out = batch->ints(firstColumn + i);
+          for( uint32_t j = 0; j < count; ++j ) {
+            out[j] = column.m_ints[rows[j]];
+          }
+        } else {
+          double* out = batch->reals(firstColumn + i);
+          for( uint32_t j = 0; j < count; ++j ) {
+            out[j] = column.m_reals[rows[j]];
+          }
+        }
+      }
+    }
+
+    uint64_t size() const noexcept {
+      return m_size;
+    }
+
+    const Vector& column( const uint32_t i ) const noexcept {
+      return m_columns[i];
+    }
+
+  private:
+    std::vector<Vector> m_columns;
+    uint64_t            m_size = 0;
+};
+
+/**
+ * Copies a set of rows of a batch into consecutive columns of another batch
+ * @param in input The batch to copy from
+ * @param in rows The rows to copy
+ * @param in count The number of rows
+ * @param out output The batch to copy to. Its size is not modified.
+ * @param in firstColumn The column of output where the first column of input
+ * is copied
+ **/
+inline void gather( const Batch& input, const uint32_t* rows, const uint32_t count, Batch* output, const uint32_t firstColumn ) noexcept {
+  for( uint32_t i = 0; i < input.numColumns(); ++i ) {
+    if( input.column(i).m_type == ValueType::E_INT ) {
+      const int64_t* in = input.ints(i);
+      int64_t* out = output->ints(firstColumn + i);
+      for( uint32_t j = 0; j < count; ++j ) {
+        out[j] = in[rows[j]];
+      }
+    } else {
+      const double* in = input.reals(i);
+      double* out = output->reals(firstColumn + i);
+      for( uint32_t j = 0; j < count; ++j ) {
+        out[j] = in[rows[j]];
+      }
+    }
+  }
+}
+
+/**
+ * Hashes an integer key (murmur3 finalizer)
+ **/
+inline uint64_t hashKey( const int64_t key ) noexcept {
+  uint64_t h = static_cast<uint64_t>(key);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _QUERY_BATCH_H_ */
@@ -0,0 +1,320 @@
+
+
+
+#ifndef _QUERY_GROUP_BY_H_
+#define _QUERY_GROUP_BY_H_
+
+#include "../base/base.h"
+#include "../base/parallel.h"
+#include "../data/table.h"
+#include "batch.h"
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+struct GroupByConfig {
+  /**
+   * Number of threads used to aggregate
+   */
+  uint32_t  m_numThreads  = 1;
+
+  /**
+   * Key ranges (max - min + 1) up to this size are aggregated by indexing
+   * an array with the key. 0 always uses hashing.
+   */
+  uint64_t  m_denseDomain = 64*1024;
+
+  /**
+   * Number of radix bits of the partitions pre-aggregated groups are spilled
+   * to, and merged by. At most 16; 0 uses a single partition.
+   */
+  uint32_t  m_radixBits   = 6;
+
+  /**
+   * Size of the cache the per thread pre-aggregation tables should fit in,
+   * in bytes
+   */
+  uint64_t  m_cacheBytes  = 256*1024;
+};
+
+/**
+ * Number of rows read from the tables at once
+ **/
+constexpr uint64_t kGroupByBlock = 4096;
+
+/**
+ * Count, sum, minimum and maximum of the values of a group. Sums of integers
+ * are kept as 64 bit integers, and sums of reals as doubles.
+ **/
+template<typename K, typename V>
+struct Group {
+  using Sum = typename std::conditional<std::is_floating_point<V>::value, double,
+              typename std::conditional<std::is_signed<V>::value, int64_t, uint64_t>::type>::type;
+
+  K         m_key   = K();
+  uint64_t  m_count = 0;
+  Sum       m_sum   = 0;
+  V         m_min   = std::numeric_limits<V>::max();
+  V         m_max   = std::numeric_limits<V>::lowest();
+
+  void add( const V value ) noexcept {
+    ++m_count;
+    m_sum += value;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  void merge( const Group& other ) noexcept {
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+  }
+
+  double average() const noexcept {
+    return m_count > 0 ? static_cast<double>(m_sum) / m_count : std::numeric_limits<double>::quiet_NaN();
+  }
+};
+
+/**
+ * Open addressing table of groups with a fixed capacity, used for the per
+ * thread pre-aggregation and for the final merge of a partition
+ **/
+template<typename K, typename V>
+class GroupTable {
+  public:
+    /**
+     * Clears the table and sizes it for a number of groups
+     **/
+    void reset( const uint64_t capacity ) noexcept {
+      uint64_t numSlots = 16;
+      while( numSlots < 2*capacity ) {
+        numSlots *= 2;
+      }
+      m_slots.assign(numSlots, 0);
+      m_groups.clear();
+      m_groups.reserve(capacity);
+    }
+
+    /**
+     * Finds the group of a key, adding it if missing
+     **/
+    Group<K, V>& find( const K key, const uint64_t hash ) noexcept {
+      const uint64_t mask = m_slots.size() - 1;
+      uint64_t slot = hash & mask;
+      while( m_slots[slot] != 0 ) {
+        Group<K, V>& group = m_groups[m_slots[slot] - 1];
+        if( group.m_key == key ) {
+          return group;
+        }
+        slot = (slot + 1) & mask;
+      }
+      m_groups.emplace_back();
+      m_groups.back().m_key = key;
+      m_slots[slot] = static_cast<uint32_t>(m_groups.size());
+      return m_groups.back();
+    }
+
+    /**
+     * Whether the table holds half as many groups as slots
+     **/
+    bool full() const noexcept {
+      return 2*m_groups.size() >= m_slots.size();
+    }
+
+    std::vector<Group<K, V>>& groups() noexcept {
+      return m_groups;
+    }
+
+  private:
+    std::vector<uint32_t>     m_slots;
+    std::vector<Group<K, V>>  m_groups;
+};
+
+/**
+ * Groups the rows of a table by a key column and aggregates a value column.
+ * If the keys span a small range, each thread aggregates into an array
+ * indexed by the key, and the arrays are summed at the end. Otherwise each
+ * thread pre-aggregates into a cache sized hash table, which is spilled into
+ * radix partitions when full; the partitions are then merged in parallel,
+ * each one in its own cache sized table.
+ * @param in keys The key column. K must be an integral type.
+ * @param in values The value column, with a value per key, or nullptr to
+ * only count the rows of each group
+ * @param in config The configuration of the aggregation
+ * @param out groups The groups, by increasing key
+ **/
+template<typename K, typename V>
+void groupBy( const ITypedTable<K>& keys,
+              const ITypedTable<V>* values,
+              const GroupByConfig& config,
+              std::vector<Group<K, V>>* groups ) noexcept {
+  static_assert(std::is_integral<K>::value, "Group by keys must be integral");
+  static_assert(std::is_arithmetic<V>::value, "Group by values must be arithmetic");
+  groups->clear();
+  const uint64_t size = keys.size();
+  const uint64_t numBlocks = (size + kGroupByBlock - 1) / kGroupByBlock;
+  const uint32_t numThreads = std::max<uint32_t>(config.m_numThreads, 1);
+  if( size == 0 ) {
+    return;
+  }
+
+  // Applies a function to the keys and values of a block
+  auto forBlock = [&]( const uint64_t block, auto f ) {
+    K keyBuffer[kGroupByBlock];
+    V valueBuffer[kGroupByBlock];
+    const uint64_t first = block*kGroupByBlock;
+    const uint64_t count = std::min(kGroupByBlock, size - first);
+    keys.getBulk(first, count, keyBuffer);
+    if( values != nullptr ) {
+      values->getBulk(first, count, valueBuffer);
+    }
+    f(keyBuffer, valueBuffer, count);
+  };
+
+  // The key range is known from the type for small key types (typeid_t),
+  // and computed otherwise. Keys are offset as unsigned integers, which
+  // also works for negative keys.
+  K minKey = std::numeric_limits<K>::min();
+  K maxKey = std::numeric_limits<K>::max();
+  if( sizeof(K) > 2 && config.m_denseDomain > 0 ) {
+    std::unique_ptr<K[]> mins(new K[numThreads]);
+    std::unique_ptr<K[]> maxs(new K[numThreads]);
+    std::fill(mins.get(), mins.get() + numThreads, std::numeric_limits<K>::max());
+    std::fill(maxs.get(), maxs.get() + numThreads, std::numeric_limits<K>::min());
+    parallelFor(0, numBlocks, numThreads, 1, [&]( const uint64_t block, const uint32_t thread ) {
+      K buffer[kGroupByBlock];
+      const uint64_t first = block*kGroupByBlock;
+      const uint64_t count = std::min(kGroupByBlock, size - first);
+      keys.getBulk(first, count, buffer);
+      const auto bounds = std::minmax_element(buffer, buffer + count);
+      mins[thread] = std::min(mins[thread], *bounds.first);
+      maxs[thread] = std::max(maxs[thread], *bounds.second);
+    });
+    minKey = *std::min_element(mins.get(), mins.get() + numThreads);
+    maxKey = *std::max_element(maxs.get(), maxs.get() + numThreads);
+  }
+  const uint64_t base = static_cast<uint64_t>(minKey);
+  const uint64_t span = static_cast<uint64_t>(maxKey) - base;
+
+  if( span < config.m_denseDomain ) {
+    const uint64_t domain = span + 1;
+    // Dense path: direct array indexing
+    std::vector<std::vector<Group<K, V>>> partials(numThreads);
+    parallelFor(0, numBlocks, numThreads, 1, [&]( const uint64_t block, const uint32_t thread ) {
+      std::vector<Group<K, V>>& local = partials[thread];
+      if( local.empty() ) {
+        local.resize(domain);
+      }
+      forBlock(block, [&]( const K* k, const V* v, const uint64_t count ) {
+        if( values != nullptr ) {
+          for( uint64_t i = 0; i < count; ++i ) {
+            local[static_cast<uint64_t>(k[i]) - base].add(v[i]);
+          }
+        } else {
+          for( uint64_t i = 0; i < count; ++i ) {
+            ++local[static_cast<uint64_t>(k[i]) - base].m_count;
+          }
+        }
+      });
+    });
+    std::vector<Group<K, V>> merged(domain);
+    parallelFor(0, domain, numThreads, 4096, [&]( const uint64_t key, const uint32_t ) {
+      for( const std::vector<Group<K, V>>& local : partials ) {
+        if( !local.empty() ) {
+          merged[key].merge(local[key]);
+        }
+      }
+    });
+    for( uint64_t key = 0; key < domain; ++key ) {
+      if( merged[key].m_count > 0 ) {
+        merged[key].m_key = static_cast<K>(key + base);
+        groups->push_back(merged[key]);
+      }
+    }
+    return;
+  }
+
+  // Hash path: per thread pre-aggregation spilled into radix partitions
+  const uint32_t bits = std::min<uint32_t>(config.m_radixBits, 16);
+  const uint64_t numPartitions = 1ULL << bits;
+  const uint64_t tableCapacity = std::max<uint64_t>(config.m_cacheBytes / (2*sizeof(Group<K, V>)), 64);
+  std::vector<GroupTable<K, V>> tables(numThreads);
+  std::vector<std::vector<Group<K, V>>> spills(numThreads*numPartitions);
+  auto spill = [&]( const uint32_t thread ) {
+    for( const Group<K, V>& group : tables[thread].groups() ) {
+      // The high bits of the hash select the partition. Shifting by 64 is
+      // undefined, so no radix bits means a single partition.
+      const uint64_t partition = bits == 0 ? 0 : hashKey(static_cast<int64_t>(group.m_key)) >> (64 - bits);
+      spills[thread*numPartitions + partition].push_back(group);
+    }
+    tables[thread].reset(tableCapacity);
+  };
+  for( GroupTable<K, V>& table : tables ) {
+    table.reset(tableCapacity);
+  }
+  parallelFor(0, numBlocks, numThreads, 1, [&]( const uint64_t block, const uint32_t thread ) {
+    GroupTable<K, V>& table = tables[thread];
+    forBlock(block, [&]( const K* k, const V* v, const uint64_t count ) {
+      for( uint64_t i = 0; i < count; ++i ) {
+        Group<K, V>& group = table.find(k[i], hashKey(static_cast<int64_t>(k[i])));
+        if( values != nullptr ) {
+          group.add(v[i]);
+        } else {
+          ++group.m_count;
+        }
+        if( table.full() ) {
+          spill(thread);
+        }
+      }
+    });
+  });
+  for( uint32_t thread = 0; thread < numThreads; ++thread ) {
+    spill(thread);
+  }
+
+  std::vector<std::vector<Group<K, V>>> results(numPartitions);
+  parallelFor(0, numPartitions, numThreads, 1, [&]( const uint64_t partition, const uint32_t ) {
+    uint64_t total = 0;
+    for( uint32_t thread = 0; thread < numThreads; ++thread ) {
+      total += spills[thread*numPartitions + partition].size();
+    }
+    GroupTable<K, V> table;
+    table.reset(total);
+    for( uint32_t thread = 0; thread < numThreads; ++thread ) {
+      std::vector<Group<K, V>>& spilled = spills[thread*numPartitions + partition];
+      for( const Group<K, V>& group : spilled ) {
+        table.find(group.m_key, hashKey(static_cast<int64_t>(group.m_key))).merge(group);
+      }
+      std::vector<Group<K, V>>().swap(spilled);
+    }
+    results[partition].swap(table.groups());
+  });
+  for( std::vector<Group<K, V>>& result : results ) {
+    groups->insert(groups->end(), result.begin(), result.end());
+  }
+  std::sort(groups->begin(), groups->end(), []( const Group<K, V>& a, const Group<K, V>& b ) {
+    return a.m_key < b.m_key;
+  });
+}
+
+/**
+ * Counts the rows of each key of a column
+ * @param in keys The key column. K must be an integral type.
+ * @param in config The configuration of the aggregation
+ * @param out groups The groups, by increasing key. Only their counts are set.
+ **/
+template<typename K>
+void countBy( const ITypedTable<K>& keys,
+              const GroupByConfig& config,
+              std::vector<Group<K, K>>* groups ) noexcept {
+  groupBy<K, K>(keys, nullptr, config, groups);
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _QUERY_GROUP_BY_H_ */
@@ -0,0 +1,265 @@
+
+
+
+#include "hash_aggregate.h"
+#include <algorithm>
+#include <limits>
+
+SMILE_NS_BEGIN
+
+HashAggregateOperator::HashAggregateOperator( std::unique_ptr<Operator> child,
+                                              const std::vector<uint32_t>& keys,
+                                              const std::vector<Aggregate>& aggregates ) noexcept :
+  p_child(std::move(child)),
+  m_keys(keys),
+  m_aggregates(aggregates),
+  m_rowGroups(kBatchSize) {
+}
+
+ErrorCode HashAggregateOperator::open() noexcept {
+  const ErrorCode error = p_child->open();
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  const std::vector<ValueType>& input = p_child->types();
+  m_types.clear();
+  for( const uint32_t key : m_keys ) {
+    if( key >= input.size() ) {
+      return ErrorCode::E_QUERY_INVALID_COLUMN;
+    }
+    if( input[key] != ValueType::E_INT ) {
+      return ErrorCode::E_QUERY_INVALID_TYPE;
+    }
+    m_types.push_back(ValueType::E_INT);
+  }
+  for( const Aggregate& aggregate : m_aggregates ) {
+    if( aggregate.m_function == AggregateFunction::E_COUNT ) {
+      m_types.push_back(ValueType::E_INT);
+      continue;
+    }
+    if( aggregate.m_column >= input.size() ) {
+      return ErrorCode::E_QUERY_INVALID_COLUMN;
+    }
+    m_types.push_back(aggregate.m_function == AggregateFunction::E_AVERAGE ? ValueType::E_REAL : input[aggregate.m_column]);
+  }
+
+  m_groupKeys.clear();
+  m_groupHashes.clear();
+  m_counts.clear();
+  m_states.assign(m_aggregates.size(), AggregateState());
+  m_slots.assign(16, 0);
+  m_numGroups = 0;
+  if( m_keys.empty() ) {
+    addGroup();
+  }
+  m_consumed = false;
+  m_nextGroup = 0;
+  return ErrorCode::E_NO_ERROR;
+}
+
+void HashAggregateOperator::addGroup() noexcept {
+  m_counts.push_back(0);
+  const std::vector<ValueType>& input = p_child->types();
+  for( uint32_t i = 0; i < m_aggregates.size(); ++i ) {
+    const Aggregate& aggregate = m_aggregates[i];
+    AggregateState& state = m_states[i];
+    switch( aggregate.m_function ) {
+      case AggregateFunction::E_COUNT:
+        break;
+      case AggregateFunction::E_AVERAGE:
+        state.m_reals.push_back(0.0);
+        break;
+      case AggregateFunction::E_SUM:
+      case AggregateFunction::E_MIN:
+      case AggregateFunction::E_MAX:
+        if( input[aggregate.m_column] == ValueType::E_INT ) {
+          state.m_ints.push_back(aggregate.m_function == AggregateFunction::E_MIN ? std::numeric_limits<int64_t>::max() :
+                                 aggregate.m_function == AggregateFunction::E_MAX ? std::numeric_limits<int64_t>::min() : 0);
+        } else {
+          state.m_reals.push_back(aggregate.m_function == AggregateFunction::E_MIN ? std::numeric_limits<double>::infinity() :
+                                  aggregate.m_function == AggregateFunction::E_MAX ? -std::numeric_limits<double>::infinity() : 0.0);
+        }
+        break;
+    }
+  }
+  ++m_numGroups;
+}
+
+void HashAggregateOperator::grow() noexcept {
+  m_slots.assign(m_slots.size()*2, 0);
+  const uint64_t mask = m_slots.size() - 1;
+  for( uint64_t group = 0; group < m_numGroups; ++group ) {
+    uint64_t slot = m_groupHashes[group] & mask;
+    while( m_slots[slot] != 0 ) {
+      slot = (slot + 1) & mask;
+    }
+    m_slots[slot] = group + 1;
+  }
+}
+
+uint64_t HashAggregateOperator::findGroup( const Batch& batch, const uint32_t row, const uint64_t hash ) noexcept {
+  const uint64_t mask = m_slots.size() - 1;
+  const uint64_t numKeys = m_keys.size();
+  uint64_t slot = hash & mask;
+  while( m_slots[slot] != 0 ) {
+    const uint64_t group = m_slots[slot] - 1;
+    if( m_groupHashes[group] == hash ) {
+      bool equal = true;
+      for( uint64_t k = 0; k < numKeys && equal; ++k ) {
+        equal = m_groupKeys[group*numKeys + k] == batch.ints(m_keys[k])[row];
+      }
+      if( equal ) {
+        return group;
+      }
+    }
+    slot = (slot + 1) & mask;
+  }
+  const uint64_t group = m_numGroups;
+  for( const uint32_t key : m_keys ) {
+    m_groupKeys.push_back(batch.ints(key)[row]);
+  }
+  m_groupHashes.push_back(hash);
+  addGroup();
+  m_slots[slot] = group + 1;
+  if( 2*m_numGroups > m_slots.size() ) {
+    grow();
+  }
+  return group;
+}
+
+void HashAggregateOperator::resolveGroups( const Batch& batch ) noexcept {
+  const uint32_t size = batch.size();
+  if( m_keys.empty() ) {
+    std::fill(m_rowGroups.begin(), m_rowGroups.begin() + size, 0);
+    return;
+  }
+  // The hashes of the rows are computed a key column at a time
+  uint64_t hashes[kBatchSize];
+  std::fill(hashes, hashes + size, 0);
+  for( const uint32_t key : m_keys ) {
+    const int64_t* values = batch.ints(key);
+    for( uint32_t i = 0; i < size; ++i ) {
+      hashes[i] = hashKey(values[i] ^ static_cast<int64_t>(hashes[i] * 0x9E3779B97F4A7C15ULL));
+    }
+  }
+  for( uint32_t i = 0; i < size; ++i ) {
+    m_rowGroups[i] = findGroup(batch, i, hashes[i]);
+  }
+}
+
+void HashAggregateOperator::consume() noexcept {
+  Batch batch;
+  while( p_child->next(&batch) ) {
+    resolveGroups(batch);
+    const uint32_t size = batch.size();
+    const uint64_t* groups = m_rowGroups.data();
+    for( uint32_t i = 0; i < size; ++i ) {
+      ++m_counts[groups[i]];
+    }
+    for( uint32_t a = 0; a < m_aggregates.size(); ++a ) {
+      const Aggregate& aggregate = m_aggregates[a];
+      if( aggregate.m_function == AggregateFunction::E_COUNT ) {
+        continue;
+      }
+      AggregateState& state = m_states[a];
+      const bool integer = batch.column(aggregate.m_column).m_type == ValueType::E_INT;
+      const int64_t* ints = integer ? batch.ints(aggregate.m_column) : nullptr;
+      const double* reals = integer ? nullptr : batch.reals(aggregate.m_column);
+      switch( aggregate.m_function ) {
+        case AggregateFunction::E_AVERAGE:
+          if( integer ) {
+            for( uint32_t i = 0; i < size; ++i ) {
+              state.m_reals[groups[i]] += static_cast<double>(ints[i]);
+            }
+          } else {
+            for( uint32_t i = 0; i < size; ++i ) {
+              state.m_reals[groups[i]] += reals[i];
+            }
+          }
+          break;
+        case AggregateFunction::E_SUM:
+          if( integer ) {
+            for( uint32_t i = 0; i < size; ++i ) {
+              state.m_ints[groups[i]] += ints[i];
+            }
+          } else {
+            for( uint32_t i = 0; i < size; ++i ) {
+              state.m_reals[groups[i]] += reals[i];
+            }
+          }
+          break;
+        case AggregateFunction::E_MIN:
+          if( integer ) {
+            for( uint32_t i = 0; i < size; ++i ) {
+              state.m_ints[groups[i]] = std::min(state.m_ints[groups[i]], ints[i]);
+            }
+          } else {
+            for( uint32_t i = 0; i < size; ++i ) {
+              state.m_reals[groups[i]] = std::min(state.m_reals[groups[i]], reals[i]);
+            }
+          }
+          break;
+        case AggregateFunction::E_MAX:
+          if( integer ) {
+            for( uint32_t i = 0; i < size; ++i ) {
+              state.m_ints[groups[i]] = std::max(state.m_ints[groups[i]], ints[i]);
+            }
+          } else {
+            for( uint32_t i = 0; i < size; ++i ) {
+              state.m_reals[groups[i]] = std::max(state.m_reals[groups[i]], reals[i]);
+            }
+          }
+          break;
+        case AggregateFunction::E_COUNT:
+          break;
+      }
+    }
+  }
+  m_consumed = true;
+}
+
+bool HashAggregateOperator::next( Batch* batch ) noexcept {
+  if( !m_consumed ) {
+    consume();
+  }
+  batch->reset(m_types);
+  if( m_nextGroup >= m_numGroups ) {
+    return false;
+  }
+  const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(kBatchSize, m_numGroups - m_nextGroup));
+  const uint64_t first = m_nextGroup;
+  const uint32_t numKeys = static_cast<uint32_t>(m_keys.size());
+  for( uint32_t k = 0; k < numKeys; ++k ) {
+    int64_t* out = batch->ints(k);
+    for( uint32_t i = 0; i < count; ++i ) {
+      out[i] = m_groupKeys[(first + i)*numKeys + k];
+    }
+  }
+  for( uint32_t a = 0; a < m_aggregates.size(); ++a ) {
+    const uint32_t column = numKeys + a;
+    const AggregateState& state = m_states[a];
+    switch( m_aggregates[a].m_function ) {
+      case AggregateFunction::E_COUNT:
+        std::copy(m_counts.begin() + first, m_counts.begin() + first + count, batch->ints(column));
+        break;
+      case AggregateFunction::E_AVERAGE:
+        for( uint32_t i = 0; i < count; ++i ) {
+          const int64_t rows = m_counts[first + i];
+          batch->reals(column)[i] = rows > 0 ? state.m_reals[first + i] / rows : std::numeric_limits<double>::quiet_NaN();
+        }
+        break;
+      default:
+        if( m_types[column] == ValueType::E_INT ) {
+          std::copy(state.m_ints.begin() + first, state.m_ints.begin() + first + count, batch->ints(column));
+        } else {
+          std::copy(state.m_reals.begin() + first, state.m_reals.begin() + first + count, batch->reals(column));
+        }
+        break;
+    }
+  }
+  batch->setSize(count);
+  m_nextGroup += count;
+  return true;
+}
+
+SMILE_NS_END
@@ -0,0 +1,120 @@
+
+
+
+#ifndef _QUERY_HASH_AGGREGATE_H_
+#define _QUERY_HASH_AGGREGATE_H_
+
+#include "../base/base.h"
+#include "operator.h"
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+enum class AggregateFunction {
+  E_COUNT,
+  E_SUM,
+  E_MIN,
+  E_MAX,
+  E_AVERAGE
+};
+
+/**
+ * An aggregate computed per group. The column is ignored by E_COUNT.
+ **/
+struct Aggregate {
+  AggregateFunction m_function;
+  uint32_t          m_column;
+};
+
+/**
+ * Groups its input by a set of integer columns and computes aggregates per
+ * group. For each input batch the group of every row is resolved first, with
+ * an open addressing hash table over the group keys; each aggregate is then
+ * updated in a separate loop over the batch. The output has the group keys
+ * followed by the aggregates, in the order groups were first seen. Without
+ * group keys a single row is produced, even for an empty input.
+ *
+ * E_COUNT produces integers, E_AVERAGE reals, and the other functions the
+ * type of their column.
+ **/
+class HashAggregateOperator : public Operator {
+    SMILE_NON_COPYABLE(HashAggregateOperator);
+  public:
+    HashAggregateOperator( std::unique_ptr<Operator> child,
+                           const std::vector<uint32_t>& keys,
+                           const std::vector<Aggregate>& aggregates ) noexcept;
+    virtual ~HashAggregateOperator() noexcept = default;
+
+    ErrorCode open() noexcept override;
+
+    bool next( Batch* batch ) noexcept override;
+
+  private:
+
+    /**
+     * The state of an aggregate, per group
+     **/
+    struct AggregateState {
+      std::vector<int64_t>  m_ints;
+      std::vector<double>   m_reals;
+    };
+
+    /**
+     * Consumes the input and computes the aggregates
+     **/
+    void consume() noexcept;
+
+    /**
+     * Resolves the group of each row of a batch, creating new groups
+     **/
+    void resolveGroups( const Batch& batch ) noexcept;
+
+    /**
+     * Finds or creates the group of a row
+     **/
+    uint64_t findGroup( const Batch& batch, const uint32_t row, const uint64_t hash ) noexcept;
+
+    /**
+     * Doubles the size of the hash table
+     **/
+    void grow() noexcept;
+
+    /**
+     * Adds a group
+     **/
+    void addGroup() noexcept;
+
+    std::unique_ptr<Operator>   p_child;
+    std::vector<uint32_t>       m_keys;
+    std::vector<Aggregate>      m_aggregates;
+
+    // The keys of the groups, numKeys values per group
+    std::vector<int64_t>        m_groupKeys;
+
+    // The hash of each group
+    std::vector<uint64_t>       m_groupHashes;
+
+    // The number of rows of each group
+    std::vector<int64_t>        m_counts;
+
+    // The state of each aggregate
+    std::vector<AggregateState> m_states;
+
+    // Open addressing table of group ids plus one (0 is an empty slot)
+    std::vector<uint64_t>       m_slots;
+
+    // The number of groups
+    uint64_t                    m_numGroups = 0;
+
+    // The group of each row of the current batch
+    std::vector<uint64_t>       m_rowGroups;
+
+    // Whether the input has been consumed, and the next group to output
+    bool                        m_consumed = false;
+    uint64_t                    m_nextGroup = 0;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _QUERY_HASH_AGGREGATE_H_ */
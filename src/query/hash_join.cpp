@@ -0,0 +1,147 @@
+
+
+
+#include "hash_join.h"
+
+SMILE_NS_BEGIN
+
+/**
+ * Marks the end of a chain
+ **/
+static constexpr uint64_t kNoRow = UINT64_MAX;
+
+HashJoinOperator::HashJoinOperator( std::unique_ptr<Operator> build,
+                                    std::unique_ptr<Operator> probe,
+                                    const uint32_t buildKey,
+                                    const uint32_t probeKey ) noexcept :
+  p_build(std::move(build)),
+  p_probe(std::move(probe)),
+  m_buildKey(buildKey),
+  m_probeKey(probeKey),
+  m_probeMatches(kBatchSize),
+  m_buildMatches(kBatchSize) {
+}
+
+ErrorCode HashJoinOperator::open() noexcept {
+  ErrorCode error = p_build->open();
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = p_probe->open();
+  }
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  const std::vector<ValueType>& buildTypes = p_build->types();
+  const std::vector<ValueType>& probeTypes = p_probe->types();
+  if( m_buildKey >= buildTypes.size() || m_probeKey >= probeTypes.size() ) {
+    return ErrorCode::E_QUERY_INVALID_COLUMN;
+  }
+  if( buildTypes[m_buildKey] != ValueType::E_INT || probeTypes[m_probeKey] != ValueType::E_INT ) {
+    return ErrorCode::E_QUERY_INVALID_TYPE;
+  }
+  m_types = probeTypes;
+  m_types.insert(m_types.end(), buildTypes.begin(), buildTypes.end());
+  build();
+  m_probeBatch.reset(probeTypes);
+  m_probeRow = 0;
+  m_chainRow = kNoRow;
+  return ErrorCode::E_NO_ERROR;
+}
+
+void HashJoinOperator::build() noexcept {
+  m_rows.reset(p_build->types());
+  Batch batch;
+  while( p_build->next(&batch) ) {
+    m_rows.append(batch);
+  }
+  const uint64_t numRows = m_rows.size();
+  uint64_t numBuckets = 16;
+  while( numBuckets < 2*numRows ) {
+    numBuckets *= 2;
+  }
+  m_mask = numBuckets - 1;
+  m_buckets.assign(numBuckets, kNoRow);
+  m_chains.resize(numRows);
+  // Rows are inserted backwards so chains list them in input order
+  const int64_t* keys = m_rows.column(m_buildKey).m_ints.data();
+  for( uint64_t row = numRows; row-- > 0; ) {
+    const uint64_t bucket = hashKey(keys[row]) & m_mask;
+    m_chains[row] = m_buckets[bucket];
+    m_buckets[bucket] = row;
+  }
+}
+
+bool HashJoinOperator::next( Batch* batch ) noexcept {
+  batch->reset(m_types);
+  const int64_t* buildKeys = m_rows.column(m_buildKey).m_ints.data();
+  const uint32_t numProbeColumns = m_probeBatch.numColumns();
+  uint32_t count = 0;
+  uint32_t gathered = 0;
+
+  // Gathers the pairs found in the current probe batch into the output
+  auto flush = [&]() {
+    for( uint32_t i = 0; i < numProbeColumns; ++i ) {
+      if( m_types[i] == ValueType::E_INT ) {
+        const int64_t* in = m_probeBatch.ints(i);
+        int64_t* out = batch->ints(i);
+        for( uint32_t j = gathered; j < count; ++j ) {
+          out[j] = in[m_probeMatches[j]];
+        }
+      } else {
+        const double* in = m_probeBatch.reals(i);
+        double* out = batch->reals(i);
+        for( uint32_t j = gathered; j < count; ++j ) {
+          out[j] = in[m_probeMatches[j]];
+        }
+      }
+    }
+    for( uint32_t i = numProbeColumns; i < m_types.size(); ++i ) {
+      const Vector& column = m_rows.column(i - numProbeColumns);
+      if( m_types[i] == ValueType::E_INT ) {
+        int64_t* out = batch->ints(i);
+        for( uint32_t j = gathered; j < count; ++j ) {
+          out[j] = column.m_ints[m_buildMatches[j]];
+        }
+      } else {
+        double* out = batch->reals(i);
+        for( uint32_t j = gathered; j < count; ++j ) {
+          out[j] = column.m_reals[m_buildMatches[j]];
+        }
+      }
+    }
+    gathered = count;
+  };
+
+  while( count < kBatchSize ) {
+    if( m_probeRow >= m_probeBatch.size() ) {
+      flush();
+      if( !p_probe->next(&m_probeBatch) ) {
+        break;
+      }
+      m_probeRow = 0;
+      m_chainRow = kNoRow;
+    }
+    const int64_t* probeKeys = m_probeBatch.ints(m_probeKey);
+    const uint32_t size = m_probeBatch.size();
+    while( m_probeRow < size && count < kBatchSize ) {
+      const int64_t key = probeKeys[m_probeRow];
+      uint64_t row = m_chainRow == kNoRow ? m_buckets[hashKey(key) & m_mask] : m_chainRow;
+      for( ; row != kNoRow && count < kBatchSize; row = m_chains[row] ) {
+        m_probeMatches[count] = m_probeRow;
+        m_buildMatches[count] = row;
+        count += buildKeys[row] == key ? 1 : 0;
+      }
+      if( row != kNoRow ) {
+        // The output is full: resume from this row of the chain
+        m_chainRow = row;
+        break;
+      }
+      m_chainRow = kNoRow;
+      ++m_probeRow;
+    }
+  }
+  flush();
+  batch->setSize(count);
+  return count > 0;
+}
+
+SMILE_NS_END
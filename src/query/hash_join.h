@@ -0,0 +1,67 @@
+
+
+
+#ifndef _QUERY_HASH_JOIN_H_
+#define _QUERY_HASH_JOIN_H_
+
+#include "../base/base.h"
+#include "operator.h"
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Inner equi join on integer keys. The build input is consumed when the
+ * operator is opened and stored by column, with a chained hash table over
+ * its keys. The probe input is then streamed: for each probe batch the
+ * matching (probe row, build row) pairs are collected first and the output
+ * columns are gathered afterwards, one column at a time. The output has the
+ * probe columns followed by the build columns.
+ **/
+class HashJoinOperator : public Operator {
+    SMILE_NON_COPYABLE(HashJoinOperator);
+  public:
+    HashJoinOperator( std::unique_ptr<Operator> build,
+                      std::unique_ptr<Operator> probe,
+                      const uint32_t buildKey,
+                      const uint32_t probeKey ) noexcept;
+    virtual ~HashJoinOperator() noexcept = default;
+
+    ErrorCode open() noexcept override;
+
+    bool next( Batch* batch ) noexcept override;
+
+  private:
+
+    /**
+     * Consumes the build input and builds the hash table
+     **/
+    void build() noexcept;
+
+    std::unique_ptr<Operator> p_build;
+    std::unique_ptr<Operator> p_probe;
+    uint32_t                  m_buildKey;
+    uint32_t                  m_probeKey;
+
+    // The rows of the build input
+    BatchBuffer               m_rows;
+
+    // The first build row of each bucket, and the next row of each row
+    std::vector<uint64_t>     m_buckets;
+    std::vector<uint64_t>     m_chains;
+    uint64_t                  m_mask = 0;
+
+    // The probe batch being joined, and where its join stopped
+    Batch                     m_probeBatch;
+    uint32_t                  m_probeRow = 0;
+    uint64_t                  m_chainRow = 0;
+
+    // The matching pairs of the output batch being built
+    std::vector<uint32_t>     m_probeMatches;
+    std::vector<uint64_t>     m_buildMatches;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _QUERY_HASH_JOIN_H_ */
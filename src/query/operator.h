@@ -0,0 +1,72 @@
+
+
+
+#ifndef _QUERY_OPERATOR_H_
+#define _QUERY_OPERATOR_H_
+
+#include "../base/base.h"
+#include "batch.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * A vectorized query operator. Operators form a tree and are pulled from the
+ * root: each call to next produces a batch of up to kBatchSize rows, so the
+ * per row work runs in tight loops over the columns of a batch instead of
+ * through a call per element.
+ **/
+class Operator {
+  public:
+    virtual ~Operator() noexcept = default;
+
+    /**
+     * Opens the operator and its children. Must be called once before next.
+     * @return E_QUERY_INVALID_COLUMN if the operator references a column its
+     * input does not have, and E_QUERY_INVALID_TYPE if a column has a type
+     * the operator does not support
+     **/
+    virtual ErrorCode open() noexcept = 0;
+
+    /**
+     * Produces the next batch
+     * @param out batch The batch where the rows are written
+     * @return false if the operator is exhausted. The batch is then empty.
+     **/
+    virtual bool next( Batch* batch ) noexcept = 0;
+
+    /**
+     * Gets the types of the columns produced by the operator. Valid after
+     * open.
+     **/
+    const std::vector<ValueType>& types() const noexcept {
+      return m_types;
+    }
+
+  protected:
+    // The types of the produced columns
+    std::vector<ValueType> m_types;
+};
+
+/**
+ * Opens an operator tree and passes each of its batches to a function
+ * @param in root The root of the operator tree
+ * @param in f The function receiving the batches
+ **/
+inline ErrorCode execute( Operator* root, std::function<void(const Batch&)> f ) noexcept {
+  const ErrorCode error = root->open();
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  Batch batch;
+  while( root->next(&batch) ) {
+    f(batch);
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _QUERY_OPERATOR_H_ */
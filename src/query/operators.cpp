@@ -0,0 +1,271 @@
+
+
+
+#include "operators.h"
+#include <algorithm>
+#include <functional>
+
+SMILE_NS_BEGIN
+
+/**
+ * Writes into selection the rows whose value satisfies a comparison with a
+ * constant, without branching on the result
+ * @return The number of selected rows
+ **/
+template<typename V, typename C, typename Compare>
+static uint32_t selectRows( const V* values,
+                            const uint32_t size,
+                            const C constant,
+                            Compare compare,
+                            uint32_t* selection ) noexcept {
+  uint32_t count = 0;
+  for( uint32_t i = 0; i < size; ++i ) {
+    selection[count] = i;
+    count += compare(static_cast<C>(values[i]), constant) ? 1 : 0;
+  }
+  return count;
+}
+
+template<typename V, typename C>
+static uint32_t selectRows( const V* values,
+                            const uint32_t size,
+                            const C constant,
+                            const Condition condition,
+                            uint32_t* selection ) noexcept {
+  switch( condition ) {
+    case Condition::E_EQUALS:
+      return selectRows(values, size, constant, std::equal_to<C>(), selection);
+    case Condition::E_DIFFERENT:
+      return selectRows(values, size, constant, std::not_equal_to<C>(), selection);
+    case Condition::E_GREATER:
+      return selectRows(values, size, constant, std::greater<C>(), selection);
+    case Condition::E_GREATER_EQUALS:
+      return selectRows(values, size, constant, std::greater_equal<C>(), selection);
+    case Condition::E_SMALLER:
+      return selectRows(values, size, constant, std::less<C>(), selection);
+    case Condition::E_SMALLER_EQUALS:
+      return selectRows(values, size, constant, std::less_equal<C>(), selection);
+  }
+  return 0;
+}
+
+FilterOperator::FilterOperator( std::unique_ptr<Operator> child,
+                                const uint32_t column,
+                                const Condition condition,
+                                const Value& value ) noexcept :
+  p_child(std::move(child)),
+  m_column(column),
+  m_condition(condition),
+  m_value(value),
+  m_selection(kBatchSize) {
+}
+
+ErrorCode FilterOperator::open() noexcept {
+  const ErrorCode error = p_child->open();
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  if( m_column >= p_child->types().size() ) {
+    return ErrorCode::E_QUERY_INVALID_COLUMN;
+  }
+  m_types = p_child->types();
+  return ErrorCode::E_NO_ERROR;
+}
+
+bool FilterOperator::next( Batch* batch ) noexcept {
+  while( p_child->next(batch) ) {
+    uint32_t count = 0;
+    if( m_types[m_column] == ValueType::E_INT && m_value.m_type == ValueType::E_INT ) {
+      count = selectRows(batch->ints(m_column), batch->size(), m_value.m_int, m_condition, m_selection.data());
+    } else if( m_types[m_column] == ValueType::E_INT ) {
+      count = selectRows(batch->ints(m_column), batch->size(), m_value.m_real, m_condition, m_selection.data());
+    } else {
+      count = selectRows(batch->reals(m_column), batch->size(), m_value.m_real, m_condition, m_selection.data());
+    }
+    if( count == batch->size() ) {
+      return true;
+    }
+    if( count > 0 ) {
+      // Selected rows never move forward, so the batch is compacted in place
+      gather(*batch, m_selection.data(), count, batch, 0);
+      batch->setSize(count);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Applies a binary function to a column and another column or a constant
+ **/
+template<typename T, typename F>
+static void apply( const T* left,
+                   const T* right,
+                   const T constant,
+                   const bool hasConstant,
+                   const uint32_t size,
+                   T* out,
+                   F f ) noexcept {
+  if( hasConstant ) {
+    for( uint32_t i = 0; i < size; ++i ) {
+      out[i] = f(left[i], constant);
+    }
+  } else {
+    for( uint32_t i = 0; i < size; ++i ) {
+      out[i] = f(left[i], right[i]);
+    }
+  }
+}
+
+template<typename T>
+static void arithmetic( const ProjectionType type,
+                        const T* left,
+                        const T* right,
+                        const T constant,
+                        const bool hasConstant,
+                        const uint32_t size,
+                        T* out ) noexcept {
+  switch( type ) {
+    case ProjectionType::E_ADD:
+      apply(left, right, constant, hasConstant, size, out, std::plus<T>());
+      break;
+    case ProjectionType::E_SUBTRACT:
+      apply(left, right, constant, hasConstant, size, out, std::minus<T>());
+      break;
+    case ProjectionType::E_MULTIPLY:
+      apply(left, right, constant, hasConstant, size, out, std::multiplies<T>());
+      break;
+    case ProjectionType::E_DIVIDE:
+      apply(left, right, constant, hasConstant, size, out, std::divides<T>());
+      break;
+    case ProjectionType::E_COLUMN:
+      break;
+  }
+}
+
+/**
+ * Gets the values of a column as reals, converting them if needed
+ **/
+static const double* realValues( const Batch& batch, const uint32_t column, double* buffer ) noexcept {
+  if( batch.column(column).m_type == ValueType::E_REAL ) {
+    return batch.reals(column);
+  }
+  const int64_t* values = batch.ints(column);
+  for( uint32_t i = 0; i < batch.size(); ++i ) {
+    buffer[i] = static_cast<double>(values[i]);
+  }
+  return buffer;
+}
+
+ProjectOperator::ProjectOperator( std::unique_ptr<Operator> child,
+                                  const std::vector<Projection>& projections ) noexcept :
+  p_child(std::move(child)),
+  m_projections(projections) {
+}
+
+ErrorCode ProjectOperator::open() noexcept {
+  const ErrorCode error = p_child->open();
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  const std::vector<ValueType>& input = p_child->types();
+  m_types.clear();
+  for( const Projection& projection : m_projections ) {
+    if( projection.m_left >= input.size() ||
+        (projection.m_type != ProjectionType::E_COLUMN && !projection.m_hasConstant && projection.m_right >= input.size()) ) {
+      return ErrorCode::E_QUERY_INVALID_COLUMN;
+    }
+    if( projection.m_type == ProjectionType::E_COLUMN ) {
+      m_types.push_back(input[projection.m_left]);
+      continue;
+    }
+    const ValueType right = projection.m_hasConstant ? projection.m_constant.m_type : input[projection.m_right];
+    const bool integer = input[projection.m_left] == ValueType::E_INT &&
+                         right == ValueType::E_INT &&
+                         projection.m_type != ProjectionType::E_DIVIDE;
+    m_types.push_back(integer ? ValueType::E_INT : ValueType::E_REAL);
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+bool ProjectOperator::next( Batch* batch ) noexcept {
+  batch->reset(m_types);
+  if( !p_child->next(&m_input) ) {
+    return false;
+  }
+  const uint32_t size = m_input.size();
+  double leftBuffer[kBatchSize];
+  double rightBuffer[kBatchSize];
+  for( uint32_t i = 0; i < m_projections.size(); ++i ) {
+    const Projection& projection = m_projections[i];
+    if( projection.m_type == ProjectionType::E_COLUMN ) {
+      if( m_types[i] == ValueType::E_INT ) {
+        std::copy(m_input.ints(projection.m_left), m_input.ints(projection.m_left) + size, batch->ints(i));
+      } else {
+        std::copy(m_input.reals(projection.m_left), m_input.reals(projection.m_left) + size, batch->reals(i));
+      }
+    } else if( m_types[i] == ValueType::E_INT ) {
+      arithmetic(projection.m_type,
+                 m_input.ints(projection.m_left),
+                 projection.m_hasConstant ? nullptr : m_input.ints(projection.m_right),
+                 projection.m_constant.m_int,
+                 projection.m_hasConstant,
+                 size,
+                 batch->ints(i));
+    } else {
+      arithmetic(projection.m_type,
+                 realValues(m_input, projection.m_left, leftBuffer),
+                 projection.m_hasConstant ? nullptr : realValues(m_input, projection.m_right, rightBuffer),
+                 projection.m_constant.m_real,
+                 projection.m_hasConstant,
+                 size,
+                 batch->reals(i));
+    }
+  }
+  batch->setSize(size);
+  return true;
+}
+
+LimitOperator::LimitOperator( std::unique_ptr<Operator> child, const uint64_t limit, const uint64_t offset ) noexcept :
+  p_child(std::move(child)),
+  m_limit(limit),
+  m_offset(offset),
+  m_selection(kBatchSize) {
+}
+
+ErrorCode LimitOperator::open() noexcept {
+  const ErrorCode error = p_child->open();
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  m_types = p_child->types();
+  m_remaining = m_limit;
+  m_toSkip = m_offset;
+  return ErrorCode::E_NO_ERROR;
+}
+
+bool LimitOperator::next( Batch* batch ) noexcept {
+  while( m_remaining > 0 && p_child->next(batch) ) {
+    const uint32_t size = batch->size();
+    if( m_toSkip >= size ) {
+      m_toSkip -= size;
+      continue;
+    }
+    const uint32_t first = static_cast<uint32_t>(m_toSkip);
+    const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(size - first, m_remaining));
+    m_toSkip = 0;
+    m_remaining -= count;
+    if( first > 0 || count < size ) {
+      for( uint32_t i = 0; i < count; ++i ) {
+        m_selection[i] = first + i;
+      }
+      gather(*batch, m_selection.data(), count, batch, 0);
+      batch->setSize(count);
+    }
+    return true;
+  }
+  batch->reset(m_types);
+  return false;
+}
+
+SMILE_NS_END
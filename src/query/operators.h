@@ -0,0 +1,119 @@
+
+
+
+#ifndef _QUERY_OPERATORS_H_
+#define _QUERY_OPERATORS_H_
+
+#include "../base/base.h"
+#include "../data/types.h"
+#include "operator.h"
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Keeps the rows whose value in a column satisfies a condition. The selected
+ * rows of each input batch are computed without branches and then compacted.
+ * Empty batches are never returned.
+ **/
+class FilterOperator : public Operator {
+    SMILE_NON_COPYABLE(FilterOperator);
+  public:
+    FilterOperator( std::unique_ptr<Operator> child,
+                    const uint32_t column,
+                    const Condition condition,
+                    const Value& value ) noexcept;
+    virtual ~FilterOperator() noexcept = default;
+
+    ErrorCode open() noexcept override;
+
+    bool next( Batch* batch ) noexcept override;
+
+  private:
+    std::unique_ptr<Operator> p_child;
+    uint32_t                  m_column;
+    Condition                 m_condition;
+    Value                     m_value;
+    std::vector<uint32_t>     m_selection;
+};
+
+enum class ProjectionType {
+  E_COLUMN,
+  E_ADD,
+  E_SUBTRACT,
+  E_MULTIPLY,
+  E_DIVIDE
+};
+
+/**
+ * An output column of a ProjectOperator: either an input column or an
+ * arithmetic expression over an input column and another column or a
+ * constant. Integer expressions produce integers, except divisions, which
+ * always produce reals.
+ **/
+struct Projection {
+  ProjectionType  m_type;
+  uint32_t        m_left;
+  uint32_t        m_right;
+  bool            m_hasConstant;
+  Value           m_constant;
+
+  static Projection column( const uint32_t column ) noexcept {
+    return Projection{ProjectionType::E_COLUMN, column, 0, false, Value::integer(0)};
+  }
+
+  static Projection arithmetic( const ProjectionType type, const uint32_t left, const uint32_t right ) noexcept {
+    return Projection{type, left, right, false, Value::integer(0)};
+  }
+
+  static Projection arithmetic( const ProjectionType type, const uint32_t left, const Value& constant ) noexcept {
+    return Projection{type, left, 0, true, constant};
+  }
+};
+
+/**
+ * Computes a list of projections over its input
+ **/
+class ProjectOperator : public Operator {
+    SMILE_NON_COPYABLE(ProjectOperator);
+  public:
+    ProjectOperator( std::unique_ptr<Operator> child, const std::vector<Projection>& projections ) noexcept;
+    virtual ~ProjectOperator() noexcept = default;
+
+    ErrorCode open() noexcept override;
+
+    bool next( Batch* batch ) noexcept override;
+
+  private:
+    std::unique_ptr<Operator> p_child;
+    std::vector<Projection>   m_projections;
+    Batch                     m_input;
+};
+
+/**
+ * Skips the first offset rows of its input and produces at most limit rows.
+ * The input is not pulled once the limit is reached.
+ **/
+class LimitOperator : public Operator {
+    SMILE_NON_COPYABLE(LimitOperator);
+  public:
+    LimitOperator( std::unique_ptr<Operator> child, const uint64_t limit, const uint64_t offset = 0 ) noexcept;
+    virtual ~LimitOperator() noexcept = default;
+
+    ErrorCode open() noexcept override;
+
+    bool next( Batch* batch ) noexcept override;
+
+  private:
+    std::unique_ptr<Operator> p_child;
+    uint64_t                  m_limit;
+    uint64_t                  m_offset;
+    uint64_t                  m_remaining = 0;
+    uint64_t                  m_toSkip = 0;
+    std::vector<uint32_t>     m_selection;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _QUERY_OPERATORS_H_ */
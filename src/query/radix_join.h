@@ -0,0 +1,334 @@
+
+
+
+#ifndef _QUERY_RADIX_JOIN_H_
+#define _QUERY_RADIX_JOIN_H_
+
+#include "../base/base.h"
+#include "../base/parallel.h"
+#include "../data/table.h"
+#include "../data/types.h"
+#include "batch.h"
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+SMILE_NS_BEGIN
+
+/**
+ * The endpoint of the edges used as join key
+ **/
+enum class EdgeEndpoint {
+  E_TAIL,
+  E_HEAD
+};
+
+struct RadixJoinConfig {
+  /**
+   * Number of threads used to partition and join
+   */
+  uint32_t  m_numThreads = 1;
+
+  /**
+   * Number of radix bits. 0 chooses them so that the build side of a
+   * partition and its hash table fit in m_cacheBytes.
+   */
+  uint32_t  m_radixBits  = 0;
+
+  /**
+   * Size of the cache a partition should fit in, in bytes
+   */
+  uint64_t  m_cacheBytes = 256*1024;
+};
+
+/**
+ * Number of tuples read from a table at once while partitioning
+ **/
+constexpr uint32_t kRadixReadBlock = 4096;
+
+/**
+ * Key used to mark the empty slots of the partition hash tables. Tuples with
+ * this key never match.
+ **/
+constexpr oid_t kRadixEmptyKey = UINT64_MAX;
+
+/**
+ * Partitions a relation by the low bits of the hash of its keys. Each thread
+ * builds a histogram of its chunk of the input, the histograms are turned into
+ * per thread write offsets, and the chunks are scattered in a second pass, so
+ * threads write to disjoint ranges without synchronization.
+ * @param in size The number of tuples of the relation
+ * @param in bits The number of radix bits
+ * @param in numThreads The number of threads
+ * @param in read Function copying the tuples [first, first+count) into a
+ * buffer
+ * @param out tuples The partitioned tuples
+ * @param out offsets The first tuple of each partition, plus the end
+ **/
+template<typename Tuple, typename Read>
+void radixPartition( const uint64_t size,
+                     const uint32_t bits,
+                     const uint32_t numThreads,
+                     Read read,
+                     std::vector<Tuple>* tuples,
+                     std::vector<uint64_t>* offsets ) noexcept {
+  const uint64_t numPartitions = 1ULL << bits;
+  const uint64_t mask = numPartitions - 1;
+  const uint32_t threads = std::max<uint32_t>(numThreads, 1);
+  const uint64_t chunkSize = (size + threads - 1) / threads;
+  std::vector<uint64_t> histograms(threads*numPartitions, 0);
+
+  // Applies a function to the tuples of the chunk of a thread
+  auto forChunk = [&]( const uint32_t chunk, auto f ) {
+    Tuple buffer[kRadixReadBlock];
+    const uint64_t end = std::min(size, (chunk + 1)*chunkSize);
+    for( uint64_t first = chunk*chunkSize; first < end; first += kRadixReadBlock ) {
+      const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(kRadixReadBlock, end - first));
+      read(first, count, buffer);
+      for( uint32_t i = 0; i < count; ++i ) {
+        f(buffer[i]);
+      }
+    }
+  };
+
+  parallelFor(0, threads, threads, 1, [&]( const uint64_t chunk, const uint32_t ) {
+    uint64_t* histogram = &histograms[chunk*numPartitions];
+    forChunk(static_cast<uint32_t>(chunk), [&]( const Tuple& tuple ) {
+      ++histogram[hashKey(tuple.m_key) & mask];
+    });
+  });
+
+  offsets->assign(numPartitions + 1, 0);
+  uint64_t position = 0;
+  for( uint64_t p = 0; p < numPartitions; ++p ) {
+    (*offsets)[p] = position;
+    for( uint32_t t = 0; t < threads; ++t ) {
+      const uint64_t count = histograms[t*numPartitions + p];
+      histograms[t*numPartitions + p] = position;
+      position += count;
+    }
+  }
+  (*offsets)[numPartitions] = position;
+
+  tuples->resize(size);
+  Tuple* out = tuples->data();
+  parallelFor(0, threads, threads, 1, [&]( const uint64_t chunk, const uint32_t ) {
+    uint64_t* next = &histograms[chunk*numPartitions];
+    forChunk(static_cast<uint32_t>(chunk), [&]( const Tuple& tuple ) {
+      out[next[hashKey(tuple.m_key) & mask]++] = tuple;
+    });
+  });
+}
+
+/**
+ * Linear probing hash table over the build tuples of a partition. Slots are
+ * probed in pairs, which are compared against the key at once with SSE2.
+ **/
+class RadixHashTable {
+  public:
+    /**
+     * Builds the table over a set of keys
+     * @param in keys The keys
+     * @param in count The number of keys
+     * @param in shift The number of hash bits used by the partitioning
+     **/
+    void build( const oid_t* keys, const uint64_t count, const uint32_t shift ) noexcept {
+      uint64_t numSlots = 2;
+      while( numSlots < 2*count ) {
+        numSlots *= 2;
+      }
+      m_keys.assign(numSlots, kRadixEmptyKey);
+      m_rows.resize(numSlots);
+      m_groupMask = numSlots/2 - 1;
+      m_shift = shift;
+      for( uint64_t i = 0; i < count; ++i ) {
+        if( keys[i] == kRadixEmptyKey ) {
+          continue;
+        }
+        uint64_t slot = (group(keys[i]) * 2);
+        while( m_keys[slot] != kRadixEmptyKey ) {
+          slot = (slot + 1) & (numSlots - 1);
+        }
+        m_keys[slot] = keys[i];
+        m_rows[slot] = static_cast<uint32_t>(i);
+      }
+    }
+
+    /**
+     * Calls a function with the position of each build key equal to the given
+     * key
+     **/
+    template<typename F>
+    void probe( const oid_t key, F f ) const noexcept {
+      if( key == kRadixEmptyKey ) {
+        return;
+      }
+      uint64_t g = group(key);
+#if defined(__SSE2__)
+      const __m128i needle = _mm_set1_epi64x(static_cast<int64_t>(key));
+      const __m128i empty = _mm_set1_epi64x(static_cast<int64_t>(kRadixEmptyKey));
+      while( true ) {
+        const __m128i slots = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_keys[2*g]));
+        // 64 bit equality from the 32 bit one: both halves have to match
+        __m128i equal = _mm_cmpeq_epi32(slots, needle);
+        equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128i free = _mm_cmpeq_epi32(slots, empty);
+        free = _mm_and_si128(free, _mm_shuffle_epi32(free, _MM_SHUFFLE(2, 3, 0, 1)));
+        const int matches = _mm_movemask_pd(_mm_castsi128_pd(equal));
+        if( matches & 1 ) {
+          f(m_rows[2*g]);
+        }
+        if( matches & 2 ) {
+          f(m_rows[2*g + 1]);
+        }
+        if( _mm_movemask_pd(_mm_castsi128_pd(free)) != 0 ) {
+          return;
+        }
+        g = (g + 1) & m_groupMask;
+      }
+#else
+      while( true ) {
+        for( uint64_t slot = 2*g; slot < 2*g + 2; ++slot ) {
+          if( m_keys[slot] == key ) {
+            f(m_rows[slot]);
+          }
+        }
+        if( m_keys[2*g] == kRadixEmptyKey || m_keys[2*g + 1] == kRadixEmptyKey ) {
+          return;
+        }
+        g = (g + 1) & m_groupMask;
+      }
+#endif
+    }
+
+  private:
+    uint64_t group( const oid_t key ) const noexcept {
+      return (hashKey(key) >> m_shift) & m_groupMask;
+    }
+
+    std::vector<oid_t>    m_keys;
+    std::vector<uint32_t> m_rows;
+    uint64_t              m_groupMask = 0;
+    uint32_t              m_shift = 0;
+};
+
+/**
+ * Tuple of the build side of a radix join
+ **/
+template<typename T>
+struct RadixBuildTuple {
+  oid_t m_key;
+  T     m_value;
+};
+
+/**
+ * Tuple of the probe side of a radix join
+ **/
+struct RadixProbeTuple {
+  oid_t     m_key;
+  uint64_t  m_row;
+};
+
+/**
+ * Joins the edges of a table with node attributes, on the oid of one of the
+ * endpoints of each edge. Both inputs are radix partitioned in parallel so
+ * the build side of each partition fits in the cache; partitions are then
+ * joined in parallel, each with its own hash table. Matches are reported
+ * through a function, called concurrently from the join threads.
+ * @param in edges The edges
+ * @param in endpoint The endpoint of the edges to join on
+ * @param in values The node attributes, as (oid, value) pairs
+ * @param in config The join configuration
+ * @param in f Function called for each match with the thread number, the
+ * row of the edge in edges, and the value of the node
+ * @param out numMatches If not null, the number of matches
+ **/
+template<typename T, typename F>
+ErrorCode radixJoin( const ITypedTable<Edge>& edges,
+                     const EdgeEndpoint endpoint,
+                     const ITypedTable<KeyValue<T>>& values,
+                     const RadixJoinConfig& config,
+                     F f,
+                     uint64_t* numMatches = nullptr ) noexcept {
+  using BuildTuple = RadixBuildTuple<T>;
+  const uint32_t threads = std::max<uint32_t>(config.m_numThreads, 1);
+
+  // Enough partitions for the build side of each to fit in the cache, and to
+  // keep the threads busy
+  uint32_t bits = config.m_radixBits;
+  if( bits == 0 ) {
+    const uint64_t bytesPerTuple = sizeof(BuildTuple) + 2*(sizeof(oid_t) + sizeof(uint32_t));
+    while( bits < 16 && ((values.size()*bytesPerTuple) >> bits) > config.m_cacheBytes ) {
+      ++bits;
+    }
+    while( bits < 16 && threads > 1 && (1ULL << bits) < 4ULL*threads && (values.size() >> bits) > kRadixReadBlock ) {
+      ++bits;
+    }
+  }
+  bits = std::min<uint32_t>(bits, 24);
+
+  std::vector<BuildTuple> build;
+  std::vector<uint64_t> buildOffsets;
+  radixPartition(values.size(), bits, threads,
+                 [&]( const uint64_t first, const uint32_t count, BuildTuple* out ) {
+    KeyValue<T> buffer[kRadixReadBlock];
+    values.getBulk(first, count, buffer);
+    for( uint32_t i = 0; i < count; ++i ) {
+      out[i] = BuildTuple{buffer[i].m_id, buffer[i].m_value};
+    }
+  }, &build, &buildOffsets);
+
+  std::vector<RadixProbeTuple> probe;
+  std::vector<uint64_t> probeOffsets;
+  radixPartition(edges.size(), bits, threads,
+                 [&]( const uint64_t first, const uint32_t count, RadixProbeTuple* out ) {
+    Edge buffer[kRadixReadBlock];
+    edges.getBulk(first, count, buffer);
+    for( uint32_t i = 0; i < count; ++i ) {
+      out[i] = RadixProbeTuple{endpoint == EdgeEndpoint::E_TAIL ? buffer[i].m_tail : buffer[i].m_head, first + i};
+    }
+  }, &probe, &probeOffsets);
+
+  const uint64_t numPartitions = 1ULL << bits;
+  std::vector<RadixHashTable> tables(threads);
+  std::vector<std::vector<oid_t>> keys(threads);
+  std::vector<uint64_t> matches(threads, 0);
+  parallelFor(0, numPartitions, threads, 1, [&]( const uint64_t p, const uint32_t thread ) {
+    const BuildTuple* buildTuples = build.data() + buildOffsets[p];
+    const uint64_t buildSize = buildOffsets[p+1] - buildOffsets[p];
+    if( buildSize == 0 || probeOffsets[p+1] == probeOffsets[p] ) {
+      return;
+    }
+    std::vector<oid_t>& partitionKeys = keys[thread];
+    partitionKeys.resize(buildSize);
+    for( uint64_t i = 0; i < buildSize; ++i ) {
+      partitionKeys[i] = buildTuples[i].m_key;
+    }
+    RadixHashTable& table = tables[thread];
+    table.build(partitionKeys.data(), buildSize, bits);
+    uint64_t count = 0;
+    for( uint64_t i = probeOffsets[p]; i < probeOffsets[p+1]; ++i ) {
+      const RadixProbeTuple& tuple = probe[i];
+      table.probe(tuple.m_key, [&]( const uint32_t row ) {
+        f(thread, tuple.m_row, buildTuples[row].m_value);
+        ++count;
+      });
+    }
+    matches[thread] += count;
+  });
+
+  if( numMatches != nullptr ) {
+    *numMatches = 0;
+    for( const uint64_t count : matches ) {
+      *numMatches += count;
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _QUERY_RADIX_JOIN_H_ */
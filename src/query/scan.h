@@ -0,0 +1,196 @@
+
+
+
+#ifndef _QUERY_SCAN_H_
+#define _QUERY_SCAN_H_
+
+#include "../base/base.h"
+#include "../data/table.h"
+#include "operator.h"
+#include <limits>
+#include <type_traits>
+
+SMILE_NS_BEGIN
+
+/**
+ * Converts the values of an attribute type to the value types of the
+ * operators
+ **/
+template<typename T, typename Enable = void>
+struct ScanTraits;
+
+template<typename T>
+struct ScanTraits<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+  static constexpr ValueType type = ValueType::E_INT;
+  static int64_t toInt( const T& value ) noexcept {
+    return static_cast<int64_t>(value);
+  }
+  static double toReal( const T& value ) noexcept {
+    return static_cast<double>(value);
+  }
+};
+
+template<typename T>
+struct ScanTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static constexpr ValueType type = ValueType::E_REAL;
+  static int64_t toInt( const T& value ) noexcept {
+    return static_cast<int64_t>(value);
+  }
+  static double toReal( const T& value ) noexcept {
+    return static_cast<double>(value);
+  }
+};
+
+template<>
+struct ScanTraits<timestamp> {
+  static constexpr ValueType type = ValueType::E_INT;
+  static int64_t toInt( const timestamp& value ) noexcept {
+    return static_cast<int64_t>(value.val);
+  }
+  static double toReal( const timestamp& value ) noexcept {
+    return static_cast<double>(value.val);
+  }
+};
+
+/**
+ * Reads ranges of a column into the vectors of a batch
+ **/
+class IColumnScan {
+  public:
+    virtual ~IColumnScan() noexcept = default;
+
+    virtual ValueType type() const noexcept = 0;
+
+    virtual uint64_t size() const noexcept = 0;
+
+    virtual void read( const uint64_t first, const uint32_t count, Vector* vector ) noexcept = 0;
+};
+
+template<typename T>
+class ColumnScan : public IColumnScan {
+  public:
+    explicit ColumnScan( const ITypedTable<T>* table ) noexcept :
+      p_table(table),
+      m_buffer(kBatchSize) {
+    }
+    virtual ~ColumnScan() noexcept = default;
+
+    ValueType type() const noexcept override {
+      return ScanTraits<T>::type;
+    }
+
+    uint64_t size() const noexcept override {
+      return p_table->size();
+    }
+
+    void read( const uint64_t first, const uint32_t count, Vector* vector ) noexcept override {
+      p_table->getBulk(first, count, m_buffer.data());
+      if( ScanTraits<T>::type == ValueType::E_INT ) {
+        int64_t* out = vector->m_ints.data();
+        for( uint32_t i = 0; i < count; ++i ) {
+          out[i] = ScanTraits<T>::toInt(m_buffer[i]);
+        }
+      } else {
+        double* out = vector->m_reals.data();
+        for( uint32_t i = 0; i < count; ++i ) {
+          out[i] = ScanTraits<T>::toReal(m_buffer[i]);
+        }
+      }
+    }
+
+  private:
+    const ITypedTable<T>* p_table;
+    std::vector<T>        m_buffer;
+};
+
+/**
+ * Scans a set of columns of the same length, whose rows are aligned (e.g.
+ * the attributes of a node type, indexed by oid). Columns are copied a batch
+ * at a time with ITypedTable::getBulk.
+ **/
+class ScanOperator : public Operator {
+    SMILE_NON_COPYABLE(ScanOperator);
+  public:
+    /**
+     * @param in first The first row to scan
+     * @param in last The row after the last one to scan. Clamped to the
+     * column size.
+     **/
+    ScanOperator( const uint64_t first = 0,
+                  const uint64_t last = std::numeric_limits<uint64_t>::max() ) noexcept :
+      m_first(first),
+      m_last(last) {
+    }
+    virtual ~ScanOperator() noexcept = default;
+
+    /**
+     * Adds a column to the scan. The table must outlive the operator.
+     **/
+    template<typename T>
+    void addColumn( const ITypedTable<T>* table ) noexcept {
+      m_columns.emplace_back(new ColumnScan<T>(table));
+    }
+
+    /**
+     * Adds a column with the row numbers (the oids) of the scanned rows
+     **/
+    void addRowIdColumn() noexcept {
+      m_columns.emplace_back(nullptr);
+    }
+
+    ErrorCode open() noexcept override {
+      m_types.clear();
+      uint64_t end = m_last;
+      bool hasTable = false;
+      for( const std::unique_ptr<IColumnScan>& column : m_columns ) {
+        m_types.push_back(column == nullptr ? ValueType::E_INT : column->type());
+        if( column != nullptr ) {
+          end = std::min(end, column->size());
+          hasTable = true;
+        }
+      }
+      if( !hasTable ) {
+        return ErrorCode::E_QUERY_INVALID_COLUMN;
+      }
+      m_position = m_first;
+      m_end = end;
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    bool next( Batch* batch ) noexcept override {
+      batch->reset(m_types);
+      if( m_position >= m_end ) {
+        return false;
+      }
+      const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(kBatchSize, m_end - m_position));
+      for( uint32_t i = 0; i < m_columns.size(); ++i ) {
+        if( m_columns[i] == nullptr ) {
+          int64_t* out = batch->ints(i);
+          for( uint32_t j = 0; j < count; ++j ) {
+            out[j] = static_cast<int64_t>(m_position + j);
+          }
+        } else {
+          m_columns[i]->read(m_position, count, &batch->column(i));
+        }
+      }
+      batch->setSize(count);
+      m_position += count;
+      return true;
+    }
+
+  private:
+    // The scanned columns. nullptr stands for the row id column.
+    std::vector<std::unique_ptr<IColumnScan>> m_columns;
+
+    // The range of rows to scan
+    uint64_t  m_first;
+    uint64_t  m_last;
+
+    // The next row to scan and the end of the scan
+    uint64_t  m_position = 0;
+    uint64_t  m_end = 0;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _QUERY_SCAN_H_ */
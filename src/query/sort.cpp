@@ -0,0 +1,87 @@
+
+
+
+#include "sort.h"
+#include <algorithm>
+#include <numeric>
+
+SMILE_NS_BEGIN
+
+SortOperator::SortOperator( std::unique_ptr<Operator> child,
+                            const std::vector<SortKey>& keys,
+                            const uint64_t limit ) noexcept :
+  p_child(std::move(child)),
+  m_keys(keys),
+  m_limit(limit) {
+}
+
+ErrorCode SortOperator::open() noexcept {
+  const ErrorCode error = p_child->open();
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  for( const SortKey& key : m_keys ) {
+    if( key.m_column >= p_child->types().size() ) {
+      return ErrorCode::E_QUERY_INVALID_COLUMN;
+    }
+  }
+  m_types = p_child->types();
+  m_rows.reset(m_types);
+  m_order.clear();
+  m_sorted = false;
+  m_next = 0;
+  return ErrorCode::E_NO_ERROR;
+}
+
+void SortOperator::sort() noexcept {
+  Batch batch;
+  while( p_child->next(&batch) ) {
+    m_rows.append(batch);
+  }
+  m_order.resize(m_rows.size());
+  std::iota(m_order.begin(), m_order.end(), 0);
+  auto less = [this]( const uint64_t a, const uint64_t b ) {
+    for( const SortKey& key : m_keys ) {
+      const Vector& column = m_rows.column(key.m_column);
+      if( column.m_type == ValueType::E_INT ) {
+        const int64_t x = column.m_ints[a];
+        const int64_t y = column.m_ints[b];
+        if( x != y ) {
+          return key.m_ascending ? x < y : x > y;
+        }
+      } else {
+        const double x = column.m_reals[a];
+        const double y = column.m_reals[b];
+        if( x != y ) {
+          return key.m_ascending ? x < y : x > y;
+        }
+      }
+    }
+    // Ties are broken by row number, which keeps the sort stable
+    return a < b;
+  };
+  if( m_limit < m_order.size() ) {
+    std::partial_sort(m_order.begin(), m_order.begin() + m_limit, m_order.end(), less);
+    m_order.resize(m_limit);
+  } else {
+    std::sort(m_order.begin(), m_order.end(), less);
+  }
+  m_sorted = true;
+}
+
+bool SortOperator::next( Batch* batch ) noexcept {
+  if( !m_sorted ) {
+    sort();
+  }
+  batch->reset(m_types);
+  if( m_next >= m_order.size() ) {
+    return false;
+  }
+  const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(kBatchSize, m_order.size() - m_next));
+  m_rows.gather(m_order.data() + m_next, count, batch, 0);
+  batch->setSize(count);
+  m_next += count;
+  return true;
+}
+
+SMILE_NS_END
@@ -0,0 +1,62 @@
+
+
+
+#ifndef _QUERY_SORT_H_
+#define _QUERY_SORT_H_
+
+#include "../base/base.h"
+#include "operator.h"
+#include <limits>
+#include <memory>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+struct SortKey {
+  uint32_t  m_column;
+  bool      m_ascending;
+};
+
+/**
+ * Sorts its input by a list of keys. The input is buffered by column and a
+ * permutation of the row numbers is sorted; the output is gathered through
+ * the permutation a batch at a time. The sort is stable. If a limit is given
+ * only the first limit rows are produced, and a partial sort is used.
+ **/
+class SortOperator : public Operator {
+    SMILE_NON_COPYABLE(SortOperator);
+  public:
+    SortOperator( std::unique_ptr<Operator> child,
+                  const std::vector<SortKey>& keys,
+                  const uint64_t limit = std::numeric_limits<uint64_t>::max() ) noexcept;
+    virtual ~SortOperator() noexcept = default;
+
+    ErrorCode open() noexcept override;
+
+    bool next( Batch* batch ) noexcept override;
+
+  private:
+
+    /**
+     * Consumes the input and sorts it
+     **/
+    void sort() noexcept;
+
+    std::unique_ptr<Operator> p_child;
+    std::vector<SortKey>      m_keys;
+    uint64_t                  m_limit;
+
+    // The buffered input
+    BatchBuffer               m_rows;
+
+    // The sorted row numbers
+    std::vector<uint64_t>     m_order;
+
+    // Whether the input has been sorted, and the next row to output
+    bool                      m_sorted = false;
+    uint64_t                  m_next = 0;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _QUERY_SORT_H_ */
@@ -0,0 +1,482 @@
+
+
+#include "contraction_hierarchy.h"
+#include "../base/parallel.h"
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+SMILE_NS_BEGIN
+
+ContractionHierarchy::ContractionHierarchy( const ContractionHierarchyConfig& config ) noexcept :
+  m_config(config) {
+}
+
+void ContractionHierarchy::contract( std::vector<nodeId_t>* order,
+                                     std::vector<std::vector<nodeId_t>>* upward ) const noexcept {
+  const nodeId_t numNodes = p_graph->numNodes();
+
+  // Undirected neighborhoods, without self loops nor parallel edges
+  std::vector<std::vector<nodeId_t>> neighbors(numNodes);
+  for( nodeId_t node = 0; node < numNodes; ++node ) {
+    for( edgeId_t e = p_graph->firstOut(node); e < p_graph->endOut(node); ++e ) {
+      const nodeId_t head = p_graph->head(e);
+      if( head != node ) {
+        neighbors[node].push_back(head);
+        neighbors[head].push_back(node);
+      }
+    }
+  }
+  for( std::vector<nodeId_t>& list : neighbors ) {
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+  }
+
+  const bool computeOrder = order->empty();
+  using HeapEntry = std::pair<uint64_t, nodeId_t>;
+  std::vector<HeapEntry> heap;
+  if( computeOrder ) {
+    for( nodeId_t node = 0; node < numNodes; ++node ) {
+      heap.push_back(HeapEntry(neighbors[node].size(), node));
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+  }
+
+  upward->assign(numNodes, std::vector<nodeId_t>());
+  std::vector<bool> contracted(numNodes, false);
+  std::vector<nodeId_t> merged;
+  for( nodeId_t i = 0; i < numNodes; ++i ) {
+    nodeId_t node;
+    if( computeOrder ) {
+      // Lazy deletion: skip entries whose degree is outdated
+      while( true ) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        const HeapEntry entry = heap.back();
+        heap.pop_back();
+        if( !contracted[entry.second] && entry.first == neighbors[entry.second].size() ) {
+          node = entry.second;
+          break;
+        }
+      }
+      order->push_back(node);
+    } else {
+      node = (*order)[i];
+    }
+
+    // The remaining neighbors of the node become a clique
+    contracted[node] = true;
+    const std::vector<nodeId_t>& clique = neighbors[node];
+    for( const nodeId_t neighbor : clique ) {
+      std::vector<nodeId_t>& list = neighbors[neighbor];
+      merged.clear();
+      std::set_union(list.begin(), list.end(), clique.begin(), clique.end(), std::back_inserter(merged));
+      list.clear();
+      for( const nodeId_t other : merged ) {
+        if( other != neighbor && other != node ) {
+          list.push_back(other);
+        }
+      }
+      if( computeOrder ) {
+        heap.push_back(HeapEntry(list.size(), neighbor));
+        std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+      }
+    }
+    (*upward)[node] = std::move(neighbors[node]);
+    neighbors[node].clear();
+  }
+}
+
+ErrorCode ContractionHierarchy::build( const RoutingGraph* graph,
+                                       const std::vector<nodeId_t>& order ) noexcept {
+  const nodeId_t numNodes = graph->numNodes();
+  if( !order.empty() ) {
+    if( order.size() != numNodes ) {
+      return ErrorCode::E_ROUTING_INVALID_NODE;
+    }
+    std::vector<bool> seen(numNodes, false);
+    for( const nodeId_t node : order ) {
+      if( node >= numNodes || seen[node] ) {
+        return ErrorCode::E_ROUTING_INVALID_NODE;
+      }
+      seen[node] = true;
+    }
+  }
+
+  p_graph = graph;
+  m_order = order;
+  std::vector<std::vector<nodeId_t>> upward;
+  contract(&m_order, &upward);
+
+  m_ranks.resize(numNodes);
+  for( nodeId_t rank = 0; rank < numNodes; ++rank ) {
+    m_ranks[m_order[rank]] = rank;
+  }
+
+  // Upward arcs in rank space
+  m_upOffsets.assign(numNodes+1, 0);
+  m_upHeads.clear();
+  for( nodeId_t rank = 0; rank < numNodes; ++rank ) {
+    const std::vector<nodeId_t>& heads = upward[m_order[rank]];
+    const arcId_t first = static_cast<arcId_t>(m_upHeads.size());
+    for( const nodeId_t head : heads ) {
+      m_upHeads.push_back(m_ranks[head]);
+    }
+    std::sort(m_upHeads.begin() + first, m_upHeads.end());
+    m_upOffsets[rank+1] = static_cast<arcId_t>(m_upHeads.size());
+  }
+  const arcId_t numArcs = static_cast<arcId_t>(m_upHeads.size());
+
+  // Downward arcs, sorted by tail since arcs are visited in rank order
+  m_downOffsets.assign(numNodes+1, 0);
+  for( arcId_t arc = 0; arc < numArcs; ++arc ) {
+    ++m_downOffsets[m_upHeads[arc]+1];
+  }
+  for( nodeId_t rank = 0; rank < numNodes; ++rank ) {
+    m_downOffsets[rank+1] += m_downOffsets[rank];
+  }
+  m_downTails.resize(numArcs);
+  m_downArcs.resize(numArcs);
+  std::vector<arcId_t> next(m_downOffsets.begin(), m_downOffsets.end()-1);
+  for( nodeId_t rank = 0; rank < numNodes; ++rank ) {
+    for( arcId_t arc = m_upOffsets[rank]; arc < m_upOffsets[rank+1]; ++arc ) {
+      const arcId_t position = next[m_upHeads[arc]]++;
+      m_downTails[position] = rank;
+      m_downArcs[position] = arc;
+    }
+  }
+
+  // Mapping between the edges of the graph and the arcs
+  m_edgeArcs.assign(graph->numEdges(), kInvalidArc);
+  m_arcEdgeOffsets.assign(numArcs+1, 0);
+  for( nodeId_t node = 0; node < numNodes; ++node ) {
+    for( edgeId_t e = graph->firstOut(node); e < graph->endOut(node); ++e ) {
+      const nodeId_t tail = m_ranks[node];
+      const nodeId_t head = m_ranks[graph->head(e)];
+      if( tail != head ) {
+        m_edgeArcs[e] = findArc(std::min(tail, head), std::max(tail, head));
+        ++m_arcEdgeOffsets[m_edgeArcs[e]+1];
+      }
+    }
+  }
+  for( arcId_t arc = 0; arc < numArcs; ++arc ) {
+    m_arcEdgeOffsets[arc+1] += m_arcEdgeOffsets[arc];
+  }
+  m_arcEdges.resize(m_arcEdgeOffsets[numArcs]);
+  next.assign(m_arcEdgeOffsets.begin(), m_arcEdgeOffsets.end()-1);
+  for( nodeId_t node = 0; node < numNodes; ++node ) {
+    for( edgeId_t e = graph->firstOut(node); e < graph->endOut(node); ++e ) {
+      if( m_edgeArcs[e] != kInvalidArc ) {
+        const bool up = m_ranks[node] < m_ranks[graph->head(e)];
+        m_arcEdges[next[m_edgeArcs[e]]++] = ArcEdge{e, up};
+      }
+    }
+  }
+
+  // Levels: a rank is one level above the highest of its lower neighbors
+  m_levels.assign(numNodes, 0);
+  uint32_t numLevels = numNodes > 0 ? 1 : 0;
+  for( nodeId_t rank = 0; rank < numNodes; ++rank ) {
+    for( arcId_t i = m_downOffsets[rank]; i < m_downOffsets[rank+1]; ++i ) {
+      m_levels[rank] = std::max(m_levels[rank], m_levels[m_downTails[i]] + 1);
+    }
+    numLevels = std::max(numLevels, m_levels[rank] + 1);
+  }
+  m_levelOffsets.assign(numLevels+1, 0);
+  for( nodeId_t rank = 0; rank < numNodes; ++rank ) {
+    ++m_levelOffsets[m_levels[rank]+1];
+  }
+  for( uint32_t level = 0; level < numLevels; ++level ) {
+    m_levelOffsets[level+1] += m_levelOffsets[level];
+  }
+  m_levelRanks.resize(numNodes);
+  std::vector<uint32_t> nextRank(m_levelOffsets.begin(), m_levelOffsets.end()-1);
+  for( nodeId_t rank = 0; rank < numNodes; ++rank ) {
+    m_levelRanks[nextRank[m_levels[rank]]++] = rank;
+  }
+
+  m_upWeights.assign(numArcs, kInfiniteWeight);
+  m_downWeights.assign(numArcs, kInfiniteWeight);
+  m_pending.assign(numArcs, false);
+  return ErrorCode::E_NO_ERROR;
+}
+
+arcId_t ContractionHierarchy::findArc( const nodeId_t low, const nodeId_t high ) const noexcept {
+  const auto first = m_upHeads.begin() + m_upOffsets[low];
+  const auto last = m_upHeads.begin() + m_upOffsets[low+1];
+  const auto it = std::lower_bound(first, last, high);
+  if( it == last || *it != high ) {
+    return kInvalidArc;
+  }
+  return static_cast<arcId_t>(it - m_upHeads.begin());
+}
+
+bool ContractionHierarchy::customizeArc( const nodeId_t low, const arcId_t arc, const weight_t* weights ) noexcept {
+  const nodeId_t high = m_upHeads[arc];
+  weight_t up = kInfiniteWeight;
+  weight_t down = kInfiniteWeight;
+  for( uint32_t i = m_arcEdgeOffsets[arc]; i < m_arcEdgeOffsets[arc+1]; ++i ) {
+    const weight_t weight = weights[m_arcEdges[i].m_edge];
+    if( m_arcEdges[i].m_up ) {
+      up = std::min(up, weight);
+    } else {
+      down = std::min(down, weight);
+    }
+  }
+
+  // Lower triangles: common lower neighbors of low and high
+  arcId_t i = m_downOffsets[low];
+  arcId_t j = m_downOffsets[high];
+  const arcId_t endI = m_downOffsets[low+1];
+  const arcId_t endJ = m_downOffsets[high+1];
+  while( i < endI && j < endJ ) {
+    if( m_downTails[i] < m_downTails[j] ) {
+      ++i;
+    } else if( m_downTails[j] < m_downTails[i] ) {
+      ++j;
+    } else {
+      const arcId_t lowArc = m_downArcs[i];
+      const arcId_t highArc = m_downArcs[j];
+      up = std::min(up, addWeights(m_downWeights[lowArc], m_upWeights[highArc]));
+      down = std::min(down, addWeights(m_downWeights[highArc], m_upWeights[lowArc]));
+      ++i;
+      ++j;
+    }
+  }
+
+  const bool changed = up != m_upWeights[arc] || down != m_downWeights[arc];
+  m_upWeights[arc] = up;
+  m_downWeights[arc] = down;
+  return changed;
+}
+
+ErrorCode ContractionHierarchy::customize( const Metric& metric ) noexcept {
+  if( metric.size() != m_edgeArcs.size() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+  const weight_t* weights = metric.weights();
+  const uint32_t numLevels = static_cast<uint32_t>(m_levelOffsets.size()) - 1;
+  for( uint32_t level = 0; level < numLevels; ++level ) {
+    parallelFor(m_levelOffsets[level], m_levelOffsets[level+1], m_config.m_numThreads, 256,
+                [&]( const uint64_t i, const uint32_t ) {
+                  const nodeId_t rank = m_levelRanks[i];
+                  for( arcId_t arc = m_upOffsets[rank]; arc < m_upOffsets[rank+1]; ++arc ) {
+                    customizeArc(rank, arc, weights);
+                  }
+                });
+  }
+  m_metricVersion = metric.version();
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode ContractionHierarchy::update( const Metric& metric, const std::vector<edgeId_t>& edges ) noexcept {
+  if( metric.size() != m_edgeArcs.size() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+  const weight_t* weights = metric.weights();
+  for( const edgeId_t edge : edges ) {
+    if( edge >= m_edgeArcs.size() ) {
+      return ErrorCode::E_ROUTING_INVALID_EDGE;
+    }
+  }
+
+  using PendingArc = std::pair<nodeId_t, arcId_t>;
+  const uint32_t numLevels = static_cast<uint32_t>(m_levelOffsets.size()) - 1;
+  std::vector<std::vector<PendingArc>> pending(numLevels);
+  auto schedule = [&]( const nodeId_t low, const arcId_t arc ) {
+    if( !m_pending[arc] ) {
+      m_pending[arc] = true;
+      pending[m_levels[low]].push_back(PendingArc(low, arc));
+    }
+  };
+
+  for( const edgeId_t edge : edges ) {
+    const arcId_t arc = m_edgeArcs[edge];
+    if( arc != kInvalidArc ) {
+      const nodeId_t low = static_cast<nodeId_t>(
+          std::upper_bound(m_upOffsets.begin(), m_upOffsets.end(), arc) - m_upOffsets.begin() - 1);
+      schedule(low, arc);
+    }
+  }
+
+  m_numUpdatedArcs = 0;
+  std::vector<uint8_t> changed;
+  for( uint32_t level = 0; level < numLevels; ++level ) {
+    const std::vector<PendingArc>& arcs = pending[level];
+    changed.assign(arcs.size(), 0);
+    parallelFor(0, arcs.size(), m_config.m_numThreads, 64,
+                [&]( const uint64_t i, const uint32_t ) {
+                  changed[i] = customizeArc(arcs[i].first, arcs[i].second, weights);
+                });
+
+    // A changed arc (z,x) is part of the lower triangles of the arcs between
+    // x and the other higher neighbors of z, which are in higher levels.
+    for( uint64_t i = 0; i < arcs.size(); ++i ) {
+      m_pending[arcs[i].second] = false;
+      if( !changed[i] ) {
+        continue;
+      }
+      const nodeId_t low = arcs[i].first;
+      const nodeId_t x = m_upHeads[arcs[i].second];
+      for( arcId_t arc = m_upOffsets[low]; arc < m_upOffsets[low+1]; ++arc ) {
+        const nodeId_t y = m_upHeads[arc];
+        if( y != x ) {
+          const nodeId_t a = std::min(x, y);
+          schedule(a, findArc(a, std::max(x, y)));
+        }
+      }
+    }
+    m_numUpdatedArcs += arcs.size();
+  }
+  m_metricVersion = metric.version();
+  return ErrorCode::E_NO_ERROR;
+}
+
+void ContractionHierarchy::unpack( const nodeId_t from,
+                                   const nodeId_t to,
+                                   const Metric& metric,
+                                   std::vector<nodeId_t>* path ) const noexcept {
+  const bool upward = from < to;
+  const nodeId_t low = upward ? from : to;
+  const nodeId_t high = upward ? to : from;
+  const arcId_t arc = findArc(low, high);
+  const weight_t weight = upward ? m_upWeights[arc] : m_downWeights[arc];
+
+  for( uint32_t i = m_arcEdgeOffsets[arc]; i < m_arcEdgeOffsets[arc+1]; ++i ) {
+    if( m_arcEdges[i].m_up == upward && metric.weight(m_arcEdges[i].m_edge) == weight ) {
+      path->push_back(to);
+      return;
+    }
+  }
+
+  arcId_t i = m_downOffsets[low];
+  arcId_t j = m_downOffsets[high];
+  while( i < m_downOffsets[low+1] && j < m_downOffsets[high+1] ) {
+    if( m_downTails[i] < m_downTails[j] ) {
+      ++i;
+    } else if( m_downTails[j] < m_downTails[i] ) {
+      ++j;
+    } else {
+      const arcId_t lowArc = m_downArcs[i];
+      const arcId_t highArc = m_downArcs[j];
+      const weight_t viaWeight = upward ?
+        addWeights(m_downWeights[lowArc], m_upWeights[highArc]) :
+        addWeights(m_downWeights[highArc], m_upWeights[lowArc]);
+      if( viaWeight == weight ) {
+        unpack(from, m_downTails[i], metric, path);
+        unpack(m_downTails[i], to, metric, path);
+        return;
+      }
+      ++i;
+      ++j;
+    }
+  }
+}
+
+ContractionHierarchyQuery::ContractionHierarchyQuery( const ContractionHierarchy* hierarchy ) noexcept :
+  p_hierarchy(hierarchy),
+  m_distances{std::vector<weight_t>(hierarchy->numNodes(), kInfiniteWeight),
+              std::vector<weight_t>(hierarchy->numNodes(), kInfiniteWeight)},
+  m_parents{std::vector<nodeId_t>(hierarchy->numNodes(), kInvalidNode),
+            std::vector<nodeId_t>(hierarchy->numNodes(), kInvalidNode)},
+  m_queues{{hierarchy->numNodes()}, {hierarchy->numNodes()}} {
+}
+
+void ContractionHierarchyQuery::settle( const uint32_t direction ) noexcept {
+  const nodeId_t rank = m_queues[direction].pop();
+  SMILE_PROFILE_COUNT(p_stats, m_heapPops);
+  SMILE_PROFILE_COUNT(p_stats, m_nodesSettled);
+  const weight_t distance = m_distances[direction][rank];
+  const weight_t total = addWeights(distance, m_distances[1-direction][rank]);
+  if( total < m_distance ) {
+    m_distance = total;
+    m_meeting = rank;
+  }
+
+  for( arcId_t arc = p_hierarchy->firstUp(rank); arc < p_hierarchy->endUp(rank); ++arc ) {
+    const nodeId_t head = p_hierarchy->upHead(arc);
+    const weight_t weight = direction == 0 ? p_hierarchy->upWeight(arc) : p_hierarchy->downWeight(arc);
+    const weight_t candidate = addWeights(distance, weight);
+    SMILE_PROFILE_COUNT(p_stats, m_edgesRelaxed);
+    if( candidate < m_distances[direction][head] ) {
+      if( m_distances[direction][head] == kInfiniteWeight ) {
+        m_touched[direction].push_back(head);
+        SMILE_PROFILE_COUNT(p_stats, m_heapPushes);
+      } else {
+        SMILE_PROFILE_COUNT(p_stats, m_heapDecreases);
+      }
+      m_distances[direction][head] = candidate;
+      m_parents[direction][head] = rank;
+      m_queues[direction].pushOrDecrease(head, candidate);
+    }
+  }
+}
+
+ErrorCode ContractionHierarchyQuery::run( const nodeId_t source, const nodeId_t target ) noexcept {
+  const nodeId_t numNodes = p_hierarchy->numNodes();
+  if( source >= numNodes || target >= numNodes ) {
+    return ErrorCode::E_ROUTING_INVALID_NODE;
+  }
+
+  ScopedPhaseTimer timer(p_stats, QueryPhase::E_SEARCH);
+  for( uint32_t direction = 0; direction < 2; ++direction ) {
+    for( const nodeId_t rank : m_touched[direction] ) {
+      m_distances[direction][rank] = kInfiniteWeight;
+      m_parents[direction][rank] = kInvalidNode;
+    }
+    m_touched[direction].clear();
+    m_queues[direction].clear();
+  }
+
+  m_source = p_hierarchy->rank(source);
+  m_target = p_hierarchy->rank(target);
+  m_distance = kInfiniteWeight;
+  m_meeting = kInvalidNode;
+  const nodeId_t start[2] = {m_source, m_target};
+  for( uint32_t direction = 0; direction < 2; ++direction ) {
+    m_distances[direction][start[direction]] = 0;
+    m_touched[direction].push_back(start[direction]);
+    m_queues[direction].pushOrDecrease(start[direction], 0);
+    SMILE_PROFILE_COUNT(p_stats, m_heapPushes);
+  }
+
+  while( true ) {
+    const bool forward = !m_queues[0].empty() && m_queues[0].minKey() < m_distance;
+    const bool backward = !m_queues[1].empty() && m_queues[1].minKey() < m_distance;
+    if( !forward && !backward ) {
+      break;
+    }
+    if( forward && (!backward || m_queues[0].minKey() <= m_queues[1].minKey()) ) {
+      settle(0);
+    } else {
+      settle(1);
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+void ContractionHierarchyQuery::path( const Metric& metric, std::vector<nodeId_t>* path ) const noexcept {
+  ScopedPhaseTimer timer(p_stats, QueryPhase::E_UNPACK);
+  path->clear();
+  if( m_distance == kInfiniteWeight ) {
+    return;
+  }
+
+  std::vector<nodeId_t> ranks;
+  for( nodeId_t rank = m_meeting; rank != kInvalidNode; rank = m_parents[0][rank] ) {
+    ranks.push_back(rank);
+  }
+  std::reverse(ranks.begin(), ranks.end());
+  for( nodeId_t rank = m_parents[1][m_meeting]; rank != kInvalidNode; rank = m_parents[1][rank] ) {
+    ranks.push_back(rank);
+  }
+
+  std::vector<nodeId_t> unpacked{ranks[0]};
+  for( uint64_t i = 1; i < ranks.size(); ++i ) {
+    p_hierarchy->unpack(ranks[i-1], ranks[i], metric, &unpacked);
+  }
+  for( const nodeId_t rank : unpacked ) {
+    path->push_back(p_hierarchy->node(rank));
+  }
+}
+
+SMILE_NS_END
@@ -0,0 +1,347 @@
+
+
+
+#ifndef _SMILE_ROUTING_CONTRACTION_HIERARCHY_H_
+#define _SMILE_ROUTING_CONTRACTION_HIERARCHY_H_
+
+#include "../base/base.h"
+#include "../base/profiling.h"
+#include "graph.h"
+#include "metric.h"
+#include "priority_queue.h"
+#include <vector>
+
+SMILE_NS_BEGIN
+
+using arcId_t = uint32_t;
+
+constexpr arcId_t kInvalidArc = 0xFFFFFFFF;
+
+struct ContractionHierarchyConfig {
+  /**
+   * Number of threads used during customization
+   */
+  uint32_t  m_numThreads = 1;
+};
+
+/**
+ * Customizable Contraction Hierarchy. The preprocessing is split in two
+ * phases:
+ *  - build: metric independent. Nodes are ordered (by default with a minimum
+ *  degree heuristic) and contracted without witness searches, which yields
+ *  a chordal supergraph whose arcs go from lower to higher ranked nodes.
+ *  - customize: computes the weights of the arcs for a given metric. The
+ *  weight of an arc (x,y) is the minimum of the input edges between x and y
+ *  and of the paths x-z-y through its lower triangles.
+ *
+ * Since the weight of an arc only depends on its input edges and on the arcs
+ * of its lower triangles, after a change of a few edge weights only the arcs
+ * reachable from them through triangles need to be recomputed. Arcs are
+ * processed by level (the height of their lower node in the elimination
+ * order), and arcs in the same level are independent, so each level is
+ * customized in parallel.
+ *
+ * All nodes and arcs are stored in rank space (the position of the node in
+ * the contraction order).
+ **/
+class ContractionHierarchy {
+  public:
+    SMILE_NON_COPYABLE(ContractionHierarchy);
+
+    ContractionHierarchy( const ContractionHierarchyConfig& config = ContractionHierarchyConfig() ) noexcept;
+    ~ContractionHierarchy() noexcept = default;
+
+    /**
+     * Builds the metric independent hierarchy of a graph
+     * @param in graph The graph. Must outlive the hierarchy.
+     * @param in order The contraction order (order[i] is the node contracted
+     * i-th). If empty, it is computed with a minimum degree heuristic.
+     * @return E_ROUTING_INVALID_NODE if the order is not a permutation of the
+     * nodes of the graph
+     **/
+    ErrorCode build( const RoutingGraph* graph,
+                     const std::vector<nodeId_t>& order = std::vector<nodeId_t>() ) noexcept;
+
+    /**
+     * Computes the weights of all the arcs of the hierarchy
+     * @param in metric The weights of the edges
+     * @return E_ROUTING_METRIC_SIZE_MISSMATCH if the metric does not match the
+     * graph
+     **/
+    ErrorCode customize( const Metric& metric ) noexcept;
+
+    /**
+     * Recomputes the weights of the arcs affected by a change in the weights
+     * of some edges. The hierarchy must have been customized before.
+     * @param in metric The new version of the metric the hierarchy was
+     * customized with
+     * @param in edges The edge slots whose weight changed
+     * @return E_ROUTING_INVALID_EDGE if an edge is out of bounds,
+     * E_ROUTING_METRIC_SIZE_MISSMATCH if the metric does not match the graph
+     **/
+    ErrorCode update( const Metric& metric, const std::vector<edgeId_t>& edges ) noexcept;
+
+    /**
+     * Gets the version of the metric the hierarchy was last customized or
+     * updated with
+     **/
+    uint64_t metricVersion() const noexcept {
+      return m_metricVersion;
+    }
+
+    /**
+     * Gets the number of arcs recomputed by the last call to update
+     **/
+    uint64_t numUpdatedArcs() const noexcept {
+      return m_numUpdatedArcs;
+    }
+
+    /**
+     * Gets the number of nodes of the hierarchy
+     **/
+    nodeId_t numNodes() const noexcept {
+      return static_cast<nodeId_t>(m_order.size());
+    }
+
+    /**
+     * Gets the number of arcs of the hierarchy
+     **/
+    arcId_t numArcs() const noexcept {
+      return static_cast<arcId_t>(m_upHeads.size());
+    }
+
+    /**
+     * Gets the rank of a node
+     **/
+    nodeId_t rank( const nodeId_t node ) const noexcept {
+      return m_ranks[node];
+    }
+
+    /**
+     * Gets the node with the given rank
+     **/
+    nodeId_t node( const nodeId_t rank ) const noexcept {
+      return m_order[rank];
+    }
+
+    /**
+     * Gets the first arc to a higher ranked node
+     **/
+    arcId_t firstUp( const nodeId_t rank ) const noexcept {
+      return m_upOffsets[rank];
+    }
+
+    /**
+     * Gets the end (one past the last) arc to a higher ranked node
+     **/
+    arcId_t endUp( const nodeId_t rank ) const noexcept {
+      return m_upOffsets[rank+1];
+    }
+
+    /**
+     * Gets the rank of the higher node of an arc
+     **/
+    nodeId_t upHead( const arcId_t arc ) const noexcept {
+      return m_upHeads[arc];
+    }
+
+    /**
+     * Gets the weight of an arc from the lower to the higher node
+     **/
+    weight_t upWeight( const arcId_t arc ) const noexcept {
+      return m_upWeights[arc];
+    }
+
+    /**
+     * Gets the weight of an arc from the higher to the lower node
+     **/
+    weight_t downWeight( const arcId_t arc ) const noexcept {
+      return m_downWeights[arc];
+    }
+
+    /**
+     * Finds the arc between two nodes
+     * @param in low The rank of the lower node
+     * @param in high The rank of the higher node
+     * @return The arc or kInvalidArc if the nodes are not adjacent
+     **/
+    arcId_t findArc( const nodeId_t low, const nodeId_t high ) const noexcept;
+
+    /**
+     * Unpacks the path between two adjacent nodes into the nodes of the graph
+     * (in rank space), appending all the nodes except the first one.
+     * @param in from The rank of the first node
+     * @param in to The rank of the last node
+     * @param in metric The metric the hierarchy was customized with
+     * @param out path The path
+     **/
+    void unpack( const nodeId_t from,
+                 const nodeId_t to,
+                 const Metric& metric,
+                 std::vector<nodeId_t>* path ) const noexcept;
+
+  private:
+
+    struct ArcEdge {
+      edgeId_t  m_edge;
+      bool      m_up;
+    };
+
+    /**
+     * Contracts the nodes of the graph, without witness searches
+     * @param in/out order The contraction order. If empty, it is filled with
+     * the order given by a minimum degree heuristic.
+     * @param out upward The higher ranked neighbors of each node
+     **/
+    void contract( std::vector<nodeId_t>* order,
+                   std::vector<std::vector<nodeId_t>>* upward ) const noexcept;
+
+    /**
+     * Recomputes the weights of an arc from its input edges and its lower
+     * triangles.
+     * @return true if the weights changed
+     **/
+    bool customizeArc( const nodeId_t low, const arcId_t arc, const weight_t* weights ) noexcept;
+
+    // The configuration of the hierarchy
+    ContractionHierarchyConfig  m_config;
+
+    // The graph of the hierarchy
+    const RoutingGraph*         p_graph = nullptr;
+
+    // The node with each rank
+    std::vector<nodeId_t>       m_order;
+
+    // The rank of each node
+    std::vector<nodeId_t>       m_ranks;
+
+    // The first upward arc of each rank. Has numNodes+1 entries
+    std::vector<arcId_t>        m_upOffsets;
+
+    // The higher rank of each arc. Sorted for each lower rank
+    std::vector<nodeId_t>       m_upHeads;
+
+    // The first downward arc of each rank. Has numNodes+1 entries
+    std::vector<arcId_t>        m_downOffsets;
+
+    // The lower rank of each downward arc. Sorted for each higher rank
+    std::vector<nodeId_t>       m_downTails;
+
+    // The arc of each downward arc
+    std::vector<arcId_t>        m_downArcs;
+
+    // The first input edge of each arc. Has numArcs+1 entries
+    std::vector<uint32_t>       m_arcEdgeOffsets;
+
+    // The input edges of each arc
+    std::vector<ArcEdge>        m_arcEdges;
+
+    // The arc of each edge slot of the graph
+    std::vector<arcId_t>        m_edgeArcs;
+
+    // The level of each rank
+    std::vector<uint32_t>       m_levels;
+
+    // The first rank of each level in m_levelRanks
+    std::vector<uint32_t>       m_levelOffsets;
+
+    // The ranks sorted by level
+    std::vector<nodeId_t>       m_levelRanks;
+
+    // The weight of each arc from the lower to the higher node
+    std::vector<weight_t>       m_upWeights;
+
+    // The weight of each arc from the higher to the lower node
+    std::vector<weight_t>       m_downWeights;
+
+    // Whether each arc is pending to be recomputed during an update
+    std::vector<bool>           m_pending;
+
+    // The number of arcs recomputed by the last update
+    uint64_t                    m_numUpdatedArcs = 0;
+
+    // The version of the metric of the last customization
+    uint64_t                    m_metricVersion = 0;
+};
+
+/**
+ * Shortest path query on a customized ContractionHierarchy: a bidirectional
+ * Dijkstra that only follows arcs to higher ranked nodes. The search state is
+ * reused between queries.
+ **/
+class ContractionHierarchyQuery {
+  public:
+    SMILE_NON_COPYABLE(ContractionHierarchyQuery);
+
+    ContractionHierarchyQuery( const ContractionHierarchy* hierarchy ) noexcept;
+    ~ContractionHierarchyQuery() noexcept = default;
+
+    /**
+     * Computes the shortest path distance between two nodes
+     * @param in source The source node
+     * @param in target The target node
+     * @return E_ROUTING_INVALID_NODE if source or target are out of bounds
+     **/
+    ErrorCode run( const nodeId_t source, const nodeId_t target ) noexcept;
+
+    /**
+     * Sets the object where the counters of the following queries are
+     * accumulated, or nullptr to stop profiling
+     **/
+    void setStats( QueryStats* stats ) noexcept {
+      p_stats = stats;
+    }
+
+    /**
+     * Gets the distance computed by the last query, or kInfiniteWeight
+     **/
+    weight_t distance() const noexcept {
+      return m_distance;
+    }
+
+    /**
+     * Gets the nodes of the shortest path computed by the last query
+     * @param in metric The metric the hierarchy was customized with
+     * @param out path The nodes of the path, from source to target
+     **/
+    void path( const Metric& metric, std::vector<nodeId_t>* path ) const noexcept;
+
+  private:
+
+    /**
+     * Settles the next node of one direction of the search
+     **/
+    void settle( const uint32_t direction ) noexcept;
+
+    // The hierarchy to search in
+    const ContractionHierarchy* p_hierarchy;
+
+    // The tentative distances of each direction, in rank space
+    std::vector<weight_t>       m_distances[2];
+
+    // The predecessor of each rank in each direction
+    std::vector<nodeId_t>       m_parents[2];
+
+    // The ranks touched by the last query in each direction
+    std::vector<nodeId_t>       m_touched[2];
+
+    // The queues of each direction
+    IndexedBinaryHeap           m_queues[2];
+
+    // The distance of the last query
+    weight_t                    m_distance = kInfiniteWeight;
+
+    // The rank where the forward and backward searches met
+    nodeId_t                    m_meeting = kInvalidNode;
+
+    // The source and target of the last query
+    nodeId_t                    m_source = kInvalidNode;
+    nodeId_t                    m_target = kInvalidNode;
+
+    // Where to accumulate the counters of the queries, or nullptr
+    QueryStats*                 p_stats = nullptr;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_CONTRACTION_HIERARCHY_H_ */
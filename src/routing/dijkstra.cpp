@@ -0,0 +1,75 @@
+
+
+#include "dijkstra.h"
+
+SMILE_NS_BEGIN
+
+Dijkstra::Dijkstra( const RoutingGraph* graph ) noexcept :
+  p_graph(graph),
+  m_distances(graph->numNodes(), kInfiniteWeight),
+  m_parents(graph->numNodes(), kInvalidNode),
+  m_queue(graph->numNodes()) {
+}
+
+ErrorCode Dijkstra::run( const nodeId_t source,
+                         const Metric& metric,
+                         const SearchDirection direction,
+                         const nodeId_t target ) noexcept {
+  const nodeId_t numNodes = p_graph->numNodes();
+  if( source >= numNodes || (target != kInvalidNode && target >= numNodes) ) {
+    return ErrorCode::E_ROUTING_INVALID_NODE;
+  }
+  if( metric.size() != p_graph->numEdges() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+
+  ScopedPhaseTimer timer(p_stats, QueryPhase::E_SEARCH);
+  reset();
+  const weight_t* weights = metric.weights();
+  m_distances[source] = 0;
+  m_touched.push_back(source);
+  m_queue.pushOrDecrease(source, 0);
+  SMILE_PROFILE_COUNT(p_stats, m_heapPushes);
+
+  const bool forward = direction == SearchDirection::E_FORWARD;
+  while( !m_queue.empty() ) {
+    const nodeId_t node = m_queue.pop();
+    SMILE_PROFILE_COUNT(p_stats, m_heapPops);
+    SMILE_PROFILE_COUNT(p_stats, m_nodesSettled);
+    if( node == target ) {
+      break;
+    }
+    const weight_t distance = m_distances[node];
+    const edgeId_t first = forward ? p_graph->firstOut(node) : p_graph->firstIn(node);
+    const edgeId_t end = forward ? p_graph->endOut(node) : p_graph->endIn(node);
+    for( edgeId_t e = first; e < end; ++e ) {
+      const nodeId_t next = forward ? p_graph->head(e) : p_graph->tail(e);
+      const weight_t weight = weights[forward ? e : p_graph->forwardEdge(e)];
+      const weight_t candidate = addWeights(distance, weight);
+      SMILE_PROFILE_COUNT(p_stats, m_edgesRelaxed);
+      if( candidate < m_distances[next] ) {
+        if( m_distances[next] == kInfiniteWeight ) {
+          m_touched.push_back(next);
+          SMILE_PROFILE_COUNT(p_stats, m_heapPushes);
+        } else {
+          SMILE_PROFILE_COUNT(p_stats, m_heapDecreases);
+        }
+        m_distances[next] = candidate;
+        m_parents[next] = node;
+        m_queue.pushOrDecrease(next, candidate);
+      }
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+void Dijkstra::reset() noexcept {
+  for( const nodeId_t node : m_touched ) {
+    m_distances[node] = kInfiniteWeight;
+    m_parents[node] = kInvalidNode;
+  }
+  m_touched.clear();
+  m_queue.clear();
+}
+
+SMILE_NS_END
@@ -0,0 +1,100 @@
+
+
+
+#ifndef _SMILE_ROUTING_DIJKSTRA_H_
+#define _SMILE_ROUTING_DIJKSTRA_H_
+
+#include "../base/base.h"
+#include "../base/profiling.h"
+#include "graph.h"
+#include "metric.h"
+#include "priority_queue.h"
+#include <vector>
+
+SMILE_NS_BEGIN
+
+enum class SearchDirection {
+  E_FORWARD,
+  E_BACKWARD
+};
+
+/**
+ * Single criterion one-to-all (or one-to-one) Dijkstra search. The search
+ * state is kept between queries and only the touched nodes are reset, so the
+ * same instance should be reused for many queries on the same graph.
+ **/
+class Dijkstra {
+  public:
+    SMILE_NON_COPYABLE(Dijkstra);
+
+    Dijkstra( const RoutingGraph* graph ) noexcept;
+    ~Dijkstra() noexcept = default;
+
+    /**
+     * Runs a search from the given source
+     * @param in source The node to start the search from
+     * @param in metric The weights of the edges
+     * @param in direction Whether to follow edges forward or backward
+     * @param in target If not kInvalidNode, the search stops once the target is
+     * settled.
+     * @return E_ROUTING_INVALID_NODE if the source or target are out of bounds,
+     * E_ROUTING_METRIC_SIZE_MISSMATCH if the metric does not match the graph
+     **/
+    ErrorCode run( const nodeId_t source,
+                   const Metric& metric,
+                   const SearchDirection direction = SearchDirection::E_FORWARD,
+                   const nodeId_t target = kInvalidNode ) noexcept;
+
+    /**
+     * Sets the object where the counters of the following searches are
+     * accumulated, or nullptr to stop profiling
+     **/
+    void setStats( QueryStats* stats ) noexcept {
+      p_stats = stats;
+    }
+
+    /**
+     * Gets the distance to a node computed by the last search, or
+     * kInfiniteWeight if the node was not reached.
+     **/
+    weight_t distance( const nodeId_t node ) const noexcept {
+      return m_distances[node];
+    }
+
+    /**
+     * Gets the predecessor of a node in the shortest path tree of the last
+     * search, or kInvalidNode.
+     **/
+    nodeId_t parent( const nodeId_t node ) const noexcept {
+      return m_parents[node];
+    }
+
+  private:
+
+    /**
+     * Resets the state of the nodes touched by the previous search
+     **/
+    void reset() noexcept;
+
+    // The graph to search in
+    const RoutingGraph*   p_graph;
+
+    // The tentative distance of each node
+    std::vector<weight_t> m_distances;
+
+    // The predecessor of each node
+    std::vector<nodeId_t> m_parents;
+
+    // The nodes touched by the last search
+    std::vector<nodeId_t> m_touched;
+
+    // The queue of the search
+    IndexedBinaryHeap     m_queue;
+
+    // Where to accumulate the counters of the searches, or nullptr
+    QueryStats*           p_stats = nullptr;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_DIJKSTRA_H_ */
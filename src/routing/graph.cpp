@@ -0,0 +1,157 @@
+
+
+#include "graph.h"
+
+SMILE_NS_BEGIN
+
+ErrorCode RoutingGraph::build( const nodeId_t numNodes,
+                               const std::vector<RoutingEdge>& edges,
+                               std::vector<edgeId_t>* permutation ) noexcept {
+  for( const RoutingEdge& edge : edges ) {
+    if( edge.m_tail >= numNodes || edge.m_head >= numNodes ) {
+      return ErrorCode::E_ROUTING_INVALID_NODE;
+    }
+  }
+
+  m_numNodes = numNodes;
+  const edgeId_t numEdges = static_cast<edgeId_t>(edges.size());
+
+  // Counting sort of the edges by tail (forward) and by head (reverse). The
+  // sort is stable, so parallel edges keep their input order.
+  m_offsets.assign(numNodes+1, 0);
+  m_reverseOffsets.assign(numNodes+1, 0);
+  for( const RoutingEdge& edge : edges ) {
+    ++m_offsets[edge.m_tail+1];
+    ++m_reverseOffsets[edge.m_head+1];
+  }
+  for( nodeId_t i = 0; i < numNodes; ++i ) {
+    m_offsets[i+1] += m_offsets[i];
+    m_reverseOffsets[i+1] += m_reverseOffsets[i];
+  }
+
+  std::vector<edgeId_t> next(m_offsets.begin(), m_offsets.end()-1);
+  m_heads.resize(numEdges);
+  if( permutation != nullptr ) {
+    permutation->resize(numEdges);
+  }
+  std::vector<edgeId_t> slots(numEdges);
+  for( edgeId_t i = 0; i < numEdges; ++i ) {
+    const edgeId_t slot = next[edges[i].m_tail]++;
+    m_heads[slot] = edges[i].m_head;
+    slots[i] = slot;
+    if( permutation != nullptr ) {
+      (*permutation)[slot] = i;
+    }
+  }
+
+  next.assign(m_reverseOffsets.begin(), m_reverseOffsets.end()-1);
+  m_reverseTails.resize(numEdges);
+  m_reverseEdges.resize(numEdges);
+  for( edgeId_t i = 0; i < numEdges; ++i ) {
+    const edgeId_t slot = next[edges[i].m_head]++;
+    m_reverseTails[slot] = edges[i].m_tail;
+    m_reverseEdges[slot] = slots[i];
+  }
+  m_numEdges = numEdges;
+  attach();
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode RoutingGraph::store( SnapshotWriter* writer, const std::string& name ) const noexcept {
+  const uint64_t numNodes = static_cast<uint64_t>(m_numNodes) + 1;
+  ErrorCode error = writer->addSection(name + ".offsets", p_offsets, numNodes);
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = writer->addSection(name + ".heads", p_heads, m_numEdges);
+  }
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = writer->addSection(name + ".reverse_offsets", p_reverseOffsets, numNodes);
+  }
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = writer->addSection(name + ".reverse_tails", p_reverseTails, m_numEdges);
+  }
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = writer->addSection(name + ".reverse_edges", p_reverseEdges, m_numEdges);
+  }
+  return error;
+}
+
+/**
+ * Checks that the offsets of an adjacency array never decrease and that its
+ * entries are below a bound
+ **/
+template<typename T>
+static bool validAdjacency( const edgeId_t* offsets, const uint64_t numOffsets,
+                            const T* entries, const uint64_t numEntries, const uint64_t bound ) noexcept {
+  for( uint64_t i = 1; i < numOffsets; ++i ) {
+    if( offsets[i] < offsets[i-1] ) {
+      return false;
+    }
+  }
+  for( uint64_t i = 0; i < numEntries; ++i ) {
+    if( entries[i] >= bound ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ErrorCode RoutingGraph::open( const Snapshot& snapshot, const std::string& name ) noexcept {
+  const edgeId_t* offsets = nullptr;
+  const nodeId_t* heads = nullptr;
+  const edgeId_t* reverseOffsets = nullptr;
+  const nodeId_t* reverseTails = nullptr;
+  const edgeId_t* reverseEdges = nullptr;
+  uint64_t counts[5];
+  ErrorCode error = snapshot.section(name + ".offsets", &offsets, &counts[0]);
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = snapshot.section(name + ".heads", &heads, &counts[1]);
+  }
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = snapshot.section(name + ".reverse_offsets", &reverseOffsets, &counts[2]);
+  }
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = snapshot.section(name + ".reverse_tails", &reverseTails, &counts[3]);
+  }
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = snapshot.section(name + ".reverse_edges", &reverseEdges, &counts[4]);
+  }
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  if( counts[0] == 0 || counts[0] != counts[2] || counts[1] != counts[3] || counts[1] != counts[4] ||
+      offsets[counts[0]-1] != counts[1] || reverseOffsets[counts[2]-1] != counts[1] ) {
+    return ErrorCode::E_STORAGE_INVALID_SECTION;
+  }
+  // The searches do not check the ids they read, so a corrupted snapshot is
+  // rejected here once rather than on every edge relaxation
+  const uint64_t numNodes = counts[0] - 1;
+  if( !validAdjacency(offsets, counts[0], heads, counts[1], numNodes) ||
+      !validAdjacency(reverseOffsets, counts[2], reverseTails, counts[3], numNodes) ||
+      !validAdjacency(nullptr, 0, reverseEdges, counts[4], counts[1]) ) {
+    return ErrorCode::E_STORAGE_INVALID_SECTION;
+  }
+
+  m_offsets.clear();
+  m_heads.clear();
+  m_reverseOffsets.clear();
+  m_reverseTails.clear();
+  m_reverseEdges.clear();
+  m_numNodes = static_cast<nodeId_t>(counts[0] - 1);
+  m_numEdges = static_cast<edgeId_t>(counts[1]);
+  p_offsets = offsets;
+  p_heads = heads;
+  p_reverseOffsets = reverseOffsets;
+  p_reverseTails = reverseTails;
+  p_reverseEdges = reverseEdges;
+  return ErrorCode::E_NO_ERROR;
+}
+
+void RoutingGraph::attach() noexcept {
+  p_offsets = m_offsets.data();
+  p_heads = m_heads.data();
+  p_reverseOffsets = m_reverseOffsets.data();
+  p_reverseTails = m_reverseTails.data();
+  p_reverseEdges = m_reverseEdges.data();
+}
+
+SMILE_NS_END
@@ -0,0 +1,174 @@
+
+
+
+#ifndef _SMILE_ROUTING_GRAPH_H_
+#define _SMILE_ROUTING_GRAPH_H_
+
+#include "../base/base.h"
+#include "types.h"
+#include "../storage/snapshot.h"
+#include <vector>
+
+SMILE_NS_BEGIN
+
+struct RoutingEdge {
+  nodeId_t m_tail;
+  nodeId_t m_head;
+};
+
+/**
+ * Static directed graph stored in Compressed Sparse Row (CSR) format. The
+ * outgoing edges of each node are stored contiguously, sorted by tail.
+ * Edge weights are not stored in the graph: they are kept in arrays aligned
+ * with the adjacency order (the edge slot), so the same topology can be
+ * traversed with different weights. A reverse adjacency is also kept, whose
+ * slots point back to the forward edge slot, so backward searches can use the
+ * same weight arrays.
+ **/
+class RoutingGraph {
+  public:
+    SMILE_NON_COPYABLE(RoutingGraph);
+
+    RoutingGraph() noexcept = default;
+    ~RoutingGraph() noexcept = default;
+
+    RoutingGraph( RoutingGraph&& ) = default;
+    RoutingGraph& operator=( RoutingGraph&& ) = default;
+
+    /**
+     * Builds the graph from an edge list
+     * @param in numNodes The number of nodes of the graph
+     * @param in edges The edges of the graph
+     * @param out permutation If not null, filled with the position in edges of
+     * the edge stored at each edge slot, so attributes of the input edges can
+     * be reordered to adjacency order.
+     * @return E_ROUTING_INVALID_NODE if an edge references a node out of bounds
+     **/
+    ErrorCode build( const nodeId_t numNodes,
+                     const std::vector<RoutingEdge>& edges,
+                     std::vector<edgeId_t>* permutation = nullptr ) noexcept;
+
+    /**
+     * Writes the adjacency arrays of the graph into a snapshot
+     * @param in writer The snapshot being written
+     * @param in name The prefix of the sections of the graph
+     **/
+    ErrorCode store( SnapshotWriter* writer, const std::string& name ) const noexcept;
+
+    /**
+     * Opens a graph stored in a snapshot. The adjacency arrays are not
+     * copied: the graph points to the mapped sections, so the snapshot must
+     * outlive the graph.
+     * @param in snapshot The snapshot
+     * @param in name The prefix of the sections of the graph
+     * @return E_STORAGE_UNEXISTING_SECTION if the graph is not in the
+     * snapshot and E_STORAGE_INVALID_SECTION if its sections are inconsistent,
+     * its offsets decrease or a node or edge id is out of range
+     **/
+    ErrorCode open( const Snapshot& snapshot, const std::string& name ) noexcept;
+
+    /**
+     * Gets the number of nodes of the graph
+     **/
+    nodeId_t numNodes() const noexcept {
+      return m_numNodes;
+    }
+
+    /**
+     * Gets the number of edges of the graph
+     **/
+    edgeId_t numEdges() const noexcept {
+      return m_numEdges;
+    }
+
+    /**
+     * Gets the first outgoing edge slot of a node
+     **/
+    edgeId_t firstOut( const nodeId_t node ) const noexcept {
+      return p_offsets[node];
+    }
+
+    /**
+     * Gets the end (one past the last) outgoing edge slot of a node
+     **/
+    edgeId_t endOut( const nodeId_t node ) const noexcept {
+      return p_offsets[node+1];
+    }
+
+    /**
+     * Gets the head of the edge at the given slot
+     **/
+    nodeId_t head( const edgeId_t edge ) const noexcept {
+      return p_heads[edge];
+    }
+
+    /**
+     * Gets the first incoming edge slot of a node in the reverse adjacency
+     **/
+    edgeId_t firstIn( const nodeId_t node ) const noexcept {
+      return p_reverseOffsets[node];
+    }
+
+    /**
+     * Gets the end (one past the last) incoming edge slot of a node in the
+     * reverse adjacency
+     **/
+    edgeId_t endIn( const nodeId_t node ) const noexcept {
+      return p_reverseOffsets[node+1];
+    }
+
+    /**
+     * Gets the tail of the edge at the given reverse adjacency slot
+     **/
+    nodeId_t tail( const edgeId_t inEdge ) const noexcept {
+      return p_reverseTails[inEdge];
+    }
+
+    /**
+     * Gets the forward edge slot of the edge at the given reverse adjacency
+     * slot
+     **/
+    edgeId_t forwardEdge( const edgeId_t inEdge ) const noexcept {
+      return p_reverseEdges[inEdge];
+    }
+
+  private:
+
+    /**
+     * Points the adjacency arrays to the vectors owned by the graph
+     **/
+    void attach() noexcept;
+
+    // The number of nodes of the graph
+    nodeId_t              m_numNodes = 0;
+
+    // The number of edges of the graph
+    edgeId_t              m_numEdges = 0;
+
+    // The first edge slot of each node. Has numNodes+1 entries
+    const edgeId_t*       p_offsets = nullptr;
+
+    // The head of each edge slot
+    const nodeId_t*       p_heads = nullptr;
+
+    // The first reverse edge slot of each node. Has numNodes+1 entries
+    const edgeId_t*       p_reverseOffsets = nullptr;
+
+    // The tail of each reverse edge slot
+    const nodeId_t*       p_reverseTails = nullptr;
+
+    // The forward edge slot of each reverse edge slot
+    const edgeId_t*       p_reverseEdges = nullptr;
+
+    // The storage of the adjacency arrays of a built graph. Empty if the
+    // graph was opened from a snapshot.
+    std::vector<edgeId_t> m_offsets;
+    std::vector<nodeId_t> m_heads;
+    std::vector<edgeId_t> m_reverseOffsets;
+    std::vector<nodeId_t> m_reverseTails;
+    std::vector<edgeId_t> m_reverseEdges;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_GRAPH_H_ */
@@ -0,0 +1,226 @@
+
+
+#include "hub_labels.h"
+#include "../base/parallel.h"
+#include <algorithm>
+#include <cstdlib>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+SMILE_NS_BEGIN
+
+/**
+ * Hubs used to pad the labels of each direction. They are different, so
+ * padding entries never match.
+ **/
+static constexpr uint32_t kPaddingHub[2] = {0xFFFFFFFE, 0xFFFFFFFF};
+
+/**
+ * Labels start at multiples of this number of 32 bit words (a cache line)
+ **/
+static constexpr uint64_t kLabelAlignment = 16;
+
+namespace {
+
+struct LabelEntry {
+  uint32_t  m_hub;
+  weight_t  m_distance;
+};
+
+/**
+ * Computes the distance between two labels being built
+ **/
+weight_t intersect( const std::vector<LabelEntry>& forward, const std::vector<LabelEntry>& backward ) noexcept {
+  weight_t best = kInfiniteWeight;
+  uint64_t i = 0;
+  uint64_t j = 0;
+  while( i < forward.size() && j < backward.size() ) {
+    if( forward[i].m_hub < backward[j].m_hub ) {
+      ++i;
+    } else if( backward[j].m_hub < forward[i].m_hub ) {
+      ++j;
+    } else {
+      best = std::min(best, addWeights(forward[i].m_distance, backward[j].m_distance));
+      ++i;
+      ++j;
+    }
+  }
+  return best;
+}
+
+}
+
+HubLabels::HubLabels( const HubLabelsConfig& config ) noexcept :
+  m_config(config) {
+}
+
+HubLabels::~HubLabels() noexcept {
+  free(p_data[0]);
+  free(p_data[1]);
+}
+
+ErrorCode HubLabels::build( const ContractionHierarchy& hierarchy ) noexcept {
+  const nodeId_t numNodes = hierarchy.numNodes();
+
+  // Nodes are processed top-down by levels: the labels of a node only depend
+  // on the labels of the nodes in its upward search space, which are in
+  // previous levels.
+  std::vector<uint32_t> levels(numNodes, 0);
+  uint32_t numLevels = 0;
+  for( nodeId_t rank = numNodes; rank-- > 0; ) {
+    for( arcId_t arc = hierarchy.firstUp(rank); arc < hierarchy.endUp(rank); ++arc ) {
+      levels[rank] = std::max(levels[rank], levels[hierarchy.upHead(arc)] + 1);
+    }
+    numLevels = std::max(numLevels, levels[rank] + 1);
+  }
+  std::vector<std::vector<nodeId_t>> ranksByLevel(numLevels);
+  for( nodeId_t rank = 0; rank < numNodes; ++rank ) {
+    ranksByLevel[levels[rank]].push_back(rank);
+  }
+
+  std::vector<std::vector<LabelEntry>> labels[2];
+  labels[0].resize(numNodes);
+  labels[1].resize(numNodes);
+  for( uint32_t level = 0; level < numLevels; ++level ) {
+    const std::vector<nodeId_t>& ranks = ranksByLevel[level];
+    parallelFor(0, ranks.size(), m_config.m_numThreads, 16,
+                [&]( const uint64_t i, const uint32_t ) {
+      const nodeId_t rank = ranks[i];
+      for( uint32_t direction = 0; direction < 2; ++direction ) {
+        std::vector<LabelEntry> candidates{LabelEntry{rank, 0}};
+        for( arcId_t arc = hierarchy.firstUp(rank); arc < hierarchy.endUp(rank); ++arc ) {
+          const weight_t weight = direction == 0 ? hierarchy.upWeight(arc) : hierarchy.downWeight(arc);
+          if( weight == kInfiniteWeight ) {
+            continue;
+          }
+          for( const LabelEntry& entry : labels[direction][hierarchy.upHead(arc)] ) {
+            candidates.push_back(LabelEntry{entry.m_hub, addWeights(weight, entry.m_distance)});
+          }
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  []( const LabelEntry& a, const LabelEntry& b ) {
+                    return a.m_hub < b.m_hub || (a.m_hub == b.m_hub && a.m_distance < b.m_distance);
+                  });
+        candidates.erase(std::unique(candidates.begin(), candidates.end(),
+                                     []( const LabelEntry& a, const LabelEntry& b ) {
+                                       return a.m_hub == b.m_hub;
+                                     }), candidates.end());
+
+        // Prune the entries for which a shorter path through another hub
+        // exists. Their distance is not the shortest one, so they are never
+        // needed to answer a query.
+        std::vector<LabelEntry>& label = labels[direction][rank];
+        for( const LabelEntry& entry : candidates ) {
+          if( entry.m_distance == kInfiniteWeight ) {
+            continue;
+          }
+          if( entry.m_hub != rank ) {
+            const weight_t other = direction == 0 ?
+              intersect(candidates, labels[1][entry.m_hub]) :
+              intersect(labels[0][entry.m_hub], candidates);
+            if( other < entry.m_distance ) {
+              continue;
+            }
+          }
+          label.push_back(entry);
+        }
+      }
+    });
+  }
+
+  // Pack the labels into cache aligned buffers, indexed by node
+  m_numEntries = 0;
+  for( uint32_t direction = 0; direction < 2; ++direction ) {
+    m_offsets[direction].resize(numNodes);
+    m_sizes[direction].resize(numNodes);
+    uint64_t capacity = 0;
+    for( nodeId_t node = 0; node < numNodes; ++node ) {
+      const uint32_t size = static_cast<uint32_t>(labels[direction][hierarchy.rank(node)].size());
+      m_offsets[direction][node] = capacity;
+      m_sizes[direction][node] = size;
+      capacity += (2*paddedSize(size) + kLabelAlignment - 1) / kLabelAlignment * kLabelAlignment;
+      m_numEntries += size;
+    }
+
+    free(p_data[direction]);
+    p_data[direction] = nullptr;
+    void* data = nullptr;
+    if( posix_memalign(&data, kLabelAlignment*sizeof(uint32_t), std::max<uint64_t>(capacity, 1)*sizeof(uint32_t)) != 0 ) {
+      return ErrorCode::E_UNEXPECTED_ERROR;
+    }
+    p_data[direction] = static_cast<uint32_t*>(data);
+    m_capacities[direction] = capacity;
+
+    for( nodeId_t node = 0; node < numNodes; ++node ) {
+      const std::vector<LabelEntry>& label = labels[direction][hierarchy.rank(node)];
+      const uint32_t padded = paddedSize(m_sizes[direction][node]);
+      uint32_t* hubs = p_data[direction] + m_offsets[direction][node];
+      uint32_t* distances = hubs + padded;
+      for( uint32_t i = 0; i < padded; ++i ) {
+        hubs[i] = i < label.size() ? label[i].m_hub : kPaddingHub[direction];
+        distances[i] = i < label.size() ? label[i].m_distance : kInfiniteWeight;
+      }
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+weight_t HubLabels::distance( const nodeId_t source, const nodeId_t target ) const noexcept {
+  const uint32_t* hubsA = hubs(0, source);
+  const uint32_t* hubsB = hubs(1, target);
+  const uint32_t* distancesA = distances(0, source);
+  const uint32_t* distancesB = distances(1, target);
+  const uint32_t sizeA = paddedSize(m_sizes[0][source]);
+  const uint32_t sizeB = paddedSize(m_sizes[1][target]);
+
+#if defined(__SSE2__)
+  // Blocks of four hubs are compared all against all by rotating one of them.
+  // Distances are below 2^30, so their sums can be compared as signed
+  // integers.
+  const __m128i infinite = _mm_set1_epi32(kInfiniteWeight);
+  __m128i best = infinite;
+  uint32_t i = 0;
+  uint32_t j = 0;
+  while( i < sizeA && j < sizeB ) {
+    const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(hubsA + i));
+    const __m128i da = _mm_load_si128(reinterpret_cast<const __m128i*>(distancesA + i));
+    __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(hubsB + j));
+    __m128i db = _mm_load_si128(reinterpret_cast<const __m128i*>(distancesB + j));
+    for( uint32_t rotation = 0; rotation < 4; ++rotation ) {
+      const __m128i match = _mm_cmpeq_epi32(a, b);
+      const __m128i sum = _mm_add_epi32(da, db);
+      const __m128i candidate = _mm_or_si128(_mm_and_si128(match, sum), _mm_andnot_si128(match, infinite));
+      const __m128i smaller = _mm_cmplt_epi32(candidate, best);
+      best = _mm_or_si128(_mm_and_si128(smaller, candidate), _mm_andnot_si128(smaller, best));
+      b = _mm_shuffle_epi32(b, _MM_SHUFFLE(0,3,2,1));
+      db = _mm_shuffle_epi32(db, _MM_SHUFFLE(0,3,2,1));
+    }
+    const uint32_t lastA = hubsA[i+3];
+    const uint32_t lastB = hubsB[j+3];
+    i += lastA <= lastB ? 4 : 0;
+    j += lastB <= lastA ? 4 : 0;
+  }
+  alignas(16) uint32_t lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), best);
+  return std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+#else
+  weight_t best = kInfiniteWeight;
+  uint32_t i = 0;
+  uint32_t j = 0;
+  while( i < sizeA && j < sizeB ) {
+    if( hubsA[i] < hubsB[j] ) {
+      ++i;
+    } else if( hubsB[j] < hubsA[i] ) {
+      ++j;
+    } else {
+      best = std::min(best, addWeights(distancesA[i], distancesB[j]));
+      ++i;
+      ++j;
+    }
+  }
+  return best;
+#endif
+}
+
+SMILE_NS_END
@@ -0,0 +1,121 @@
+
+
+
+#ifndef _SMILE_ROUTING_HUB_LABELS_H_
+#define _SMILE_ROUTING_HUB_LABELS_H_
+
+#include "../base/base.h"
+#include "contraction_hierarchy.h"
+#include <vector>
+
+SMILE_NS_BEGIN
+
+struct HubLabelsConfig {
+  /**
+   * Number of threads used to build the labels of each level
+   */
+  uint32_t  m_numThreads = 1;
+};
+
+/**
+ * Hub labeling distance oracle. Each node has a forward label (hubs reachable
+ * from the node) and a backward label (hubs that reach the node), computed
+ * from a customized ContractionHierarchy: the label of a node is the union of
+ * the labels of its higher neighbors, pruned of the entries whose distance is
+ * not the shortest one. Hubs are identified by their rank, so labels are
+ * sorted by hub, and the distance between two nodes is the minimum over the
+ * common hubs of the forward label of the source and the backward label of the
+ * target.
+ *
+ * The labels of all the nodes of a direction are stored in a single buffer.
+ * Each label starts at a cache line boundary and holds its hubs followed by
+ * their distances, both padded to a multiple of four entries, so labels are
+ * intersected four by four hubs with SIMD instructions.
+ **/
+class HubLabels {
+  public:
+    SMILE_NON_COPYABLE(HubLabels);
+
+    HubLabels( const HubLabelsConfig& config = HubLabelsConfig() ) noexcept;
+    ~HubLabels() noexcept;
+
+    /**
+     * Builds the labels of a customized hierarchy
+     * @param in hierarchy The hierarchy. It can be discarded after the build.
+     **/
+    ErrorCode build( const ContractionHierarchy& hierarchy ) noexcept;
+
+    /**
+     * Computes the shortest path distance between two nodes
+     * @param in source The source node
+     * @param in target The target node
+     * @return The distance, or kInfiniteWeight if target is not reachable
+     **/
+    weight_t distance( const nodeId_t source, const nodeId_t target ) const noexcept;
+
+    /**
+     * Gets the number of nodes of the labels
+     **/
+    nodeId_t numNodes() const noexcept {
+      return static_cast<nodeId_t>(m_sizes[0].size());
+    }
+
+    /**
+     * Gets the total number of label entries of both directions
+     **/
+    uint64_t numEntries() const noexcept {
+      return m_numEntries;
+    }
+
+    /**
+     * Gets the memory used by the labels in bytes
+     **/
+    uint64_t memoryUsage() const noexcept {
+      return (m_capacities[0] + m_capacities[1]) * sizeof(uint32_t);
+    }
+
+  private:
+
+    /**
+     * Gets the hubs of the label of a node
+     **/
+    const uint32_t* hubs( const uint32_t direction, const nodeId_t node ) const noexcept {
+      return p_data[direction] + m_offsets[direction][node];
+    }
+
+    /**
+     * Gets the distances of the label of a node
+     **/
+    const uint32_t* distances( const uint32_t direction, const nodeId_t node ) const noexcept {
+      return hubs(direction, node) + paddedSize(m_sizes[direction][node]);
+    }
+
+    /**
+     * Rounds a label size up to a multiple of the SIMD block size
+     **/
+    static uint32_t paddedSize( const uint32_t size ) noexcept {
+      return (size + 3) & ~3u;
+    }
+
+    // The configuration of the labels
+    HubLabelsConfig         m_config;
+
+    // The labels of each direction (forward, backward)
+    uint32_t*               p_data[2] = {nullptr, nullptr};
+
+    // The capacity of the label buffers, in 32 bit words
+    uint64_t                m_capacities[2] = {0, 0};
+
+    // The offset in p_data of the label of each node
+    std::vector<uint64_t>   m_offsets[2];
+
+    // The number of entries of the label of each node
+    std::vector<uint32_t>   m_sizes[2];
+
+    // The total number of entries
+    uint64_t                m_numEntries = 0;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_HUB_LABELS_H_ */
@@ -0,0 +1,179 @@
+
+
+#include "label_pool.h"
+#include <limits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+SMILE_NS_BEGIN
+
+/**
+ * Cost used for the empty slots of a bag block. It never dominates a label.
+ **/
+static constexpr int32_t kDeadCost = std::numeric_limits<int32_t>::max();
+
+LabelPool::LabelPool( const nodeId_t numNodes ) noexcept :
+  m_heads(numNodes, kInvalidBlock) {
+}
+
+void LabelPool::reset() noexcept {
+  for( const nodeId_t node : m_touched ) {
+    m_heads[node] = kInvalidBlock;
+  }
+  m_touched.clear();
+  m_labels.clear();
+  m_blocks.clear();
+}
+
+uint32_t LabelPool::newBlock() noexcept {
+  BagBlock block;
+  for( uint32_t i = 0; i < kBagBlockSize; ++i ) {
+    block.m_first[i] = kDeadCost;
+    block.m_second[i] = kDeadCost;
+    block.m_labels[i] = kInvalidLabel;
+  }
+  block.m_next = kInvalidBlock;
+  m_blocks.push_back(block);
+  return static_cast<uint32_t>(m_blocks.size() - 1);
+}
+
+/**
+ * Computes a bit mask with the slots of a block that dominate (or are equal
+ * to) the given costs.
+ **/
+static inline uint32_t dominatingSlots( const int32_t* first,
+                                        const int32_t* second,
+                                        const int32_t a,
+                                        const int32_t b ) noexcept {
+#if defined(__SSE2__)
+  const __m128i va = _mm_set1_epi32(a);
+  const __m128i vb = _mm_set1_epi32(b);
+  uint32_t mask = 0;
+  for( uint32_t i = 0; i < kBagBlockSize; i += 4 ) {
+    const __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i));
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + i));
+    // A slot does not dominate if any of its costs is greater
+    const __m128i notDominating = _mm_or_si128(_mm_cmpgt_epi32(f, va), _mm_cmpgt_epi32(s, vb));
+    const uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(notDominating)));
+    mask |= (~bits & 0xF) << i;
+  }
+  return mask;
+#else
+  uint32_t mask = 0;
+  for( uint32_t i = 0; i < kBagBlockSize; ++i ) {
+    if( first[i] <= a && second[i] <= b ) {
+      mask |= 1 << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+/**
+ * Computes a bit mask with the slots of a block that are dominated by (or are
+ * equal to) the given costs.
+ **/
+static inline uint32_t dominatedSlots( const int32_t* first,
+                                       const int32_t* second,
+                                       const int32_t a,
+                                       const int32_t b ) noexcept {
+#if defined(__SSE2__)
+  const __m128i va = _mm_set1_epi32(a);
+  const __m128i vb = _mm_set1_epi32(b);
+  uint32_t mask = 0;
+  for( uint32_t i = 0; i < kBagBlockSize; i += 4 ) {
+    const __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i));
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + i));
+    const __m128i notDominated = _mm_or_si128(_mm_cmpgt_epi32(va, f), _mm_cmpgt_epi32(vb, s));
+    const uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(notDominated)));
+    mask |= (~bits & 0xF) << i;
+  }
+  return mask;
+#else
+  uint32_t mask = 0;
+  for( uint32_t i = 0; i < kBagBlockSize; ++i ) {
+    if( first[i] >= a && second[i] >= b ) {
+      mask |= 1 << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+bool LabelPool::isDominated( const nodeId_t node, const weight_t costs[kNumCriteria] ) const noexcept {
+  const int32_t a = static_cast<int32_t>(costs[0]);
+  const int32_t b = static_cast<int32_t>(costs[1]);
+  for( uint32_t block = m_heads[node]; block != kInvalidBlock; block = m_blocks[block].m_next ) {
+    if( dominatingSlots(m_blocks[block].m_first, m_blocks[block].m_second, a, b) != 0 ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+labelId_t LabelPool::insert( const nodeId_t node,
+                             const weight_t costs[kNumCriteria],
+                             const labelId_t parent ) noexcept {
+  if( isDominated(node, costs) ) {
+    return kInvalidLabel;
+  }
+
+  const int32_t a = static_cast<int32_t>(costs[0]);
+  const int32_t b = static_cast<int32_t>(costs[1]);
+
+  // Remove the labels dominated by the new one, looking for a free slot
+  uint32_t freeBlock = kInvalidBlock;
+  uint32_t freeSlot = 0;
+  uint32_t lastBlock = kInvalidBlock;
+  for( uint32_t block = m_heads[node]; block != kInvalidBlock; block = m_blocks[block].m_next ) {
+    BagBlock& current = m_blocks[block];
+    uint32_t mask = dominatedSlots(current.m_first, current.m_second, a, b);
+    while( mask != 0 ) {
+      const uint32_t slot = __builtin_ctz(mask);
+      mask &= mask - 1;
+      if( current.m_labels[slot] != kInvalidLabel ) {
+        m_labels[current.m_labels[slot]].m_dead = true;
+        current.m_labels[slot] = kInvalidLabel;
+        current.m_first[slot] = kDeadCost;
+        current.m_second[slot] = kDeadCost;
+      }
+      if( freeBlock == kInvalidBlock ) {
+        freeBlock = block;
+        freeSlot = slot;
+      }
+    }
+    lastBlock = block;
+  }
+
+  if( freeBlock == kInvalidBlock ) {
+    freeBlock = newBlock();
+    freeSlot = 0;
+    if( lastBlock == kInvalidBlock ) {
+      m_heads[node] = freeBlock;
+      m_touched.push_back(node);
+    } else {
+      m_blocks[lastBlock].m_next = freeBlock;
+    }
+  }
+
+  const labelId_t label = static_cast<labelId_t>(m_labels.size());
+  m_labels.push_back(ParetoLabel{{costs[0], costs[1]}, node, parent, false});
+  BagBlock& target = m_blocks[freeBlock];
+  target.m_first[freeSlot] = a;
+  target.m_second[freeSlot] = b;
+  target.m_labels[freeSlot] = label;
+  return label;
+}
+
+void LabelPool::bag( const nodeId_t node, std::vector<labelId_t>* labels ) const noexcept {
+  for( uint32_t block = m_heads[node]; block != kInvalidBlock; block = m_blocks[block].m_next ) {
+    for( uint32_t slot = 0; slot < kBagBlockSize; ++slot ) {
+      if( m_blocks[block].m_labels[slot] != kInvalidLabel ) {
+        labels->push_back(m_blocks[block].m_labels[slot]);
+      }
+    }
+  }
+}
+
+SMILE_NS_END
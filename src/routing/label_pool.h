@@ -0,0 +1,140 @@
+
+
+
+#ifndef _SMILE_ROUTING_LABEL_POOL_H_
+#define _SMILE_ROUTING_LABEL_POOL_H_
+
+#include "../base/platform.h"
+#include "types.h"
+#include <vector>
+
+SMILE_NS_BEGIN
+
+using labelId_t = uint32_t;
+
+constexpr labelId_t kInvalidLabel = 0xFFFFFFFF;
+
+/**
+ * The number of criteria of a multi-criteria label
+ **/
+constexpr uint32_t kNumCriteria = 2;
+
+/**
+ * The number of labels stored in each block of a bag
+ **/
+constexpr uint32_t kBagBlockSize = 8;
+
+struct ParetoLabel {
+  /**
+   * The cost of the label for each criterion
+   */
+  weight_t  m_costs[kNumCriteria];
+
+  /**
+   * The node the label belongs to
+   */
+  nodeId_t  m_node;
+
+  /**
+   * The label this label was created from, or kInvalidLabel
+   */
+  labelId_t m_parent;
+
+  /**
+   * Whether the label has been dominated after being inserted
+   */
+  bool      m_dead;
+};
+
+/**
+ * Arena holding the labels of a multi-criteria search and the Pareto bag of
+ * each node. Labels and bag blocks are stored in vectors that are cleared, but
+ * not freed, between queries, so a search does not allocate once the pool has
+ * grown to the size of its search space. Each bag is a linked list of
+ * fixed-size blocks storing the costs in struct of arrays layout, which allows
+ * checking dominance against several labels at once with SIMD instructions.
+ **/
+class LabelPool {
+  public:
+    SMILE_NON_COPYABLE(LabelPool);
+
+    LabelPool( const nodeId_t numNodes ) noexcept;
+    ~LabelPool() noexcept = default;
+
+    /**
+     * Removes all the labels and bags of the pool, keeping the memory
+     **/
+    void reset() noexcept;
+
+    /**
+     * Inserts a label into the bag of a node, unless it is dominated by (or
+     * equal to) a label of the bag. Labels of the bag dominated by the new
+     * label are marked as dead and removed from the bag.
+     * @param in node The node to insert the label to
+     * @param in costs The costs of the label
+     * @param in parent The label the new label comes from
+     * @return The identifier of the inserted label, or kInvalidLabel if it was
+     * dominated.
+     **/
+    labelId_t insert( const nodeId_t node,
+                      const weight_t costs[kNumCriteria],
+                      const labelId_t parent ) noexcept;
+
+    /**
+     * Tells if the given costs are dominated by (or equal to) a label in the bag
+     * of a node.
+     **/
+    bool isDominated( const nodeId_t node, const weight_t costs[kNumCriteria] ) const noexcept;
+
+    /**
+     * Gets a label
+     **/
+    const ParetoLabel& label( const labelId_t label ) const noexcept {
+      return m_labels[label];
+    }
+
+    /**
+     * Appends the alive labels in the bag of a node to the given vector
+     **/
+    void bag( const nodeId_t node, std::vector<labelId_t>* labels ) const noexcept;
+
+    /**
+     * Gets the number of labels created since the last reset
+     **/
+    uint64_t numLabels() const noexcept {
+      return m_labels.size();
+    }
+
+  private:
+
+    static constexpr uint32_t kInvalidBlock = 0xFFFFFFFF;
+
+    struct BagBlock {
+      int32_t   m_first[kBagBlockSize];
+      int32_t   m_second[kBagBlockSize];
+      labelId_t m_labels[kBagBlockSize];
+      uint32_t  m_next;
+    };
+
+    /**
+     * Appends an empty block to the pool
+     * @return The identifier of the new block
+     **/
+    uint32_t newBlock() noexcept;
+
+    // The labels created since the last reset
+    std::vector<ParetoLabel>  m_labels;
+
+    // The bag blocks created since the last reset
+    std::vector<BagBlock>     m_blocks;
+
+    // The first bag block of each node
+    std::vector<uint32_t>     m_heads;
+
+    // The nodes with a non empty bag
+    std::vector<nodeId_t>     m_touched;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_LABEL_POOL_H_ */
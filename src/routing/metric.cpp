@@ -0,0 +1,205 @@
+
+
+#include "metric.h"
+#include <fstream>
+
+SMILE_NS_BEGIN
+
+/**
+ * Identifies metric files
+ **/
+static constexpr uint64_t kMetricFileMagic = 0x43495254454d4c53; // "SLMETRIC"
+
+/**
+ * Checks that weights are at most kInfiniteWeight. Larger weights would wrap
+ * around when the searches add them with addWeights.
+ **/
+static bool validWeights( const weight_t* weights, const uint64_t count ) noexcept {
+  for( uint64_t i = 0; i < count; ++i ) {
+    if( weights[i] > kInfiniteWeight ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Metric::Metric( const std::string& name ) noexcept :
+  m_name(name) {
+}
+
+ErrorCode Metric::assign( const RoutingGraph& graph, std::vector<weight_t> weights ) noexcept {
+  if( weights.size() != graph.numEdges() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+  if( !validWeights(weights.data(), weights.size()) ) {
+    return ErrorCode::E_ROUTING_INVALID_WEIGHT;
+  }
+  m_weights = std::move(weights);
+  attach();
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode Metric::assign( const RoutingGraph& graph,
+                          const std::vector<weight_t>& weights,
+                          const std::vector<edgeId_t>& permutation ) noexcept {
+  if( weights.size() != graph.numEdges() || permutation.size() != graph.numEdges() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+  if( !validWeights(weights.data(), weights.size()) ) {
+    return ErrorCode::E_ROUTING_INVALID_WEIGHT;
+  }
+  // Each input edge must be mapped to exactly one edge slot
+  std::vector<bool> seen(weights.size(), false);
+  std::vector<weight_t> permuted(weights.size());
+  for( edgeId_t e = 0; e < graph.numEdges(); ++e ) {
+    const edgeId_t input = permutation[e];
+    if( input >= weights.size() || seen[input] ) {
+      return ErrorCode::E_ROUTING_INVALID_EDGE;
+    }
+    seen[input] = true;
+    permuted[e] = weights[input];
+  }
+  m_weights = std::move(permuted);
+  attach();
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode Metric::load( const RoutingGraph& graph, const std::string& path ) noexcept {
+  std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+  if( !file ) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  uint64_t header[2];
+  file.read(reinterpret_cast<char*>(header), sizeof(header));
+  if( !file || header[0] != kMetricFileMagic ) {
+    return ErrorCode::E_ROUTING_INVALID_METRIC_FILE;
+  }
+  if( header[1] != graph.numEdges() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+  std::vector<weight_t> weights(header[1]);
+  file.read(reinterpret_cast<char*>(weights.data()), weights.size()*sizeof(weight_t));
+  if( !file ) {
+    return ErrorCode::E_ROUTING_INVALID_METRIC_FILE;
+  }
+  if( !validWeights(weights.data(), weights.size()) ) {
+    return ErrorCode::E_ROUTING_INVALID_WEIGHT;
+  }
+  m_weights = std::move(weights);
+  attach();
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode Metric::store( const std::string& path ) const noexcept {
+  std::ofstream file(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if( !file ) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  const uint64_t header[2] = {kMetricFileMagic, m_size};
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(p_weights), m_size*sizeof(weight_t));
+  if( !file ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode Metric::store( SnapshotWriter* writer ) const noexcept {
+  return writer->addSection("metric." + m_name, p_weights, m_size);
+}
+
+ErrorCode Metric::open( const RoutingGraph& graph, const Snapshot& snapshot ) noexcept {
+  const weight_t* weights = nullptr;
+  uint64_t count = 0;
+  const ErrorCode error = snapshot.section("metric." + m_name, &weights, &count);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  if( count != graph.numEdges() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+  if( !validWeights(weights, count) ) {
+    return ErrorCode::E_ROUTING_INVALID_WEIGHT;
+  }
+  m_weights.clear();
+  p_weights = weights;
+  m_size = static_cast<edgeId_t>(count);
+  return ErrorCode::E_NO_ERROR;
+}
+
+void Metric::attach() noexcept {
+  p_weights = m_weights.data();
+  m_size = static_cast<edgeId_t>(m_weights.size());
+}
+
+MetricRegistry::MetricRegistry( const RoutingGraph* graph ) noexcept :
+  p_graph(graph) {
+}
+
+ErrorCode MetricRegistry::publish( std::unique_ptr<Metric> metric ) noexcept {
+  if( metric->size() != p_graph->numEdges() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+  std::lock_guard<std::mutex> writeLock(m_writeMutex);
+  install(std::shared_ptr<Metric>(std::move(metric)));
+  return ErrorCode::E_NO_ERROR;
+}
+
+void MetricRegistry::install( std::shared_ptr<Metric> metric ) noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  metric->m_version = ++m_lastVersion;
+  m_metrics[metric->name()] = std::move(metric);
+}
+
+ErrorCode MetricRegistry::update( const std::string& name,
+                                  const std::vector<std::pair<edgeId_t, weight_t>>& changes,
+                                  std::shared_ptr<const Metric>* published ) noexcept {
+  // The writer lock is held from the read of the current version to the
+  // publication of the new one, so concurrent updates are not lost
+  std::lock_guard<std::mutex> writeLock(m_writeMutex);
+  const std::shared_ptr<const Metric> current = get(name);
+  if( current == nullptr ) {
+    return ErrorCode::E_ROUTING_UNEXISTING_METRIC;
+  }
+  for( const auto& change : changes ) {
+    if( change.first >= current->size() ) {
+      return ErrorCode::E_ROUTING_INVALID_EDGE;
+    }
+    if( change.second > kInfiniteWeight ) {
+      return ErrorCode::E_ROUTING_INVALID_WEIGHT;
+    }
+  }
+
+  // Copy on write: the new version is built without blocking the readers
+  std::shared_ptr<Metric> next = std::make_shared<Metric>(name);
+  next->m_weights.assign(current->weights(), current->weights() + current->size());
+  for( const auto& change : changes ) {
+    next->m_weights[change.first] = change.second;
+  }
+  next->attach();
+  install(next);
+  if( published != nullptr ) {
+    *published = next;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode MetricRegistry::remove( const std::string& name ) noexcept {
+  std::lock_guard<std::mutex> writeLock(m_writeMutex);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if( m_metrics.erase(name) == 0 ) {
+    return ErrorCode::E_ROUTING_UNEXISTING_METRIC;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+std::shared_ptr<const Metric> MetricRegistry::get( const std::string& name ) const noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const auto it = m_metrics.find(name);
+  if( it == m_metrics.end() ) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+SMILE_NS_END
@@ -0,0 +1,239 @@
+
+
+
+#ifndef _SMILE_ROUTING_METRIC_H_
+#define _SMILE_ROUTING_METRIC_H_
+
+#include "../base/base.h"
+#include "graph.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * A named set of edge weights (car, truck, rush hour...). Weights are stored
+ * in a dense array aligned with the edge slots of a RoutingGraph, separated
+ * from the topology, so several metrics share one copy of the graph and
+ * switching metric does not touch the adjacency data. Weights are at most
+ * kInfiniteWeight, so that the searches add them without overflowing; an
+ * edge of weight kInfiniteWeight is never used.
+ **/
+class Metric {
+  public:
+    SMILE_NON_COPYABLE(Metric);
+
+    Metric( const std::string& name ) noexcept;
+    ~Metric() noexcept = default;
+
+    /**
+     * Sets the weights of the metric
+     * @param in graph The graph the weights belong to
+     * @param in weights The weight of each edge slot of the graph
+     * @return E_ROUTING_METRIC_SIZE_MISSMATCH if the number of weights does
+     * not match the number of edges of the graph and E_ROUTING_INVALID_WEIGHT
+     * if a weight is larger than kInfiniteWeight
+     **/
+    ErrorCode assign( const RoutingGraph& graph, std::vector<weight_t> weights ) noexcept;
+
+    /**
+     * Sets the weights of the metric from weights given in the order of the
+     * edges the graph was built from
+     * @param in graph The graph the weights belong to
+     * @param in weights The weight of each input edge
+     * @param in permutation The permutation returned by RoutingGraph::build
+     * @return E_ROUTING_METRIC_SIZE_MISSMATCH if the number of weights does
+     * not match the number of edges of the graph, E_ROUTING_INVALID_WEIGHT
+     * if a weight is larger than kInfiniteWeight and E_ROUTING_INVALID_EDGE
+     * if the permutation has an out of range or a repeated input edge
+     **/
+    ErrorCode assign( const RoutingGraph& graph,
+                      const std::vector<weight_t>& weights,
+                      const std::vector<edgeId_t>& permutation ) noexcept;
+
+    /**
+     * Loads the weights of the metric from a file written with store
+     * @param in graph The graph the weights belong to
+     * @param in path The path of the file
+     * @return E_STORAGE_INVALID_PATH if the file cannot be opened,
+     * E_ROUTING_INVALID_METRIC_FILE if it is not a metric file,
+     * E_ROUTING_METRIC_SIZE_MISSMATCH if it does not match the graph and
+     * E_ROUTING_INVALID_WEIGHT if a weight is larger than kInfiniteWeight
+     **/
+    ErrorCode load( const RoutingGraph& graph, const std::string& path ) noexcept;
+
+    /**
+     * Stores the weights of the metric into a file
+     * @param in path The path of the file
+     **/
+    ErrorCode store( const std::string& path ) const noexcept;
+
+    /**
+     * Writes the weights of the metric into a snapshot, in a section named
+     * after the metric
+     * @param in writer The snapshot being written
+     **/
+    ErrorCode store( SnapshotWriter* writer ) const noexcept;
+
+    /**
+     * Opens the weights of the metric from a snapshot, without copying them.
+     * The snapshot must outlive the metric.
+     * @param in graph The graph the weights belong to
+     * @param in snapshot The snapshot
+     * @return E_STORAGE_UNEXISTING_SECTION if the metric is not in the
+     * snapshot, E_ROUTING_METRIC_SIZE_MISSMATCH if it does not match the
+     * graph and E_ROUTING_INVALID_WEIGHT if a weight is larger than
+     * kInfiniteWeight
+     **/
+    ErrorCode open( const RoutingGraph& graph, const Snapshot& snapshot ) noexcept;
+
+    /**
+     * Gets the name of the metric
+     **/
+    const std::string& name() const noexcept {
+      return m_name;
+    }
+
+    /**
+     * Gets the version of the metric. It is set when the metric is published
+     * into a MetricRegistry, and increases with every publication.
+     **/
+    uint64_t version() const noexcept {
+      return m_version;
+    }
+
+    /**
+     * Gets the number of weights of the metric
+     **/
+    edgeId_t size() const noexcept {
+      return m_size;
+    }
+
+    /**
+     * Gets the weight of an edge slot
+     **/
+    weight_t weight( const edgeId_t edge ) const noexcept {
+      return p_weights[edge];
+    }
+
+    /**
+     * Gets the weights array, aligned with the edge slots of the graph
+     **/
+    const weight_t* weights() const noexcept {
+      return p_weights;
+    }
+
+  private:
+    friend class MetricRegistry;
+
+    // The name of the metric
+    std::string           m_name;
+
+    // The version of the metric
+    uint64_t              m_version = 0;
+
+    /**
+     * Points the weights to the vector owned by the metric
+     **/
+    void attach() noexcept;
+
+    // The weight of each edge slot
+    const weight_t*       p_weights = nullptr;
+
+    // The number of weights
+    edgeId_t              m_size = 0;
+
+    // The storage of the weights, unless they are in a snapshot
+    std::vector<weight_t> m_weights;
+};
+
+/**
+ * Set of metrics over the same graph. Metrics are published as immutable
+ * snapshots: a query takes a snapshot of the metric it needs and keeps using
+ * it even if a new version is published in the meantime, so metrics can be
+ * loaded and replaced while queries run. Snapshots are released when the last
+ * query using them finishes.
+ **/
+class MetricRegistry {
+  public:
+    SMILE_NON_COPYABLE(MetricRegistry);
+
+    MetricRegistry( const RoutingGraph* graph ) noexcept;
+    ~MetricRegistry() noexcept = default;
+
+    /**
+     * Publishes a metric, replacing the metric with the same name if any
+     * @param in metric The metric to publish. The registry takes ownership of
+     * it and sets its version; it is then read through get.
+     * @return E_ROUTING_METRIC_SIZE_MISSMATCH if the metric does not match the
+     * graph of the registry
+     **/
+    ErrorCode publish( std::unique_ptr<Metric> metric ) noexcept;
+
+    /**
+     * Publishes a new version of a metric with some of its weights changed.
+     * The previous version is copied, so queries using it are not affected.
+     * Concurrent updates of a metric are applied one after the other.
+     * @param in name The name of the metric
+     * @param in changes The edge slots to change and their new weight
+     * @param out published If not null, the new version of the metric
+     * @return E_ROUTING_UNEXISTING_METRIC if there is no metric with that name,
+     * E_ROUTING_INVALID_EDGE if an edge is out of bounds and
+     * E_ROUTING_INVALID_WEIGHT if a weight is larger than kInfiniteWeight
+     **/
+    ErrorCode update( const std::string& name,
+                      const std::vector<std::pair<edgeId_t, weight_t>>& changes,
+                      std::shared_ptr<const Metric>* published = nullptr ) noexcept;
+
+    /**
+     * Removes a metric from the registry
+     * @return E_ROUTING_UNEXISTING_METRIC if there is no metric with that name
+     **/
+    ErrorCode remove( const std::string& name ) noexcept;
+
+    /**
+     * Gets a snapshot of the current version of a metric
+     * @return The metric, or a null pointer if there is no metric with that
+     * name
+     **/
+    std::shared_ptr<const Metric> get( const std::string& name ) const noexcept;
+
+    /**
+     * Gets the graph of the registry
+     **/
+    const RoutingGraph* graph() const noexcept {
+      return p_graph;
+    }
+
+  private:
+
+    /**
+     * Replaces the current version of a metric. The writer lock must be held,
+     * and the metric must not be reachable from outside the registry yet.
+     **/
+    void install( std::shared_ptr<Metric> metric ) noexcept;
+
+    // The graph shared by all the metrics
+    const RoutingGraph*                                   p_graph;
+
+    // The current version of each metric
+    std::map<std::string, std::shared_ptr<const Metric>>  m_metrics;
+
+    // The last assigned version
+    uint64_t                                              m_lastVersion = 0;
+
+    // Protects the metrics map
+    mutable std::mutex                                    m_mutex;
+
+    // Serializes the writers, so an update is not based on a version that
+    // another writer is replacing. Readers only take m_mutex.
+    std::mutex                                            m_writeMutex;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_METRIC_H_ */
@@ -0,0 +1,132 @@
+
+
+#include "pareto_search.h"
+#include <algorithm>
+#include <functional>
+
+SMILE_NS_BEGIN
+
+ParetoSearch::ParetoSearch( const RoutingGraph* graph, const ParetoSearchConfig& config ) noexcept :
+  p_graph(graph),
+  m_config(config),
+  m_pool(graph->numNodes()),
+  m_bounds{{graph}, {graph}} {
+}
+
+void ParetoSearch::setStats( QueryStats* stats ) noexcept {
+  // The bound searches are not given the stats: their time is accounted as a
+  // whole under E_BOUNDS, and their counters would mix with the labels of the
+  // search itself
+  p_stats = stats;
+}
+
+void ParetoSearch::push( const labelId_t label ) noexcept {
+  const ParetoLabel& l = m_pool.label(label);
+  const uint64_t key = (static_cast<uint64_t>(l.m_costs[0]) << 32) | l.m_costs[1];
+  m_queue.push_back(QueueEntry(key, label));
+  std::push_heap(m_queue.begin(), m_queue.end(), std::greater<QueueEntry>());
+  SMILE_PROFILE_COUNT(p_stats, m_heapPushes);
+}
+
+ErrorCode ParetoSearch::run( const nodeId_t source,
+                             const nodeId_t target,
+                             const Metric* const metrics[kNumCriteria] ) noexcept {
+  const nodeId_t numNodes = p_graph->numNodes();
+  if( source >= numNodes || target >= numNodes ) {
+    return ErrorCode::E_ROUTING_INVALID_NODE;
+  }
+
+  const weight_t* weights[kNumCriteria];
+  for( uint32_t c = 0; c < kNumCriteria; ++c ) {
+    if( metrics[c]->size() != p_graph->numEdges() ) {
+      return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+    }
+    weights[c] = metrics[c]->weights();
+  }
+
+  m_pool.reset();
+  m_queue.clear();
+  m_solutions.clear();
+
+  if( m_config.m_useBounds ) {
+    ScopedPhaseTimer timer(p_stats, QueryPhase::E_BOUNDS);
+    for( uint32_t c = 0; c < kNumCriteria; ++c ) {
+      m_bounds[c].run(target, *metrics[c], SearchDirection::E_BACKWARD);
+    }
+    if( m_bounds[0].distance(source) == kInfiniteWeight ) {
+      return ErrorCode::E_NO_ERROR;
+    }
+  }
+
+  ScopedPhaseTimer timer(p_stats, QueryPhase::E_SEARCH);
+  const weight_t zero[kNumCriteria] = {0, 0};
+  push(m_pool.insert(source, zero, kInvalidLabel));
+
+  while( !m_queue.empty() ) {
+    std::pop_heap(m_queue.begin(), m_queue.end(), std::greater<QueueEntry>());
+    const labelId_t current = m_queue.back().second;
+    m_queue.pop_back();
+    SMILE_PROFILE_COUNT(p_stats, m_heapPops);
+
+    const ParetoLabel label = m_pool.label(current);
+    if( label.m_dead || label.m_node == target ) {
+      continue;
+    }
+    SMILE_PROFILE_COUNT(p_stats, m_nodesSettled);
+
+    for( edgeId_t e = p_graph->firstOut(label.m_node); e < p_graph->endOut(label.m_node); ++e ) {
+      const nodeId_t head = p_graph->head(e);
+      SMILE_PROFILE_COUNT(p_stats, m_edgesRelaxed);
+      weight_t costs[kNumCriteria];
+      bool reachable = true;
+      for( uint32_t c = 0; c < kNumCriteria; ++c ) {
+        costs[c] = addWeights(label.m_costs[c], weights[c][e]);
+        reachable &= costs[c] < kInfiniteWeight;
+      }
+      if( !reachable ) {
+        continue;
+      }
+
+      // Target pruning: discard the label if, even following the best
+      // possible path for each criterion, it is dominated at the target.
+      if( m_config.m_useBounds ) {
+        weight_t bounded[kNumCriteria];
+        for( uint32_t c = 0; c < kNumCriteria; ++c ) {
+          bounded[c] = addWeights(costs[c], m_bounds[c].distance(head));
+        }
+        if( bounded[0] == kInfiniteWeight || m_pool.isDominated(target, bounded) ) {
+          continue;
+        }
+      } else if( head != target && m_pool.isDominated(target, costs) ) {
+        continue;
+      }
+
+      const labelId_t inserted = m_pool.insert(head, costs, current);
+      if( inserted != kInvalidLabel ) {
+        push(inserted);
+      }
+    }
+  }
+
+  m_targetLabels.clear();
+  m_pool.bag(target, &m_targetLabels);
+  for( const labelId_t label : m_targetLabels ) {
+    const ParetoLabel& l = m_pool.label(label);
+    m_solutions.push_back(ParetoSolution{{l.m_costs[0], l.m_costs[1]}, label});
+  }
+  std::sort(m_solutions.begin(), m_solutions.end(),
+            []( const ParetoSolution& a, const ParetoSolution& b ) {
+              return a.m_costs[0] < b.m_costs[0];
+            });
+  return ErrorCode::E_NO_ERROR;
+}
+
+void ParetoSearch::path( const uint32_t solution, std::vector<nodeId_t>* nodes ) const noexcept {
+  nodes->clear();
+  for( labelId_t label = m_solutions[solution].m_label; label != kInvalidLabel; label = m_pool.label(label).m_parent ) {
+    nodes->push_back(m_pool.label(label).m_node);
+  }
+  std::reverse(nodes->begin(), nodes->end());
+}
+
+SMILE_NS_END
@@ -0,0 +1,131 @@
+
+
+
+#ifndef _SMILE_ROUTING_PARETO_SEARCH_H_
+#define _SMILE_ROUTING_PARETO_SEARCH_H_
+
+#include "../base/base.h"
+#include "../base/profiling.h"
+#include "dijkstra.h"
+#include "graph.h"
+#include "label_pool.h"
+#include <vector>
+#include <utility>
+
+SMILE_NS_BEGIN
+
+struct ParetoSearchConfig {
+  /**
+   * Whether to compute per criterion lower bounds to the target (with one
+   * backward Dijkstra per criterion) and use them to prune labels that cannot
+   * lead to a Pareto optimal solution.
+   */
+  bool      m_useBounds = true;
+};
+
+struct ParetoSolution {
+  /**
+   * The cost of the solution for each criterion
+   */
+  weight_t  m_costs[kNumCriteria];
+
+  /**
+   * The label of the solution at the target node
+   */
+  labelId_t m_label;
+};
+
+/**
+ * Bi-criteria label-setting (multi-criteria Dijkstra) point to point search.
+ * Labels are settled in lexicographic order of their costs, so a label is
+ * Pareto optimal once it is extracted from the queue. Labels are kept in a
+ * LabelPool that is reused across queries. Besides the dominance at each node,
+ * labels are pruned when they (plus a lower bound of the remaining costs) are
+ * dominated by a label already found at the target.
+ **/
+class ParetoSearch {
+  public:
+    SMILE_NON_COPYABLE(ParetoSearch);
+
+    ParetoSearch( const RoutingGraph* graph, const ParetoSearchConfig& config = ParetoSearchConfig() ) noexcept;
+    ~ParetoSearch() noexcept = default;
+
+    /**
+     * Computes the Pareto set of paths between source and target
+     * @param in source The source node
+     * @param in target The target node
+     * @param in metrics The metric of each criterion
+     * @return E_ROUTING_INVALID_NODE if source or target are out of bounds,
+     * E_ROUTING_METRIC_SIZE_MISSMATCH if a metric does not match the graph
+     **/
+    ErrorCode run( const nodeId_t source,
+                   const nodeId_t target,
+                   const Metric* const metrics[kNumCriteria] ) noexcept;
+
+    /**
+     * Sets the object where the counters of the following searches are
+     * accumulated, or nullptr to stop profiling. The counters only cover the
+     * labels of the search; the bound searches are only timed, under
+     * E_BOUNDS.
+     **/
+    void setStats( QueryStats* stats ) noexcept;
+
+    /**
+     * Gets the Pareto optimal solutions found by the last search, sorted by
+     * increasing cost of the first criterion.
+     **/
+    const std::vector<ParetoSolution>& solutions() const noexcept {
+      return m_solutions;
+    }
+
+    /**
+     * Gets the nodes of the path of a solution, from source to target
+     * @param in solution The index of the solution
+     * @param out nodes The nodes of the path
+     **/
+    void path( const uint32_t solution, std::vector<nodeId_t>* nodes ) const noexcept;
+
+    /**
+     * Gets the number of labels created by the last search
+     **/
+    uint64_t numLabels() const noexcept {
+      return m_pool.numLabels();
+    }
+
+  private:
+
+    using QueueEntry = std::pair<uint64_t, labelId_t>;
+
+    /**
+     * Pushes a label into the queue, keyed by its costs in lexicographic order
+     **/
+    void push( const labelId_t label ) noexcept;
+
+    // The graph to search in
+    const RoutingGraph*         p_graph;
+
+    // The configuration of the search
+    ParetoSearchConfig          m_config;
+
+    // The labels and bags of the search
+    LabelPool                   m_pool;
+
+    // The label queue (a binary heap)
+    std::vector<QueueEntry>     m_queue;
+
+    // The searches used to compute the lower bounds of each criterion
+    Dijkstra                    m_bounds[kNumCriteria];
+
+    // The solutions of the last search
+    std::vector<ParetoSolution> m_solutions;
+
+    // Scratch vector used to collect the labels at the target
+    std::vector<labelId_t>      m_targetLabels;
+
+    // Where to accumulate the counters of the searches, or nullptr
+    QueryStats*                 p_stats = nullptr;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_PARETO_SEARCH_H_ */
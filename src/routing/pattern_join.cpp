@@ -0,0 +1,383 @@
+
+
+
+#include "pattern_join.h"
+#include "../base/parallel.h"
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+SMILE_NS_BEGIN
+
+/**
+ * Sets whose size ratio is above this are intersected by galloping
+ **/
+static constexpr uint32_t kGallopRatio = 32;
+
+/**
+ * Sorts the neighbors of each node of one direction of a graph, removes their
+ * duplicates and self loops, and packs them
+ **/
+template<typename First, typename Neighbor>
+static uint32_t sortNeighbors( const nodeId_t numNodes,
+                               const uint32_t numThreads,
+                               First first,
+                               Neighbor neighbor,
+                               std::vector<edgeId_t>* offsets,
+                               std::vector<nodeId_t>* sets ) noexcept {
+  sets->resize(first(numNodes));
+  std::vector<uint32_t> sizes(numNodes);
+  parallelFor(0, numNodes, numThreads, 256, [&]( const uint64_t index, const uint32_t ) {
+    const nodeId_t node = static_cast<nodeId_t>(index);
+    nodeId_t* set = sets->data() + first(node);
+    nodeId_t* end = set;
+    for( edgeId_t slot = first(node); slot < first(node+1); ++slot ) {
+      *end++ = neighbor(slot);
+    }
+    std::sort(set, end);
+    end = std::unique(set, end);
+    end = std::remove(set, end, node);
+    sizes[node] = static_cast<uint32_t>(end - set);
+  });
+
+  // Sets only move to lower positions, so they are packed in node order
+  uint32_t maxSize = 0;
+  offsets->assign(numNodes+1, 0);
+  for( nodeId_t node = 0; node < numNodes; ++node ) {
+    const nodeId_t* set = sets->data() + first(node);
+    std::copy(set, set + sizes[node], sets->data() + (*offsets)[node]);
+    (*offsets)[node+1] = (*offsets)[node] + sizes[node];
+    maxSize = std::max(maxSize, sizes[node]);
+  }
+  sets->resize((*offsets)[numNodes]);
+  sets->shrink_to_fit();
+  return maxSize;
+}
+
+void SortedAdjacency::build( const RoutingGraph& graph, const uint32_t numThreads ) noexcept {
+  m_numNodes = graph.numNodes();
+  if( m_numNodes == 0 ) {
+    m_maxDegree = 0;
+    m_outOffsets.assign(1, 0);
+    m_inOffsets.assign(1, 0);
+    m_out.clear();
+    m_in.clear();
+    return;
+  }
+  const uint32_t maxOut = sortNeighbors(m_numNodes, numThreads,
+                                        [&]( const nodeId_t node ) {
+                                          return node < m_numNodes ? graph.firstOut(node) : graph.endOut(node-1);
+                                        },
+                                        [&]( const edgeId_t slot ) { return graph.head(slot); },
+                                        &m_outOffsets, &m_out);
+  const uint32_t maxIn = sortNeighbors(m_numNodes, numThreads,
+                                       [&]( const nodeId_t node ) {
+                                         return node < m_numNodes ? graph.firstIn(node) : graph.endIn(node-1);
+                                       },
+                                       [&]( const edgeId_t slot ) { return graph.tail(slot); },
+                                       &m_inOffsets, &m_in);
+  m_maxDegree = std::max(maxOut, maxIn);
+}
+
+/**
+ * Intersects a small set with a large one, searching the elements of the
+ * small set by galloping from the position of the previous one
+ **/
+static uint32_t gallop( const nodeId_t* small,
+                        const uint32_t smallSize,
+                        const nodeId_t* large,
+                        const uint32_t largeSize,
+                        nodeId_t* out ) noexcept {
+  uint32_t count = 0;
+  uint32_t position = 0;
+  for( uint32_t i = 0; i < smallSize && position < largeSize; ++i ) {
+    const nodeId_t value = small[i];
+    uint32_t low = position;
+    uint32_t high = position;
+    uint32_t step = 1;
+    while( high < largeSize && large[high] < value ) {
+      low = high + 1;
+      high += step;
+      step *= 2;
+    }
+    position = static_cast<uint32_t>(std::lower_bound(large + low, large + std::min(high, largeSize), value) - large);
+    if( position < largeSize && large[position] == value ) {
+      out[count++] = value;
+      ++position;
+    }
+  }
+  return count;
+}
+
+uint32_t intersectSorted( const nodeId_t* a,
+                          const uint32_t sizeA,
+                          const nodeId_t* b,
+                          const uint32_t sizeB,
+                          nodeId_t* out ) noexcept {
+  if( sizeA == 0 || sizeB == 0 ) {
+    return 0;
+  }
+  if( static_cast<uint64_t>(sizeA) * kGallopRatio < sizeB ) {
+    return gallop(a, sizeA, b, sizeB, out);
+  }
+  if( static_cast<uint64_t>(sizeB) * kGallopRatio < sizeA ) {
+    return gallop(b, sizeB, a, sizeA, out);
+  }
+
+  uint32_t count = 0;
+  uint32_t i = 0;
+  uint32_t j = 0;
+#if defined(__SSE2__)
+  // Blocks of four elements are compared all against all by rotating one of
+  // them. The block with the smallest last element is consumed. An element
+  // matches at most once, since the sets have no duplicates.
+  while( i + 4 <= sizeA && j + 4 <= sizeB ) {
+    const __m128i blockA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i blockB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+    __m128i match = _mm_cmpeq_epi32(blockA, blockB);
+    for( uint32_t rotation = 1; rotation < 4; ++rotation ) {
+      blockB = _mm_shuffle_epi32(blockB, _MM_SHUFFLE(0,3,2,1));
+      match = _mm_or_si128(match, _mm_cmpeq_epi32(blockA, blockB));
+    }
+    const nodeId_t lastA = a[i+3];
+    const nodeId_t lastB = b[j+3];
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(match)));
+    if( mask != 0 ) {
+      alignas(16) nodeId_t lanes[4];
+      _mm_store_si128(reinterpret_cast<__m128i*>(lanes), blockA);
+      // Only matching lanes are stored, out may be exactly as large as the
+      // intersection
+      for( uint32_t lane = 0; lane < 4; ++lane, mask >>= 1 ) {
+        if( mask & 1 ) {
+          out[count++] = lanes[lane];
+        }
+      }
+    }
+    i += lastA <= lastB ? 4 : 0;
+    j += lastB <= lastA ? 4 : 0;
+  }
+#endif
+  while( i < sizeA && j < sizeB ) {
+    if( a[i] < b[j] ) {
+      ++i;
+    } else if( b[j] < a[i] ) {
+      ++j;
+    } else {
+      out[count++] = a[i];
+      ++i;
+      ++j;
+    }
+  }
+  return count;
+}
+
+namespace {
+
+/**
+ * Neighbor set of a previous variable a variable is restricted to
+ **/
+struct JoinStep {
+  uint32_t  m_variable;
+  bool      m_outgoing;
+};
+
+/**
+ * Constraints of a variable on the variables bound before it
+ **/
+struct JoinLevel {
+  std::vector<JoinStep> m_steps;
+  std::vector<uint32_t> m_greaterThan;
+  std::vector<uint32_t> m_smallerThan;
+};
+
+/**
+ * State of a join thread: the current binding and the candidates of each
+ * variable. Sets are intersected alternating between two buffers.
+ **/
+struct JoinState {
+  std::vector<nodeId_t>                                         m_binding;
+  std::vector<std::vector<nodeId_t>>                            m_candidates[2];
+  std::vector<std::pair<const nodeId_t*, const nodeId_t*>>      m_sets;
+  uint64_t                                                      m_count = 0;
+};
+
+class PatternJoin {
+  public:
+    PatternJoin( const SortedAdjacency& adjacency,
+                 const Pattern& pattern,
+                 const std::vector<JoinLevel>& levels,
+                 const PatternMatchFunction& f ) noexcept :
+      m_adjacency(adjacency),
+      m_pattern(pattern),
+      m_levels(levels),
+      m_f(f) {
+    }
+
+    /**
+     * Binds a variable to each of its candidates and extends the bindings
+     * to the next variables
+     **/
+    void extend( JoinState& state, const uint32_t thread, const uint32_t level ) const noexcept {
+      const JoinLevel& constraints = m_levels[level];
+      nodeId_t lower = 0;
+      nodeId_t upper = m_adjacency.numNodes();
+      for( const uint32_t variable : constraints.m_greaterThan ) {
+        lower = std::max<nodeId_t>(lower, state.m_binding[variable] + 1);
+      }
+      for( const uint32_t variable : constraints.m_smallerThan ) {
+        upper = std::min(upper, state.m_binding[variable]);
+      }
+      if( lower >= upper ) {
+        return;
+      }
+
+      // The neighbor sets are trimmed to the bounds, and intersected from the
+      // smallest one
+      std::vector<std::pair<const nodeId_t*, const nodeId_t*>>& sets = state.m_sets;
+      sets.clear();
+      for( const JoinStep& step : constraints.m_steps ) {
+        const nodeId_t node = state.m_binding[step.m_variable];
+        const nodeId_t* begin = step.m_outgoing ? m_adjacency.outBegin(node) : m_adjacency.inBegin(node);
+        const nodeId_t* end = step.m_outgoing ? m_adjacency.outEnd(node) : m_adjacency.inEnd(node);
+        begin = std::lower_bound(begin, end, lower);
+        end = std::lower_bound(begin, end, upper);
+        if( begin == end ) {
+          return;
+        }
+        sets.emplace_back(begin, end);
+      }
+      std::sort(sets.begin(), sets.end(), []( const std::pair<const nodeId_t*, const nodeId_t*>& a,
+                                             const std::pair<const nodeId_t*, const nodeId_t*>& b ) {
+        return a.second - a.first < b.second - b.first;
+      });
+      const nodeId_t* candidates = sets[0].first;
+      uint32_t numCandidates = static_cast<uint32_t>(sets[0].second - sets[0].first);
+      for( uint32_t i = 1; i < sets.size() && numCandidates > 0; ++i ) {
+        nodeId_t* buffer = state.m_candidates[i % 2][level].data();
+        numCandidates = intersectSorted(candidates, numCandidates, sets[i].first,
+                                        static_cast<uint32_t>(sets[i].second - sets[i].first), buffer);
+        candidates = buffer;
+      }
+
+      const bool last = level + 1 == m_pattern.m_numVariables;
+      if( last && !m_f ) {
+        // Counting the matches of the last variable does not need to
+        // enumerate them: candidates bound to previous variables are removed
+        uint64_t count = numCandidates;
+        if( m_pattern.m_injective ) {
+          for( uint32_t variable = 0; variable < level; ++variable ) {
+            count -= std::binary_search(candidates, candidates + numCandidates, state.m_binding[variable]) ? 1 : 0;
+          }
+        }
+        state.m_count += count;
+        return;
+      }
+      for( uint32_t i = 0; i < numCandidates; ++i ) {
+        if( bind(state, thread, level, candidates[i]) && !last ) {
+          extend(state, thread, level + 1);
+        }
+      }
+    }
+
+    /**
+     * Binds a variable to a node, reporting the match if it is the last
+     * variable
+     * @return Whether the node can be bound to the variable
+     **/
+    bool bind( JoinState& state, const uint32_t thread, const uint32_t level, const nodeId_t node ) const noexcept {
+      if( m_pattern.m_injective ) {
+        for( uint32_t variable = 0; variable < level; ++variable ) {
+          if( state.m_binding[variable] == node ) {
+            return false;
+          }
+        }
+      }
+      state.m_binding[level] = node;
+      if( level + 1 == m_pattern.m_numVariables ) {
+        ++state.m_count;
+        if( m_f ) {
+          m_f(thread, state.m_binding.data());
+        }
+      }
+      return true;
+    }
+
+  private:
+    const SortedAdjacency&        m_adjacency;
+    const Pattern&                m_pattern;
+    const std::vector<JoinLevel>& m_levels;
+    const PatternMatchFunction&   m_f;
+};
+
+}
+
+ErrorCode matchPattern( const SortedAdjacency& adjacency,
+                        const Pattern& pattern,
+                        const PatternJoinConfig& config,
+                        const PatternMatchFunction& f,
+                        uint64_t* numMatches ) noexcept {
+  *numMatches = 0;
+  const uint32_t numVariables = pattern.m_numVariables;
+  auto valid = [&]( const PatternEdge& edge ) {
+    return edge.m_from < numVariables && edge.m_to < numVariables && edge.m_from != edge.m_to;
+  };
+
+  // Each relation of the pattern restricts the later of its variables
+  std::vector<JoinLevel> levels(numVariables);
+  for( const PatternEdge& edge : pattern.m_edges ) {
+    if( !valid(edge) ) {
+      return ErrorCode::E_ROUTING_INVALID_PATTERN;
+    }
+    if( edge.m_from < edge.m_to ) {
+      levels[edge.m_to].m_steps.push_back(JoinStep{edge.m_from, true});
+    } else {
+      levels[edge.m_from].m_steps.push_back(JoinStep{edge.m_to, false});
+    }
+  }
+  for( const PatternEdge& constraint : pattern.m_smaller ) {
+    if( !valid(constraint) ) {
+      return ErrorCode::E_ROUTING_INVALID_PATTERN;
+    }
+    if( constraint.m_from < constraint.m_to ) {
+      levels[constraint.m_to].m_greaterThan.push_back(constraint.m_from);
+    } else {
+      levels[constraint.m_from].m_smallerThan.push_back(constraint.m_to);
+    }
+  }
+  for( uint32_t level = 1; level < numVariables; ++level ) {
+    if( levels[level].m_steps.empty() ) {
+      return ErrorCode::E_ROUTING_INVALID_PATTERN;
+    }
+  }
+  if( numVariables == 0 ) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  const uint32_t numThreads = std::max<uint32_t>(config.m_numThreads, 1);
+  std::vector<JoinState> states(numThreads);
+  for( JoinState& state : states ) {
+    state.m_binding.resize(numVariables);
+    for( std::vector<std::vector<nodeId_t>>& candidates : state.m_candidates ) {
+      candidates.resize(numVariables);
+      for( uint32_t level = 1; level < numVariables; ++level ) {
+        if( levels[level].m_steps.size() > 1 ) {
+          candidates[level].resize(adjacency.maxDegree());
+        }
+      }
+    }
+  }
+  const PatternJoin join(adjacency, pattern, levels, f);
+  parallelFor(0, adjacency.numNodes(), numThreads, 64, [&]( const uint64_t node, const uint32_t thread ) {
+    JoinState& state = states[thread];
+    if( join.bind(state, thread, 0, static_cast<nodeId_t>(node)) && numVariables > 1 ) {
+      join.extend(state, thread, 1);
+    }
+  });
+  for( const JoinState& state : states ) {
+    *numMatches += state.m_count;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+SMILE_NS_END
@@ -0,0 +1,171 @@
+
+
+
+#ifndef _SMILE_ROUTING_PATTERN_JOIN_H_
+#define _SMILE_ROUTING_PATTERN_JOIN_H_
+
+#include "../base/base.h"
+#include "graph.h"
+#include "types.h"
+#include <functional>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Outgoing and incoming neighbors of each node of a graph as sorted sets:
+ * parallel edges and self loops are removed. These are the tries the pattern
+ * join intersects.
+ **/
+class SortedAdjacency {
+  public:
+    SMILE_NON_COPYABLE(SortedAdjacency);
+
+    SortedAdjacency() noexcept = default;
+    ~SortedAdjacency() noexcept = default;
+
+    /**
+     * Builds the sorted neighbor sets of a graph
+     * @param in graph The graph
+     * @param in numThreads The number of threads sorting the sets
+     **/
+    void build( const RoutingGraph& graph, const uint32_t numThreads = 1 ) noexcept;
+
+    /**
+     * Gets the number of nodes of the graph
+     **/
+    nodeId_t numNodes() const noexcept {
+      return m_numNodes;
+    }
+
+    /**
+     * Gets the largest number of outgoing or incoming neighbors of a node
+     **/
+    uint32_t maxDegree() const noexcept {
+      return m_maxDegree;
+    }
+
+    /**
+     * Gets the first of the sorted heads of the outgoing edges of a node
+     **/
+    const nodeId_t* outBegin( const nodeId_t node ) const noexcept {
+      return m_out.data() + m_outOffsets[node];
+    }
+
+    /**
+     * Gets the end of the sorted heads of the outgoing edges of a node
+     **/
+    const nodeId_t* outEnd( const nodeId_t node ) const noexcept {
+      return m_out.data() + m_outOffsets[node+1];
+    }
+
+    /**
+     * Gets the first of the sorted tails of the incoming edges of a node
+     **/
+    const nodeId_t* inBegin( const nodeId_t node ) const noexcept {
+      return m_in.data() + m_inOffsets[node];
+    }
+
+    /**
+     * Gets the end of the sorted tails of the incoming edges of a node
+     **/
+    const nodeId_t* inEnd( const nodeId_t node ) const noexcept {
+      return m_in.data() + m_inOffsets[node+1];
+    }
+
+  private:
+    nodeId_t              m_numNodes = 0;
+    uint32_t              m_maxDegree = 0;
+    std::vector<edgeId_t> m_outOffsets;
+    std::vector<nodeId_t> m_out;
+    std::vector<edgeId_t> m_inOffsets;
+    std::vector<nodeId_t> m_in;
+};
+
+/**
+ * Intersects two sorted sets of nodes without duplicates. Sets of similar
+ * sizes are merged four by four elements, comparing blocks all against all
+ * with SIMD instructions; when a set is much smaller than the other, its
+ * elements are searched in the larger one by galloping.
+ * @param in a The first set
+ * @param in sizeA The size of the first set
+ * @param in b The second set
+ * @param in sizeB The size of the second set
+ * @param out out The intersection, sorted. Must have room for the smallest
+ * set, and not overlap the sets.
+ * @return The size of the intersection
+ **/
+uint32_t intersectSorted( const nodeId_t* a,
+                          const uint32_t sizeA,
+                          const nodeId_t* b,
+                          const uint32_t sizeB,
+                          nodeId_t* out ) noexcept;
+
+/**
+ * Pair of pattern variables. As an edge, it is matched by a graph edge from
+ * the node bound to m_from to the node bound to m_to. As an order
+ * constraint, the node bound to m_from must be smaller than the node bound
+ * to m_to.
+ **/
+struct PatternEdge {
+  uint32_t  m_from;
+  uint32_t  m_to;
+};
+
+/**
+ * Subgraph pattern: variables bound to nodes, the edges between them, and
+ * order constraints that break the symmetries of the pattern so that each
+ * subgraph is reported once
+ **/
+struct Pattern {
+  uint32_t                  m_numVariables = 0;
+  std::vector<PatternEdge>  m_edges;
+  std::vector<PatternEdge>  m_smaller;
+
+  /**
+   * Whether distinct variables must be bound to distinct nodes
+   */
+  bool                      m_injective = true;
+};
+
+struct PatternJoinConfig {
+  /**
+   * Number of threads. The candidates of the first variable are distributed
+   * among them.
+   */
+  uint32_t  m_numThreads = 1;
+};
+
+/**
+ * Function receiving the matches of a pattern: the thread number and the
+ * node bound to each variable. Called concurrently from the join threads.
+ **/
+using PatternMatchFunction = std::function<void(uint32_t, const nodeId_t*)>;
+
+/**
+ * Matches a pattern with Generic Join, a worst-case optimal join. Variables
+ * are bound one at a time in the order they are numbered: the candidates of
+ * a variable are the intersection of the neighbor sets of the nodes bound to
+ * its neighbors in the pattern, restricted by its order constraints. Cyclic
+ * patterns such as triangles are thus evaluated without the intermediate
+ * results of binary joins over the edges.
+ * @param in adjacency The sorted adjacency of the graph
+ * @param in pattern The pattern. Every variable but the first must have an
+ * edge to a variable numbered before it.
+ * @param in config The configuration of the join
+ * @param in f The function receiving the matches, or nullptr to only count
+ * them
+ * @param out numMatches The number of matches
+ * @return E_ROUTING_INVALID_PATTERN if the pattern references variables out
+ * of bounds, relates a variable with itself, or a variable has no edge to a
+ * previous one
+ **/
+ErrorCode matchPattern( const SortedAdjacency& adjacency,
+                        const Pattern& pattern,
+                        const PatternJoinConfig& config,
+                        const PatternMatchFunction& f,
+                        uint64_t* numMatches ) noexcept;
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_PATTERN_JOIN_H_ */
@@ -0,0 +1,157 @@
+
+
+
+#ifndef _SMILE_ROUTING_PRIORITY_QUEUE_H_
+#define _SMILE_ROUTING_PRIORITY_QUEUE_H_
+
+#include "../base/platform.h"
+#include "types.h"
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Binary min-heap of node identifiers keyed by weight, supporting decrease key.
+ * The position of each node in the heap is kept in an array of the size of the
+ * graph, so the heap can be reused across queries without reallocating.
+ **/
+class IndexedBinaryHeap {
+  public:
+    SMILE_NON_COPYABLE(IndexedBinaryHeap);
+
+    IndexedBinaryHeap( const nodeId_t numNodes ) noexcept :
+      m_positions(numNodes, kNotInHeap) {
+    }
+
+    ~IndexedBinaryHeap() noexcept = default;
+
+    /**
+     * Tells if the heap is empty
+     **/
+    bool empty() const noexcept {
+      return m_elements.empty();
+    }
+
+    /**
+     * Gets the number of elements in the heap
+     **/
+    uint64_t size() const noexcept {
+      return m_elements.size();
+    }
+
+    /**
+     * Tells if the node is in the heap
+     **/
+    bool contains( const nodeId_t node ) const noexcept {
+      return m_positions[node] != kNotInHeap;
+    }
+
+    /**
+     * Gets the key of the element at the top of the heap
+     **/
+    weight_t minKey() const noexcept {
+      return m_elements[0].m_key;
+    }
+
+    /**
+     * Inserts a node into the heap, or decreases its key if it is already
+     * contained and the new key is smaller.
+     * @param in node The node to insert
+     * @param in key The key of the node
+     **/
+    void pushOrDecrease( const nodeId_t node, const weight_t key ) noexcept {
+      uint32_t position = m_positions[node];
+      if( position == kNotInHeap ) {
+        position = static_cast<uint32_t>(m_elements.size());
+        m_elements.push_back(Element{key, node});
+      } else if( key < m_elements[position].m_key ) {
+        m_elements[position].m_key = key;
+      } else {
+        return;
+      }
+      siftUp(position);
+    }
+
+    /**
+     * Removes the element at the top of the heap
+     * @return The removed node
+     **/
+    nodeId_t pop() noexcept {
+      const nodeId_t node = m_elements[0].m_node;
+      m_positions[node] = kNotInHeap;
+      const Element last = m_elements.back();
+      m_elements.pop_back();
+      if( !m_elements.empty() ) {
+        m_elements[0] = last;
+        m_positions[last.m_node] = 0;
+        siftDown(0);
+      }
+      return node;
+    }
+
+    /**
+     * Removes all the elements of the heap
+     **/
+    void clear() noexcept {
+      for( const Element& element : m_elements ) {
+        m_positions[element.m_node] = kNotInHeap;
+      }
+      m_elements.clear();
+    }
+
+  private:
+
+    static constexpr uint32_t kNotInHeap = 0xFFFFFFFF;
+
+    struct Element {
+      weight_t m_key;
+      nodeId_t m_node;
+    };
+
+    void siftUp( uint32_t position ) noexcept {
+      const Element element = m_elements[position];
+      while( position > 0 ) {
+        const uint32_t parent = (position - 1) / 2;
+        if( m_elements[parent].m_key <= element.m_key ) {
+          break;
+        }
+        m_elements[position] = m_elements[parent];
+        m_positions[m_elements[position].m_node] = position;
+        position = parent;
+      }
+      m_elements[position] = element;
+      m_positions[element.m_node] = position;
+    }
+
+    void siftDown( uint32_t position ) noexcept {
+      const Element element = m_elements[position];
+      const uint32_t size = static_cast<uint32_t>(m_elements.size());
+      while( true ) {
+        uint32_t child = 2*position + 1;
+        if( child >= size ) {
+          break;
+        }
+        if( child + 1 < size && m_elements[child+1].m_key < m_elements[child].m_key ) {
+          ++child;
+        }
+        if( element.m_key <= m_elements[child].m_key ) {
+          break;
+        }
+        m_elements[position] = m_elements[child];
+        m_positions[m_elements[position].m_node] = position;
+        position = child;
+      }
+      m_elements[position] = element;
+      m_positions[element.m_node] = position;
+    }
+
+    // The heap elements
+    std::vector<Element>  m_elements;
+
+    // The position of each node in m_elements, or kNotInHeap
+    std::vector<uint32_t> m_positions;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_PRIORITY_QUEUE_H_ */
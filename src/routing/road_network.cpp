@@ -0,0 +1,528 @@
+
+
+
+#include "road_network.h"
+#include "../base/types_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Read only memory mapping of a whole file
+ **/
+class MappedFile {
+  public:
+    SMILE_NON_COPYABLE(MappedFile);
+
+    MappedFile() noexcept = default;
+
+    ~MappedFile() noexcept {
+      if( p_data != nullptr ) {
+        munmap(const_cast<char*>(p_data), m_size);
+      }
+    }
+
+    ErrorCode open( const std::string& path ) noexcept {
+      const int fd = ::open(path.c_str(), O_RDONLY);
+      if( fd < 0 ) {
+        return ErrorCode::E_STORAGE_INVALID_PATH;
+      }
+      struct stat status;
+      if( fstat(fd, &status) != 0 ) {
+        ::close(fd);
+        return ErrorCode::E_STORAGE_INVALID_PATH;
+      }
+      m_size = static_cast<uint64_t>(status.st_size);
+      if( m_size > 0 ) {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if( data == MAP_FAILED ) {
+          ::close(fd);
+          return ErrorCode::E_STORAGE_INVALID_PATH;
+        }
+        madvise(data, m_size, MADV_SEQUENTIAL);
+        p_data = static_cast<const char*>(data);
+      }
+      ::close(fd);
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    const char* begin() const noexcept {
+      return p_data;
+    }
+
+    const char* end() const noexcept {
+      return p_data + m_size;
+    }
+
+  private:
+    const char* p_data = nullptr;
+    uint64_t    m_size = 0;
+};
+
+/**
+ * Splits the lines of a DIMACS file into whitespace separated tokens
+ **/
+class DimacsTokenizer {
+  public:
+    DimacsTokenizer( const char* begin, const char* end ) noexcept :
+      p_next(begin),
+      p_end(end) {
+    }
+
+    /**
+     * Moves to the next line
+     * @return false if there are no more lines
+     **/
+    bool nextLine() noexcept {
+      if( p_next >= p_end ) {
+        return false;
+      }
+      p_current = p_next;
+      const char* newline = static_cast<const char*>(memchr(p_next, '\n', p_end - p_next));
+      p_lineEnd = newline != nullptr ? newline : p_end;
+      p_next = p_lineEnd + 1;
+      return true;
+    }
+
+    /**
+     * Gets the next token of the current line
+     * @return false if the line has no more tokens
+     **/
+    bool nextToken( const char** begin, const char** end ) noexcept {
+      while( p_current < p_lineEnd && isSpace(*p_current) ) {
+        ++p_current;
+      }
+      if( p_current == p_lineEnd ) {
+        return false;
+      }
+      *begin = p_current;
+      while( p_current < p_lineEnd && !isSpace(*p_current) ) {
+        ++p_current;
+      }
+      *end = p_current;
+      return true;
+    }
+
+    /**
+     * Parses the next token of the current line
+     **/
+    template<typename T>
+    bool next( T* value ) noexcept {
+      const char* begin;
+      const char* end;
+      return nextToken(&begin, &end) && parser<T>::parse(begin, end, value) == ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Checks that the current line has no more tokens
+     **/
+    bool atEnd() noexcept {
+      const char* begin;
+      const char* end;
+      return !nextToken(&begin, &end);
+    }
+
+  private:
+    static bool isSpace( const char c ) noexcept {
+      return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    const char* p_next;
+    const char* p_end;
+    const char* p_current = nullptr;
+    const char* p_lineEnd = nullptr;
+};
+
+/**
+ * Checks that a token is the given keyword
+ **/
+static bool isKeyword( const char* begin, const char* end, const char* keyword ) noexcept {
+  const size_t length = strlen(keyword);
+  return static_cast<size_t>(end - begin) == length && memcmp(begin, keyword, length) == 0;
+}
+
+ErrorCode RoadNetwork::build( RoutingGraph* graph, Metric* metric ) const noexcept {
+  if( m_weights.size() != m_edges.size() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+  std::vector<edgeId_t> permutation;
+  ErrorCode error = graph->build(m_numNodes, m_edges, &permutation);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  return metric->assign(*graph, m_weights, permutation);
+}
+
+ErrorCode loadDimacsGraph( const std::string& path, RoadNetwork* network ) noexcept {
+  MappedFile file;
+  ErrorCode error = file.open(path);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  network->m_numNodes = 0;
+  network->m_edges.clear();
+  network->m_weights.clear();
+  network->m_coordinates.clear();
+
+  bool hasProblem = false;
+  uint64_t numArcs = 0;
+  DimacsTokenizer tokenizer(file.begin(), file.end());
+  while( tokenizer.nextLine() ) {
+    const char* begin;
+    const char* end;
+    if( !tokenizer.nextToken(&begin, &end) || isKeyword(begin, end, "c") ) {
+      continue;
+    }
+    if( isKeyword(begin, end, "p") ) {
+      uint32_t numNodes = 0;
+      if( hasProblem ||
+          !tokenizer.nextToken(&begin, &end) || !isKeyword(begin, end, "sp") ||
+          !tokenizer.next(&numNodes) || !tokenizer.next(&numArcs) || !tokenizer.atEnd() ||
+          numNodes == kInvalidNode || numArcs >= kInvalidEdge ) {
+        return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+      }
+      hasProblem = true;
+      network->m_numNodes = numNodes;
+      network->m_edges.reserve(numArcs);
+      network->m_weights.reserve(numArcs);
+    } else if( isKeyword(begin, end, "a") ) {
+      nodeId_t tail = 0;
+      nodeId_t head = 0;
+      weight_t weight = 0;
+      if( !hasProblem || !tokenizer.next(&tail) || !tokenizer.next(&head) || !tokenizer.next(&weight) ||
+          !tokenizer.atEnd() || weight >= kInfiniteWeight ) {
+        return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+      }
+      if( tail == 0 || head == 0 || tail > network->m_numNodes || head > network->m_numNodes ) {
+        return ErrorCode::E_ROUTING_INVALID_NODE;
+      }
+      network->m_edges.push_back(RoutingEdge{tail-1, head-1});
+      network->m_weights.push_back(weight);
+    } else {
+      return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+    }
+  }
+  if( !hasProblem || network->m_edges.size() != numArcs ) {
+    return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode loadDimacsCoordinates( const std::string& path, RoadNetwork* network ) noexcept {
+  MappedFile file;
+  ErrorCode error = file.open(path);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+
+  std::vector<Coordinate> coordinates;
+  std::vector<bool> seen;
+  bool hasProblem = false;
+  DimacsTokenizer tokenizer(file.begin(), file.end());
+  while( tokenizer.nextLine() ) {
+    const char* begin;
+    const char* end;
+    if( !tokenizer.nextToken(&begin, &end) || isKeyword(begin, end, "c") ) {
+      continue;
+    }
+    if( isKeyword(begin, end, "p") ) {
+      uint32_t numNodes = 0;
+      if( hasProblem ) {
+        return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+      }
+      for( const char* keyword : {"aux", "sp", "co"} ) {
+        if( !tokenizer.nextToken(&begin, &end) || !isKeyword(begin, end, keyword) ) {
+          return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+        }
+      }
+      if( !tokenizer.next(&numNodes) || !tokenizer.atEnd() ) {
+        return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+      }
+      if( numNodes != network->m_numNodes ) {
+        return ErrorCode::E_ROUTING_INVALID_NODE;
+      }
+      hasProblem = true;
+      coordinates.resize(numNodes);
+      seen.assign(numNodes, false);
+    } else if( isKeyword(begin, end, "v") ) {
+      nodeId_t node = 0;
+      Coordinate coordinate;
+      if( !hasProblem || !tokenizer.next(&node) || !tokenizer.next(&coordinate.m_x) ||
+          !tokenizer.next(&coordinate.m_y) || !tokenizer.atEnd() ) {
+        return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+      }
+      if( node == 0 || node > network->m_numNodes ) {
+        return ErrorCode::E_ROUTING_INVALID_NODE;
+      }
+      coordinates[node-1] = coordinate;
+      seen[node-1] = true;
+    } else {
+      return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+    }
+  }
+  if( !hasProblem || std::find(seen.begin(), seen.end(), false) != seen.end() ) {
+    return ErrorCode::E_ROUTING_INVALID_DIMACS_FILE;
+  }
+  network->m_coordinates = std::move(coordinates);
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode storeDimacs( const RoadNetwork& network,
+                       const std::string& graphPath,
+                       const std::string& coordinatesPath ) noexcept {
+  if( network.m_weights.size() != network.m_edges.size() ) {
+    return ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH;
+  }
+  std::ofstream graph(graphPath, std::ios_base::out | std::ios_base::trunc);
+  if( !graph ) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  graph << "p sp " << network.m_numNodes << " " << network.m_edges.size() << "\n";
+  for( size_t i = 0; i < network.m_edges.size(); ++i ) {
+    const RoutingEdge& edge = network.m_edges[i];
+    graph << "a " << edge.m_tail+1 << " " << edge.m_head+1 << " " << network.m_weights[i] << "\n";
+  }
+  if( !graph ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
+  }
+  if( coordinatesPath.empty() || network.m_coordinates.empty() ) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  std::ofstream coordinates(coordinatesPath, std::ios_base::out | std::ios_base::trunc);
+  if( !coordinates ) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  coordinates << "p aux sp co " << network.m_numNodes << "\n";
+  for( nodeId_t node = 0; node < network.m_coordinates.size(); ++node ) {
+    const Coordinate& coordinate = network.m_coordinates[node];
+    coordinates << "v " << node+1 << " " << coordinate.m_x << " " << coordinate.m_y << "\n";
+  }
+  if( !coordinates ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+/**
+ * Pseudo random generator (SplitMix64). Standard library distributions are
+ * not used since their output differs between implementations.
+ **/
+class RoadRandom {
+  public:
+    explicit RoadRandom( const uint64_t seed ) noexcept :
+      m_state(seed) {
+    }
+
+    uint64_t next() noexcept {
+      uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+
+    /**
+     * Uniform double in [0,1)
+     **/
+    double uniform() noexcept {
+      return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+  private:
+    uint64_t  m_state;
+};
+
+/**
+ * Gets the euclidean distance between two coordinates
+ **/
+static double distance( const Coordinate& a, const Coordinate& b ) noexcept {
+  const double dx = static_cast<double>(a.m_x) - b.m_x;
+  const double dy = static_cast<double>(a.m_y) - b.m_y;
+  return std::sqrt(dx*dx + dy*dy);
+}
+
+/**
+ * Adds a two way road
+ **/
+static void addRoad( const nodeId_t a, const nodeId_t b, const double length, RoadNetwork* network ) noexcept {
+  const weight_t weight = static_cast<weight_t>(std::max(1.0, std::round(length)));
+  network->m_edges.push_back(RoutingEdge{a, b});
+  network->m_weights.push_back(weight);
+  network->m_edges.push_back(RoutingEdge{b, a});
+  network->m_weights.push_back(weight);
+}
+
+ErrorCode generateGrid( const nodeId_t width,
+                        const nodeId_t height,
+                        const RoadGeneratorConfig& config,
+                        RoadNetwork* network ) noexcept {
+  const uint64_t numNodes = static_cast<uint64_t>(width) * height;
+  if( numNodes >= kInvalidNode ||
+      static_cast<uint64_t>(std::max(width, height)) * config.m_spacing > INT32_MAX / 2 ) {
+    return ErrorCode::E_ROUTING_INVALID_NODE;
+  }
+  RoadRandom random(config.m_seed);
+  network->m_numNodes = static_cast<nodeId_t>(numNodes);
+  network->m_edges.clear();
+  network->m_weights.clear();
+  network->m_coordinates.resize(numNodes);
+  const double jitter = config.m_perturbation * config.m_spacing;
+  for( nodeId_t y = 0; y < height; ++y ) {
+    for( nodeId_t x = 0; x < width; ++x ) {
+      Coordinate& coordinate = network->m_coordinates[y*width + x];
+      coordinate.m_x = static_cast<int32_t>(x*config.m_spacing + (random.uniform() - 0.5)*jitter);
+      coordinate.m_y = static_cast<int32_t>(y*config.m_spacing + (random.uniform() - 0.5)*jitter);
+    }
+  }
+  const std::vector<Coordinate>& coordinates = network->m_coordinates;
+  for( nodeId_t y = 0; y < height; ++y ) {
+    for( nodeId_t x = 0; x < width; ++x ) {
+      const nodeId_t node = y*width + x;
+      if( x + 1 < width && random.uniform() >= config.m_dropProbability ) {
+        addRoad(node, node + 1, distance(coordinates[node], coordinates[node + 1]), network);
+      }
+      if( y + 1 < height && random.uniform() >= config.m_dropProbability ) {
+        addRoad(node, node + width, distance(coordinates[node], coordinates[node + width]), network);
+      }
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode generateGeometric( const nodeId_t numNodes,
+                             const RoadGeneratorConfig& config,
+                             RoadNetwork* network ) noexcept {
+  const double side = std::sqrt(static_cast<double>(numNodes)) * config.m_spacing;
+  if( numNodes == kInvalidNode || side > INT32_MAX / 2 ) {
+    return ErrorCode::E_ROUTING_INVALID_NODE;
+  }
+  RoadRandom random(config.m_seed);
+  network->m_numNodes = numNodes;
+  network->m_edges.clear();
+  network->m_weights.clear();
+  network->m_coordinates.resize(numNodes);
+  for( Coordinate& coordinate : network->m_coordinates ) {
+    coordinate.m_x = static_cast<int32_t>(random.uniform() * side);
+    coordinate.m_y = static_cast<int32_t>(random.uniform() * side);
+  }
+
+  // Nodes are bucketed in square cells as large as the radius, so only the
+  // neighboring cells of a node have to be scanned
+  const double radius = config.m_spacing * std::sqrt(std::max(config.m_averageDegree, 0.0) / M_PI);
+  const uint64_t maxCellsPerSide = static_cast<uint64_t>(std::sqrt(static_cast<double>(numNodes))) + 1;
+  const uint64_t cellsPerSide = std::max<uint64_t>(1, std::min<uint64_t>(static_cast<uint64_t>(side / std::max(radius, 1.0)), maxCellsPerSide));
+  const double cellSize = side / cellsPerSide;
+  auto cellOf = [&]( const Coordinate& coordinate, uint64_t* cx, uint64_t* cy ) {
+    *cx = std::min<uint64_t>(static_cast<uint64_t>(coordinate.m_x / cellSize), cellsPerSide - 1);
+    *cy = std::min<uint64_t>(static_cast<uint64_t>(coordinate.m_y / cellSize), cellsPerSide - 1);
+  };
+  std::vector<uint64_t> cellOffsets(cellsPerSide*cellsPerSide + 1, 0);
+  for( const Coordinate& coordinate : network->m_coordinates ) {
+    uint64_t cx, cy;
+    cellOf(coordinate, &cx, &cy);
+    ++cellOffsets[cy*cellsPerSide + cx + 1];
+  }
+  for( uint64_t i = 1; i < cellOffsets.size(); ++i ) {
+    cellOffsets[i] += cellOffsets[i-1];
+  }
+  std::vector<nodeId_t> cellNodes(numNodes);
+  std::vector<uint64_t> next(cellOffsets.begin(), cellOffsets.end() - 1);
+  for( nodeId_t node = 0; node < numNodes; ++node ) {
+    uint64_t cx, cy;
+    cellOf(network->m_coordinates[node], &cx, &cy);
+    cellNodes[next[cy*cellsPerSide + cx]++] = node;
+  }
+
+  const std::vector<Coordinate>& coordinates = network->m_coordinates;
+  for( nodeId_t node = 0; node < numNodes; ++node ) {
+    uint64_t cx, cy;
+    cellOf(coordinates[node], &cx, &cy);
+    for( uint64_t y = (cy > 0 ? cy - 1 : 0); y <= std::min(cy + 1, cellsPerSide - 1); ++y ) {
+      for( uint64_t x = (cx > 0 ? cx - 1 : 0); x <= std::min(cx + 1, cellsPerSide - 1); ++x ) {
+        const uint64_t cell = y*cellsPerSide + x;
+        for( uint64_t i = cellOffsets[cell]; i < cellOffsets[cell+1]; ++i ) {
+          const nodeId_t other = cellNodes[i];
+          const double length = distance(coordinates[node], coordinates[other]);
+          if( other > node && length <= radius ) {
+            addRoad(node, other, length, network);
+          }
+        }
+      }
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode addHighways( const uint32_t levels,
+                       const RoadGeneratorConfig& config,
+                       RoadNetwork* network ) noexcept {
+  if( network->m_coordinates.size() != network->m_numNodes ) {
+    return ErrorCode::E_ROUTING_MISSING_COORDINATES;
+  }
+  if( network->m_numNodes == 0 ) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  Coordinate min = network->m_coordinates[0];
+  Coordinate max = network->m_coordinates[0];
+  for( const Coordinate& coordinate : network->m_coordinates ) {
+    min.m_x = std::min(min.m_x, coordinate.m_x);
+    min.m_y = std::min(min.m_y, coordinate.m_y);
+    max.m_x = std::max(max.m_x, coordinate.m_x);
+    max.m_y = std::max(max.m_y, coordinate.m_y);
+  }
+
+  const std::vector<Coordinate>& coordinates = network->m_coordinates;
+  double cellSize = config.m_spacing;
+  double speedup = 1.0;
+  for( uint32_t level = 1; level <= levels; ++level ) {
+    cellSize *= 4;
+    speedup *= std::max(config.m_highwaySpeedup, 1.0);
+    const uint64_t numX = static_cast<uint64_t>((static_cast<double>(max.m_x) - min.m_x) / cellSize) + 1;
+    const uint64_t numY = static_cast<uint64_t>((static_cast<double>(max.m_y) - min.m_y) / cellSize) + 1;
+    if( numX == 1 && numY == 1 ) {
+      break;
+    }
+
+    // The interchange of a cell is the node closest to its center
+    std::vector<nodeId_t> interchanges(numX*numY, kInvalidNode);
+    std::vector<double> best(numX*numY, 0.0);
+    for( nodeId_t node = 0; node < network->m_numNodes; ++node ) {
+      const double x = static_cast<double>(coordinates[node].m_x) - min.m_x;
+      const double y = static_cast<double>(coordinates[node].m_y) - min.m_y;
+      const uint64_t cx = static_cast<uint64_t>(x / cellSize);
+      const uint64_t cy = static_cast<uint64_t>(y / cellSize);
+      const double dx = x - (cx + 0.5)*cellSize;
+      const double dy = y - (cy + 0.5)*cellSize;
+      const uint64_t cell = cy*numX + cx;
+      if( interchanges[cell] == kInvalidNode || dx*dx + dy*dy < best[cell] ) {
+        interchanges[cell] = node;
+        best[cell] = dx*dx + dy*dy;
+      }
+    }
+
+    for( uint64_t cy = 0; cy < numY; ++cy ) {
+      for( uint64_t cx = 0; cx < numX; ++cx ) {
+        const nodeId_t node = interchanges[cy*numX + cx];
+        if( node == kInvalidNode ) {
+          continue;
+        }
+        const nodeId_t right = cx + 1 < numX ? interchanges[cy*numX + cx + 1] : kInvalidNode;
+        const nodeId_t up = cy + 1 < numY ? interchanges[(cy + 1)*numX + cx] : kInvalidNode;
+        for( const nodeId_t other : {right, up} ) {
+          if( other != kInvalidNode ) {
+            addRoad(node, other, distance(coordinates[node], coordinates[other]) / speedup, network);
+          }
+        }
+      }
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+SMILE_NS_END
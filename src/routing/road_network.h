@@ -0,0 +1,142 @@
+
+
+
+#ifndef _SMILE_ROUTING_ROAD_NETWORK_H_
+#define _SMILE_ROUTING_ROAD_NETWORK_H_
+
+#include "../base/base.h"
+#include "graph.h"
+#include "metric.h"
+#include "types.h"
+#include <string>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Planar coordinate of a node. DIMACS files store longitude and latitude
+ * multiplied by 10^6; generated networks use abstract units.
+ **/
+struct Coordinate {
+  int32_t m_x;
+  int32_t m_y;
+};
+
+/**
+ * A road network as an edge list, before it is turned into a RoutingGraph.
+ * Weights are aligned with the edges; coordinates are either empty or hold
+ * one coordinate per node.
+ **/
+struct RoadNetwork {
+  nodeId_t                  m_numNodes = 0;
+  std::vector<RoutingEdge>  m_edges;
+  std::vector<weight_t>     m_weights;
+  std::vector<Coordinate>   m_coordinates;
+
+  /**
+   * Builds the graph of the network and a metric with its weights, in
+   * adjacency order
+   * @param out graph The graph to build
+   * @param out metric The metric to assign
+   **/
+  ErrorCode build( RoutingGraph* graph, Metric* metric ) const noexcept;
+};
+
+/**
+ * Reads a graph in the DIMACS shortest path format (.gr). Nodes are
+ * renumbered from 0. The file is memory mapped and parsed in place.
+ * @param in path The path to the .gr file
+ * @param out network The network. Its coordinates are cleared.
+ * @return E_ROUTING_INVALID_DIMACS_FILE if the file is malformed and
+ * E_ROUTING_INVALID_NODE if an arc references a node out of bounds
+ **/
+ErrorCode loadDimacsGraph( const std::string& path, RoadNetwork* network ) noexcept;
+
+/**
+ * Reads the coordinates of a network in the DIMACS coordinates format (.co)
+ * @param in path The path to the .co file
+ * @param inout network The network, whose graph must be loaded already
+ * @return E_ROUTING_INVALID_DIMACS_FILE if the file is malformed and
+ * E_ROUTING_INVALID_NODE if the number of nodes does not match the network
+ **/
+ErrorCode loadDimacsCoordinates( const std::string& path, RoadNetwork* network ) noexcept;
+
+/**
+ * Writes a network in the DIMACS formats
+ * @param in network The network
+ * @param in graphPath The path of the .gr file
+ * @param in coordinatesPath The path of the .co file. Ignored if empty or if
+ * the network has no coordinates.
+ **/
+ErrorCode storeDimacs( const RoadNetwork& network,
+                       const std::string& graphPath,
+                       const std::string& coordinatesPath = "" ) noexcept;
+
+struct RoadGeneratorConfig {
+  /**
+   * Seed of the generator. The same seed and parameters always produce the
+   * same network, on any platform.
+   */
+  uint64_t  m_seed            = 1;
+
+  /**
+   * Average distance between neighboring nodes, in coordinate units
+   */
+  uint32_t  m_spacing         = 100;
+
+  /**
+   * Displacement of the grid nodes, as a fraction of the spacing
+   */
+  double    m_perturbation    = 0.3;
+
+  /**
+   * Probability of removing a grid road
+   */
+  double    m_dropProbability = 0.1;
+
+  /**
+   * Expected number of roads per node in random geometric networks
+   */
+  double    m_averageDegree   = 4.0;
+
+  /**
+   * How much faster highways of the first level are than regular roads.
+   * Each level is this much faster than the level below.
+   */
+  double    m_highwaySpeedup  = 2.0;
+};
+
+/**
+ * Generates a perturbed grid: the nodes of a width x height grid are
+ * displaced randomly and connected to their four neighbors with two way
+ * roads, some of which are dropped. Weights are the road lengths.
+ **/
+ErrorCode generateGrid( const nodeId_t width,
+                        const nodeId_t height,
+                        const RoadGeneratorConfig& config,
+                        RoadNetwork* network ) noexcept;
+
+/**
+ * Generates a random geometric network: nodes are placed uniformly in a
+ * square and every pair of nodes closer than a radius is connected with a two
+ * way road. The radius is chosen to match the average degree.
+ **/
+ErrorCode generateGeometric( const nodeId_t numNodes,
+                             const RoadGeneratorConfig& config,
+                             RoadNetwork* network ) noexcept;
+
+/**
+ * Adds a hierarchy of highways over a network with coordinates. At level l
+ * the bounding box is split into cells of spacing*4^l units, the node closest
+ * to the center of each cell becomes an interchange, and the interchanges of
+ * adjacent cells are connected with two way highways.
+ * @param in levels The number of highway levels
+ * @return E_ROUTING_MISSING_COORDINATES if the network has no coordinates
+ **/
+ErrorCode addHighways( const uint32_t levels,
+                       const RoadGeneratorConfig& config,
+                       RoadNetwork* network ) noexcept;
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_ROAD_NETWORK_H_ */
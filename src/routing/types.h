@@ -0,0 +1,42 @@
+
+
+
+#ifndef _SMILE_ROUTING_TYPES_H_
+#define _SMILE_ROUTING_TYPES_H_
+
+#include "../base/platform.h"
+
+SMILE_NS_BEGIN
+
+using nodeId_t = uint32_t;
+using edgeId_t = uint32_t;
+using weight_t = uint32_t;
+
+/**
+ * Weight used to represent unreachable nodes. It is chosen so that the sum of
+ * two infinite weights still fits in a signed 32 bit integer, which allows
+ * comparing weights with signed SIMD instructions.
+ **/
+constexpr weight_t kInfiniteWeight = 0x3FFFFFFF;
+
+/**
+ * Invalid node identifier
+ **/
+constexpr nodeId_t kInvalidNode = 0xFFFFFFFF;
+
+/**
+ * Invalid edge identifier
+ **/
+constexpr edgeId_t kInvalidEdge = 0xFFFFFFFF;
+
+/**
+ * Adds two weights, saturating to kInfiniteWeight
+ **/
+inline weight_t addWeights( const weight_t a, const weight_t b ) noexcept {
+  const weight_t sum = a + b;
+  return sum < kInfiniteWeight ? sum : kInfiniteWeight;
+}
+
+SMILE_NS_END
+
+#endif /* ifndef _SMILE_ROUTING_TYPES_H_ */
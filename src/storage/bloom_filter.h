@@ -0,0 +1,195 @@
+
+
+
+#ifndef _STORAGE_BLOOM_FILTER_H_
+#define _STORAGE_BLOOM_FILTER_H_
+
+#include "../base/platform.h"
+#include "types.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Number of 64 bit words of a block of a blocked Bloom filter: a cache line
+ **/
+constexpr uint32_t kBloomBlockWords = 8;
+
+/**
+ * Default number of filter bits per key, for a false positive rate close to
+ * one percent
+ **/
+constexpr uint32_t kBloomBitsPerKey = 10;
+
+/**
+ * Mixes the bits of a key (the finalizer of MurmurHash3)
+ **/
+inline uint64_t bloomHash( uint64_t key ) noexcept {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+
+/**
+ * Blocked Bloom filter. Each key sets all its bits in a single cache line
+ * sized block, so a lookup touches one cache line. Filters answer whether a
+ * key may have been added; a negative answer is always right.
+ **/
+class BloomFilter {
+  public:
+    BloomFilter() noexcept = default;
+    ~BloomFilter() noexcept = default;
+
+    /**
+     * @param in numKeys The expected number of keys
+     * @param in bitsPerKey The number of bits of the filter per key
+     **/
+    BloomFilter( const uint64_t numKeys, const uint32_t bitsPerKey = kBloomBitsPerKey ) noexcept {
+      reset(numKeys, bitsPerKey);
+    }
+
+    /**
+     * Clears the filter and sizes it for a number of keys
+     * @param in numKeys The expected number of keys
+     * @param in bitsPerKey The number of bits of the filter per key
+     **/
+    void reset( const uint64_t numKeys, const uint32_t bitsPerKey = kBloomBitsPerKey ) noexcept {
+      const uint64_t blockBits = kBloomBlockWords*64;
+      m_numBlocks = std::max<uint64_t>((numKeys*bitsPerKey + blockBits - 1) / blockBits, 1);
+      // The optimal number of probes is bitsPerKey * ln(2)
+      m_numProbes = std::min<uint32_t>(std::max<uint32_t>((bitsPerKey*69 + 50) / 100, 1), 16);
+      m_words.assign(m_numBlocks*kBloomBlockWords, 0);
+    }
+
+    /**
+     * Adds a key
+     **/
+    void add( const uint64_t key ) noexcept {
+      const uint64_t hash = bloomHash(key);
+      uint64_t* block = m_words.data() + blockOf(hash)*kBloomBlockWords;
+      uint32_t probe = static_cast<uint32_t>(hash);
+      const uint32_t step = stepOf(hash);
+      for( uint32_t i = 0; i < m_numProbes; ++i, probe += step ) {
+        const uint32_t bit = probe >> 23;
+        block[bit >> 6] |= uint64_t(1) << (bit & 63);
+      }
+    }
+
+    /**
+     * Checks whether a key may have been added. Filters that were never
+     * sized may contain any key.
+     **/
+    bool mayContain( const uint64_t key ) const noexcept {
+      if( m_words.empty() ) {
+        return true;
+      }
+      const uint64_t hash = bloomHash(key);
+      const uint64_t* block = m_words.data() + blockOf(hash)*kBloomBlockWords;
+      uint32_t probe = static_cast<uint32_t>(hash);
+      const uint32_t step = stepOf(hash);
+      uint64_t missing = 0;
+      for( uint32_t i = 0; i < m_numProbes; ++i, probe += step ) {
+        const uint32_t bit = probe >> 23;
+        missing |= ~block[bit >> 6] & (uint64_t(1) << (bit & 63));
+      }
+      return missing == 0;
+    }
+
+    /**
+     * Gets the memory used by the filter in bytes
+     **/
+    uint64_t sizeBytes() const noexcept {
+      return m_words.size()*sizeof(uint64_t);
+    }
+
+  private:
+
+    /**
+     * Maps the high bits of a hash to a block, without a division
+     **/
+    uint64_t blockOf( const uint64_t hash ) const noexcept {
+      return ((hash >> 32) * m_numBlocks) >> 32;
+    }
+
+    /**
+     * Gets the distance between the probes of a key, never zero. It depends
+     * on all the bits of the hash, so keys of the same block do not share it.
+     **/
+    static uint32_t stepOf( const uint64_t hash ) noexcept {
+      return static_cast<uint32_t>((hash * 0x9e3779b97f4a7c15ULL) >> 32) | 1;
+    }
+
+    std::vector<uint64_t> m_words;
+    uint64_t              m_numBlocks = 0;
+    uint32_t              m_numProbes = 0;
+};
+
+/**
+ * Bloom filters of the keys stored in each page of a storage, kept in
+ * memory. Lookups of keys absent from a page are rejected without reading
+ * it. Pages without a filter may contain any key.
+ **/
+class PageFilters {
+    SMILE_NON_COPYABLE(PageFilters);
+  public:
+    /**
+     * @param in bitsPerKey The number of bits of the filters per key
+     **/
+    explicit PageFilters( const uint32_t bitsPerKey = kBloomBitsPerKey ) noexcept :
+      m_bitsPerKey(bitsPerKey) {
+    }
+    ~PageFilters() noexcept = default;
+
+    /**
+     * Builds the filter of a page, replacing the previous one
+     * @param in page The page
+     * @param in keys The keys stored in the page
+     * @param in numKeys The number of keys
+     **/
+    void build( const pageId_t page, const uint64_t* keys, const uint64_t numKeys ) noexcept {
+      BloomFilter& filter = m_filters[page];
+      filter.reset(numKeys, m_bitsPerKey);
+      for( uint64_t i = 0; i < numKeys; ++i ) {
+        filter.add(keys[i]);
+      }
+    }
+
+    /**
+     * Checks whether a page may store a key
+     **/
+    bool mayContain( const pageId_t page, const uint64_t key ) const noexcept {
+      auto it = m_filters.find(page);
+      return it == m_filters.end() || it->second.mayContain(key);
+    }
+
+    /**
+     * Removes the filter of a page, whose keys are no longer known
+     **/
+    void erase( const pageId_t page ) noexcept {
+      m_filters.erase(page);
+    }
+
+    /**
+     * Gets the memory used by the filters in bytes
+     **/
+    uint64_t sizeBytes() const noexcept {
+      uint64_t size = 0;
+      for( const auto& entry : m_filters ) {
+        size += entry.second.sizeBytes();
+      }
+      return size;
+    }
+
+  private:
+    uint32_t                                    m_bitsPerKey;
+    std::unordered_map<pageId_t, BloomFilter>   m_filters;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_BLOOM_FILTER_H_ */
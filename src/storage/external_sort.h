@@ -0,0 +1,373 @@
+
+
+
+#ifndef _STORAGE_EXTERNAL_SORT_H_
+#define _STORAGE_EXTERNAL_SORT_H_
+
+#include "../base/base.h"
+#include "../base/parallel.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+struct ExternalSortConfig {
+  /**
+   * Memory used to buffer the values of a run, in bytes
+   */
+  uint64_t    m_memoryBytes   = 256*1024*1024;
+
+  /**
+   * Size of the blocks read from each run during merges, in bytes. A merge
+   * uses m_fanIn such blocks.
+   */
+  uint64_t    m_blockBytes    = 1024*1024;
+
+  /**
+   * Maximum number of runs merged at once. If there are more runs, they are
+   * merged in several passes.
+   */
+  uint32_t    m_fanIn         = 64;
+
+  /**
+   * Number of threads used to sort the runs
+   */
+  uint32_t    m_numThreads    = 1;
+
+  /**
+   * Directory where the runs are written
+   */
+  std::string m_tempDirectory = "/tmp";
+};
+
+/**
+ * External merge sort for data sets larger than the memory. Values are
+ * buffered until the memory budget is reached; the buffer is then split in
+ * one slice per thread, the slices are sorted in parallel and written as
+ * sorted runs into temporary files. Runs are merged with k-way merges that
+ * read and write large sequential blocks, in several passes if there are
+ * more runs than the fan in. The last merge streams the sorted values to a
+ * consumer instead of writing them.
+ *
+ * Temporary files are unlinked as soon as they are created, so they are
+ * removed even if the process dies.
+ **/
+template<typename T, typename Compare = std::less<T>>
+class ExternalSorter {
+  static_assert(std::is_trivially_copyable<T>::value, "Sorted values are written as raw bytes");
+
+  public:
+    SMILE_NON_COPYABLE(ExternalSorter);
+
+    ExternalSorter( const ExternalSortConfig& config = ExternalSortConfig(),
+                    const Compare& compare = Compare() ) noexcept :
+      m_config(config),
+      m_compare(compare),
+      m_capacity(std::max<uint64_t>(config.m_memoryBytes / sizeof(T), 1)) {
+    }
+
+    ~ExternalSorter() noexcept {
+      for( Run& run : m_runs ) {
+        fclose(run.p_file);
+      }
+    }
+
+    /**
+     * Adds a value to sort
+     * @return E_STORAGE_INVALID_PATH if a temporary file cannot be created
+     * and E_STORAGE_OUT_OF_BOUNDS_WRITE if a run cannot be written
+     **/
+    ErrorCode push( const T& value ) noexcept {
+      if( m_buffer.size() == m_capacity ) {
+        const ErrorCode error = flush();
+        if( error != ErrorCode::E_NO_ERROR ) {
+          return error;
+        }
+      }
+      if( m_buffer.capacity() == 0 ) {
+        m_buffer.reserve(m_capacity);
+      }
+      m_buffer.push_back(value);
+      ++m_size;
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Sorts the values pushed so far and passes them in order to a function.
+     * The sorter is empty afterwards.
+     * @param in f The function receiving the sorted values
+     **/
+    template<typename F>
+    ErrorCode merge( F f ) noexcept {
+      ErrorCode error = ErrorCode::E_NO_ERROR;
+      if( m_runs.empty() ) {
+        // Everything fits in memory
+        std::sort(m_buffer.begin(), m_buffer.end(), m_compare);
+        for( const T& value : m_buffer ) {
+          f(value);
+        }
+      } else {
+        error = flush();
+        while( error == ErrorCode::E_NO_ERROR && m_runs.size() > std::max<uint32_t>(m_config.m_fanIn, 2) ) {
+          error = mergePass();
+        }
+        if( error == ErrorCode::E_NO_ERROR ) {
+          error = mergeRuns(0, m_runs.size(), f);
+        }
+      }
+      clear();
+      return error;
+    }
+
+    /**
+     * Gets the number of values pushed
+     **/
+    uint64_t size() const noexcept {
+      return m_size;
+    }
+
+    /**
+     * Gets the number of runs written to disk so far
+     **/
+    uint64_t numRuns() const noexcept {
+      return m_runs.size();
+    }
+
+  private:
+
+    struct Run {
+      FILE*     p_file;
+      uint64_t  m_size;
+    };
+
+    /**
+     * Sequential reader of a run, in blocks
+     **/
+    class RunReader {
+      public:
+        RunReader( const Run& run, const uint64_t blockSize ) noexcept :
+          m_run(run),
+          m_remaining(run.m_size) {
+          m_block.resize(std::max<uint64_t>(std::min(blockSize, run.m_size), 1));
+          m_position = m_block.size();
+          m_end = m_block.size();
+          rewind(run.p_file);
+        }
+
+        /**
+         * Reads the next value of the run
+         * @return false if the run is exhausted or cannot be read
+         **/
+        bool next( T* value ) noexcept {
+          if( m_position == m_end ) {
+            if( m_remaining == 0 ) {
+              return false;
+            }
+            const uint64_t count = std::min<uint64_t>(m_remaining, m_block.size());
+            if( fread(m_block.data(), sizeof(T), count, m_run.p_file) != count ) {
+              m_error = true;
+              return false;
+            }
+            m_remaining -= count;
+            m_position = 0;
+            m_end = count;
+          }
+          *value = m_block[m_position++];
+          return true;
+        }
+
+        bool error() const noexcept {
+          return m_error;
+        }
+
+      private:
+        const Run&      m_run;
+        std::vector<T>  m_block;
+        uint64_t        m_position;
+        uint64_t        m_end;
+        uint64_t        m_remaining;
+        bool            m_error = false;
+    };
+
+    /**
+     * Creates an unlinked temporary file
+     **/
+    ErrorCode createRun( Run* run ) const noexcept {
+      std::string path = m_config.m_tempDirectory + "/smile_sort_XXXXXX";
+      std::vector<char> name(path.begin(), path.end());
+      name.push_back('\0');
+      const int fd = mkstemp(name.data());
+      if( fd < 0 ) {
+        return ErrorCode::E_STORAGE_INVALID_PATH;
+      }
+      unlink(name.data());
+      run->p_file = fdopen(fd, "w+b");
+      run->m_size = 0;
+      if( run->p_file == nullptr ) {
+        close(fd);
+        return ErrorCode::E_STORAGE_INVALID_PATH;
+      }
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Sorts the buffered values in one slice per thread and writes each slice
+     * as a run
+     **/
+    ErrorCode flush() noexcept {
+      if( m_buffer.empty() ) {
+        return ErrorCode::E_NO_ERROR;
+      }
+      const uint64_t numSlices = std::min<uint64_t>(std::max<uint32_t>(m_config.m_numThreads, 1), m_buffer.size());
+      const uint64_t sliceSize = (m_buffer.size() + numSlices - 1) / numSlices;
+      parallelFor(0, numSlices, m_config.m_numThreads, 1,
+                  [&]( const uint64_t slice, const uint32_t ) {
+        const uint64_t first = slice*sliceSize;
+        const uint64_t last = std::min<uint64_t>(first + sliceSize, m_buffer.size());
+        std::sort(m_buffer.begin() + first, m_buffer.begin() + last, m_compare);
+      });
+      for( uint64_t first = 0; first < m_buffer.size(); first += sliceSize ) {
+        const uint64_t count = std::min<uint64_t>(sliceSize, m_buffer.size() - first);
+        Run run;
+        const ErrorCode error = createRun(&run);
+        if( error != ErrorCode::E_NO_ERROR ) {
+          return error;
+        }
+        m_runs.push_back(run);
+        if( fwrite(m_buffer.data() + first, sizeof(T), count, run.p_file) != count ) {
+          return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
+        }
+        m_runs.back().m_size = count;
+      }
+      m_buffer.clear();
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Merges the runs in groups of fan in runs
+     **/
+    ErrorCode mergePass() noexcept {
+      const uint64_t fanIn = std::max<uint32_t>(m_config.m_fanIn, 2);
+      std::vector<Run> merged;
+      ErrorCode error = ErrorCode::E_NO_ERROR;
+      for( uint64_t first = 0; first < m_runs.size() && error == ErrorCode::E_NO_ERROR; first += fanIn ) {
+        const uint64_t last = std::min<uint64_t>(first + fanIn, m_runs.size());
+        Run run;
+        error = createRun(&run);
+        if( error != ErrorCode::E_NO_ERROR ) {
+          break;
+        }
+        merged.push_back(run);
+        std::vector<T> block;
+        block.reserve(blockSize());
+        bool written = true;
+        auto write = [&]() {
+          written &= fwrite(block.data(), sizeof(T), block.size(), run.p_file) == block.size();
+          merged.back().m_size += block.size();
+          block.clear();
+        };
+        error = mergeRuns(first, last, [&]( const T& value ) {
+          block.push_back(value);
+          if( block.size() == blockSize() ) {
+            write();
+          }
+        });
+        write();
+        if( error == ErrorCode::E_NO_ERROR && !written ) {
+          error = ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
+        }
+      }
+      for( Run& run : m_runs ) {
+        fclose(run.p_file);
+      }
+      m_runs = std::move(merged);
+      return error;
+    }
+
+    /**
+     * K-way merge of a range of runs
+     **/
+    template<typename F>
+    ErrorCode mergeRuns( const uint64_t first, const uint64_t last, F f ) noexcept {
+      std::vector<std::unique_ptr<RunReader>> readers;
+      using Entry = std::pair<T, uint64_t>;
+      std::vector<Entry> heap;
+      // Min heap by value; equal values are taken in run order
+      auto greater = [this]( const Entry& a, const Entry& b ) {
+        return m_compare(b.first, a.first) || (!m_compare(a.first, b.first) && b.second < a.second);
+      };
+      for( uint64_t i = first; i < last; ++i ) {
+        readers.emplace_back(new RunReader(m_runs[i], blockSize()));
+        T value;
+        if( readers.back()->next(&value) ) {
+          heap.emplace_back(value, i - first);
+          std::push_heap(heap.begin(), heap.end(), greater);
+        }
+      }
+      while( !heap.empty() ) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        Entry& entry = heap.back();
+        f(entry.first);
+        if( readers[entry.second]->next(&entry.first) ) {
+          std::push_heap(heap.begin(), heap.end(), greater);
+        } else {
+          heap.pop_back();
+        }
+      }
+      for( const std::unique_ptr<RunReader>& reader : readers ) {
+        if( reader->error() ) {
+          return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_READ;
+        }
+      }
+      return ErrorCode::E_NO_ERROR;
+    }
+
+    /**
+     * Gets the number of values of an I/O block
+     **/
+    uint64_t blockSize() const noexcept {
+      return std::max<uint64_t>(m_config.m_blockBytes / sizeof(T), 1);
+    }
+
+    /**
+     * Releases the buffer and the runs
+     **/
+    void clear() noexcept {
+      for( Run& run : m_runs ) {
+        fclose(run.p_file);
+      }
+      m_runs.clear();
+      std::vector<T>().swap(m_buffer);
+      m_size = 0;
+    }
+
+    // The configuration of the sorter
+    ExternalSortConfig  m_config;
+
+    // The comparison function
+    Compare             m_compare;
+
+    // The maximum number of values in the buffer
+    uint64_t            m_capacity;
+
+    // The values not written to a run yet
+    std::vector<T>      m_buffer;
+
+    // The runs written to disk
+    std::vector<Run>    m_runs;
+
+    // The number of values pushed
+    uint64_t            m_size = 0;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_EXTERNAL_SORT_H_ */
@@ -73,29 +73,37 @@ ErrorCode FileStorage::reserve( const uint32_t& numPages, pageId_t* pageId ) noe
 }
 
 ErrorCode FileStorage::read( char* data, const pageId_t& pageId ) noexcept {
-  if(pageId == 0 || pageId >= m_size) {
+  return readPages(data, pageId, 1);
+}
+
+ErrorCode FileStorage::write( const char* data, const pageId_t& pageId ) noexcept {
+  return writePages(data, pageId, 1);
+}
+
+ErrorCode FileStorage::readPages( char* data, const pageId_t& pageId, const uint32_t& numPages ) noexcept {
+  if(pageId == 0 || numPages == 0 || pageId + numPages > m_size) {
     return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_PAGE;
   }
   m_file.seekg(pageToBytes(pageId), std::ios_base::beg);
   if(!m_file) {
     return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_PAGE;
   }
-  m_file.read(data,getPageSize());
+  m_file.read(data,pageToBytes(numPages));
   if(!m_file) {
     return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_READ;
   }
   return ErrorCode::E_NO_ERROR;
 }
 
-ErrorCode FileStorage::write( const char* data, const pageId_t& pageId ) noexcept {
-  if(pageId == 0 || pageId >= m_size) {
+ErrorCode FileStorage::writePages( const char* data, const pageId_t& pageId, const uint32_t& numPages ) noexcept {
+  if(pageId == 0 || numPages == 0 || pageId + numPages > m_size) {
     return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_PAGE;
   }
   m_file.seekp(pageToBytes(pageId), std::ios_base::beg);
   if(!m_file) {
     return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_PAGE;
   }
-  m_file.write(data,getPageSize());
+  m_file.write(data,pageToBytes(numPages));
   if(!m_file) {
     return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
   }
@@ -66,6 +66,25 @@ class FileStorage {
      **/
     ErrorCode write( const char* data, const pageId_t& pageId ) noexcept;
 
+    /**
+     * Reads a run of consecutive pages with a single request
+     * @param in data The buffer where the pages will be read. Must hold
+     * numPages pages.
+     * @param in pageId The first page to read
+     * @param in numPages The number of pages to read
+     * @return E_NO_ERROR if the pages were read
+     **/
+    ErrorCode readPages( char* data, const pageId_t& pageId, const uint32_t& numPages ) noexcept;
+
+    /**
+     * Writes a run of consecutive pages with a single request
+     * @param in data The content of the pages
+     * @param in pageId The first page to write
+     * @param in numPages The number of pages to write
+     * @return E_NO_ERROR if the pages were written
+     **/
+    ErrorCode writePages( const char* data, const pageId_t& pageId, const uint32_t& numPages ) noexcept;
+
     /**
      * Gets the current size of the storage in pages
      * @return The current size of the storage in pages
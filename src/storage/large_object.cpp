@@ -0,0 +1,202 @@
+
+
+
+#include "large_object.h"
+#include <algorithm>
+#include <cstring>
+
+SMILE_NS_BEGIN
+
+/**
+ * Gets the number of pages of an extent holding a number of bytes of an
+ * object, header included
+ **/
+static uint64_t extentPages( const uint64_t bytes, const uint32_t pageSize ) noexcept {
+  return (sizeof(LargeObjectHeader) + bytes + pageSize - 1) / pageSize;
+}
+
+LargeObjectWriter::LargeObjectWriter( FileStorage* storage, const LargeObjectConfig& config ) noexcept :
+  p_storage(storage),
+  m_config(config),
+  m_pageSize(storage->getPageSize()) {
+}
+
+ErrorCode LargeObjectWriter::begin( const uint64_t sizeHint ) noexcept {
+  const uint64_t maxPages = std::max<uint32_t>(m_config.m_maxExtentPages, 1);
+  const uint64_t numPages = sizeHint > 0 ? extentPages(sizeHint, m_pageSize) : m_config.m_firstExtentPages;
+  m_extentPages = static_cast<uint32_t>(std::min(std::max<uint64_t>(numPages, 1), maxPages));
+  const ErrorCode error = p_storage->reserve(m_extentPages, &m_extentPage);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  m_extent.assign(static_cast<uint64_t>(m_extentPages)*m_pageSize, 0);
+  m_used = 0;
+  m_first = m_extentPage;
+  m_size = 0;
+  m_firstPage.clear();
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode LargeObjectWriter::append( const char* data, const uint64_t size ) noexcept {
+  uint64_t written = 0;
+  while( written < size ) {
+    const uint64_t capacity = m_extent.size() - sizeof(LargeObjectHeader);
+    if( m_used == capacity ) {
+      // The next extent is reserved before the current one is written, so
+      // its header can point to it
+      const uint32_t nextPages = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(m_extentPages)*2,
+                                                                          std::max<uint32_t>(m_config.m_maxExtentPages, 1)));
+      pageId_t next;
+      ErrorCode error = p_storage->reserve(nextPages, &next);
+      if( error != ErrorCode::E_NO_ERROR ) {
+        return error;
+      }
+      error = flush(next, nextPages);
+      if( error != ErrorCode::E_NO_ERROR ) {
+        return error;
+      }
+      m_extentPage = next;
+      m_extentPages = nextPages;
+      m_extent.assign(static_cast<uint64_t>(m_extentPages)*m_pageSize, 0);
+      m_used = 0;
+      continue;
+    }
+    const uint64_t count = std::min(size - written, capacity - m_used);
+    memcpy(m_extent.data() + sizeof(LargeObjectHeader) + m_used, data + written, count);
+    m_used += count;
+    m_size += count;
+    written += count;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode LargeObjectWriter::finish( largeObjectId_t* id ) noexcept {
+  const bool firstExtent = m_extentPage == m_first;
+  ErrorCode error = flush(0, 0);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  if( !firstExtent ) {
+    memcpy(m_firstPage.data(), &m_size, sizeof(uint64_t));
+    error = p_storage->write(m_firstPage.data(), m_first);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+  }
+  *id = m_first;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode LargeObjectWriter::flush( const pageId_t next, const uint32_t nextPages ) noexcept {
+  const LargeObjectHeader header{m_size, next, m_used, nextPages, 0};
+  memcpy(m_extent.data(), &header, sizeof(LargeObjectHeader));
+  // Only the pages holding data are written, the rest stay zeroed
+  const uint32_t numPages = static_cast<uint32_t>(extentPages(m_used, m_pageSize));
+  const ErrorCode error = p_storage->writePages(m_extent.data(), m_extentPage, numPages);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  if( m_extentPage == m_first ) {
+    m_firstPage.assign(m_extent.begin(), m_extent.begin() + m_pageSize);
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+LargeObjectReader::LargeObjectReader( FileStorage* storage, const LargeObjectConfig& config ) noexcept :
+  p_storage(storage),
+  m_config(config),
+  m_pageSize(storage->getPageSize()) {
+  m_config.m_readAheadPages = std::max<uint32_t>(m_config.m_readAheadPages, 1);
+  m_buffer.resize(static_cast<uint64_t>(m_config.m_readAheadPages)*m_pageSize);
+}
+
+ErrorCode LargeObjectReader::open( const largeObjectId_t id, uint64_t* size ) noexcept {
+  // The size of the first extent is not known until its header is read
+  const ErrorCode error = loadExtent(id, 1);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    m_remaining = 0;
+    return error;
+  }
+  memcpy(&m_remaining, m_buffer.data(), sizeof(uint64_t));
+  *size = m_remaining;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode LargeObjectReader::read( char* data, const uint64_t size, uint64_t* numRead ) noexcept {
+  *numRead = 0;
+  while( *numRead < size && m_remaining > 0 ) {
+    if( m_position == m_end ) {
+      const ErrorCode error = fill();
+      if( error != ErrorCode::E_NO_ERROR ) {
+        return error;
+      }
+      continue;
+    }
+    const uint64_t count = std::min(std::min(size - *numRead, m_end - m_position), m_remaining);
+    memcpy(data + *numRead, m_buffer.data() + m_position, count);
+    m_position += count;
+    m_remaining -= count;
+    *numRead += count;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode LargeObjectReader::readAll( const largeObjectId_t id, std::vector<char>* data ) noexcept {
+  uint64_t size = 0;
+  ErrorCode error = open(id, &size);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  data->resize(size);
+  uint64_t numRead = 0;
+  error = read(data->data(), size, &numRead);
+  if( error == ErrorCode::E_NO_ERROR && numRead != size ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_READ;
+  }
+  return error;
+}
+
+ErrorCode LargeObjectReader::loadExtent( const pageId_t page, const uint32_t numPages ) noexcept {
+  uint32_t count = std::min(std::max<uint32_t>(numPages, 1), m_config.m_readAheadPages);
+  const ErrorCode error = p_storage->readPages(m_buffer.data(), page, count);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  LargeObjectHeader header;
+  memcpy(&header, m_buffer.data(), sizeof(LargeObjectHeader));
+  const uint32_t written = static_cast<uint32_t>(extentPages(header.m_used, m_pageSize));
+  count = std::min(count, written);
+  const uint64_t loaded = std::min<uint64_t>(header.m_used,
+                                             static_cast<uint64_t>(count)*m_pageSize - sizeof(LargeObjectHeader));
+  m_position = sizeof(LargeObjectHeader);
+  m_end = m_position + loaded;
+  m_page = page + count;
+  m_pagesLeft = written - count;
+  m_extentLeft = header.m_used - loaded;
+  m_next = header.m_next;
+  m_nextPages = header.m_nextPages;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode LargeObjectReader::fill() noexcept {
+  if( m_extentLeft > 0 ) {
+    const uint32_t count = std::min(m_pagesLeft, m_config.m_readAheadPages);
+    const ErrorCode error = p_storage->readPages(m_buffer.data(), m_page, count);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+    const uint64_t loaded = std::min<uint64_t>(m_extentLeft, static_cast<uint64_t>(count)*m_pageSize);
+    m_position = 0;
+    m_end = loaded;
+    m_extentLeft -= loaded;
+    m_page += count;
+    m_pagesLeft -= count;
+    return ErrorCode::E_NO_ERROR;
+  }
+  if( m_next != 0 ) {
+    return loadExtent(m_next, m_nextPages);
+  }
+  return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_READ;
+}
+
+SMILE_NS_END
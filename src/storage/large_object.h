@@ -0,0 +1,206 @@
+
+
+
+#ifndef _STORAGE_LARGE_OBJECT_H_
+#define _STORAGE_LARGE_OBJECT_H_
+
+#include "../base/base.h"
+#include "file_storage.h"
+#include "types.h"
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Identifier of a large object: the first page of its first extent
+ **/
+using largeObjectId_t = pageId_t;
+
+/**
+ * Header stored at the start of each extent of a large object
+ **/
+struct LargeObjectHeader {
+  // The size of the object in bytes. Only set in the first extent.
+  uint64_t  m_size;
+
+  // The first page of the next extent, or 0 if this is the last one
+  pageId_t  m_next;
+
+  // The bytes of the object stored in this extent
+  uint64_t  m_used;
+
+  // The number of pages of the next extent
+  uint32_t  m_nextPages;
+
+  uint32_t  m_reserved;
+};
+
+struct LargeObjectConfig {
+  /**
+   * Number of pages of the first extent of an object whose size is not known
+   * in advance. The following extents double in size.
+   */
+  uint32_t  m_firstExtentPages = 4;
+
+  /**
+   * Largest number of pages of an extent
+   */
+  uint32_t  m_maxExtentPages = 256;
+
+  /**
+   * Number of pages loaded by each read request of a reader. Extents are
+   * contiguous, so objects are read ahead in large sequential requests.
+   */
+  uint32_t  m_readAheadPages = 64;
+};
+
+/**
+ * Writes an object larger than a page, such as a long polyline or the edges
+ * of a hub node, in a chain of extents of consecutive pages. Each extent is
+ * reserved in one call and written with a single request. When the size of
+ * the object is known in advance, the whole object is stored in one extent.
+ **/
+class LargeObjectWriter {
+  public:
+    SMILE_NON_COPYABLE(LargeObjectWriter);
+
+    LargeObjectWriter( FileStorage* storage, const LargeObjectConfig& config = LargeObjectConfig() ) noexcept;
+    ~LargeObjectWriter() noexcept = default;
+
+    /**
+     * Starts a new object
+     * @param in sizeHint The expected size of the object in bytes, or 0 if
+     * it is not known
+     **/
+    ErrorCode begin( const uint64_t sizeHint = 0 ) noexcept;
+
+    /**
+     * Appends bytes to the object
+     * @param in data The bytes
+     * @param in size The number of bytes
+     **/
+    ErrorCode append( const char* data, const uint64_t size ) noexcept;
+
+    /**
+     * Writes the rest of the object
+     * @param out id The identifier of the object
+     **/
+    ErrorCode finish( largeObjectId_t* id ) noexcept;
+
+  private:
+
+    /**
+     * Writes the pages of the current extent holding data
+     * @param in next The first page of the next extent, or 0
+     * @param in nextPages The number of pages of the next extent
+     **/
+    ErrorCode flush( const pageId_t next, const uint32_t nextPages ) noexcept;
+
+    // The storage where the objects are written
+    FileStorage*        p_storage;
+
+    // The configuration of the writer
+    LargeObjectConfig   m_config;
+
+    // The size of the pages of the storage in bytes
+    uint32_t            m_pageSize;
+
+    // The current extent, with its header
+    std::vector<char>   m_extent;
+
+    // The first page and number of pages of the current extent
+    pageId_t            m_extentPage = 0;
+    uint32_t            m_extentPages = 0;
+
+    // The bytes of the object in the current extent
+    uint64_t            m_used = 0;
+
+    // The first page of the object, and its size so far
+    pageId_t            m_first = 0;
+    uint64_t            m_size = 0;
+
+    // The first page of the object, kept to set the size of the object once
+    // the first extent has been written
+    std::vector<char>   m_firstPage;
+};
+
+/**
+ * Streams a large object. Each extent is loaded in requests of up to
+ * m_readAheadPages consecutive pages, and the next extent of the chain is
+ * loaded with a single request sized from the header of the previous one.
+ **/
+class LargeObjectReader {
+  public:
+    SMILE_NON_COPYABLE(LargeObjectReader);
+
+    LargeObjectReader( FileStorage* storage, const LargeObjectConfig& config = LargeObjectConfig() ) noexcept;
+    ~LargeObjectReader() noexcept = default;
+
+    /**
+     * Opens an object for reading
+     * @param in id The identifier of the object
+     * @param out size The size of the object in bytes
+     **/
+    ErrorCode open( const largeObjectId_t id, uint64_t* size ) noexcept;
+
+    /**
+     * Reads the next bytes of the object
+     * @param out data The buffer where the bytes are copied
+     * @param in size The number of bytes to read
+     * @param out numRead The number of bytes read, less than size at the end
+     * of the object
+     **/
+    ErrorCode read( char* data, const uint64_t size, uint64_t* numRead ) noexcept;
+
+    /**
+     * Reads a whole object
+     * @param in id The identifier of the object
+     * @param out data The content of the object
+     **/
+    ErrorCode readAll( const largeObjectId_t id, std::vector<char>* data ) noexcept;
+
+  private:
+
+    /**
+     * Loads the first pages of an extent and its header
+     * @param in page The first page of the extent
+     * @param in numPages The number of pages of the extent
+     **/
+    ErrorCode loadExtent( const pageId_t page, const uint32_t numPages ) noexcept;
+
+    /**
+     * Loads the next pages of the object
+     **/
+    ErrorCode fill() noexcept;
+
+    // The storage where the objects are stored
+    FileStorage*        p_storage;
+
+    // The configuration of the reader
+    LargeObjectConfig   m_config;
+
+    // The size of the pages of the storage in bytes
+    uint32_t            m_pageSize;
+
+    // The loaded pages, and the range of bytes of the object not read yet
+    std::vector<char>   m_buffer;
+    uint64_t            m_position = 0;
+    uint64_t            m_end = 0;
+
+    // The next page of the current extent, the pages and the bytes of the
+    // object left to load in it
+    pageId_t            m_page = 0;
+    uint32_t            m_pagesLeft = 0;
+    uint64_t            m_extentLeft = 0;
+
+    // The first page and number of pages of the next extent
+    pageId_t            m_next = 0;
+    uint32_t            m_nextPages = 0;
+
+    // The bytes of the object not read yet
+    uint64_t            m_remaining = 0;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_LARGE_OBJECT_H_ */
@@ -0,0 +1,210 @@
+
+
+
+#include "paged_adjacency.h"
+#include <algorithm>
+#include <cstring>
+
+SMILE_NS_BEGIN
+
+PagedAdjacencyBuilder::PagedAdjacencyBuilder( FileStorage* storage,
+                                              const PagedAdjacencyConfig& config ) noexcept :
+  p_storage(storage),
+  m_config(config) {
+}
+
+ErrorCode PagedAdjacencyBuilder::begin( const uint64_t numNodes ) noexcept {
+  m_numNodes = numNodes;
+  m_numEdges = 0;
+  m_nextNode = 0;
+  for( PageWriter* writer : {&m_offsets, &m_heads} ) {
+    writer->m_page.assign(p_storage->getPageSize(), 0);
+    writer->m_used = 0;
+    writer->m_freePages = 0;
+    writer->m_pages.clear();
+  }
+  m_nodeFilters.clear();
+  if( m_config.m_bloomBitsPerKey > 0 ) {
+    // Filters are sized for the nodes of their page, all of which may have
+    // edges
+    const uint64_t perPage = p_storage->getPageSize() / sizeof(uint64_t);
+    const uint64_t numPages = (numNodes + perPage) / perPage;
+    m_nodeFilters.resize(numPages);
+    for( uint64_t page = 0; page < numPages; ++page ) {
+      m_nodeFilters[page].reset(std::min(perPage, numNodes + 1 - page*perPage), m_config.m_bloomBitsPerKey);
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode PagedAdjacencyBuilder::add( const uint32_t tail, const uint32_t head ) noexcept {
+  if( tail >= m_numNodes || head >= m_numNodes || static_cast<uint64_t>(tail) + 1 < m_nextNode ) {
+    return ErrorCode::E_STORAGE_INVALID_EDGE;
+  }
+  if( m_nextNode <= tail && !m_nodeFilters.empty() ) {
+    // First edge of the node
+    m_nodeFilters[tail / (p_storage->getPageSize() / sizeof(uint64_t))].add(tail);
+  }
+  ErrorCode error = emitOffsets(static_cast<uint64_t>(tail) + 1);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  error = append(&m_heads, head);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  ++m_numEdges;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode PagedAdjacencyBuilder::finish( PagedAdjacency* adjacency ) noexcept {
+  // The last offset closes the edges of the last node
+  ErrorCode error = emitOffsets(m_numNodes + 1);
+  if( error == ErrorCode::E_NO_ERROR && m_offsets.m_used > 0 ) {
+    error = flush(&m_offsets);
+  }
+  if( error == ErrorCode::E_NO_ERROR && m_heads.m_used > 0 ) {
+    error = flush(&m_heads);
+  }
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  adjacency->m_numNodes = m_numNodes;
+  adjacency->m_numEdges = m_numEdges;
+  adjacency->m_offsetPages = std::move(m_offsets.m_pages);
+  adjacency->m_headPages = std::move(m_heads.m_pages);
+  adjacency->m_nodeFilters = std::move(m_nodeFilters);
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode PagedAdjacencyBuilder::emitOffsets( const uint64_t node ) noexcept {
+  // The offset of a node is the number of edges added before its first edge
+  for( ; m_nextNode < node; ++m_nextNode ) {
+    const ErrorCode error = append(&m_offsets, m_numEdges);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+template<typename T>
+ErrorCode PagedAdjacencyBuilder::append( PageWriter* writer, const T& value ) noexcept {
+  memcpy(writer->m_page.data() + writer->m_used, &value, sizeof(T));
+  writer->m_used += sizeof(T);
+  if( writer->m_used + sizeof(T) > writer->m_page.size() ) {
+    return flush(writer);
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode PagedAdjacencyBuilder::flush( PageWriter* writer ) noexcept {
+  if( writer->m_freePages == 0 ) {
+    const uint32_t extent = std::max<uint32_t>(m_config.m_extentPages, 1);
+    const ErrorCode error = p_storage->reserve(extent, &writer->m_nextPage);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+    writer->m_freePages = extent;
+  }
+  const ErrorCode error = p_storage->write(writer->m_page.data(), writer->m_nextPage);
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  writer->m_pages.push_back(writer->m_nextPage);
+  ++writer->m_nextPage;
+  --writer->m_freePages;
+  writer->m_used = 0;
+  return ErrorCode::E_NO_ERROR;
+}
+
+PagedAdjacencyReader::PagedAdjacencyReader( FileStorage* storage, const PagedAdjacency* adjacency ) noexcept :
+  p_storage(storage),
+  p_adjacency(adjacency) {
+  m_offsets.m_page.resize(storage->getPageSize());
+  m_heads.m_page.resize(storage->getPageSize());
+}
+
+ErrorCode PagedAdjacencyReader::neighbors( const uint64_t node, std::vector<uint32_t>* heads ) noexcept {
+  heads->clear();
+  if( node >= p_adjacency->m_numNodes ) {
+    return ErrorCode::E_STORAGE_INVALID_EDGE;
+  }
+  const std::vector<BloomFilter>& filters = p_adjacency->m_nodeFilters;
+  if( !filters.empty() && !filters[node / (m_offsets.m_page.size() / sizeof(uint64_t))].mayContain(node) ) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  uint64_t first = 0;
+  uint64_t last = 0;
+  ErrorCode error = get(p_adjacency->m_offsetPages, &m_offsets, node, &first);
+  if( error == ErrorCode::E_NO_ERROR ) {
+    error = get(p_adjacency->m_offsetPages, &m_offsets, node + 1, &last);
+  }
+  const uint64_t perPage = m_heads.m_page.size() / sizeof(uint32_t);
+  if( error == ErrorCode::E_NO_ERROR && last > first && first / perPage != (last - 1) / perPage ) {
+    return readLongList(first, last, heads);
+  }
+  for( uint64_t e = first; e < last && error == ErrorCode::E_NO_ERROR; ++e ) {
+    uint32_t head = 0;
+    error = get(p_adjacency->m_headPages, &m_heads, e, &head);
+    heads->push_back(head);
+  }
+  return error;
+}
+
+ErrorCode PagedAdjacencyReader::readLongList( const uint64_t first,
+                                             const uint64_t last,
+                                             std::vector<uint32_t>* heads ) noexcept {
+  const std::vector<pageId_t>& pages = p_adjacency->m_headPages;
+  const uint64_t pageSize = m_heads.m_page.size();
+  const uint64_t perPage = pageSize / sizeof(uint32_t);
+  const uint64_t lastIndex = (last - 1) / perPage;
+  if( lastIndex >= pages.size() ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_PAGE;
+  }
+  heads->resize(last - first);
+  uint64_t index = first / perPage;
+  while( index <= lastIndex ) {
+    uint64_t end = index + 1;
+    while( end <= lastIndex && pages[end] == pages[end - 1] + 1 ) {
+      ++end;
+    }
+    const uint32_t numPages = static_cast<uint32_t>(end - index);
+    m_run.resize(numPages*pageSize);
+    const ErrorCode error = p_storage->readPages(m_run.data(), pages[index], numPages);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+    const uint64_t from = std::max(first, index*perPage);
+    const uint64_t to = std::min(last, end*perPage);
+    memcpy(heads->data() + (from - first), m_run.data() + (from - index*perPage)*sizeof(uint32_t), (to - from)*sizeof(uint32_t));
+    index = end;
+  }
+  // The last page is cached, as it may hold the edges of the next nodes
+  memcpy(m_heads.m_page.data(), m_run.data() + m_run.size() - pageSize, pageSize);
+  m_heads.m_index = lastIndex;
+  return ErrorCode::E_NO_ERROR;
+}
+
+template<typename T>
+ErrorCode PagedAdjacencyReader::get( const std::vector<pageId_t>& pages,
+                                     PageCache* cache,
+                                     const uint64_t i,
+                                     T* value ) noexcept {
+  const uint64_t perPage = cache->m_page.size() / sizeof(T);
+  const uint64_t index = i / perPage;
+  if( index >= pages.size() ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_PAGE;
+  }
+  if( cache->m_index != index ) {
+    const ErrorCode error = p_storage->read(cache->m_page.data(), pages[index]);
+    if( error != ErrorCode::E_NO_ERROR ) {
+      return error;
+    }
+    cache->m_index = index;
+  }
+  memcpy(value, cache->m_page.data() + (i % perPage)*sizeof(T), sizeof(T));
+  return ErrorCode::E_NO_ERROR;
+}
+
+SMILE_NS_END
@@ -0,0 +1,198 @@
+
+
+
+#ifndef _STORAGE_PAGED_ADJACENCY_H_
+#define _STORAGE_PAGED_ADJACENCY_H_
+
+#include "../base/base.h"
+#include "bloom_filter.h"
+#include "file_storage.h"
+#include "types.h"
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Compressed sparse row adjacency stored in the pages of a FileStorage. The
+ * offsets array (numNodes+1 uint64_t, the first edge of each node) and the
+ * heads array (numEdges uint32_t) are split into pages; the directories map
+ * each slice of the arrays to the page that holds it.
+ **/
+struct PagedAdjacency {
+  uint64_t              m_numNodes = 0;
+  uint64_t              m_numEdges = 0;
+
+  // The pages holding the offsets array, in order
+  std::vector<pageId_t> m_offsetPages;
+
+  // The pages holding the heads array, in order
+  std::vector<pageId_t> m_headPages;
+
+  // The Bloom filter of the nodes with edges of each page of the offsets
+  // array. Empty if the adjacency was built without filters.
+  std::vector<BloomFilter> m_nodeFilters;
+};
+
+struct PagedAdjacencyConfig {
+  /**
+   * Number of pages reserved at once for each array, so the arrays are
+   * written in large sequential extents
+   */
+  uint32_t  m_extentPages = 64;
+
+  /**
+   * Number of bits per node of the Bloom filters of the nodes with edges,
+   * which let readers skip the pages of nodes without edges. 0 disables the
+   * filters.
+   */
+  uint32_t  m_bloomBitsPerKey = kBloomBitsPerKey;
+};
+
+/**
+ * Builds a PagedAdjacency from a stream of edges sorted by tail, such as the
+ * output of an ExternalSorter. Only one page per array is kept in memory, so
+ * the adjacency can be larger than the memory.
+ **/
+class PagedAdjacencyBuilder {
+  public:
+    SMILE_NON_COPYABLE(PagedAdjacencyBuilder);
+
+    PagedAdjacencyBuilder( FileStorage* storage,
+                           const PagedAdjacencyConfig& config = PagedAdjacencyConfig() ) noexcept;
+    ~PagedAdjacencyBuilder() noexcept = default;
+
+    /**
+     * Starts building an adjacency
+     * @param in numNodes The number of nodes
+     **/
+    ErrorCode begin( const uint64_t numNodes ) noexcept;
+
+    /**
+     * Adds an edge. Edges must be added in non decreasing tail order.
+     * @param in tail The tail of the edge
+     * @param in head The head of the edge
+     * @return E_STORAGE_INVALID_EDGE if a node is out of range or the edge is
+     * not sorted
+     **/
+    ErrorCode add( const uint32_t tail, const uint32_t head ) noexcept;
+
+    /**
+     * Writes the remaining pages and returns the adjacency
+     * @param out adjacency The built adjacency
+     **/
+    ErrorCode finish( PagedAdjacency* adjacency ) noexcept;
+
+  private:
+
+    /**
+     * A page being filled, together with the extent it is written to
+     **/
+    struct PageWriter {
+      std::vector<char>     m_page;
+      uint64_t              m_used = 0;
+      pageId_t              m_nextPage = 0;
+      uint32_t              m_freePages = 0;
+      std::vector<pageId_t> m_pages;
+    };
+
+    /**
+     * Appends a value to a page, writing the page when it is full
+     **/
+    template<typename T>
+    ErrorCode append( PageWriter* writer, const T& value ) noexcept;
+
+    /**
+     * Writes the page of a writer into the next page of its extent
+     **/
+    ErrorCode flush( PageWriter* writer ) noexcept;
+
+    /**
+     * Emits the offsets of the nodes up to the given one (exclusive)
+     **/
+    ErrorCode emitOffsets( const uint64_t node ) noexcept;
+
+    // The storage where the adjacency is written
+    FileStorage*          p_storage;
+
+    // The builder configuration
+    PagedAdjacencyConfig  m_config;
+
+    // The number of nodes of the adjacency
+    uint64_t              m_numNodes = 0;
+
+    // The number of edges added so far
+    uint64_t              m_numEdges = 0;
+
+    // The next node whose offset has to be emitted
+    uint64_t              m_nextNode = 0;
+
+    // The writer of the offsets array
+    PageWriter            m_offsets;
+
+    // The writer of the heads array
+    PageWriter            m_heads;
+
+    // The filters of the nodes with edges of each offsets page
+    std::vector<BloomFilter> m_nodeFilters;
+};
+
+/**
+ * Reads the neighbors of nodes from a PagedAdjacency. The last read page of
+ * each array is cached, and the edges of hub nodes spanning several pages
+ * are read in sequential runs of pages.
+ **/
+class PagedAdjacencyReader {
+  public:
+    SMILE_NON_COPYABLE(PagedAdjacencyReader);
+
+    PagedAdjacencyReader( FileStorage* storage, const PagedAdjacency* adjacency ) noexcept;
+    ~PagedAdjacencyReader() noexcept = default;
+
+    /**
+     * Gets the heads of the edges of a node. Nodes rejected by the Bloom
+     * filters have no edges, and no page is read for them.
+     * @param in node The node
+     * @param out heads The heads of the edges leaving the node
+     * @return E_STORAGE_INVALID_EDGE if the node is out of range
+     **/
+    ErrorCode neighbors( const uint64_t node, std::vector<uint32_t>* heads ) noexcept;
+
+  private:
+
+    struct PageCache {
+      std::vector<char> m_page;
+      uint64_t          m_index = UINT64_MAX;
+    };
+
+    /**
+     * Reads the heads of a range of edges spanning several pages. Each run of
+     * consecutive pages is read with a single request.
+     **/
+    ErrorCode readLongList( const uint64_t first, const uint64_t last, std::vector<uint32_t>* heads ) noexcept;
+
+    /**
+     * Reads the i-th value of a paged array
+     **/
+    template<typename T>
+    ErrorCode get( const std::vector<pageId_t>& pages, PageCache* cache, const uint64_t i, T* value ) noexcept;
+
+    // The storage where the adjacency is stored
+    FileStorage*            p_storage;
+
+    // The adjacency being read
+    const PagedAdjacency*   p_adjacency;
+
+    // The last read page of the offsets array
+    PageCache               m_offsets;
+
+    // The last read page of the heads array
+    PageCache               m_heads;
+
+    // The consecutive pages of the heads array read at once for nodes whose
+    // edges span several pages
+    std::vector<char>       m_run;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_PAGED_ADJACENCY_H_ */
@@ -0,0 +1,200 @@
+
+
+
+#include "snapshot.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Identifies snapshot files
+ **/
+static constexpr uint64_t kSnapshotMagic = 0x544f48534e50414e; // "NAPSNHOT"
+
+/**
+ * Used to pad the sections
+ **/
+static const char kZeros[kSnapshotAlignment] = {0};
+
+/**
+ * Header stored at the beginning of the first page of a snapshot
+ **/
+struct SnapshotHeader {
+  uint64_t  m_magic;
+  uint32_t  m_version;
+  uint32_t  m_numSections;
+  uint64_t  m_directoryOffset;
+  uint64_t  m_fileSize;
+};
+
+ErrorCode SnapshotWriter::create( const std::string& path ) noexcept {
+  m_file.open(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if( !m_file ) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  m_sections.clear();
+  m_inSection = false;
+
+  // The header page is written when closing, once the directory is known
+  m_file.write(kZeros, kSnapshotAlignment);
+  m_position = kSnapshotAlignment;
+  if( !m_file ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SnapshotWriter::beginSection( const std::string& name, const uint32_t elementSize ) noexcept {
+  if( !m_file.is_open() || m_inSection ) {
+    return ErrorCode::E_STORAGE_NOT_OPEN;
+  }
+  if( name.empty() || name.size() >= kSnapshotMaxNameLength || elementSize == 0 ) {
+    return ErrorCode::E_STORAGE_INVALID_SECTION;
+  }
+  for( const SnapshotSection& section : m_sections ) {
+    if( name == section.m_name ) {
+      return ErrorCode::E_STORAGE_INVALID_SECTION;
+    }
+  }
+  SnapshotSection section;
+  memset(&section, 0, sizeof(section));
+  memcpy(section.m_name, name.c_str(), name.size());
+  section.m_offset = m_position;
+  section.m_elementSize = elementSize;
+  m_sections.push_back(section);
+  m_inSection = true;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SnapshotWriter::append( const void* data, const uint64_t size ) noexcept {
+  if( !m_inSection ) {
+    return ErrorCode::E_STORAGE_NOT_OPEN;
+  }
+  m_file.write(static_cast<const char*>(data), size);
+  if( !m_file ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
+  }
+  m_position += size;
+  m_sections.back().m_size += size;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SnapshotWriter::endSection() noexcept {
+  if( !m_inSection ) {
+    return ErrorCode::E_STORAGE_NOT_OPEN;
+  }
+  m_inSection = false;
+  pad();
+  if( !m_file ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SnapshotWriter::close() noexcept {
+  if( !m_file.is_open() || m_inSection ) {
+    return ErrorCode::E_STORAGE_NOT_OPEN;
+  }
+  SnapshotHeader header;
+  header.m_magic = kSnapshotMagic;
+  header.m_version = kSnapshotVersion;
+  header.m_numSections = static_cast<uint32_t>(m_sections.size());
+  header.m_directoryOffset = m_position;
+  header.m_fileSize = m_position + m_sections.size()*sizeof(SnapshotSection);
+  m_file.write(reinterpret_cast<const char*>(m_sections.data()), m_sections.size()*sizeof(SnapshotSection));
+  m_file.seekp(0, std::ios_base::beg);
+  m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  m_file.close();
+  if( !m_file ) {
+    return ErrorCode::E_STORAGE_OUT_OF_BOUNDS_WRITE;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+void SnapshotWriter::pad() noexcept {
+  const uint64_t padding = (kSnapshotAlignment - m_position % kSnapshotAlignment) % kSnapshotAlignment;
+  m_file.write(kZeros, padding);
+  m_position += padding;
+}
+
+Snapshot::~Snapshot() noexcept {
+  close();
+}
+
+ErrorCode Snapshot::open( const std::string& path ) noexcept {
+  close();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if( fd < 0 ) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  struct stat status;
+  if( fstat(fd, &status) != 0 ) {
+    ::close(fd);
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  const uint64_t size = static_cast<uint64_t>(status.st_size);
+  if( size < sizeof(SnapshotHeader) ) {
+    ::close(fd);
+    return ErrorCode::E_STORAGE_INVALID_SNAPSHOT;
+  }
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if( data == MAP_FAILED ) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  p_data = static_cast<char*>(data);
+  m_size = size;
+
+  SnapshotHeader header;
+  memcpy(&header, p_data, sizeof(header));
+  if( header.m_magic != kSnapshotMagic ||
+      header.m_version != kSnapshotVersion ||
+      header.m_fileSize != size ||
+      header.m_directoryOffset > size ||
+      (size - header.m_directoryOffset) / sizeof(SnapshotSection) < header.m_numSections ) {
+    close();
+    return ErrorCode::E_STORAGE_INVALID_SNAPSHOT;
+  }
+  const SnapshotSection* directory = reinterpret_cast<const SnapshotSection*>(p_data + header.m_directoryOffset);
+  for( uint32_t i = 0; i < header.m_numSections; ++i ) {
+    const SnapshotSection& section = directory[i];
+    if( section.m_offset % kSnapshotAlignment != 0 ||
+        section.m_offset > header.m_directoryOffset ||
+        section.m_size > header.m_directoryOffset - section.m_offset ||
+        section.m_name[kSnapshotMaxNameLength-1] != '\0' ) {
+      close();
+      return ErrorCode::E_STORAGE_INVALID_SNAPSHOT;
+    }
+    m_sections[section.m_name] = section;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+void Snapshot::close() noexcept {
+  if( p_data != nullptr ) {
+    munmap(p_data, m_size);
+    p_data = nullptr;
+    m_size = 0;
+  }
+  m_sections.clear();
+}
+
+ErrorCode Snapshot::section( const std::string& name,
+                             const char** data,
+                             uint64_t* size,
+                             uint32_t* elementSize ) const noexcept {
+  const auto it = m_sections.find(name);
+  if( it == m_sections.end() ) {
+    return ErrorCode::E_STORAGE_UNEXISTING_SECTION;
+  }
+  *data = p_data + it->second.m_offset;
+  *size = it->second.m_size;
+  *elementSize = it->second.m_elementSize;
+  return ErrorCode::E_NO_ERROR;
+}
+
+SMILE_NS_END
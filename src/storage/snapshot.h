@@ -0,0 +1,220 @@
+
+
+
+#ifndef _STORAGE_SNAPSHOT_H_
+#define _STORAGE_SNAPSHOT_H_
+
+#include "../base/base.h"
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Version of the snapshot format. Snapshots of other versions are rejected.
+ **/
+constexpr uint32_t kSnapshotVersion = 1;
+
+/**
+ * Alignment in bytes of the sections of a snapshot
+ **/
+constexpr uint64_t kSnapshotAlignment = 4096;
+
+/**
+ * Maximum length of the name of a section, including the null terminator
+ **/
+constexpr uint32_t kSnapshotMaxNameLength = 48;
+
+/**
+ * Entry of the directory of a snapshot
+ **/
+struct SnapshotSection {
+  char      m_name[kSnapshotMaxNameLength];
+  uint64_t  m_offset;
+  uint64_t  m_size;
+  uint32_t  m_elementSize;
+  uint32_t  m_padding;
+};
+
+/**
+ * Writes a snapshot file: a set of named binary sections (columns, adjacency
+ * arrays, weights...). The file starts with a header page, followed by the
+ * sections, each one aligned to kSnapshotAlignment so it can be memory mapped
+ * and accessed in place, and ends with the directory of the sections.
+ **/
+class SnapshotWriter {
+  public:
+    SMILE_NON_COPYABLE(SnapshotWriter);
+
+    SnapshotWriter() noexcept = default;
+    ~SnapshotWriter() noexcept = default;
+
+    /**
+     * Creates a snapshot file, overwriting it if it exists
+     * @param in path The path of the file
+     * @return E_STORAGE_INVALID_PATH if the file cannot be created
+     **/
+    ErrorCode create( const std::string& path ) noexcept;
+
+    /**
+     * Starts a new section. The data of the section is written with append.
+     * @param in name The name of the section
+     * @param in elementSize The size in bytes of the elements of the section
+     * @return E_STORAGE_INVALID_SECTION if the name is too long or already
+     * used, E_STORAGE_NOT_OPEN if the snapshot is not being written
+     **/
+    ErrorCode beginSection( const std::string& name, const uint32_t elementSize ) noexcept;
+
+    /**
+     * Appends data to the current section
+     * @param in data The data to append
+     * @param in size The size of the data in bytes
+     **/
+    ErrorCode append( const void* data, const uint64_t size ) noexcept;
+
+    /**
+     * Finishes the current section
+     **/
+    ErrorCode endSection() noexcept;
+
+    /**
+     * Writes a whole section from an array
+     * @param in name The name of the section
+     * @param in data The elements of the section
+     * @param in count The number of elements
+     **/
+    template<typename T>
+    ErrorCode addSection( const std::string& name, const T* data, const uint64_t count ) noexcept {
+      ErrorCode error = beginSection(name, sizeof(T));
+      if( error != ErrorCode::E_NO_ERROR ) {
+        return error;
+      }
+      error = append(data, count*sizeof(T));
+      if( error != ErrorCode::E_NO_ERROR ) {
+        return error;
+      }
+      return endSection();
+    }
+
+    /**
+     * Writes the directory and the header, and closes the file
+     **/
+    ErrorCode close() noexcept;
+
+  private:
+
+    /**
+     * Writes zeros up to the next multiple of kSnapshotAlignment
+     **/
+    void pad() noexcept;
+
+    // The file being written
+    std::ofstream                 m_file;
+
+    // The current position in the file
+    uint64_t                      m_position = 0;
+
+    // The sections written so far. The last one is the current section if
+    // m_inSection is true.
+    std::vector<SnapshotSection>  m_sections;
+
+    // Whether a section is being written
+    bool                          m_inSection = false;
+};
+
+/**
+ * Read only, memory mapped snapshot file. Sections are accessed in place:
+ * opening a snapshot only reads its header and its directory, and pages are
+ * loaded on demand by the operating system when they are accessed. The
+ * pointers to the sections are valid while the snapshot is open.
+ **/
+class Snapshot {
+  public:
+    SMILE_NON_COPYABLE(Snapshot);
+
+    Snapshot() noexcept = default;
+    ~Snapshot() noexcept;
+
+    /**
+     * Opens a snapshot file
+     * @param in path The path of the file
+     * @return E_STORAGE_INVALID_PATH if the file cannot be opened and
+     * E_STORAGE_INVALID_SNAPSHOT if it is not a valid snapshot of this
+     * version
+     **/
+    ErrorCode open( const std::string& path ) noexcept;
+
+    /**
+     * Closes the snapshot, unmapping the file
+     **/
+    void close() noexcept;
+
+    /**
+     * Gets the number of sections of the snapshot
+     **/
+    uint32_t numSections() const noexcept {
+      return static_cast<uint32_t>(m_sections.size());
+    }
+
+    /**
+     * Tells if the snapshot has a section
+     **/
+    bool contains( const std::string& name ) const noexcept {
+      return m_sections.find(name) != m_sections.end();
+    }
+
+    /**
+     * Gets the raw data of a section
+     * @param in name The name of the section
+     * @param out data The first byte of the section
+     * @param out size The size of the section in bytes
+     * @param out elementSize The size of the elements of the section
+     * @return E_STORAGE_UNEXISTING_SECTION if there is no such section
+     **/
+    ErrorCode section( const std::string& name,
+                       const char** data,
+                       uint64_t* size,
+                       uint32_t* elementSize ) const noexcept;
+
+    /**
+     * Gets the elements of a section
+     * @param in name The name of the section
+     * @param out data The first element of the section
+     * @param out count The number of elements of the section
+     * @return E_STORAGE_UNEXISTING_SECTION if there is no such section and
+     * E_STORAGE_INVALID_SECTION if its elements are not of the size of T
+     **/
+    template<typename T>
+    ErrorCode section( const std::string& name, const T** data, uint64_t* count ) const noexcept {
+      const char* bytes = nullptr;
+      uint64_t size = 0;
+      uint32_t elementSize = 0;
+      const ErrorCode error = section(name, &bytes, &size, &elementSize);
+      if( error != ErrorCode::E_NO_ERROR ) {
+        return error;
+      }
+      if( elementSize != sizeof(T) || size % sizeof(T) != 0 ) {
+        return ErrorCode::E_STORAGE_INVALID_SECTION;
+      }
+      *data = reinterpret_cast<const T*>(bytes);
+      *count = size / sizeof(T);
+      return ErrorCode::E_NO_ERROR;
+    }
+
+  private:
+
+    // The mapped file
+    char*                                   p_data = nullptr;
+
+    // The size of the mapped file
+    uint64_t                                m_size = 0;
+
+    // The directory of the snapshot, indexed by name
+    std::map<std::string, SnapshotSection>  m_sections;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_SNAPSHOT_H_ */
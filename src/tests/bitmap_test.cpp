@@ -0,0 +1,131 @@
+
+
+
+#include <gtest/gtest.h>
+#include <data/bitmap.h>
+#include <random>
+
+SMILE_NS_BEGIN
+
+static const uint64_t kUniverse = 5*65536 + 1234;
+
+/**
+ * Builds a bitmap and its reference with a density per chunk, so that both
+ * array and dense containers are used
+ */
+static void build( const uint32_t seed,
+                   const std::vector<double>& densities,
+                   Bitmap* bitmap,
+                   std::vector<bool>* reference ) {
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  reference->assign(kUniverse, false);
+  std::vector<oid_t> oids;
+  for( oid_t oid = 0; oid < kUniverse; ++oid ) {
+    if( uniform(random) < densities[oid >> 16] ) {
+      oids.push_back(oid);
+      (*reference)[oid] = true;
+    }
+  }
+  // Oids are added out of order
+  std::shuffle(oids.begin(), oids.end(), random);
+  for( const oid_t oid : oids ) {
+    bitmap->add(oid);
+  }
+}
+
+static void check( const Bitmap& bitmap, const std::vector<bool>& reference ) {
+  std::vector<oid_t> expected;
+  for( oid_t oid = 0; oid < kUniverse; ++oid ) {
+    if( reference[oid] ) {
+      expected.push_back(oid);
+    }
+  }
+  ASSERT_TRUE(bitmap.count() == expected.size());
+  std::vector<oid_t> oids;
+  bitmap.toOids(&oids);
+  ASSERT_TRUE(oids == expected);
+
+  // Iteration in batches of an odd size
+  BitmapCursor cursor(&bitmap);
+  oids.clear();
+  oid_t batch[77];
+  uint32_t count = 0;
+  while( (count = cursor.next(batch, 77)) > 0 ) {
+    oids.insert(oids.end(), batch, batch + count);
+  }
+  ASSERT_TRUE(oids == expected);
+  for( oid_t oid = 0; oid < kUniverse; oid += 7 ) {
+    ASSERT_TRUE(bitmap.contains(oid) == reference[oid]);
+  }
+}
+
+/**
+ * Tests adding oids and iterating over sparse and dense chunks
+ */
+TEST(BitmapTest, Build) {
+  Bitmap bitmap;
+  std::vector<bool> reference;
+  build(1, {0.001, 0.5, 0.0, 0.05, 1.0, 0.9}, &bitmap, &reference);
+  check(bitmap, reference);
+  bitmap.add(3);
+  bitmap.add(3);
+  reference[3] = true;
+  check(bitmap, reference);
+}
+
+/**
+ * Tests intersections, unions, differences and complements against the
+ * same operations on the references
+ */
+TEST(BitmapTest, SetAlgebra) {
+  Bitmap a;
+  Bitmap b;
+  std::vector<bool> ra;
+  std::vector<bool> rb;
+  build(2, {0.01, 0.6, 0.3, 0.0, 0.9, 0.02}, &a, &ra);
+  build(3, {0.5, 0.05, 0.3, 0.7, 0.0, 0.02}, &b, &rb);
+  std::vector<bool> expected(kUniverse);
+
+  Bitmap result(a);
+  result.intersect(b);
+  for( oid_t oid = 0; oid < kUniverse; ++oid ) {
+    expected[oid] = ra[oid] && rb[oid];
+  }
+  check(result, expected);
+
+  result = a;
+  result.unite(b);
+  for( oid_t oid = 0; oid < kUniverse; ++oid ) {
+    expected[oid] = ra[oid] || rb[oid];
+  }
+  check(result, expected);
+
+  result = a;
+  result.subtract(b);
+  for( oid_t oid = 0; oid < kUniverse; ++oid ) {
+    expected[oid] = ra[oid] && !rb[oid];
+  }
+  check(result, expected);
+
+  result = a;
+  result.complement(kUniverse);
+  for( oid_t oid = 0; oid < kUniverse; ++oid ) {
+    expected[oid] = !ra[oid];
+  }
+  check(result, expected);
+
+  Bitmap empty;
+  empty.complement(kUniverse);
+  ASSERT_TRUE(empty.count() == kUniverse);
+  empty.subtract(empty);
+  ASSERT_TRUE(empty.empty());
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,129 @@
+
+
+
+#include <gtest/gtest.h>
+#include <storage/bloom_filter.h>
+#include <memory/buffer_pool.h>
+#include <cstring>
+#include <random>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests that added keys are always found, and that the false positive rate
+ * of absent keys is close to the expected one
+ */
+TEST(BloomFilterTest, FalsePositives) {
+  std::mt19937_64 random(5);
+  const uint64_t numKeys = 100000;
+  BloomFilter filter(numKeys);
+  std::vector<uint64_t> keys;
+  for( uint64_t i = 0; i < numKeys; ++i ) {
+    keys.push_back(random());
+    filter.add(keys.back());
+  }
+  for( const uint64_t key : keys ) {
+    ASSERT_TRUE(filter.mayContain(key));
+  }
+  uint64_t falsePositives = 0;
+  for( uint64_t i = 0; i < numKeys; ++i ) {
+    falsePositives += filter.mayContain(random()) ? 1 : 0;
+  }
+  ASSERT_TRUE(falsePositives < numKeys / 50);
+  ASSERT_TRUE(filter.sizeBytes() == (numKeys*kBloomBitsPerKey + 511) / 512 * 64);
+
+  // Dense keys, such as oids, are spread as well
+  BloomFilter dense(numKeys);
+  for( uint64_t key = 0; key < numKeys; ++key ) {
+    dense.add(key);
+  }
+  falsePositives = 0;
+  for( uint64_t key = numKeys; key < 2*numKeys; ++key ) {
+    falsePositives += dense.mayContain(key) ? 1 : 0;
+  }
+  ASSERT_TRUE(falsePositives < numKeys / 50);
+}
+
+/**
+ * Tests that filters that were never sized contain every key, and sized
+ * empty filters none
+ */
+TEST(BloomFilterTest, EmptyFilters) {
+  BloomFilter unsized;
+  ASSERT_TRUE(unsized.mayContain(42));
+  BloomFilter empty(0);
+  ASSERT_FALSE(empty.mayContain(42));
+
+  PageFilters filters;
+  ASSERT_TRUE(filters.mayContain(3, 42));
+  filters.build(3, nullptr, 0);
+  ASSERT_FALSE(filters.mayContain(3, 42));
+  filters.erase(3);
+  ASSERT_TRUE(filters.mayContain(3, 42));
+}
+
+/**
+ * Tests rebuilding the filters of pages when the buffer pool writes them.
+ * Each page stores a count followed by that many keys. Absent keys are then
+ * rejected without pinning the pages.
+ */
+TEST(BloomFilterTest, CheckpointHook) {
+  FileStorage storage;
+  ASSERT_TRUE(storage.create("./test_bloom.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  BufferPool pool(&storage, BufferPoolConfig{256});
+  PageFilters filters;
+  uint32_t numWrites = 0;
+  pool.setWriteHook([&]( const pageId_t page, const char* data ) {
+    uint64_t count;
+    memcpy(&count, data, sizeof(uint64_t));
+    filters.build(page, reinterpret_cast<const uint64_t*>(data) + 1, count);
+    ++numWrites;
+  });
+
+  // Eight pages with keys page*1000 + 2*i, in a pool of four slots
+  std::vector<pageId_t> pages;
+  for( uint64_t p = 0; p < 8; ++p ) {
+    BufferHandler handler;
+    ASSERT_TRUE(pool.alloc(&handler) == ErrorCode::E_NO_ERROR);
+    const uint64_t count = 500;
+    memcpy(handler.m_buffer, &count, sizeof(uint64_t));
+    for( uint64_t i = 0; i < count; ++i ) {
+      const uint64_t key = p*1000 + 2*i;
+      memcpy(handler.m_buffer + (i + 1)*sizeof(uint64_t), &key, sizeof(uint64_t));
+    }
+    pool.setPageDirty(handler.m_pId);
+    ASSERT_TRUE(pool.unpin(handler.m_pId) == ErrorCode::E_NO_ERROR);
+    pages.push_back(handler.m_pId);
+  }
+  ASSERT_TRUE(pool.checkpoint() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(numWrites == 8);
+  ASSERT_TRUE(pool.checkpoint() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(numWrites == 8);
+
+  uint32_t rejected = 0;
+  for( uint64_t p = 0; p < 8; ++p ) {
+    for( uint64_t i = 0; i < 500; ++i ) {
+      ASSERT_TRUE(filters.mayContain(pages[p], p*1000 + 2*i));
+      rejected += filters.mayContain(pages[p], p*1000 + 2*i + 1) ? 0 : 1;
+    }
+  }
+  ASSERT_TRUE(rejected > 0.95 * 8 * 500);
+
+  pool.setWriteHook(nullptr);
+  BufferHandler handler;
+  ASSERT_TRUE(pool.pin(pages[0], &handler) == ErrorCode::E_NO_ERROR);
+  pool.setPageDirty(pages[0]);
+  ASSERT_TRUE(pool.unpin(pages[0]) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(pool.checkpoint() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(numWrites == 8);
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
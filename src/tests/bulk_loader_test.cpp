@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+#include <loader/bulk_loader.h>
+#include <data/planner.h>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests loading an edge list with a header, in small chunks parsed by
+ * several threads. The rows must be loaded in file order, also when they span
+ * several blocks of the tables. A second file is appended after the first one.
+ */
+TEST(BulkLoaderTest, BulkLoaderEdgeList) {
+  const uint64_t numRows = 50000;
+  {
+    std::ofstream file("./test.csv");
+    file << "tail,head,length,speed,name\n";
+    for( uint64_t i = 0; i < numRows; ++i ) {
+      file << i << "," << (i*7) % numRows << "," << -static_cast<int64_t>(i) << "," << i*0.5 << ",street" << i % 10 << "\n";
+    }
+  }
+
+  BulkLoaderConfig config;
+  config.m_skipHeader = true;
+  config.m_numThreads = 4;
+  config.m_chunkSize = 4096;
+  BulkLoader loader({AttributeDataType::E_UNSIGNED_LONG,
+                     AttributeDataType::E_UNSIGNED_INT,
+                     AttributeDataType::E_LONG,
+                     AttributeDataType::E_DOUBLE,
+                     AttributeDataType::E_STRING}, config);
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loader.numRows() == numRows);
+  ASSERT_TRUE(loader.numColumns() == 5);
+
+  const Table<uint64_t>* tails = loader.column<uint64_t>(0);
+  const Table<uint32_t>* heads = loader.column<uint32_t>(1);
+  const Table<int64_t>* lengths = loader.column<int64_t>(2);
+  const Table<double>* speeds = loader.column<double>(3);
+  const Table<std::string>* names = loader.column<std::string>(4);
+  ASSERT_TRUE(tails != nullptr && heads != nullptr && lengths != nullptr && speeds != nullptr && names != nullptr);
+  ASSERT_TRUE(loader.column<uint32_t>(0) == nullptr);
+  ASSERT_TRUE(loader.column<uint64_t>(5) == nullptr);
+  ASSERT_TRUE(tails->size() == numRows);
+  for( uint64_t i = 0; i < numRows; ++i ) {
+    ASSERT_TRUE(tails->get(i) == i);
+    ASSERT_TRUE(heads->get(i) == (i*7) % numRows);
+    ASSERT_TRUE(lengths->get(i) == -static_cast<int64_t>(i));
+    ASSERT_TRUE(speeds->get(i) == i*0.5);
+  }
+  ASSERT_TRUE(names->get(numRows - 1) == "street9");
+
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loader.numRows() == 2*numRows);
+  ASSERT_TRUE(tails->size() == 2*numRows);
+  ASSERT_TRUE(tails->get(numRows + 3) == 3);
+}
+
+/**
+ * Tests the parsing of the different data types, separators, line endings and
+ * empty lines.
+ */
+TEST(BulkLoaderTest, BulkLoaderTypes) {
+  {
+    std::ofstream file("./test.csv");
+    file << "true|-2147483648|4294967295|1.5|1000\r\n";
+    file << "\n";
+    file << "0|+7|0|-2e3|0";
+  }
+  BulkLoaderConfig config;
+  config.m_separator = '|';
+  BulkLoader loader({AttributeDataType::E_BOOL,
+                     AttributeDataType::E_INT,
+                     AttributeDataType::E_UNSIGNED_INT,
+                     AttributeDataType::E_FLOAT,
+                     AttributeDataType::E_TIMESTAMP}, config);
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loader.numRows() == 2);
+  ASSERT_TRUE(loader.column<bool>(0)->get(0) == true);
+  ASSERT_TRUE(loader.column<bool>(0)->get(1) == false);
+  ASSERT_TRUE(loader.column<int32_t>(1)->get(0) == std::numeric_limits<int32_t>::min());
+  ASSERT_TRUE(loader.column<int32_t>(1)->get(1) == 7);
+  ASSERT_TRUE(loader.column<uint32_t>(2)->get(0) == std::numeric_limits<uint32_t>::max());
+  ASSERT_TRUE(loader.column<float>(3)->get(0) == 1.5f);
+  ASSERT_TRUE(loader.column<float>(3)->get(1) == -2000.0f);
+  ASSERT_TRUE(loader.column<timestamp>(4)->get(0) == timestamp{1000});
+}
+
+/**
+ * Tests that invalid files are reported and do not load any row.
+ */
+TEST(BulkLoaderTest, BulkLoaderErrors) {
+  BulkLoader loader({AttributeDataType::E_UNSIGNED_INT, AttributeDataType::E_INT});
+  ASSERT_TRUE(loader.load("./unexisting.csv") == ErrorCode::E_STORAGE_INVALID_PATH);
+
+  {
+    std::ofstream file("./test.csv");
+    file << "1,2\n3,4\n5\n";
+  }
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_LOADER_INVALID_NUM_COLUMNS);
+  {
+    std::ofstream file("./test.csv");
+    file << "1,2\n3,4,5\n";
+  }
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_LOADER_INVALID_NUM_COLUMNS);
+  {
+    std::ofstream file("./test.csv");
+    file << "1,2\n-3,4\n";
+  }
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_LOADER_INVALID_VALUE);
+  {
+    std::ofstream file("./test.csv");
+    file << "4294967296,2\n";
+  }
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_LOADER_INVALID_VALUE);
+  ASSERT_TRUE(loader.numRows() == 0);
+  ASSERT_TRUE(loader.column<uint32_t>(0)->size() == 0);
+
+  {
+    std::ofstream file("./test.csv");
+    file << "1,-2\n";
+  }
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loader.numRows() == 1);
+  ASSERT_TRUE(loader.column<int32_t>(1)->get(0) == -2);
+}
+
+/**
+ * Tests the statistics collected while loading, over two files
+ */
+TEST(BulkLoaderTest, BulkLoaderStatistics) {
+  {
+    std::ofstream file("./test.csv");
+    for( uint64_t i = 0; i < 10000; ++i ) {
+      file << i % 100 << ",name" << i % 10 << "\n";
+    }
+  }
+  BulkLoaderConfig config;
+  config.m_numThreads = 2;
+  config.m_chunkSize = 4096;
+  BulkLoader plain({AttributeDataType::E_INT, AttributeDataType::E_STRING});
+  ASSERT_TRUE(plain.load("./test.csv") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(plain.statistics(0) == nullptr);
+
+  config.m_collectStatistics = true;
+  BulkLoader loader({AttributeDataType::E_INT, AttributeDataType::E_STRING}, config);
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_NO_ERROR);
+  const AttributeStatistics* values = loader.statistics(0);
+  const AttributeStatistics* names = loader.statistics(1);
+  ASSERT_TRUE(values != nullptr && names != nullptr);
+  ASSERT_TRUE(loader.statistics(2) == nullptr);
+  ASSERT_TRUE(values->m_numRows == 20000 && names->m_numRows == 20000);
+  ASSERT_TRUE(values->m_numDistinct == 100.0);
+  ASSERT_TRUE(values->m_min == 0.0 && values->m_max == 99.0);
+  ASSERT_TRUE(std::fabs(values->selectivity(Condition::E_SMALLER, 50) - 0.5) < 0.02);
+  ASSERT_TRUE(std::fabs(names->m_numDistinct - 10.0) < 1.0);
+}
+
+/**
+ * Tests loading string columns as codes of the global string pool
+ */
+TEST(BulkLoaderTest, BulkLoaderInternedStrings) {
+  {
+    std::ofstream file("./test.csv");
+    for( uint64_t i = 0; i < 20000; ++i ) {
+      file << i << ",street" << i % 50 << "\n";
+    }
+  }
+  BulkLoaderConfig config;
+  config.m_numThreads = 4;
+  config.m_chunkSize = 4096;
+  config.m_internStrings = true;
+  BulkLoader loader({AttributeDataType::E_UNSIGNED_INT, AttributeDataType::E_STRING}, config);
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loader.column<std::string>(1) == nullptr);
+  ASSERT_TRUE(loader.internedColumn(0) == nullptr);
+  const Table<strid_t>* names = loader.internedColumn(1);
+  ASSERT_TRUE(names != nullptr && names->size() == 20000);
+  const StringPool& pool = StringPool::global();
+  for( uint64_t i = 0; i < 20000; ++i ) {
+    ASSERT_TRUE(pool.get(names->get(i)) == "street" + std::to_string(i % 50));
+    ASSERT_TRUE(names->get(i) == names->get(i % 50));
+  }
+}
+
+/**
+ * Tests loading into the tables of a catalog, with the names resolved once
+ * when the loader is bound, and selecting from them through tables resolved
+ * when the query is set up
+ */
+TEST(BulkLoaderTest, BulkLoaderCatalog) {
+  {
+    std::ofstream file("./test.csv");
+    for( uint64_t i = 0; i < 20000; ++i ) {
+      file << i << "," << i % 90 << ",person" << i << "\n";
+    }
+  }
+  Catalog catalog;
+  typeid_t person = 0;
+  attributeid_t attribute = 0;
+  ASSERT_TRUE(catalog.addNodeType("Person", &person) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addAttribute(person, "name", AttributeDataType::E_STRING, false, &attribute) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addAttribute(person, "id", AttributeDataType::E_UNSIGNED_LONG, false, &attribute) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addAttribute(person, "age", AttributeDataType::E_INT, false, &attribute) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addAttribute(person, "score", AttributeDataType::E_DOUBLE, false, &attribute) == ErrorCode::E_NO_ERROR);
+
+  BulkLoaderConfig config;
+  config.m_numThreads = 4;
+  config.m_chunkSize = 4096;
+  config.m_collectStatistics = true;
+  BulkLoader loader({AttributeDataType::E_UNSIGNED_LONG, AttributeDataType::E_INT, AttributeDataType::E_STRING}, config);
+  ASSERT_TRUE(loader.bind(&catalog, "Person", {"id", "age"}) == ErrorCode::E_LOADER_INVALID_NUM_COLUMNS);
+  ASSERT_TRUE(loader.bind(&catalog, "City", {"id", "age", "name"}) == ErrorCode::E_GRAPH_INVALID_TYPE);
+  ASSERT_TRUE(loader.bind(&catalog, "Person", {"id", "height", "name"}) == ErrorCode::E_GRAPH_UNEXISTING_ATTRIBUTE_TYPE);
+  ASSERT_TRUE(loader.bind(&catalog, "Person", {"id", "score", "name"}) == ErrorCode::E_GRAPH_ATTRIBUTE_DATA_TYPE_MISSMATCH);
+  ASSERT_TRUE(loader.bind(&catalog, "Person", {"id", "age", "id"}) == ErrorCode::E_GRAPH_ATTRIBUTE_DATA_TYPE_MISSMATCH);
+  ASSERT_TRUE(loader.column<int32_t>(1) != nullptr);
+  BulkLoaderConfig interned;
+  interned.m_internStrings = true;
+  BulkLoader codes({AttributeDataType::E_STRING}, interned);
+  ASSERT_TRUE(codes.bind(&catalog, "Person", {"name"}) == ErrorCode::E_GRAPH_ATTRIBUTE_DATA_TYPE_MISSMATCH);
+  ASSERT_TRUE(loader.bind(&catalog, "Person", {"id", "age", "name"}) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loader.load("./test.csv") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loader.numRows() == 20000);
+  ASSERT_TRUE(loader.column<int32_t>(1) == nullptr);
+  ASSERT_TRUE(loader.statistics(1)->m_numRows == 20000);
+
+  const Catalog& query = catalog;
+  const ITypedTable<uint64_t>* ids = nullptr;
+  const ITypedTable<int32_t>* ages = nullptr;
+  const ITypedTable<std::string>* names = nullptr;
+  const ITypedTable<double>* scores = nullptr;
+  ASSERT_TRUE(query.resolveTable("Person", "id", &ids) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(query.resolveTable("Person", "age", &ages) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(query.resolveTable("Person", "name", &names) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(query.resolveTable("Person", "score", &scores) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(ids->size() == 20000 && ages->size() == 20000 && names->size() == 20000);
+  ASSERT_TRUE(scores->size() == 0);
+  for( uint64_t i = 0; i < 20000; ++i ) {
+    ASSERT_TRUE(ids->get(i) == i);
+    ASSERT_TRUE(ages->get(i) == static_cast<int32_t>(i % 90));
+    ASSERT_TRUE(names->get(i) == "person" + std::to_string(i));
+  }
+
+  ColumnPredicate<int32_t> young(ages, Condition::E_SMALLER, 18, loader.statistics(1));
+  std::unique_ptr<ICursor> cursor = openSelection(planSelection({&young}), {&young});
+  std::vector<oid_t> oids;
+  materialize(cursor.get(), &oids);
+  uint64_t expected = 0;
+  for( uint64_t i = 0; i < 20000; ++i ) {
+    expected += i % 90 < 18 ? 1 : 0;
+  }
+  ASSERT_TRUE(oids.size() == expected);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,71 @@
+
+
+
+#include <gtest/gtest.h>
+#include <data/catalog.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests adding and resolving types and attributes
+ */
+TEST(CatalogTest, Resolve) {
+  Catalog catalog;
+  typeid_t person = 0;
+  typeid_t knows = 0;
+  ASSERT_TRUE(catalog.addNodeType("Person", &person) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addEdgeType("knows", Direction::E_UNDIRECTED, &knows) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addNodeType("Person", &person) == ErrorCode::E_GRAPH_EXISTING_TYPE);
+  ASSERT_TRUE(person == 0 && knows == 1 && catalog.numTypes() == 2);
+  ASSERT_TRUE(!catalog.type(person).m_isEdgeType && catalog.type(knows).m_isEdgeType);
+
+  attributeid_t name = 0;
+  attributeid_t age = 0;
+  attributeid_t since = 0;
+  ASSERT_TRUE(catalog.addAttribute(person, "name", AttributeDataType::E_STRING, true, &name) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addAttribute(person, "age", AttributeDataType::E_INT, false, &age) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addAttribute(knows, "since", AttributeDataType::E_TIMESTAMP, false, &since) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addAttribute(person, "age", AttributeDataType::E_INT, false, &age) == ErrorCode::E_GRAPH_EXISTING_ATTRIBUTE_TYPE);
+  ASSERT_TRUE(catalog.addAttribute(7, "age", AttributeDataType::E_INT, false, &age) == ErrorCode::E_GRAPH_INVALID_TYPE);
+  ASSERT_TRUE(name == 0 && age == 1 && since == 0);
+
+  AttributeRef ref;
+  ASSERT_TRUE(catalog.resolve("Person", "age", &ref) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(ref.m_type == person && ref.m_attribute == age);
+  ASSERT_TRUE(catalog.attribute(ref).m_name == "age");
+  ASSERT_TRUE(catalog.attribute(ref).m_dataType == AttributeDataType::E_INT);
+  ASSERT_TRUE(catalog.resolve("City", "age", &ref) == ErrorCode::E_GRAPH_INVALID_TYPE);
+  ASSERT_TRUE(catalog.resolve("knows", "age", &ref) == ErrorCode::E_GRAPH_UNEXISTING_ATTRIBUTE_TYPE);
+  ASSERT_TRUE(catalog.type(person).m_attributes.size() == 2);
+}
+
+/**
+ * Tests that resolved tables are shared by every access to the attribute
+ */
+TEST(CatalogTest, Tables) {
+  Catalog catalog;
+  typeid_t person = 0;
+  attributeid_t age = 0;
+  ASSERT_TRUE(catalog.addNodeType("Person", &person) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(catalog.addAttribute(person, "age", AttributeDataType::E_INT, false, &age) == ErrorCode::E_NO_ERROR);
+
+  ITypedTable<int32_t>* ages = nullptr;
+  ASSERT_TRUE(catalog.resolveTable("Person", "age", &ages) == ErrorCode::E_NO_ERROR);
+  for( int32_t i = 0; i < 100; ++i ) {
+    ages->append(i);
+  }
+  const ITypedTable<int32_t>* same = catalog.table<int32_t>(AttributeRef{person, age});
+  ASSERT_TRUE(same == ages && same->size() == 100 && same->get(42) == 42);
+
+  ITypedTable<double>* wrong = nullptr;
+  ASSERT_TRUE(catalog.resolveTable("Person", "age", &wrong) == ErrorCode::E_GRAPH_ATTRIBUTE_DATA_TYPE_MISSMATCH);
+  ASSERT_TRUE(wrong == nullptr);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <routing/contraction_hierarchy.h>
+#include <routing/dijkstra.h>
+#include <random>
+
+SMILE_NS_BEGIN
+
+/**
+ * Builds a directed grid of size x size nodes with some random diagonals and
+ * some one way streets.
+ */
+static void buildGrid( const nodeId_t size, std::mt19937& generator, RoutingGraph* graph ) {
+  std::vector<RoutingEdge> edges;
+  std::bernoulli_distribution oneWay(0.2);
+  std::bernoulli_distribution diagonal(0.1);
+  auto add = [&]( nodeId_t a, nodeId_t b ) {
+    edges.push_back(RoutingEdge{a, b});
+    if( !oneWay(generator) ) {
+      edges.push_back(RoutingEdge{b, a});
+    }
+  };
+  for( nodeId_t i = 0; i < size; ++i ) {
+    for( nodeId_t j = 0; j < size; ++j ) {
+      const nodeId_t node = i*size + j;
+      if( j + 1 < size ) add(node, node + 1);
+      if( i + 1 < size ) add(node, node + size);
+      if( i + 1 < size && j + 1 < size && diagonal(generator) ) add(node, node + size + 1);
+    }
+  }
+  ASSERT_TRUE(graph->build(size*size, edges) == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Checks the distances and paths of the hierarchy against Dijkstra from a few
+ * sources to all targets.
+ */
+static void checkQueries( const RoutingGraph& graph,
+                          const ContractionHierarchy& hierarchy,
+                          const Metric& metric ) {
+  Dijkstra dijkstra(&graph);
+  ContractionHierarchyQuery query(&hierarchy);
+  std::vector<nodeId_t> path;
+  for( nodeId_t source = 0; source < graph.numNodes(); source += 37 ) {
+    ASSERT_TRUE(dijkstra.run(source, metric) == ErrorCode::E_NO_ERROR);
+    for( nodeId_t target = 0; target < graph.numNodes(); ++target ) {
+      ASSERT_TRUE(query.run(source, target) == ErrorCode::E_NO_ERROR);
+      ASSERT_EQ(query.distance(), dijkstra.distance(target));
+      if( query.distance() == kInfiniteWeight ) {
+        continue;
+      }
+      query.path(metric, &path);
+      ASSERT_TRUE(path.front() == source && path.back() == target);
+      weight_t length = 0;
+      for( uint64_t i = 1; i < path.size(); ++i ) {
+        weight_t best = kInfiniteWeight;
+        for( edgeId_t e = graph.firstOut(path[i-1]); e < graph.endOut(path[i-1]); ++e ) {
+          if( graph.head(e) == path[i] ) {
+            best = std::min(best, metric.weight(e));
+          }
+        }
+        ASSERT_TRUE(best != kInfiniteWeight);
+        length += best;
+      }
+      ASSERT_EQ(length, query.distance());
+    }
+  }
+}
+
+/**
+ * Tests that the distances of the customized hierarchy match those of
+ * Dijkstra, using the computed order and a given order.
+ */
+TEST(ContractionHierarchyTest, ContractionHierarchyCustomize) {
+  std::mt19937 generator(7);
+  RoutingGraph graph;
+  buildGrid(20, generator, &graph);
+  std::uniform_int_distribution<weight_t> values(1, 100);
+  std::vector<weight_t> weights(graph.numEdges());
+  for( weight_t& weight : weights ) {
+    weight = values(generator);
+  }
+
+  Metric metric("random");
+  ASSERT_TRUE(metric.assign(graph, weights) == ErrorCode::E_NO_ERROR);
+
+  ContractionHierarchy hierarchy(ContractionHierarchyConfig{4});
+  ASSERT_TRUE(hierarchy.build(&graph) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(hierarchy.customize(metric) == ErrorCode::E_NO_ERROR);
+  checkQueries(graph, hierarchy, metric);
+
+  std::vector<nodeId_t> order(graph.numNodes());
+  for( nodeId_t i = 0; i < graph.numNodes(); ++i ) {
+    order[i] = graph.numNodes() - 1 - i;
+  }
+  ContractionHierarchy ordered;
+  ASSERT_TRUE(ordered.build(&graph, order) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(ordered.rank(0) == graph.numNodes() - 1);
+  ASSERT_TRUE(ordered.customize(metric) == ErrorCode::E_NO_ERROR);
+  checkQueries(graph, ordered, metric);
+
+  order[0] = order[1];
+  ASSERT_TRUE(ordered.build(&graph, order) == ErrorCode::E_ROUTING_INVALID_NODE);
+}
+
+/**
+ * Tests that updating the weights of a few edges incrementally yields the
+ * same arc weights as customizing from scratch, recomputing only a fraction
+ * of the arcs.
+ */
+TEST(ContractionHierarchyTest, ContractionHierarchyUpdate) {
+  std::mt19937 generator(11);
+  RoutingGraph graph;
+  buildGrid(30, generator, &graph);
+  std::uniform_int_distribution<weight_t> values(1, 100);
+  std::vector<weight_t> weights(graph.numEdges());
+  for( weight_t& weight : weights ) {
+    weight = values(generator);
+  }
+
+  MetricRegistry registry(&graph);
+  std::unique_ptr<Metric> metric(new Metric("traffic"));
+  ASSERT_TRUE(metric->assign(graph, weights) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(registry.publish(std::move(metric)) == ErrorCode::E_NO_ERROR);
+
+  ContractionHierarchy hierarchy(ContractionHierarchyConfig{4});
+  ASSERT_TRUE(hierarchy.build(&graph) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(hierarchy.customize(*registry.get("traffic")) == ErrorCode::E_NO_ERROR);
+
+  std::uniform_int_distribution<edgeId_t> edges(0, graph.numEdges()-1);
+  std::shared_ptr<const Metric> current;
+  for( uint32_t round = 0; round < 5; ++round ) {
+    std::vector<std::pair<edgeId_t, weight_t>> changes;
+    std::vector<edgeId_t> changed;
+    for( uint32_t i = 0; i < 10; ++i ) {
+      const edgeId_t edge = edges(generator);
+      changes.push_back(std::make_pair(edge, round % 2 == 0 ? values(generator) * 10 : values(generator)));
+      changed.push_back(edge);
+    }
+    ASSERT_TRUE(registry.update("traffic", changes, &current) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(hierarchy.update(*current, changed) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(hierarchy.metricVersion() == current->version());
+    ASSERT_TRUE(hierarchy.numUpdatedArcs() < hierarchy.numArcs());
+
+    ContractionHierarchy reference;
+    ASSERT_TRUE(reference.build(&graph) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(reference.customize(*current) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(reference.numArcs() == hierarchy.numArcs());
+    for( arcId_t arc = 0; arc < hierarchy.numArcs(); ++arc ) {
+      ASSERT_EQ(hierarchy.upWeight(arc), reference.upWeight(arc));
+      ASSERT_EQ(hierarchy.downWeight(arc), reference.downWeight(arc));
+    }
+  }
+  checkQueries(graph, hierarchy, *current);
+
+  std::vector<edgeId_t> invalid{graph.numEdges()};
+  ASSERT_TRUE(hierarchy.update(*current, invalid) == ErrorCode::E_ROUTING_INVALID_EDGE);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,126 @@
+
+
+
+#include <gtest/gtest.h>
+#include <data/cursor.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Counts the rows read from a column
+ */
+class CountingTable : public ITypedTable<uint32_t> {
+  public:
+    CountingTable( const std::vector<uint32_t>& values ) :
+      m_values(values) {
+    }
+
+    void append(const uint32_t& val) noexcept override {
+      m_values.push_back(val);
+    }
+
+    void appendBulk(const uint32_t* vals, const uint64_t count) noexcept override {
+      m_values.insert(m_values.end(), vals, vals + count);
+    }
+
+    void foreach( std::function<void(const uint32_t&)> f ) const noexcept override {
+      for( const uint32_t& value : m_values ) {
+        f(value);
+      }
+    }
+
+    uint64_t size() const noexcept override {
+      return m_values.size();
+    }
+
+    uint64_t getCapacity() const noexcept override {
+      return m_values.capacity();
+    }
+
+    uint32_t get(const uint64_t index) const noexcept override {
+      ++m_reads;
+      return m_values[index];
+    }
+
+    std::vector<uint32_t> m_values;
+    mutable uint64_t      m_reads = 0;
+};
+
+/**
+ * Tests scanning a column with a pushed down condition, in batches
+ */
+TEST(CursorTest, Scan) {
+  std::vector<uint32_t> values;
+  for( uint32_t i = 0; i < 10000; ++i ) {
+    values.push_back(i % 10);
+  }
+  CountingTable column(values);
+  ScanCursor<uint32_t> cursor(&column, Condition::E_EQUALS, 3);
+  oid_t batch[100];
+  ASSERT_TRUE(cursor.next(batch, 100) == 100);
+  ASSERT_TRUE(batch[0] == 3 && batch[99] == 993);
+  // Only the rows needed to fill the batch were read
+  ASSERT_TRUE(column.m_reads == 994);
+
+  std::vector<oid_t> rest;
+  ASSERT_TRUE(materialize(&cursor, &rest) == 900);
+  ASSERT_TRUE(rest.front() == 1003 && rest.back() == 9993);
+  ASSERT_TRUE(cursor.next(batch, 100) == 0);
+
+  ScanCursor<uint32_t> range(&column, Condition::E_GREATER_EQUALS, 8, 100, 200);
+  std::vector<oid_t> oids;
+  ASSERT_TRUE(materialize(&range, &oids) == 20);
+  ASSERT_TRUE(oids.front() == 108 && oids.back() == 199);
+}
+
+/**
+ * Tests that point lookups and limits stop the scan early
+ */
+TEST(CursorTest, EarlyTermination) {
+  std::vector<uint32_t> values(100000, 0);
+  values[42] = 7;
+  values[50000] = 7;
+  CountingTable column(values);
+
+  ScanCursor<uint32_t> lookup(&column, Condition::E_EQUALS, 7);
+  ASSERT_TRUE(firstOid(&lookup) == 42);
+  ASSERT_TRUE(column.m_reads == 43);
+
+  ScanCursor<uint32_t> missing(&column, Condition::E_EQUALS, 8);
+  ASSERT_TRUE(firstOid(&missing) == kInvalidOid);
+
+  column.m_reads = 0;
+  LimitCursor limit(std::unique_ptr<ICursor>(new ScanCursor<uint32_t>(&column, Condition::E_EQUALS, 0)), 10);
+  std::vector<oid_t> oids;
+  ASSERT_TRUE(materialize(&limit, &oids) == 10);
+  ASSERT_TRUE(oids.back() == 9);
+  ASSERT_TRUE(column.m_reads == 10);
+}
+
+/**
+ * Tests filtering the oids of an index lookup and materializing into a table
+ */
+TEST(CursorTest, FilterAndMaterialize) {
+  std::vector<uint32_t> values;
+  for( uint32_t i = 0; i < 100; ++i ) {
+    values.push_back(i);
+  }
+  CountingTable column(values);
+  std::vector<oid_t> indexed = {5, 17, 42, 64, 99, 150};
+  FilterCursor<uint32_t> filter(std::unique_ptr<ICursor>(new VectorCursor(&indexed)),
+                                &column,
+                                Condition::E_GREATER,
+                                20);
+  Table<oid_t> table;
+  ASSERT_TRUE(materialize(&filter, &table) == 3);
+  ASSERT_TRUE(table.size() == 3);
+  ASSERT_TRUE(table.get(0) == 42 && table.get(1) == 64 && table.get(2) == 99);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
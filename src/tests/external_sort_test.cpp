@@ -0,0 +1,169 @@
+
+
+
+#include <gtest/gtest.h>
+#include <storage/external_sort.h>
+#include <storage/paged_adjacency.h>
+#include <algorithm>
+#include <random>
+
+SMILE_NS_BEGIN
+
+struct SortEdge {
+  uint32_t  m_tail;
+  uint32_t  m_head;
+
+  bool operator<( const SortEdge& other ) const noexcept {
+    return m_tail < other.m_tail || (m_tail == other.m_tail && m_head < other.m_head);
+  }
+};
+
+/**
+ * Sorts values that fit in memory, without writing runs
+ **/
+TEST(ExternalSortTest, InMemory) {
+  ExternalSorter<uint64_t> sorter;
+  std::vector<uint64_t> expected;
+  std::mt19937_64 random(7);
+  for( uint32_t i = 0; i < 1000; ++i ) {
+    const uint64_t value = random();
+    expected.push_back(value);
+    ASSERT_TRUE(sorter.push(value) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(sorter.numRuns() == 0);
+  std::sort(expected.begin(), expected.end());
+  std::vector<uint64_t> sorted;
+  ASSERT_TRUE(sorter.merge([&]( const uint64_t& value ) { sorted.push_back(value); }) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(sorted == expected);
+  ASSERT_TRUE(sorter.size() == 0);
+}
+
+/**
+ * Sorts with a tiny memory budget, so that runs are generated in parallel and
+ * merged in several passes
+ **/
+TEST(ExternalSortTest, MultiPass) {
+  ExternalSortConfig config;
+  config.m_memoryBytes = 512*sizeof(uint32_t);
+  config.m_blockBytes = 64*sizeof(uint32_t);
+  config.m_fanIn = 3;
+  config.m_numThreads = 4;
+  config.m_tempDirectory = ".";
+  ExternalSorter<uint32_t, std::greater<uint32_t>> sorter(config);
+  std::vector<uint32_t> expected;
+  std::mt19937 random(11);
+  for( uint32_t i = 0; i < 20000; ++i ) {
+    const uint32_t value = random() % 5000;
+    expected.push_back(value);
+    ASSERT_TRUE(sorter.push(value) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(sorter.numRuns() > 3);
+  ASSERT_TRUE(sorter.size() == expected.size());
+  std::sort(expected.begin(), expected.end(), std::greater<uint32_t>());
+  std::vector<uint32_t> sorted;
+  ASSERT_TRUE(sorter.merge([&]( const uint32_t& value ) { sorted.push_back(value); }) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(sorted == expected);
+}
+
+/**
+ * Fails when runs cannot be created
+ **/
+TEST(ExternalSortTest, InvalidDirectory) {
+  ExternalSortConfig config;
+  config.m_memoryBytes = 16*sizeof(uint32_t);
+  config.m_tempDirectory = "./unexisting_directory";
+  ExternalSorter<uint32_t> sorter(config);
+  ErrorCode error = ErrorCode::E_NO_ERROR;
+  for( uint32_t i = 0; i < 32 && error == ErrorCode::E_NO_ERROR; ++i ) {
+    error = sorter.push(i);
+  }
+  ASSERT_TRUE(error == ErrorCode::E_STORAGE_INVALID_PATH);
+}
+
+/**
+ * Streams externally sorted edges into a paged adjacency and checks the
+ * neighbors of every node
+ **/
+TEST(ExternalSortTest, PagedAdjacency) {
+  const uint32_t numNodes = 3000;
+  ExternalSortConfig config;
+  config.m_memoryBytes = 4096*sizeof(SortEdge);
+  config.m_blockBytes = 256*sizeof(SortEdge);
+  config.m_fanIn = 4;
+  config.m_numThreads = 2;
+  config.m_tempDirectory = ".";
+  ExternalSorter<SortEdge> sorter(config);
+  std::vector<std::vector<uint32_t>> expected(numNodes);
+  std::mt19937 random(13);
+  for( uint32_t i = 0; i < 50000; ++i ) {
+    // Leave some nodes without edges
+    const uint32_t tail = (random() % (numNodes/3))*3;
+    const uint32_t head = random() % numNodes;
+    expected[tail].push_back(head);
+    ASSERT_TRUE(sorter.push(SortEdge{tail, head}) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(sorter.numRuns() > 4);
+
+  FileStorage storage;
+  ASSERT_TRUE(storage.create("./test_adjacency.db", FileStorageConfig{4}, true) == ErrorCode::E_NO_ERROR);
+  PagedAdjacencyConfig adjacencyConfig;
+  adjacencyConfig.m_extentPages = 8;
+  PagedAdjacencyBuilder builder(&storage, adjacencyConfig);
+  ASSERT_TRUE(builder.begin(numNodes) == ErrorCode::E_NO_ERROR);
+  ErrorCode error = ErrorCode::E_NO_ERROR;
+  ASSERT_TRUE(sorter.merge([&]( const SortEdge& edge ) {
+    if( error == ErrorCode::E_NO_ERROR ) {
+      error = builder.add(edge.m_tail, edge.m_head);
+    }
+  }) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(error == ErrorCode::E_NO_ERROR);
+  PagedAdjacency adjacency;
+  ASSERT_TRUE(builder.finish(&adjacency) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(adjacency.m_numNodes == numNodes);
+  ASSERT_TRUE(adjacency.m_numEdges == 50000);
+  ASSERT_TRUE(adjacency.m_headPages.size() == (50000*sizeof(uint32_t) + 4095) / 4096);
+
+  PagedAdjacencyReader reader(&storage, &adjacency);
+  std::vector<uint32_t> heads;
+  for( uint32_t node = 0; node < numNodes; ++node ) {
+    std::sort(expected[node].begin(), expected[node].end());
+    ASSERT_TRUE(reader.neighbors(node, &heads) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(heads == expected[node]);
+  }
+  ASSERT_TRUE(reader.neighbors(numNodes, &heads) == ErrorCode::E_STORAGE_INVALID_EDGE);
+
+  // The filters keep every node with edges, and reject most of the others
+  ASSERT_TRUE(adjacency.m_nodeFilters.size() == adjacency.m_offsetPages.size());
+  const uint64_t perPage = 4096 / sizeof(uint64_t);
+  uint32_t rejected = 0;
+  for( uint32_t node = 0; node < numNodes; ++node ) {
+    const bool mayHaveEdges = adjacency.m_nodeFilters[node / perPage].mayContain(node);
+    ASSERT_TRUE(mayHaveEdges || expected[node].empty());
+    rejected += mayHaveEdges ? 0 : 1;
+  }
+  ASSERT_TRUE(rejected > 0.9 * (numNodes - numNodes/3));
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Rejects edges that are not sorted by tail
+ **/
+TEST(ExternalSortTest, PagedAdjacencyUnsorted) {
+  FileStorage storage;
+  ASSERT_TRUE(storage.create("./test_adjacency.db", FileStorageConfig{4}, true) == ErrorCode::E_NO_ERROR);
+  PagedAdjacencyBuilder builder(&storage);
+  ASSERT_TRUE(builder.begin(4) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(builder.add(2, 1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(builder.add(2, 3) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(builder.add(1, 0) == ErrorCode::E_STORAGE_INVALID_EDGE);
+  ASSERT_TRUE(builder.add(3, 4) == ErrorCode::E_STORAGE_INVALID_EDGE);
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
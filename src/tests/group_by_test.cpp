@@ -0,0 +1,129 @@
+
+
+
+#include <gtest/gtest.h>
+#include <query/group_by.h>
+#include <cmath>
+#include <map>
+#include <random>
+
+SMILE_NS_BEGIN
+
+/**
+ * Reference aggregation with an ordered map
+ */
+template<typename K, typename V>
+static std::map<K, Group<K, V>> reference( const Table<K>& keys, const Table<V>& values ) {
+  std::map<K, Group<K, V>> groups;
+  for( uint64_t i = 0; i < keys.size(); ++i ) {
+    Group<K, V>& group = groups[keys.get(i)];
+    group.m_key = keys.get(i);
+    group.add(values.get(i));
+  }
+  return groups;
+}
+
+template<typename K, typename V>
+static void check( const std::vector<Group<K, V>>& groups, const std::map<K, Group<K, V>>& expected ) {
+  ASSERT_TRUE(groups.size() == expected.size());
+  auto it = expected.begin();
+  for( const Group<K, V>& group : groups ) {
+    ASSERT_TRUE(group.m_key == it->first);
+    ASSERT_TRUE(group.m_count == it->second.m_count);
+    ASSERT_TRUE(std::fabs(static_cast<double>(group.m_sum) - static_cast<double>(it->second.m_sum)) < 1e-6);
+    ASSERT_TRUE(group.m_min == it->second.m_min && group.m_max == it->second.m_max);
+    ++it;
+  }
+}
+
+/**
+ * Tests the dense path: type ids and a small range of negative keys
+ */
+TEST(GroupByTest, Dense) {
+  Table<uint8_t> types;
+  Table<int64_t> classes;
+  Table<double> lengths;
+  std::mt19937 random(7);
+  for( uint32_t i = 0; i < 100000; ++i ) {
+    types.append(static_cast<uint8_t>(random() % 12));
+    classes.append(static_cast<int64_t>(random() % 50) - 25);
+    lengths.append((random() % 10000) * 0.25);
+  }
+  GroupByConfig config;
+  config.m_numThreads = 4;
+  std::vector<Group<uint8_t, double>> byType;
+  groupBy(types, &lengths, config, &byType);
+  check(byType, reference(types, lengths));
+
+  std::vector<Group<int64_t, double>> byClass;
+  groupBy(classes, &lengths, config, &byClass);
+  check(byClass, reference(classes, lengths));
+  ASSERT_TRUE(byClass.front().m_key == -25 && byClass.back().m_key == 24);
+
+  std::vector<Group<uint8_t, uint8_t>> counts;
+  countBy(types, config, &counts);
+  ASSERT_TRUE(counts.size() == 12);
+  uint64_t total = 0;
+  for( uint32_t i = 0; i < counts.size(); ++i ) {
+    ASSERT_TRUE(counts[i].m_count == byType[i].m_count);
+    total += counts[i].m_count;
+  }
+  ASSERT_TRUE(total == 100000);
+}
+
+/**
+ * Tests the hash path with more groups than fit in the pre-aggregation
+ * tables, so they are spilled several times
+ */
+TEST(GroupByTest, Hash) {
+  Table<uint64_t> buckets;
+  Table<int32_t> speeds;
+  std::mt19937_64 random(9);
+  for( uint32_t i = 0; i < 300000; ++i ) {
+    buckets.append((random() % 40000) * 1000003ULL);
+    speeds.append(static_cast<int32_t>(random() % 200) - 50);
+  }
+  const std::map<uint64_t, Group<uint64_t, int32_t>> expected = reference(buckets, speeds);
+  for( const uint32_t numThreads : {1, 4} ) {
+    GroupByConfig config;
+    config.m_numThreads = numThreads;
+    config.m_cacheBytes = 16*1024;
+    std::vector<Group<uint64_t, int32_t>> groups;
+    groupBy(buckets, &speeds, config, &groups);
+    check(groups, expected);
+  }
+
+  // Without radix bits, all the groups are spilled to a single partition
+  for( const uint32_t numThreads : {1, 4} ) {
+    GroupByConfig config;
+    config.m_numThreads = numThreads;
+    config.m_cacheBytes = 16*1024;
+    config.m_radixBits = 0;
+    std::vector<Group<uint64_t, int32_t>> groups;
+    groupBy(buckets, &speeds, config, &groups);
+    check(groups, expected);
+  }
+
+  // Hashing can be forced for small ranges too
+  GroupByConfig config;
+  config.m_denseDomain = 0;
+  Table<int32_t> keys;
+  for( uint32_t i = 0; i < 1000; ++i ) {
+    keys.append(static_cast<int32_t>(i % 10));
+  }
+  std::vector<Group<int32_t, int32_t>> groups;
+  countBy(keys, config, &groups);
+  ASSERT_TRUE(groups.size() == 10 && groups[3].m_key == 3 && groups[3].m_count == 100);
+
+  Table<int32_t> empty;
+  countBy(empty, config, &groups);
+  ASSERT_TRUE(groups.empty());
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,195 @@
+
+
+
+#include <gtest/gtest.h>
+#include <memory/heap_file.h>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+static std::string toString( const std::vector<char>& data ) {
+  return std::string(data.begin(), data.end());
+}
+
+/**
+ * Tests that slotted pages reuse the space of deleted and shrunk records,
+ * compacting the page when it is fragmented
+ */
+TEST(HeapFileTest, SlottedPage) {
+  const uint32_t pageSize = 1024;
+  std::vector<char> data(pageSize);
+  SlottedPage page(data.data(), pageSize);
+  page.init();
+  ASSERT_TRUE(page.freeSpace() == pageSize - sizeof(SlottedPageHeader));
+
+  // Fill the page with records of 100 bytes
+  std::vector<uint32_t> slots;
+  std::string value(100, 'a');
+  uint32_t slot;
+  while( page.insert(value.data(), value.size(), 0, &slot) ) {
+    slots.push_back(slot);
+    ++value[0];
+  }
+  ASSERT_TRUE(slots.size() == 9);
+
+  // Deleting two records that are not adjacent leaves room for one of 200
+  page.erase(slots[2]);
+  page.erase(slots[5]);
+  std::string big(200, 'z');
+  ASSERT_TRUE(page.insert(big.data(), big.size(), 0, &slot));
+  ASSERT_TRUE(slot == slots[2]);
+
+  // Records keep their content and slot through the compaction
+  for( uint32_t i = 0; i < slots.size(); ++i ) {
+    const char* record;
+    uint32_t size;
+    uint32_t flags;
+    if( i == 5 ) {
+      ASSERT_FALSE(page.get(slots[i], &record, &size, &flags));
+      continue;
+    }
+    ASSERT_TRUE(page.get(slots[i], &record, &size, &flags));
+    ASSERT_TRUE(flags == 0);
+    if( i == 2 ) {
+      ASSERT_TRUE(std::string(record, size) == big);
+    } else {
+      ASSERT_TRUE(size == 100 && record[0] == static_cast<char>('a' + i));
+    }
+  }
+
+  // Shrinking a record frees space that another one can grow into
+  std::string small(10, 's');
+  ASSERT_TRUE(page.update(slots[0], small.data(), small.size(), 0));
+  std::string grown(180, 'g');
+  ASSERT_TRUE(page.update(slots[1], grown.data(), grown.size(), kSlotMoved));
+  const char* record;
+  uint32_t size;
+  uint32_t flags;
+  ASSERT_TRUE(page.get(slots[1], &record, &size, &flags));
+  ASSERT_TRUE(std::string(record, size) == grown && flags == kSlotMoved);
+  ASSERT_FALSE(page.update(slots[3], big.data(), big.size(), 0));
+  ASSERT_TRUE(page.get(slots[3], &record, &size, &flags));
+  ASSERT_TRUE(size == 100 && record[0] == static_cast<char>('a' + 3));
+
+  // Deleting the last records shrinks the slot directory
+  page.erase(slots[8]);
+  page.erase(slots[7]);
+  ASSERT_TRUE(page.numSlots() == 7);
+}
+
+/**
+ * Tests random inserts, updates and deletes of variable size records against
+ * an in memory copy, through reads, scans and the reopening of the file
+ */
+TEST(HeapFileTest, RandomOperations) {
+  FileStorage storage;
+  ASSERT_TRUE(storage.create("./test_heap.db", FileStorageConfig{4}, true) == ErrorCode::E_NO_ERROR);
+  BufferPool pool(&storage, BufferPoolConfig{64});
+  HeapFile heap(&storage, &pool);
+  ASSERT_TRUE(heap.maxRecordSize() == 4096 - sizeof(SlottedPageHeader) - sizeof(Slot) - kRecordIdSize);
+
+  std::mt19937 generator(3);
+  std::uniform_int_distribution<uint32_t> sizes(1, 600);
+  std::map<std::pair<pageId_t, uint32_t>, std::string> expected;
+  std::vector<RecordId> rids;
+  uint32_t counter = 0;
+  auto makeRecord = [&]( const uint32_t size ) {
+    std::string value(size, 0);
+    for( uint32_t i = 0; i < size; ++i ) {
+      value[i] = static_cast<char>('a' + (counter + i) % 26);
+    }
+    ++counter;
+    return value;
+  };
+
+  for( uint32_t op = 0; op < 20000; ++op ) {
+    const uint32_t kind = generator() % 4;
+    if( kind == 0 || rids.empty() ) {
+      const std::string value = makeRecord(sizes(generator));
+      RecordId rid;
+      ASSERT_TRUE(heap.insert(value.data(), value.size(), &rid) == ErrorCode::E_NO_ERROR);
+      ASSERT_TRUE(expected.find(std::make_pair(rid.m_page, rid.m_slot)) == expected.end());
+      expected[std::make_pair(rid.m_page, rid.m_slot)] = value;
+      rids.push_back(rid);
+    } else if( kind == 1 && rids.size() > 200 ) {
+      const uint32_t i = generator() % rids.size();
+      ASSERT_TRUE(heap.erase(rids[i]) == ErrorCode::E_NO_ERROR);
+      expected.erase(std::make_pair(rids[i].m_page, rids[i].m_slot));
+      rids[i] = rids.back();
+      rids.pop_back();
+    } else {
+      // Updates often grow records past the free space of their page
+      const uint32_t i = generator() % rids.size();
+      const std::string value = makeRecord(generator() % 2 == 0 ? sizes(generator) : sizes(generator) * 3);
+      ASSERT_TRUE(heap.update(rids[i], value.data(), value.size()) == ErrorCode::E_NO_ERROR);
+      expected[std::make_pair(rids[i].m_page, rids[i].m_slot)] = value;
+    }
+  }
+
+  std::vector<char> data;
+  for( const RecordId& rid : rids ) {
+    ASSERT_TRUE(heap.read(rid, &data) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(toString(data) == expected[std::make_pair(rid.m_page, rid.m_slot)]);
+  }
+
+  // Freed space is reused: the file is not much larger than its records
+  uint64_t bytes = 0;
+  for( const auto& entry : expected ) {
+    bytes += entry.second.size();
+  }
+  ASSERT_TRUE(heap.pages().size() * 4096 < bytes * 2);
+
+  // Scans report each record once, with its original id
+  ASSERT_TRUE(pool.checkpoint() == ErrorCode::E_NO_ERROR);
+  HeapFile reopened(&storage, &pool);
+  ASSERT_TRUE(reopened.open(heap.pages()) == ErrorCode::E_NO_ERROR);
+  std::map<std::pair<pageId_t, uint32_t>, std::string> scanned;
+  ASSERT_TRUE(reopened.scan([&]( const RecordId& rid, const char* record, const uint32_t size ) {
+    const auto key = std::make_pair(rid.m_page, rid.m_slot);
+    ASSERT_TRUE(scanned.find(key) == scanned.end());
+    scanned[key] = std::string(record, size);
+  }) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(scanned == expected);
+
+  // Records keep being updated after the file is reopened
+  const std::string value = makeRecord(heap.maxRecordSize());
+  ASSERT_TRUE(reopened.update(rids[0], value.data(), value.size()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(reopened.read(rids[0], &data) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(toString(data) == value);
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests the errors on records that are too large or do not exist
+ */
+TEST(HeapFileTest, Errors) {
+  FileStorage storage;
+  ASSERT_TRUE(storage.create("./test_heap.db", FileStorageConfig{4}, true) == ErrorCode::E_NO_ERROR);
+  BufferPool pool(&storage, BufferPoolConfig{64});
+  HeapFile heap(&storage, &pool);
+
+  std::string value(heap.maxRecordSize() + 1, 'x');
+  RecordId rid;
+  ASSERT_TRUE(heap.insert(value.data(), value.size(), &rid) == ErrorCode::E_HEAP_RECORD_TOO_LARGE);
+  ASSERT_TRUE(heap.insert(value.data(), 10, &rid) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(heap.update(rid, value.data(), value.size()) == ErrorCode::E_HEAP_RECORD_TOO_LARGE);
+
+  std::vector<char> data;
+  ASSERT_TRUE(heap.read(RecordId{rid.m_page, rid.m_slot + 1}, &data) == ErrorCode::E_HEAP_INVALID_RECORD);
+  ASSERT_TRUE(heap.read(RecordId{rid.m_page + 100, 0}, &data) == ErrorCode::E_HEAP_INVALID_RECORD);
+  ASSERT_TRUE(heap.erase(rid) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(heap.read(rid, &data) == ErrorCode::E_HEAP_INVALID_RECORD);
+  ASSERT_TRUE(heap.erase(rid) == ErrorCode::E_HEAP_INVALID_RECORD);
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
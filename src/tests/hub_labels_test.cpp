@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <routing/hub_labels.h>
+#include <routing/dijkstra.h>
+#include <random>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests that the distances of the hub labels match those of Dijkstra on a
+ * directed grid with random weights and some one way streets.
+ */
+TEST(HubLabelsTest, HubLabelsDistances) {
+  std::mt19937 generator(3);
+  std::bernoulli_distribution oneWay(0.2);
+  std::uniform_int_distribution<weight_t> values(1, 1000);
+  const nodeId_t size = 25;
+  std::vector<RoutingEdge> edges;
+  for( nodeId_t i = 0; i < size; ++i ) {
+    for( nodeId_t j = 0; j < size; ++j ) {
+      const nodeId_t node = i*size + j;
+      if( j + 1 < size ) {
+        edges.push_back(RoutingEdge{node, node + 1});
+        if( !oneWay(generator) ) edges.push_back(RoutingEdge{node + 1, node});
+      }
+      if( i + 1 < size ) {
+        edges.push_back(RoutingEdge{node + size, node});
+        if( !oneWay(generator) ) edges.push_back(RoutingEdge{node, node + size});
+      }
+    }
+  }
+  RoutingGraph graph;
+  ASSERT_TRUE(graph.build(size*size, edges) == ErrorCode::E_NO_ERROR);
+  std::vector<weight_t> weights(graph.numEdges());
+  for( weight_t& weight : weights ) {
+    weight = values(generator);
+  }
+  Metric metric("random");
+  ASSERT_TRUE(metric.assign(graph, weights) == ErrorCode::E_NO_ERROR);
+
+  ContractionHierarchy hierarchy;
+  ASSERT_TRUE(hierarchy.build(&graph) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(hierarchy.customize(metric) == ErrorCode::E_NO_ERROR);
+  HubLabels labels(HubLabelsConfig{4});
+  ASSERT_TRUE(labels.build(hierarchy) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(labels.numNodes() == graph.numNodes());
+  ASSERT_TRUE(labels.numEntries() > 0);
+
+  Dijkstra dijkstra(&graph);
+  for( nodeId_t source = 0; source < graph.numNodes(); source += 13 ) {
+    ASSERT_TRUE(dijkstra.run(source, metric) == ErrorCode::E_NO_ERROR);
+    for( nodeId_t target = 0; target < graph.numNodes(); ++target ) {
+      ASSERT_EQ(labels.distance(source, target), dijkstra.distance(target));
+    }
+  }
+}
+
+/**
+ * Tests that unreachable nodes get an infinite distance
+ */
+TEST(HubLabelsTest, HubLabelsUnreachable) {
+  std::vector<RoutingEdge> edges{{0,1},{1,2},{3,4}};
+  RoutingGraph graph;
+  ASSERT_TRUE(graph.build(5, edges) == ErrorCode::E_NO_ERROR);
+  Metric metric("unit");
+  ASSERT_TRUE(metric.assign(graph, std::vector<weight_t>(graph.numEdges(), 1)) == ErrorCode::E_NO_ERROR);
+  ContractionHierarchy hierarchy;
+  ASSERT_TRUE(hierarchy.build(&graph) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(hierarchy.customize(metric) == ErrorCode::E_NO_ERROR);
+  HubLabels labels;
+  ASSERT_TRUE(labels.build(hierarchy) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(labels.distance(0, 2) == 2);
+  ASSERT_TRUE(labels.distance(2, 0) == kInfiniteWeight);
+  ASSERT_TRUE(labels.distance(0, 4) == kInfiniteWeight);
+  ASSERT_TRUE(labels.distance(3, 3) == 0);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
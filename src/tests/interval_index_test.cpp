@@ -0,0 +1,159 @@
+
+
+
+#include <gtest/gtest.h>
+#include <data/interval_index.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Gets the sorted oids of the intervals overlapping [from, to), or
+ * containing from if stab is set, by brute force
+ */
+static std::vector<oid_t> bruteForce( const std::vector<TimeInterval<timestamp>>& intervals,
+                                      const timestamp from,
+                                      const timestamp to,
+                                      const bool stab ) {
+  std::vector<oid_t> oids;
+  for( const TimeInterval<timestamp>& interval : intervals ) {
+    const bool starts = stab ? interval.m_start <= from : interval.m_start < to;
+    if( starts && from < interval.m_end ) {
+      oids.push_back(interval.m_oid);
+    }
+  }
+  std::sort(oids.begin(), oids.end());
+  return oids;
+}
+
+static std::vector<oid_t> sorted( std::vector<oid_t> oids ) {
+  std::sort(oids.begin(), oids.end());
+  return oids;
+}
+
+/**
+ * Tests that timestamps are compared by value
+ */
+TEST(IntervalIndexTest, TimestampComparisons) {
+  ASSERT_TRUE(timestamp{2} >= timestamp{1});
+  ASSERT_TRUE(timestamp{2} >= timestamp{2});
+  ASSERT_FALSE(timestamp{1} >= timestamp{2});
+  ASSERT_TRUE(timestamp{1} <= timestamp{2});
+}
+
+/**
+ * Tests stabbing and overlap queries on bulk built indexes of several sizes,
+ * against brute force
+ */
+TEST(IntervalIndexTest, BulkQueries) {
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<uint64_t> starts(0, 100000);
+  std::uniform_int_distribution<uint64_t> lengths(0, 2000);
+  for( const uint32_t size : {0u, 1u, 3u, 7u, 8u, 100u, 1000u, 5000u} ) {
+    std::vector<TimeInterval<timestamp>> intervals;
+    for( uint32_t i = 0; i < size; ++i ) {
+      const uint64_t start = starts(generator);
+      // Some long intervals, which subtrees of short ones do not prune
+      const uint64_t length = i % 50 == 0 ? 30000 : 1 + lengths(generator);
+      intervals.push_back(TimeInterval<timestamp>{timestamp{start}, timestamp{start + length}, i});
+    }
+    IntervalIndex<timestamp> index;
+    index.build(intervals);
+    ASSERT_TRUE(index.size() == size);
+    for( uint32_t query = 0; query < 200; ++query ) {
+      const timestamp from{starts(generator)};
+      const timestamp to{from.val + lengths(generator)};
+      std::vector<oid_t> oids;
+      index.stab(from, &oids);
+      ASSERT_TRUE(sorted(oids) == bruteForce(intervals, from, to, true));
+      oids.clear();
+      index.overlap(from, to, &oids);
+      ASSERT_TRUE(sorted(oids) == bruteForce(intervals, from, to, false));
+    }
+  }
+}
+
+/**
+ * Tests the bounds of the intervals: starts are included and ends excluded
+ */
+TEST(IntervalIndexTest, Bounds) {
+  IntervalIndex<timestamp> index;
+  index.build({{timestamp{10}, timestamp{20}, 0}, {timestamp{20}, timestamp{30}, 1}, {timestamp{5}, timestamp{5}, 2}});
+  std::vector<oid_t> oids;
+  index.stab(timestamp{20}, &oids);
+  ASSERT_TRUE(oids == std::vector<oid_t>{1});
+  oids.clear();
+  index.stab(timestamp{10}, &oids);
+  ASSERT_TRUE(oids == std::vector<oid_t>{0});
+  oids.clear();
+  index.stab(timestamp{5}, &oids);
+  ASSERT_TRUE(oids.empty());
+  index.overlap(timestamp{0}, timestamp{10}, &oids);
+  ASSERT_TRUE(oids.empty());
+  index.overlap(timestamp{19}, timestamp{21}, &oids);
+  ASSERT_TRUE(sorted(oids) == (std::vector<oid_t>{0, 1}));
+}
+
+/**
+ * Tests incremental inserts, on top of a bulk built index, against brute
+ * force while runs are created and merged
+ */
+TEST(IntervalIndexTest, Inserts) {
+  std::mt19937 generator(2);
+  std::uniform_int_distribution<uint64_t> starts(0, 50000);
+  std::uniform_int_distribution<uint64_t> lengths(1, 1000);
+  std::vector<TimeInterval<timestamp>> intervals;
+  for( uint32_t i = 0; i < 700; ++i ) {
+    const uint64_t start = starts(generator);
+    intervals.push_back(TimeInterval<timestamp>{timestamp{start}, timestamp{start + lengths(generator)}, i});
+  }
+  IntervalIndex<timestamp> index;
+  index.build(intervals);
+  for( uint32_t i = 700; i < 5000; ++i ) {
+    const uint64_t start = starts(generator);
+    intervals.push_back(TimeInterval<timestamp>{timestamp{start}, timestamp{start + lengths(generator)}, i});
+    index.insert(intervals.back().m_start, intervals.back().m_end, i);
+    ASSERT_TRUE(index.size() == intervals.size());
+    if( i % 97 == 0 ) {
+      for( uint32_t query = 0; query < 20; ++query ) {
+        const timestamp from{starts(generator)};
+        const timestamp to{from.val + lengths(generator)};
+        std::vector<oid_t> oids;
+        index.stab(from, &oids);
+        ASSERT_TRUE(sorted(oids) == bruteForce(intervals, from, to, true));
+        oids.clear();
+        index.overlap(from, to, &oids);
+        ASSERT_TRUE(sorted(oids) == bruteForce(intervals, from, to, false));
+      }
+    }
+  }
+}
+
+/**
+ * Tests building an index from a pair of timestamp columns
+ */
+TEST(IntervalIndexTest, BuildFromColumns) {
+  Table<timestamp> opened;
+  Table<timestamp> closed;
+  for( uint64_t i = 0; i < 10000; ++i ) {
+    opened.append(timestamp{i * 10});
+    closed.append(timestamp{i * 10 + (i % 3 == 0 ? 100 : 5)});
+  }
+  IntervalIndex<timestamp> index;
+  index.build(opened, closed);
+  ASSERT_TRUE(index.size() == 10000);
+  std::vector<oid_t> oids;
+  index.stab(timestamp{50002}, &oids);
+  // Rows 4991 to 5000 cover 50002 if i % 3 == 0, and row 5000 always does
+  ASSERT_TRUE(sorted(oids) == (std::vector<oid_t>{4992, 4995, 4998, 5000}));
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
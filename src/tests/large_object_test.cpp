@@ -0,0 +1,157 @@
+
+
+
+#include <gtest/gtest.h>
+#include <storage/large_object.h>
+#include <storage/paged_adjacency.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+static std::vector<char> makeObject( const uint64_t size, const uint32_t seed ) {
+  std::vector<char> object(size);
+  std::mt19937 random(seed);
+  for( char& byte : object ) {
+    byte = static_cast<char>(random());
+  }
+  return object;
+}
+
+/**
+ * Tests that objects of a known size are stored in a single extent of
+ * consecutive pages
+ */
+TEST(LargeObjectTest, KnownSize) {
+  FileStorage storage;
+  ASSERT_TRUE(storage.create("./test_large_object.db", FileStorageConfig{4}, true) == ErrorCode::E_NO_ERROR);
+  LargeObjectConfig config;
+  LargeObjectWriter writer(&storage, config);
+  LargeObjectReader reader(&storage, config);
+
+  const std::vector<char> object = makeObject(100000, 1);
+  const uint64_t sizeBefore = storage.size();
+  ASSERT_TRUE(writer.begin(object.size()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(writer.append(object.data(), object.size()) == ErrorCode::E_NO_ERROR);
+  largeObjectId_t id;
+  ASSERT_TRUE(writer.finish(&id) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(storage.size() - sizeBefore == (object.size() + sizeof(LargeObjectHeader) + 4095) / 4096);
+
+  std::vector<char> data;
+  ASSERT_TRUE(reader.readAll(id, &data) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(data == object);
+
+  // Empty objects take a page
+  ASSERT_TRUE(writer.begin() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(writer.finish(&id) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(reader.readAll(id, &data) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(data.empty());
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests streaming objects of unknown size through chains of growing extents,
+ * with reads of random sizes smaller and larger than the read ahead
+ */
+TEST(LargeObjectTest, Chains) {
+  FileStorage storage;
+  ASSERT_TRUE(storage.create("./test_large_object.db", FileStorageConfig{4}, true) == ErrorCode::E_NO_ERROR);
+  LargeObjectConfig config;
+  config.m_firstExtentPages = 2;
+  config.m_maxExtentPages = 16;
+  config.m_readAheadPages = 5;
+  LargeObjectWriter writer(&storage, config);
+
+  std::mt19937 random(2);
+  const std::vector<uint64_t> sizes = {1, 4096 - sizeof(LargeObjectHeader), 2*4096 - sizeof(LargeObjectHeader),
+                                       2*4096 - sizeof(LargeObjectHeader) + 1, 300000, 1000000};
+  std::vector<std::vector<char>> objects;
+  std::vector<largeObjectId_t> ids;
+  for( uint32_t i = 0; i < sizes.size(); ++i ) {
+    objects.push_back(makeObject(sizes[i], i + 10));
+    ASSERT_TRUE(writer.begin() == ErrorCode::E_NO_ERROR);
+    uint64_t written = 0;
+    while( written < sizes[i] ) {
+      const uint64_t count = std::min<uint64_t>(random() % 20000, sizes[i] - written);
+      ASSERT_TRUE(writer.append(objects[i].data() + written, count) == ErrorCode::E_NO_ERROR);
+      written += count;
+    }
+    largeObjectId_t id;
+    ASSERT_TRUE(writer.finish(&id) == ErrorCode::E_NO_ERROR);
+    ids.push_back(id);
+  }
+
+  LargeObjectReader reader(&storage, config);
+  for( uint32_t i = 0; i < sizes.size(); ++i ) {
+    std::vector<char> data;
+    ASSERT_TRUE(reader.readAll(ids[i], &data) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(data == objects[i]);
+
+    uint64_t size;
+    ASSERT_TRUE(reader.open(ids[i], &size) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(size == sizes[i]);
+    data.assign(size + 100, 0);
+    uint64_t total = 0;
+    uint64_t numRead = 1;
+    while( numRead > 0 ) {
+      ASSERT_TRUE(reader.read(data.data() + total, 1 + random() % 100, &numRead) == ErrorCode::E_NO_ERROR);
+      total += numRead;
+      if( random() % 7 == 0 ) {
+        ASSERT_TRUE(reader.read(data.data() + total, 30000, &numRead) == ErrorCode::E_NO_ERROR);
+        total += numRead;
+      }
+    }
+    ASSERT_TRUE(total == size);
+    data.resize(size);
+    ASSERT_TRUE(data == objects[i]);
+  }
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests reading the edges of hub nodes spanning many pages of the heads
+ * array, across the extents of the array
+ */
+TEST(LargeObjectTest, HubAdjacency) {
+  FileStorage storage;
+  ASSERT_TRUE(storage.create("./test_large_object.db", FileStorageConfig{4}, true) == ErrorCode::E_NO_ERROR);
+  PagedAdjacencyConfig config;
+  config.m_extentPages = 8;
+  PagedAdjacencyBuilder builder(&storage, config);
+  const uint32_t numNodes = 1000;
+  ASSERT_TRUE(builder.begin(numNodes) == ErrorCode::E_NO_ERROR);
+  std::vector<std::vector<uint32_t>> expected(numNodes);
+  std::mt19937 random(3);
+  for( uint32_t tail = 0; tail < numNodes; ++tail ) {
+    const uint32_t degree = tail % 100 == 7 ? 20000 + tail : random() % 20;
+    for( uint32_t i = 0; i < degree; ++i ) {
+      const uint32_t head = random() % numNodes;
+      expected[tail].push_back(head);
+      ASSERT_TRUE(builder.add(tail, head) == ErrorCode::E_NO_ERROR);
+    }
+  }
+  PagedAdjacency adjacency;
+  ASSERT_TRUE(builder.finish(&adjacency) == ErrorCode::E_NO_ERROR);
+
+  PagedAdjacencyReader reader(&storage, &adjacency);
+  std::vector<uint32_t> heads;
+  for( uint32_t node = 0; node < numNodes; ++node ) {
+    ASSERT_TRUE(reader.neighbors(node, &heads) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(heads == expected[node]);
+  }
+  // In reverse order, so the lists rarely start in the cached page
+  for( uint32_t node = numNodes; node-- > 0; ) {
+    ASSERT_TRUE(reader.neighbors(node, &heads) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(heads == expected[node]);
+  }
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
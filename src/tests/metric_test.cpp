@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+#include <routing/metric.h>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+SMILE_NS_BEGIN
+
+/**
+ * Builds a path graph 0 -> 1 -> ... -> numNodes-1
+ */
+static void buildPath( const nodeId_t numNodes, RoutingGraph* graph ) {
+  std::vector<RoutingEdge> edges;
+  for( nodeId_t i = 0; i + 1 < numNodes; ++i ) {
+    edges.push_back(RoutingEdge{i, i+1});
+  }
+  ASSERT_TRUE(graph->build(numNodes, edges) == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests assigning, storing and loading metrics, and that metrics that do not
+ * match the graph are rejected.
+ */
+TEST(MetricTest, MetricLoadStore) {
+  RoutingGraph graph;
+  buildPath(100, &graph);
+  std::vector<weight_t> weights(graph.numEdges());
+  for( edgeId_t e = 0; e < graph.numEdges(); ++e ) {
+    weights[e] = e * 3;
+  }
+
+  Metric car("car");
+  ASSERT_TRUE(car.assign(graph, std::vector<weight_t>(10)) == ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH);
+  ASSERT_TRUE(car.assign(graph, weights) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(car.store("./test.metric") == ErrorCode::E_NO_ERROR);
+
+  Metric loaded("car");
+  ASSERT_TRUE(loaded.load(graph, "./test.metric") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loaded.size() == graph.numEdges());
+  for( edgeId_t e = 0; e < graph.numEdges(); ++e ) {
+    ASSERT_TRUE(loaded.weight(e) == e * 3);
+  }
+
+  RoutingGraph smaller;
+  buildPath(50, &smaller);
+  ASSERT_TRUE(loaded.load(smaller, "./test.metric") == ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH);
+  ASSERT_TRUE(loaded.load(graph, "./unexisting.metric") == ErrorCode::E_STORAGE_INVALID_PATH);
+}
+
+/**
+ * Tests assigning weights through a permutation, and that permutations with
+ * out of range or repeated input edges are rejected
+ */
+TEST(MetricTest, MetricPermutation) {
+  RoutingGraph graph;
+  buildPath(5, &graph);
+  const std::vector<weight_t> weights{10, 20, 30, 40};
+  std::vector<edgeId_t> permutation{3, 1, 0, 2};
+  Metric metric("car");
+  ASSERT_TRUE(metric.assign(graph, weights, permutation) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(metric.weight(0) == 40 && metric.weight(1) == 20 && metric.weight(2) == 10 && metric.weight(3) == 30);
+
+  permutation[2] = kInvalidEdge;
+  ASSERT_TRUE(metric.assign(graph, weights, permutation) == ErrorCode::E_ROUTING_INVALID_EDGE);
+  permutation[2] = 4;
+  ASSERT_TRUE(metric.assign(graph, weights, permutation) == ErrorCode::E_ROUTING_INVALID_EDGE);
+  permutation[2] = 1;
+  ASSERT_TRUE(metric.assign(graph, weights, permutation) == ErrorCode::E_ROUTING_INVALID_EDGE);
+  permutation.pop_back();
+  ASSERT_TRUE(metric.assign(graph, weights, permutation) == ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH);
+  ASSERT_TRUE(metric.weight(0) == 40 && metric.weight(2) == 10);
+}
+
+/**
+ * Tests that weights larger than kInfiniteWeight, which would overflow when
+ * added by the searches, are rejected on every path into a metric
+ */
+TEST(MetricTest, MetricInvalidWeights) {
+  RoutingGraph graph;
+  buildPath(10, &graph);
+  std::vector<weight_t> weights(graph.numEdges(), 1);
+  weights[3] = kInfiniteWeight;
+
+  Metric metric("car");
+  ASSERT_TRUE(metric.assign(graph, weights) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(metric.store("./test.metric") == ErrorCode::E_NO_ERROR);
+  weights[3] = kInfiniteWeight + 1;
+  ASSERT_TRUE(metric.assign(graph, weights) == ErrorCode::E_ROUTING_INVALID_WEIGHT);
+  std::vector<edgeId_t> permutation(graph.numEdges());
+  for( edgeId_t e = 0; e < graph.numEdges(); ++e ) {
+    permutation[e] = e;
+  }
+  ASSERT_TRUE(metric.assign(graph, weights, permutation) == ErrorCode::E_ROUTING_INVALID_WEIGHT);
+  ASSERT_TRUE(metric.weight(3) == kInfiniteWeight);
+
+  // The weights follow the 16 bytes header of the file
+  {
+    std::fstream file("./test.metric", std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+    const weight_t invalid = 0xFFFFFFFF;
+    file.seekp(16 + 5*sizeof(weight_t));
+    file.write(reinterpret_cast<const char*>(&invalid), sizeof(weight_t));
+  }
+  Metric loaded("car");
+  ASSERT_TRUE(loaded.load(graph, "./test.metric") == ErrorCode::E_ROUTING_INVALID_WEIGHT);
+  ASSERT_TRUE(loaded.size() == 0);
+
+  MetricRegistry registry(&graph);
+  std::unique_ptr<Metric> published(new Metric("car"));
+  ASSERT_TRUE(published->assign(graph, std::vector<weight_t>(graph.numEdges(), 1)) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(registry.publish(std::move(published)) == ErrorCode::E_NO_ERROR);
+  std::vector<std::pair<edgeId_t, weight_t>> changes{{0, 2}, {1, 0xFFFFFFFF}};
+  ASSERT_TRUE(registry.update("car", changes) == ErrorCode::E_ROUTING_INVALID_WEIGHT);
+  ASSERT_TRUE(registry.get("car")->version() == 1 && registry.get("car")->weight(0) == 1);
+  changes[1].second = kInfiniteWeight;
+  ASSERT_TRUE(registry.update("car", changes) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(registry.get("car")->weight(1) == kInfiniteWeight);
+}
+
+/**
+ * Tests publishing several metrics over the same graph, and that snapshots
+ * taken by queries are not affected by later updates.
+ */
+TEST(MetricTest, MetricRegistryVersions) {
+  RoutingGraph graph;
+  buildPath(100, &graph);
+  MetricRegistry registry(&graph);
+
+  std::unique_ptr<Metric> car(new Metric("car"));
+  std::unique_ptr<Metric> truck(new Metric("truck"));
+  ASSERT_TRUE(car->assign(graph, std::vector<weight_t>(graph.numEdges(), 1)) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(truck->assign(graph, std::vector<weight_t>(graph.numEdges(), 2)) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(registry.publish(std::move(car)) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(registry.publish(std::move(truck)) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(registry.get("car")->version() == 1);
+  ASSERT_TRUE(registry.get("truck")->version() == 2);
+  ASSERT_TRUE(registry.get("bike") == nullptr);
+
+  std::shared_ptr<const Metric> snapshot = registry.get("car");
+  std::shared_ptr<const Metric> updated;
+  std::vector<std::pair<edgeId_t, weight_t>> changes{{0, 10}, {5, 20}};
+  ASSERT_TRUE(registry.update("car", changes, &updated) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(updated->version() == 3);
+  ASSERT_TRUE(registry.get("car") == updated);
+  ASSERT_TRUE(snapshot->weight(0) == 1 && snapshot->weight(5) == 1);
+  ASSERT_TRUE(updated->weight(0) == 10 && updated->weight(5) == 20 && updated->weight(1) == 1);
+
+  changes.push_back(std::make_pair(graph.numEdges(), 1));
+  ASSERT_TRUE(registry.update("car", changes) == ErrorCode::E_ROUTING_INVALID_EDGE);
+  ASSERT_TRUE(registry.update("bike", changes) == ErrorCode::E_ROUTING_UNEXISTING_METRIC);
+  ASSERT_TRUE(registry.remove("truck") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(registry.remove("truck") == ErrorCode::E_ROUTING_UNEXISTING_METRIC);
+}
+
+/**
+ * Tests that readers always observe a complete version of a metric while it
+ * is being updated by another thread.
+ */
+TEST(MetricTest, MetricRegistryConcurrentSwap) {
+  RoutingGraph graph;
+  buildPath(1000, &graph);
+  MetricRegistry registry(&graph);
+  std::unique_ptr<Metric> metric(new Metric("live"));
+  ASSERT_TRUE(metric->assign(graph, std::vector<weight_t>(graph.numEdges(), 0)) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(registry.publish(std::move(metric)) == ErrorCode::E_NO_ERROR);
+
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> inconsistent(0);
+  std::thread reader([&]() {
+    while( !done ) {
+      std::shared_ptr<const Metric> snapshot = registry.get("live");
+      const weight_t first = snapshot->weight(0);
+      for( edgeId_t e = 0; e < snapshot->size(); ++e ) {
+        if( snapshot->weight(e) != first ) {
+          ++inconsistent;
+        }
+      }
+    }
+  });
+
+  for( weight_t value = 1; value <= 100; ++value ) {
+    std::vector<std::pair<edgeId_t, weight_t>> changes;
+    for( edgeId_t e = 0; e < graph.numEdges(); ++e ) {
+      changes.push_back(std::make_pair(e, value));
+    }
+    ASSERT_TRUE(registry.update("live", changes) == ErrorCode::E_NO_ERROR);
+  }
+  done = true;
+  reader.join();
+  ASSERT_TRUE(inconsistent == 0);
+  ASSERT_TRUE(registry.get("live")->weight(0) == 100);
+}
+
+/**
+ * Tests that concurrent updates of the same metric are all applied
+ */
+TEST(MetricTest, MetricRegistryConcurrentUpdates) {
+  RoutingGraph graph;
+  buildPath(1000, &graph);
+  MetricRegistry registry(&graph);
+  std::unique_ptr<Metric> metric(new Metric("live"));
+  ASSERT_TRUE(metric->assign(graph, std::vector<weight_t>(graph.numEdges(), 0)) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(registry.publish(std::move(metric)) == ErrorCode::E_NO_ERROR);
+
+  // Each thread sets its own edges, one update per edge
+  const uint32_t numThreads = 4;
+  std::atomic<uint64_t> errors(0);
+  std::vector<std::thread> writers;
+  for( uint32_t t = 0; t < numThreads; ++t ) {
+    writers.emplace_back([&, t]() {
+      for( edgeId_t e = t; e < graph.numEdges(); e += numThreads ) {
+        const std::vector<std::pair<edgeId_t, weight_t>> changes{{e, e + 1}};
+        if( registry.update("live", changes) != ErrorCode::E_NO_ERROR ) {
+          ++errors;
+        }
+      }
+    });
+  }
+  for( std::thread& writer : writers ) {
+    writer.join();
+  }
+  ASSERT_TRUE(errors == 0);
+  std::shared_ptr<const Metric> last = registry.get("live");
+  ASSERT_TRUE(last->version() == 1 + graph.numEdges());
+  for( edgeId_t e = 0; e < graph.numEdges(); ++e ) {
+    ASSERT_TRUE(last->weight(e) == e + 1);
+  }
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
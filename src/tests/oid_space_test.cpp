@@ -0,0 +1,99 @@
+
+
+
+#include <gtest/gtest.h>
+#include <data/oid_space.h>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests interleaved allocations of several types: each type gets a dense
+ * range, and type checks are range checks
+ */
+TEST(OidSpaceTest, Allocation) {
+  OidSpace space;
+  std::vector<oid_t> persons;
+  std::vector<oid_t> cities;
+  for( uint32_t i = 0; i < 1000; ++i ) {
+    oid_t oid;
+    ASSERT_TRUE(space.allocate(1, &oid) == ErrorCode::E_NO_ERROR);
+    persons.push_back(oid);
+    if( i % 10 == 0 ) {
+      ASSERT_TRUE(space.allocate(7, &oid) == ErrorCode::E_NO_ERROR);
+      cities.push_back(oid);
+    }
+  }
+  OidRange range;
+  ASSERT_TRUE(space.allocate(7, 50, &range) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(range.size() == 50 && range.m_first == cities.back() + 1);
+
+  const OidRange personRange = space.range(1);
+  ASSERT_TRUE(personRange.size() == 1000 && space.count(1) == 1000);
+  ASSERT_TRUE(space.range(7).size() == 150);
+  ASSERT_TRUE(space.range(3).size() == 0);
+  for( uint32_t i = 0; i < persons.size(); ++i ) {
+    ASSERT_TRUE(persons[i] == personRange.m_first + i);
+    ASSERT_TRUE(oidType(persons[i]) == 1 && oidLocal(persons[i]) == i);
+    ASSERT_TRUE(personRange.contains(persons[i]));
+    ASSERT_TRUE(space.exists(persons[i]));
+  }
+  for( const oid_t city : cities ) {
+    ASSERT_TRUE(!personRange.contains(city) && space.range(7).contains(city));
+  }
+  ASSERT_TRUE(!space.exists(makeOid(1, 1000)));
+  ASSERT_TRUE(!space.exists(makeOid(3, 0)));
+
+  RangeCursor cursor(space.range(7));
+  std::vector<oid_t> oids;
+  materialize(&cursor, &oids);
+  ASSERT_TRUE(oids.size() == 150 && oids.front() == makeOid(7, 0) && oids.back() == makeOid(7, 149));
+}
+
+/**
+ * Tests attributes partitioned by type and per type scans
+ */
+TEST(OidSpaceTest, PartitionedTable) {
+  OidSpace space;
+  PartitionedTable<int32_t> ages;
+  for( uint32_t i = 0; i < 5000; ++i ) {
+    const typeid_t type = i % 3 == 0 ? 2 : 5;
+    oid_t oid;
+    ASSERT_TRUE(space.allocate(type, &oid) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(ages.append(oid, static_cast<int32_t>(i % 100)) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(ages.append(makeOid(2, 0), 1) == ErrorCode::E_GRAPH_UNEXISTING_OBJECT);
+  ASSERT_TRUE(ages.partition(2)->size() == space.count(2));
+  ASSERT_TRUE(ages.partition(4) == nullptr);
+
+  int32_t age = 0;
+  ASSERT_TRUE(ages.get(makeOid(5, 0), &age) == ErrorCode::E_NO_ERROR && age == 1);
+  ASSERT_TRUE(ages.get(makeOid(2, 1), &age) == ErrorCode::E_NO_ERROR && age == 3);
+  ASSERT_TRUE(ages.get(makeOid(2, space.count(2)), &age) == ErrorCode::E_GRAPH_UNEXISTING_OBJECT);
+
+  // Only objects of type 2 are produced, in oid order
+  std::unique_ptr<ICursor> cursor = ages.scan(2, Condition::E_SMALLER, 10);
+  std::vector<oid_t> oids;
+  materialize(cursor.get(), &oids);
+  uint64_t expected = 0;
+  for( uint32_t i = 0; i < 5000; i += 3 ) {
+    expected += i % 100 < 10 ? 1 : 0;
+  }
+  ASSERT_TRUE(oids.size() == expected);
+  for( const oid_t oid : oids ) {
+    ASSERT_TRUE(space.range(2).contains(oid));
+    ASSERT_TRUE(ages.get(oid, &age) == ErrorCode::E_NO_ERROR && age < 10);
+  }
+  ASSERT_TRUE(std::is_sorted(oids.begin(), oids.end()));
+
+  cursor = ages.scan(4, Condition::E_SMALLER, 10);
+  ASSERT_TRUE(firstOid(cursor.get()) == kInvalidOid);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <routing/pareto_search.h>
+#include <algorithm>
+#include <random>
+#include <set>
+
+SMILE_NS_BEGIN
+
+using Costs = std::pair<weight_t, weight_t>;
+
+/**
+ * Enumerates all the simple paths between node and target, collecting their
+ * costs.
+ */
+static void enumeratePaths( const RoutingGraph& graph,
+                            const std::vector<weight_t> weights[2],
+                            nodeId_t node,
+                            nodeId_t target,
+                            Costs costs,
+                            std::vector<bool>& visited,
+                            std::vector<Costs>& paths ) {
+  if( node == target ) {
+    paths.push_back(costs);
+    return;
+  }
+  visited[node] = true;
+  for( edgeId_t e = graph.firstOut(node); e < graph.endOut(node); ++e ) {
+    if( !visited[graph.head(e)] ) {
+      enumeratePaths(graph, weights, graph.head(e), target,
+                     Costs(costs.first + weights[0][e], costs.second + weights[1][e]),
+                     visited, paths);
+    }
+  }
+  visited[node] = false;
+}
+
+/**
+ * Computes the Pareto front of a set of costs
+ */
+static std::set<Costs> paretoFront( const std::vector<Costs>& paths ) {
+  std::set<Costs> front;
+  for( const Costs& a : paths ) {
+    bool dominated = false;
+    for( const Costs& b : paths ) {
+      if( b != a && b.first <= a.first && b.second <= a.second ) {
+        dominated = true;
+        break;
+      }
+    }
+    if( !dominated ) {
+      front.insert(a);
+    }
+  }
+  return front;
+}
+
+/**
+ * Tests the search on a small graph with three trade-off paths between 0 and
+ * 3, one of them dominated, and checks the solutions and their paths.
+ */
+TEST(ParetoSearchTest, ParetoSearchSmallGraph) {
+  std::vector<RoutingEdge> edges{{0,1},{1,3},{0,2},{2,3},{0,3},{0,4},{4,3}};
+  std::vector<weight_t> time{1,1,2,2,10,3,3};
+  std::vector<weight_t> cost{10,10,5,5,1,7,7};
+  RoutingGraph graph;
+  std::vector<edgeId_t> permutation;
+  ASSERT_TRUE(graph.build(5, edges, &permutation) == ErrorCode::E_NO_ERROR);
+  Metric timeMetric("time");
+  Metric costMetric("cost");
+  ASSERT_TRUE(timeMetric.assign(graph, time, permutation) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(costMetric.assign(graph, cost, permutation) == ErrorCode::E_NO_ERROR);
+  const Metric* criteria[2] = {&timeMetric, &costMetric};
+
+  ParetoSearch search(&graph);
+  ASSERT_TRUE(search.run(0, 3, criteria) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(search.solutions().size() == 3);
+  ASSERT_TRUE(search.solutions()[0].m_costs[0] == 2 && search.solutions()[0].m_costs[1] == 20);
+  ASSERT_TRUE(search.solutions()[1].m_costs[0] == 4 && search.solutions()[1].m_costs[1] == 10);
+  ASSERT_TRUE(search.solutions()[2].m_costs[0] == 10 && search.solutions()[2].m_costs[1] == 1);
+
+  std::vector<nodeId_t> path;
+  search.path(1, &path);
+  ASSERT_TRUE((path == std::vector<nodeId_t>{0,2,3}));
+
+  ASSERT_TRUE(search.run(3, 0, criteria) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(search.solutions().empty());
+  ASSERT_TRUE(search.run(0, 5, criteria) == ErrorCode::E_ROUTING_INVALID_NODE);
+
+  // Metrics that do not match the graph are rejected before any weight is read
+  Metric empty("empty");
+  const Metric* mismatched[2] = {&timeMetric, &empty};
+  ASSERT_TRUE(search.run(0, 3, mismatched) == ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH);
+  Dijkstra dijkstra(&graph);
+  ASSERT_TRUE(dijkstra.run(0, empty, SearchDirection::E_FORWARD) == ErrorCode::E_ROUTING_METRIC_SIZE_MISSMATCH);
+  ASSERT_TRUE(dijkstra.run(0, timeMetric, SearchDirection::E_FORWARD) == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Compares the solutions of the search, with and without pruning bounds,
+ * against the Pareto front of all the simple paths of random graphs.
+ */
+TEST(ParetoSearchTest, ParetoSearchRandomGraphs) {
+  std::mt19937 generator(42);
+  const nodeId_t numNodes = 10;
+  for( uint32_t round = 0; round < 20; ++round ) {
+    std::vector<RoutingEdge> edges;
+    std::uniform_int_distribution<nodeId_t> nodes(0, numNodes-1);
+    for( uint32_t i = 0; i < 25; ++i ) {
+      const nodeId_t tail = nodes(generator);
+      const nodeId_t head = nodes(generator);
+      if( tail != head ) {
+        edges.push_back(RoutingEdge{tail, head});
+      }
+    }
+    RoutingGraph graph;
+    ASSERT_TRUE(graph.build(numNodes, edges) == ErrorCode::E_NO_ERROR);
+    std::vector<weight_t> weights[2];
+    std::uniform_int_distribution<weight_t> values(0, 20);
+    for( edgeId_t e = 0; e < graph.numEdges(); ++e ) {
+      weights[0].push_back(values(generator));
+      weights[1].push_back(values(generator));
+    }
+    Metric first("first");
+    Metric second("second");
+    ASSERT_TRUE(first.assign(graph, weights[0]) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(second.assign(graph, weights[1]) == ErrorCode::E_NO_ERROR);
+    const Metric* criteria[2] = {&first, &second};
+
+    ParetoSearch bounded(&graph);
+    ParetoSearch unbounded(&graph, ParetoSearchConfig{false});
+    for( nodeId_t target = 1; target < numNodes; ++target ) {
+      std::vector<Costs> paths;
+      std::vector<bool> visited(numNodes, false);
+      enumeratePaths(graph, weights, 0, target, Costs(0,0), visited, paths);
+      const std::set<Costs> expected = paretoFront(paths);
+
+      for( ParetoSearch* search : {&bounded, &unbounded} ) {
+        ASSERT_TRUE(search->run(0, target, criteria) == ErrorCode::E_NO_ERROR);
+        std::set<Costs> found;
+        for( const ParetoSolution& solution : search->solutions() ) {
+          found.insert(Costs(solution.m_costs[0], solution.m_costs[1]));
+        }
+        ASSERT_TRUE(found == expected);
+        ASSERT_TRUE(found.size() == search->solutions().size());
+      }
+    }
+  }
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
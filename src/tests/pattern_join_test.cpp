@@ -0,0 +1,271 @@
+#include <gtest/gtest.h>
+#include <routing/pattern_join.h>
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <set>
+
+SMILE_NS_BEGIN
+
+/**
+ * Builds a random directed graph, with parallel edges and self loops
+ */
+static void randomGraph( const nodeId_t numNodes,
+                         const uint32_t numEdges,
+                         const uint32_t seed,
+                         RoutingGraph* graph ) {
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<nodeId_t> nodes(0, numNodes - 1);
+  std::vector<RoutingEdge> edges;
+  for( uint32_t i = 0; i < numEdges; ++i ) {
+    edges.push_back(RoutingEdge{nodes(generator), nodes(generator)});
+  }
+  ASSERT_TRUE(graph->build(numNodes, edges) == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests the intersection kernels against std::set_intersection, on sets of
+ * similar and of skewed sizes
+ */
+TEST(PatternJoinTest, PatternJoinIntersect) {
+  std::mt19937 generator(1);
+  const uint32_t sizes[][2] = {{0, 10}, {7, 9}, {100, 120}, {1000, 1000}, {5, 2000}, {3000, 20}};
+  for( const auto& size : sizes ) {
+    for( const uint32_t range : {1000u, 10000u} ) {
+      std::uniform_int_distribution<nodeId_t> values(0, range);
+      std::set<nodeId_t> setA;
+      std::set<nodeId_t> setB;
+      while( setA.size() < std::min(size[0], range) ) setA.insert(values(generator));
+      while( setB.size() < std::min(size[1], range) ) setB.insert(values(generator));
+      std::vector<nodeId_t> a(setA.begin(), setA.end());
+      std::vector<nodeId_t> b(setB.begin(), setB.end());
+      std::vector<nodeId_t> expected;
+      std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+      std::vector<nodeId_t> result(std::max<size_t>(std::min(a.size(), b.size()), 1));
+      const uint32_t count = intersectSorted(a.data(), a.size(), b.data(), b.size(), result.data());
+      result.resize(count);
+      ASSERT_TRUE(result == expected);
+    }
+  }
+}
+
+/**
+ * Tests intersections where the whole smaller set matches, with an output
+ * buffer exactly as large as that set. Sentinels after it must be left
+ * untouched.
+ */
+TEST(PatternJoinTest, PatternJoinIntersectExactOutput) {
+  const nodeId_t sentinel = 0xdeadbeef;
+  std::vector<nodeId_t> a;
+  for( nodeId_t v = 1; v <= 8; ++v ) a.push_back(v);
+  std::vector<nodeId_t> b = {2, 3, 4, 5};
+  std::vector<nodeId_t> evens;
+  std::vector<nodeId_t> all;
+  for( nodeId_t v = 0; v < 64; ++v ) {
+    all.push_back(v);
+    if( v % 2 == 0 ) evens.push_back(v);
+  }
+  const std::vector<std::pair<std::vector<nodeId_t>, std::vector<nodeId_t>>> cases = {{a, b}, {b, a}, {all, evens}, {evens, all}};
+  for( const auto& c : cases ) {
+    const std::vector<nodeId_t>& small = c.first.size() < c.second.size() ? c.first : c.second;
+    std::vector<nodeId_t> result(small.size() + 4, sentinel);
+    const uint32_t count = intersectSorted(c.first.data(), c.first.size(), c.second.data(), c.second.size(), result.data());
+    ASSERT_TRUE(count == small.size());
+    ASSERT_TRUE(std::vector<nodeId_t>(result.begin(), result.begin() + count) == small);
+    for( uint32_t i = count; i < result.size(); ++i ) {
+      ASSERT_TRUE(result[i] == sentinel);
+    }
+  }
+}
+
+/**
+ * Tests that the sorted adjacency has the distinct neighbors of each node,
+ * without self loops
+ */
+TEST(PatternJoinTest, PatternJoinSortedAdjacency) {
+  RoutingGraph graph;
+  randomGraph(50, 400, 2, &graph);
+  SortedAdjacency adjacency;
+  adjacency.build(graph, 4);
+  ASSERT_TRUE(adjacency.numNodes() == 50);
+  for( nodeId_t node = 0; node < graph.numNodes(); ++node ) {
+    std::set<nodeId_t> out;
+    for( edgeId_t edge = graph.firstOut(node); edge < graph.endOut(node); ++edge ) {
+      if( graph.head(edge) != node ) out.insert(graph.head(edge));
+    }
+    std::set<nodeId_t> in;
+    for( edgeId_t edge = graph.firstIn(node); edge < graph.endIn(node); ++edge ) {
+      if( graph.tail(edge) != node ) in.insert(graph.tail(edge));
+    }
+    ASSERT_TRUE(std::vector<nodeId_t>(out.begin(), out.end()) ==
+                std::vector<nodeId_t>(adjacency.outBegin(node), adjacency.outEnd(node)));
+    ASSERT_TRUE(std::vector<nodeId_t>(in.begin(), in.end()) ==
+                std::vector<nodeId_t>(adjacency.inBegin(node), adjacency.inEnd(node)));
+    ASSERT_TRUE(out.size() <= adjacency.maxDegree() && in.size() <= adjacency.maxDegree());
+  }
+}
+
+/**
+ * Tests triangle counting on undirected graphs, with symmetric edges and
+ * order constraints, against brute force
+ */
+TEST(PatternJoinTest, PatternJoinTriangles) {
+  const nodeId_t numNodes = 120;
+  std::mt19937 generator(3);
+  std::bernoulli_distribution connected(0.1);
+  std::vector<RoutingEdge> edges;
+  std::vector<std::vector<bool>> matrix(numNodes, std::vector<bool>(numNodes, false));
+  for( nodeId_t u = 0; u < numNodes; ++u ) {
+    for( nodeId_t v = u + 1; v < numNodes; ++v ) {
+      if( connected(generator) ) {
+        edges.push_back(RoutingEdge{u, v});
+        edges.push_back(RoutingEdge{v, u});
+        matrix[u][v] = matrix[v][u] = true;
+      }
+    }
+  }
+  uint64_t expected = 0;
+  for( nodeId_t u = 0; u < numNodes; ++u ) {
+    for( nodeId_t v = u + 1; v < numNodes; ++v ) {
+      for( nodeId_t w = v + 1; w < numNodes; ++w ) {
+        expected += matrix[u][v] && matrix[v][w] && matrix[u][w] ? 1 : 0;
+      }
+    }
+  }
+  ASSERT_TRUE(expected > 0);
+
+  RoutingGraph graph;
+  ASSERT_TRUE(graph.build(numNodes, edges) == ErrorCode::E_NO_ERROR);
+  SortedAdjacency adjacency;
+  adjacency.build(graph);
+  Pattern triangle;
+  triangle.m_numVariables = 3;
+  triangle.m_edges = {{0, 1}, {0, 2}, {1, 2}};
+  triangle.m_smaller = {{0, 1}, {1, 2}};
+  for( const uint32_t numThreads : {1u, 4u} ) {
+    uint64_t count = 0;
+    ASSERT_TRUE(matchPattern(adjacency, triangle, PatternJoinConfig{numThreads}, nullptr, &count) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(count == expected);
+
+    // Enumerated matches are the same triangles
+    std::mutex mutex;
+    std::set<std::vector<nodeId_t>> matches;
+    ASSERT_TRUE(matchPattern(adjacency, triangle, PatternJoinConfig{numThreads},
+                             [&]( const uint32_t, const nodeId_t* binding ) {
+                               std::lock_guard<std::mutex> lock(mutex);
+                               ASSERT_TRUE(binding[0] < binding[1] && binding[1] < binding[2]);
+                               ASSERT_TRUE(matrix[binding[0]][binding[1]] && matrix[binding[1]][binding[2]] &&
+                                           matrix[binding[0]][binding[2]]);
+                               matches.insert(std::vector<nodeId_t>(binding, binding + 3));
+                             }, &count) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(count == expected);
+    ASSERT_TRUE(matches.size() == expected);
+  }
+
+  // Without order constraints, each triangle is found once per permutation
+  triangle.m_smaller.clear();
+  uint64_t count = 0;
+  ASSERT_TRUE(matchPattern(adjacency, triangle, PatternJoinConfig{2}, nullptr, &count) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(count == 6*expected);
+}
+
+/**
+ * Tests directed patterns (cycles, turns, a four node cycle with a chord and
+ * non injective paths) against brute force on random graphs
+ */
+TEST(PatternJoinTest, PatternJoinDirected) {
+  const nodeId_t numNodes = 40;
+  RoutingGraph graph;
+  randomGraph(numNodes, 300, 4, &graph);
+  SortedAdjacency adjacency;
+  adjacency.build(graph);
+  std::vector<std::vector<bool>> matrix(numNodes, std::vector<bool>(numNodes, false));
+  for( nodeId_t node = 0; node < numNodes; ++node ) {
+    for( edgeId_t edge = graph.firstOut(node); edge < graph.endOut(node); ++edge ) {
+      matrix[node][graph.head(edge)] = graph.head(edge) != node;
+    }
+  }
+
+  // Brute force over all the bindings of the variables
+  auto bruteForce = [&]( const Pattern& pattern ) {
+    uint64_t count = 0;
+    std::vector<nodeId_t> binding(pattern.m_numVariables, 0);
+    while( true ) {
+      bool match = true;
+      for( const PatternEdge& edge : pattern.m_edges ) {
+        match = match && matrix[binding[edge.m_from]][binding[edge.m_to]];
+      }
+      for( const PatternEdge& constraint : pattern.m_smaller ) {
+        match = match && binding[constraint.m_from] < binding[constraint.m_to];
+      }
+      for( uint32_t i = 0; pattern.m_injective && i < binding.size(); ++i ) {
+        for( uint32_t j = i + 1; j < binding.size(); ++j ) {
+          match = match && binding[i] != binding[j];
+        }
+      }
+      count += match ? 1 : 0;
+      uint32_t variable = 0;
+      while( variable < binding.size() && ++binding[variable] == numNodes ) {
+        binding[variable++] = 0;
+      }
+      if( variable == binding.size() ) {
+        return count;
+      }
+    }
+  };
+
+  std::vector<Pattern> patterns(5);
+  patterns[0].m_numVariables = 3;
+  patterns[0].m_edges = {{0, 1}, {1, 2}, {2, 0}};
+  patterns[0].m_smaller = {{0, 1}, {0, 2}};
+  patterns[1].m_numVariables = 3;
+  patterns[1].m_edges = {{0, 1}, {2, 0}, {1, 2}, {0, 2}};
+  patterns[2].m_numVariables = 4;
+  patterns[2].m_edges = {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {0, 2}};
+  patterns[3].m_numVariables = 3;
+  patterns[3].m_edges = {{1, 0}, {2, 1}};
+  patterns[3].m_smaller = {{2, 0}};
+  patterns[4].m_numVariables = 3;
+  patterns[4].m_edges = {{0, 1}, {1, 2}};
+  patterns[4].m_injective = false;
+  for( const Pattern& pattern : patterns ) {
+    const uint64_t expected = bruteForce(pattern);
+    uint64_t count = 0;
+    ASSERT_TRUE(matchPattern(adjacency, pattern, PatternJoinConfig{3}, nullptr, &count) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(count == expected);
+    uint64_t enumerated = 0;
+    ASSERT_TRUE(matchPattern(adjacency, pattern, PatternJoinConfig{1},
+                             [&]( const uint32_t, const nodeId_t* ) { ++enumerated; }, &count) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(count == expected && enumerated == expected);
+  }
+}
+
+/**
+ * Tests that invalid patterns are rejected
+ */
+TEST(PatternJoinTest, PatternJoinInvalid) {
+  RoutingGraph graph;
+  randomGraph(10, 20, 5, &graph);
+  SortedAdjacency adjacency;
+  adjacency.build(graph);
+  uint64_t count = 0;
+  Pattern pattern;
+  pattern.m_numVariables = 2;
+  pattern.m_edges = {{0, 2}};
+  ASSERT_TRUE(matchPattern(adjacency, pattern, PatternJoinConfig(), nullptr, &count) == ErrorCode::E_ROUTING_INVALID_PATTERN);
+  pattern.m_edges = {{1, 1}};
+  ASSERT_TRUE(matchPattern(adjacency, pattern, PatternJoinConfig(), nullptr, &count) == ErrorCode::E_ROUTING_INVALID_PATTERN);
+  pattern.m_numVariables = 3;
+  pattern.m_edges = {{0, 1}};
+  ASSERT_TRUE(matchPattern(adjacency, pattern, PatternJoinConfig(), nullptr, &count) == ErrorCode::E_ROUTING_INVALID_PATTERN);
+  pattern.m_edges = {{0, 1}, {2, 1}};
+  ASSERT_TRUE(matchPattern(adjacency, pattern, PatternJoinConfig(), nullptr, &count) == ErrorCode::E_NO_ERROR);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
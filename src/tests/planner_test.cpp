@@ -0,0 +1,171 @@
+
+
+
+#include <gtest/gtest.h>
+#include <data/planner.h>
+#include <cmath>
+#include <functional>
+#include <random>
+
+SMILE_NS_BEGIN
+
+/**
+ * Node attributes: a timestamp increasing with the oid, a category and a
+ * uniform value, with their statistics and access structures
+ */
+struct Nodes {
+  Table<int64_t>      m_time;
+  Table<int32_t>      m_category;
+  Table<int32_t>      m_value;
+  AttributeStatistics m_timeStatistics;
+  AttributeStatistics m_categoryStatistics;
+  AttributeStatistics m_valueStatistics;
+  ZoneMap<int64_t>    m_timeZones;
+  Index<int32_t, oid_t> m_categoryIndex;
+  Index<int32_t, oid_t> m_valueIndex;
+};
+
+static void buildNodes( const uint32_t numNodes, Nodes* nodes ) {
+  std::mt19937 random(11);
+  for( uint32_t i = 0; i < numNodes; ++i ) {
+    nodes->m_time.append(1000 + 2*i);
+    nodes->m_category.append(static_cast<int32_t>(random() % 20));
+    nodes->m_value.append(static_cast<int32_t>(random() % 1000));
+    nodes->m_categoryIndex.insert(nodes->m_category.get(i), i);
+    nodes->m_valueIndex.insert(nodes->m_value.get(i), i);
+  }
+  collectStatistics(nodes->m_time, &nodes->m_timeStatistics);
+  collectStatistics(nodes->m_category, &nodes->m_categoryStatistics);
+  collectStatistics(nodes->m_value, &nodes->m_valueStatistics);
+  nodes->m_timeZones.build(nodes->m_time);
+}
+
+/**
+ * Runs a plan and checks its result against a scan of all the rows
+ */
+static void check( const SelectionPlan& plan,
+                   const std::vector<const IPredicate*>& predicates,
+                   const std::function<bool(oid_t)>& expected ) {
+  std::unique_ptr<ICursor> cursor = openSelection(plan, predicates);
+  std::vector<oid_t> oids;
+  materialize(cursor.get(), &oids);
+  std::sort(oids.begin(), oids.end());
+  std::vector<oid_t> reference;
+  for( oid_t oid = 0; oid < predicates[0]->numRows(); ++oid ) {
+    if( expected(oid) ) {
+      reference.push_back(oid);
+    }
+  }
+  ASSERT_TRUE(oids == reference);
+}
+
+/**
+ * Tests the access path chosen for single predicates
+ */
+TEST(PlannerTest, SinglePredicate) {
+  Nodes nodes;
+  buildNodes(100000, &nodes);
+
+  // Range on a clustered attribute: most zones are pruned
+  ColumnPredicate<int64_t> recent(&nodes.m_time, Condition::E_GREATER_EQUALS, 190000,
+                                  &nodes.m_timeStatistics, &nodes.m_timeZones);
+  SelectionPlan plan = planSelection({&recent});
+  ASSERT_TRUE(plan.m_path == AccessPath::E_ZONE_MAP_SCAN);
+  ASSERT_TRUE(std::fabs(plan.m_rows - 5500.0) < 500.0);
+  check(plan, {&recent}, [&]( const oid_t oid ) { return nodes.m_time.get(oid) >= 190000; });
+
+  // Selective equality on an indexed attribute
+  ColumnPredicate<int32_t> point(&nodes.m_value, Condition::E_EQUALS, 500,
+                                 &nodes.m_valueStatistics, nullptr, &nodes.m_valueIndex, IndexKind::E_HASH);
+  plan = planSelection({&point});
+  ASSERT_TRUE(plan.m_path == AccessPath::E_HASH_INDEX);
+  check(plan, {&point}, [&]( const oid_t oid ) { return nodes.m_value.get(oid) == 500; });
+
+  // A hash index cannot evaluate ranges, and unselective predicates are scanned
+  ColumnPredicate<int32_t> range(&nodes.m_value, Condition::E_SMALLER, 500,
+                                 &nodes.m_valueStatistics, nullptr, &nodes.m_valueIndex, IndexKind::E_HASH);
+  ASSERT_TRUE(range.indexKind() == IndexKind::E_NONE);
+  plan = planSelection({&range});
+  ASSERT_TRUE(plan.m_path == AccessPath::E_FULL_SCAN);
+  check(plan, {&range}, [&]( const oid_t oid ) { return nodes.m_value.get(oid) < 500; });
+
+  // Selective range on an ordered index
+  ColumnPredicate<int32_t> low(&nodes.m_value, Condition::E_SMALLER_EQUALS, 4,
+                               &nodes.m_valueStatistics, nullptr, &nodes.m_valueIndex);
+  plan = planSelection({&low});
+  ASSERT_TRUE(plan.m_path == AccessPath::E_ORDERED_INDEX);
+  check(plan, {&low}, [&]( const oid_t oid ) { return nodes.m_value.get(oid) <= 4; });
+}
+
+/**
+ * Tests that zone maps built before their column grew are not costed as
+ * pruning the rows they do not cover
+ */
+TEST(PlannerTest, StaleZoneMap) {
+  Table<int64_t> time;
+  ZoneMap<int64_t> empty;
+  empty.build(time);
+  ZoneMap<int64_t> partial;
+  for( int64_t i = 0; i < 100000; ++i ) {
+    time.append(i);
+    if( i + 1 == 10000 ) {
+      partial.build(time);
+    }
+  }
+
+  ColumnPredicate<int64_t> emptyZones(&time, Condition::E_SMALLER, 100, nullptr, &empty);
+  ASSERT_TRUE(emptyZones.zoneFraction() == 1.0);
+  SelectionPlan plan = planSelection({&emptyZones});
+  ASSERT_TRUE(plan.m_path == AccessPath::E_FULL_SCAN);
+  check(plan, {&emptyZones}, [&]( const oid_t oid ) { return time.get(oid) < 100; });
+
+  ColumnPredicate<int64_t> partialZones(&time, Condition::E_SMALLER, 100, nullptr, &partial);
+  ASSERT_TRUE(partialZones.zoneFraction() > 0.9);
+  plan = planSelection({&partialZones});
+  check(plan, {&partialZones}, [&]( const oid_t oid ) { return time.get(oid) < 100; });
+}
+
+/**
+ * Tests conjunctions: filters ordered by selectivity and bitmap
+ * intersections of indexed predicates
+ */
+TEST(PlannerTest, Conjunction) {
+  Nodes nodes;
+  buildNodes(100000, &nodes);
+
+  ColumnPredicate<int32_t> category(&nodes.m_category, Condition::E_EQUALS, 3,
+                                    &nodes.m_categoryStatistics, nullptr, &nodes.m_categoryIndex);
+  ColumnPredicate<int32_t> value(&nodes.m_value, Condition::E_SMALLER, 50,
+                                 &nodes.m_valueStatistics, nullptr, &nodes.m_valueIndex);
+  ColumnPredicate<int64_t> time(&nodes.m_time, Condition::E_GREATER, 1000);
+  std::vector<const IPredicate*> predicates = {&time, &category, &value};
+  SelectionPlan plan = planSelection(predicates);
+  ASSERT_TRUE(plan.m_path == AccessPath::E_BITMAP_INTERSECTION);
+  ASSERT_TRUE(plan.m_drivers.size() == 2);
+  ASSERT_TRUE(plan.m_filters.size() == 1 && plan.m_filters[0] == 0);
+  check(plan, predicates, [&]( const oid_t oid ) {
+    return nodes.m_time.get(oid) > 1000 && nodes.m_category.get(oid) == 3 && nodes.m_value.get(oid) < 50;
+  });
+
+  // Without indexes, the most selective predicate drives a scan and the
+  // others are applied from the most to the least selective one
+  ColumnPredicate<int32_t> plainCategory(&nodes.m_category, Condition::E_DIFFERENT, 3, &nodes.m_categoryStatistics);
+  ColumnPredicate<int32_t> plainValue(&nodes.m_value, Condition::E_SMALLER, 50, &nodes.m_valueStatistics);
+  ColumnPredicate<int64_t> plainTime(&nodes.m_time, Condition::E_SMALLER, 100000, &nodes.m_timeStatistics);
+  predicates = {&plainCategory, &plainTime, &plainValue};
+  plan = planSelection(predicates);
+  ASSERT_TRUE(plan.m_path == AccessPath::E_FULL_SCAN);
+  ASSERT_TRUE(plan.m_drivers[0] == 2);
+  ASSERT_TRUE(plan.m_filters.size() == 2 && plan.m_filters[0] == 1 && plan.m_filters[1] == 0);
+  check(plan, predicates, [&]( const oid_t oid ) {
+    return nodes.m_category.get(oid) != 3 && nodes.m_time.get(oid) < 100000 && nodes.m_value.get(oid) < 50;
+  });
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <base/profiling.h>
+#include <memory/buffer_pool.h>
+#include <routing/dijkstra.h>
+#include <routing/contraction_hierarchy.h>
+#include <routing/pareto_search.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests the counters of a Dijkstra search on a small graph where the
+ * tentative distance of one node is decreased once. Queries without a
+ * QueryStats object must not be counted.
+ */
+TEST(ProfilingTest, ProfilingDijkstra) {
+  std::vector<RoutingEdge> edges{{0,1}, {0,2}, {2,1}, {1,3}};
+  std::vector<edgeId_t> permutation;
+  RoutingGraph graph;
+  ASSERT_TRUE(graph.build(4, edges, &permutation) == ErrorCode::E_NO_ERROR);
+  Metric metric("length");
+  ASSERT_TRUE(metric.assign(graph, std::vector<weight_t>{5, 1, 1, 1}, permutation) == ErrorCode::E_NO_ERROR);
+
+  QueryStats stats;
+  Dijkstra dijkstra(&graph);
+  dijkstra.setStats(&stats);
+  ASSERT_TRUE(dijkstra.run(0, metric) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dijkstra.distance(3) == 3);
+#if defined(SMILE_ENABLE_PROFILING)
+  ASSERT_TRUE(stats.m_nodesSettled == 4);
+  ASSERT_TRUE(stats.m_edgesRelaxed == 4);
+  ASSERT_TRUE(stats.m_heapPushes == 4);
+  ASSERT_TRUE(stats.m_heapPops == 4);
+  ASSERT_TRUE(stats.m_heapDecreases == 1);
+#else
+  ASSERT_TRUE(stats.m_nodesSettled == 0);
+#endif
+
+  dijkstra.setStats(nullptr);
+  ASSERT_TRUE(dijkstra.run(0, metric) == ErrorCode::E_NO_ERROR);
+#if defined(SMILE_ENABLE_PROFILING)
+  ASSERT_TRUE(stats.m_nodesSettled == 4);
+#endif
+
+  stats.reset();
+  ASSERT_TRUE(stats.m_nodesSettled == 0);
+  ASSERT_TRUE(stats.m_phaseTimes[static_cast<uint32_t>(QueryPhase::E_SEARCH)] == 0);
+}
+
+/**
+ * Tests that the bound searches of a Pareto search are timed under E_BOUNDS
+ * and not counted with the labels of the search. Only the bound searches
+ * decrease keys, and the backward search of the first criterion does.
+ */
+TEST(ProfilingTest, ProfilingParetoSearch) {
+  std::vector<RoutingEdge> edges{{0,1},{1,3},{0,2},{2,3},{0,3},{0,4},{4,3}};
+  std::vector<edgeId_t> permutation;
+  RoutingGraph graph;
+  ASSERT_TRUE(graph.build(5, edges, &permutation) == ErrorCode::E_NO_ERROR);
+  Metric time("time");
+  Metric cost("cost");
+  ASSERT_TRUE(time.assign(graph, std::vector<weight_t>{1,1,2,2,10,3,3}, permutation) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(cost.assign(graph, std::vector<weight_t>{10,10,5,5,1,7,7}, permutation) == ErrorCode::E_NO_ERROR);
+  const Metric* criteria[2] = {&time, &cost};
+
+  QueryStats stats;
+  ParetoSearch search(&graph);
+  search.setStats(&stats);
+  ASSERT_TRUE(search.run(0, 3, criteria) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(search.solutions().size() == 3);
+  ASSERT_TRUE(stats.m_heapDecreases == 0);
+#if defined(SMILE_ENABLE_PROFILING)
+  ASSERT_TRUE(stats.m_heapPops > 0);
+  ASSERT_TRUE(stats.m_phaseTimes[static_cast<uint32_t>(QueryPhase::E_BOUNDS)] > 0);
+#endif
+}
+
+/**
+ * Tests that a hierarchy query settles nodes of both directions and that
+ * unpacking the path is accounted in its own phase.
+ */
+TEST(ProfilingTest, ProfilingContractionHierarchy) {
+  const nodeId_t numNodes = 64;
+  std::vector<RoutingEdge> edges;
+  for( nodeId_t node = 0; node + 1 < numNodes; ++node ) {
+    edges.push_back(RoutingEdge{node, node + 1});
+    edges.push_back(RoutingEdge{node + 1, node});
+  }
+  RoutingGraph graph;
+  ASSERT_TRUE(graph.build(numNodes, edges) == ErrorCode::E_NO_ERROR);
+  Metric metric("length");
+  ASSERT_TRUE(metric.assign(graph, std::vector<weight_t>(graph.numEdges(), 1)) == ErrorCode::E_NO_ERROR);
+  ContractionHierarchy hierarchy;
+  ASSERT_TRUE(hierarchy.build(&graph) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(hierarchy.customize(metric) == ErrorCode::E_NO_ERROR);
+
+  QueryStats stats;
+  ContractionHierarchyQuery query(&hierarchy);
+  query.setStats(&stats);
+  ASSERT_TRUE(query.run(0, numNodes - 1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(query.distance() == numNodes - 1);
+  std::vector<nodeId_t> path;
+  query.path(metric, &path);
+  ASSERT_TRUE(path.size() == numNodes);
+#if defined(SMILE_ENABLE_PROFILING)
+  ASSERT_TRUE(stats.m_nodesSettled >= 2);
+  ASSERT_TRUE(stats.m_heapPops == stats.m_nodesSettled);
+  ASSERT_TRUE(stats.m_heapPushes >= stats.m_heapPops);
+  ASSERT_TRUE(stats.m_phaseTimes[static_cast<uint32_t>(QueryPhase::E_SEARCH)] > 0);
+  ASSERT_TRUE(stats.m_phaseTimes[static_cast<uint32_t>(QueryPhase::E_UNPACK)] > 0);
+#endif
+}
+
+/**
+ * Tests the page counters of the Buffer Pool. A 2-slot Buffer Pool is filled
+ * with more pages than slots, so pinning the first one again needs to read it
+ * from storage.
+ */
+TEST(ProfilingTest, ProfilingBufferPool) {
+  FileStorage fileStorage;
+  ASSERT_TRUE(fileStorage.create("./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  BufferPool bufferPool(&fileStorage, BufferPoolConfig{128});
+  BufferHandler bufferHandler;
+  QueryStats stats;
+  {
+    ScopedBufferPoolProfile profile(&bufferPool, &stats);
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    pageId_t pId = bufferHandler.m_pId;
+    ASSERT_TRUE(bufferPool.unpin(pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.pin(pId, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(pId) == ErrorCode::E_NO_ERROR);
+    for( uint32_t i = 0; i < 8; ++i ) {
+      ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+      ASSERT_TRUE(bufferPool.unpin(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    }
+    ASSERT_TRUE(bufferPool.pin(pId, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(pId) == ErrorCode::E_NO_ERROR);
+  }
+#if defined(SMILE_ENABLE_PROFILING)
+  ASSERT_TRUE(stats.m_pagesTouched == 11);
+  ASSERT_TRUE(stats.m_pageMisses == 1);
+#else
+  ASSERT_TRUE(stats.m_pagesTouched == 0);
+#endif
+}
+
+/**
+ * Tests that the sampler selects one out of every period queries.
+ */
+TEST(ProfilingTest, ProfilingSampler) {
+  QuerySampler sampler(3);
+  uint32_t sampled = 0;
+  for( uint32_t i = 0; i < 9; ++i ) {
+    sampled += sampler.sample() ? 1 : 0;
+  }
+#if defined(SMILE_ENABLE_PROFILING)
+  ASSERT_TRUE(sampled == 3);
+#else
+  ASSERT_TRUE(sampled == 0);
+#endif
+  QuerySampler never(0);
+  ASSERT_TRUE(!never.sample());
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
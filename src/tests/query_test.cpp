@@ -0,0 +1,230 @@
+
+
+
+#include <gtest/gtest.h>
+#include <query/scan.h>
+#include <query/operators.h>
+#include <query/hash_join.h>
+#include <query/hash_aggregate.h>
+#include <query/sort.h>
+#include <cmath>
+#include <map>
+#include <random>
+
+SMILE_NS_BEGIN
+
+/**
+ * Node attributes: age and score, indexed by oid
+ */
+struct Nodes {
+  Table<int32_t>  m_age;
+  Table<double>   m_score;
+};
+
+static void buildNodes( const uint32_t numNodes, Nodes* nodes ) {
+  for( uint32_t i = 0; i < numNodes; ++i ) {
+    nodes->m_age.append(static_cast<int32_t>(i % 90));
+    nodes->m_score.append(i * 0.5);
+  }
+}
+
+static std::unique_ptr<Operator> scanNodes( const Nodes& nodes ) {
+  ScanOperator* scan = new ScanOperator();
+  scan->addRowIdColumn();
+  scan->addColumn(&nodes.m_age);
+  scan->addColumn(&nodes.m_score);
+  return std::unique_ptr<Operator>(scan);
+}
+
+/**
+ * Collects the integer values of a column of all the batches
+ */
+static ErrorCode collect( Operator* root, const uint32_t column, std::vector<int64_t>* values ) {
+  return execute(root, [&]( const Batch& batch ) {
+    values->insert(values->end(), batch.ints(column), batch.ints(column) + batch.size());
+  });
+}
+
+/**
+ * Tests scans, filters, projections and limits
+ */
+TEST(QueryTest, ScanFilterProject) {
+  Nodes nodes;
+  buildNodes(20000, &nodes);
+
+  // SELECT oid, age*2, score+age FROM nodes WHERE age >= 80
+  std::unique_ptr<Operator> filter(new FilterOperator(scanNodes(nodes), 1, Condition::E_GREATER_EQUALS, Value::integer(80)));
+  ProjectOperator project(std::move(filter), {Projection::column(0),
+                                              Projection::arithmetic(ProjectionType::E_MULTIPLY, 1, Value::integer(2)),
+                                              Projection::arithmetic(ProjectionType::E_ADD, 2, 1)});
+  uint64_t numRows = 0;
+  ASSERT_TRUE(execute(&project, [&]( const Batch& batch ) {
+    ASSERT_TRUE(batch.size() > 0);
+    for( uint32_t i = 0; i < batch.size(); ++i ) {
+      const int64_t oid = batch.ints(0)[i];
+      ASSERT_TRUE(oid % 90 >= 80);
+      ASSERT_TRUE(batch.ints(1)[i] == 2*(oid % 90));
+      ASSERT_TRUE(batch.reals(2)[i] == oid*0.5 + oid % 90);
+    }
+    numRows += batch.size();
+  }) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(project.types()[1] == ValueType::E_INT);
+  ASSERT_TRUE(project.types()[2] == ValueType::E_REAL);
+  uint64_t expected = 0;
+  for( uint32_t i = 0; i < 20000; ++i ) {
+    expected += i % 90 >= 80 ? 1 : 0;
+  }
+  ASSERT_TRUE(numRows == expected);
+
+  // Filter on a real column, with an offset and a limit spanning batches
+  std::unique_ptr<Operator> scoreFilter(new FilterOperator(scanNodes(nodes), 2, Condition::E_SMALLER, Value::real(5000.0)));
+  LimitOperator limit(std::move(scoreFilter), 1500, 900);
+  std::vector<int64_t> oids;
+  ASSERT_TRUE(collect(&limit, 0, &oids) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(oids.size() == 1500);
+  ASSERT_TRUE(oids.front() == 900 && oids.back() == 2399);
+
+  FilterOperator invalid(scanNodes(nodes), 3, Condition::E_EQUALS, Value::integer(0));
+  ASSERT_TRUE(invalid.open() == ErrorCode::E_QUERY_INVALID_COLUMN);
+}
+
+/**
+ * Tests joining edges with the attributes of their heads, including keys
+ * with more matches than a batch
+ */
+TEST(QueryTest, HashJoin) {
+  const uint32_t numNodes = 5000;
+  Nodes nodes;
+  buildNodes(numNodes, &nodes);
+  Table<uint64_t> tails;
+  Table<uint64_t> heads;
+  std::mt19937 random(3);
+  for( uint32_t i = 0; i < 30000; ++i ) {
+    tails.append(random() % numNodes);
+    // Node 7 is the head of many edges
+    heads.append(i % 10 == 0 ? 7 : random() % (numNodes + 100));
+  }
+
+  // SELECT tail, head, age FROM edges JOIN nodes ON head = oid
+  ScanOperator* edges = new ScanOperator();
+  edges->addColumn(&tails);
+  edges->addColumn(&heads);
+  HashJoinOperator join(scanNodes(nodes), std::unique_ptr<Operator>(edges), 0, 1);
+  uint64_t numRows = 0;
+  ASSERT_TRUE(execute(&join, [&]( const Batch& batch ) {
+    ASSERT_TRUE(batch.numColumns() == 5);
+    for( uint32_t i = 0; i < batch.size(); ++i ) {
+      ASSERT_TRUE(batch.ints(1)[i] == batch.ints(2)[i]);
+      ASSERT_TRUE(batch.ints(3)[i] == batch.ints(1)[i] % 90);
+    }
+    numRows += batch.size();
+  }) == ErrorCode::E_NO_ERROR);
+  uint64_t expected = 0;
+  for( uint64_t i = 0; i < heads.size(); ++i ) {
+    expected += heads.get(i) < numNodes ? 1 : 0;
+  }
+  ASSERT_TRUE(numRows == expected);
+
+  // Many to many: 3000 build rows and 3000 probe rows with the same key
+  Table<int64_t> keys;
+  for( uint32_t i = 0; i < 3000; ++i ) {
+    keys.append(1);
+  }
+  ScanOperator* left = new ScanOperator();
+  left->addColumn(&keys);
+  ScanOperator* right = new ScanOperator();
+  right->addColumn(&keys);
+  HashJoinOperator cross(std::unique_ptr<Operator>(left), std::unique_ptr<Operator>(right), 0, 0);
+  numRows = 0;
+  ASSERT_TRUE(execute(&cross, [&]( const Batch& batch ) {
+    numRows += batch.size();
+  }) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(numRows == 3000ULL*3000ULL);
+
+  HashJoinOperator invalid(scanNodes(nodes), scanNodes(nodes), 2, 0);
+  ASSERT_TRUE(invalid.open() == ErrorCode::E_QUERY_INVALID_TYPE);
+}
+
+/**
+ * Tests grouped and global aggregations
+ */
+TEST(QueryTest, HashAggregate) {
+  Nodes nodes;
+  buildNodes(20000, &nodes);
+
+  // SELECT age, COUNT(*), SUM(oid), MIN(score), MAX(score), AVG(score) GROUP BY age
+  HashAggregateOperator aggregate(scanNodes(nodes), {1}, {Aggregate{AggregateFunction::E_COUNT, 0},
+                                                          Aggregate{AggregateFunction::E_SUM, 0},
+                                                          Aggregate{AggregateFunction::E_MIN, 2},
+                                                          Aggregate{AggregateFunction::E_MAX, 2},
+                                                          Aggregate{AggregateFunction::E_AVERAGE, 2}});
+  std::map<int64_t, int64_t> counts;
+  std::map<int64_t, int64_t> sums;
+  for( uint32_t i = 0; i < 20000; ++i ) {
+    ++counts[i % 90];
+    sums[i % 90] += i;
+  }
+  uint64_t numGroups = 0;
+  ASSERT_TRUE(execute(&aggregate, [&]( const Batch& batch ) {
+    for( uint32_t i = 0; i < batch.size(); ++i ) {
+      const int64_t age = batch.ints(0)[i];
+      ASSERT_TRUE(batch.ints(1)[i] == counts[age]);
+      ASSERT_TRUE(batch.ints(2)[i] == sums[age]);
+      ASSERT_TRUE(batch.reals(3)[i] == age*0.5);
+      ASSERT_TRUE(batch.reals(4)[i] == (age + 90*(counts[age] - 1))*0.5);
+      ASSERT_TRUE(std::fabs(batch.reals(5)[i] - sums[age]*0.5/counts[age]) < 1e-9);
+    }
+    numGroups += batch.size();
+  }) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(numGroups == 90);
+
+  // Many groups, on two keys
+  HashAggregateOperator pairs(scanNodes(nodes), {0, 1}, {Aggregate{AggregateFunction::E_COUNT, 0}});
+  std::vector<int64_t> pairCounts;
+  ASSERT_TRUE(collect(&pairs, 2, &pairCounts) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(pairCounts.size() == 20000);
+  ASSERT_TRUE(std::all_of(pairCounts.begin(), pairCounts.end(), []( const int64_t c ) { return c == 1; }));
+
+  // Global aggregation over an empty input
+  std::unique_ptr<Operator> none(new FilterOperator(scanNodes(nodes), 1, Condition::E_GREATER, Value::integer(100)));
+  HashAggregateOperator total(std::move(none), {}, {Aggregate{AggregateFunction::E_COUNT, 0}});
+  std::vector<int64_t> totals;
+  ASSERT_TRUE(collect(&total, 0, &totals) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(totals.size() == 1 && totals[0] == 0);
+}
+
+/**
+ * Tests full and top-k sorts
+ */
+TEST(QueryTest, Sort) {
+  Nodes nodes;
+  buildNodes(5000, &nodes);
+
+  // ORDER BY age DESC, oid ASC
+  SortOperator sort(scanNodes(nodes), {SortKey{1, false}, SortKey{0, true}});
+  std::vector<int64_t> oids;
+  ASSERT_TRUE(collect(&sort, 0, &oids) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(oids.size() == 5000);
+  for( size_t i = 1; i < oids.size(); ++i ) {
+    const int64_t a = oids[i-1] % 90;
+    const int64_t b = oids[i] % 90;
+    ASSERT_TRUE(a > b || (a == b && oids[i-1] < oids[i]));
+  }
+
+  // Top 10 scores
+  SortOperator top(scanNodes(nodes), {SortKey{2, false}}, 10);
+  oids.clear();
+  ASSERT_TRUE(collect(&top, 0, &oids) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(oids.size() == 10);
+  for( int64_t i = 0; i < 10; ++i ) {
+    ASSERT_TRUE(oids[i] == 4999 - i);
+  }
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
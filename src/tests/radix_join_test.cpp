@@ -0,0 +1,120 @@
+
+
+#include <gtest/gtest.h>
+#include <query/radix_join.h>
+#include <atomic>
+#include <random>
+#include <unordered_map>
+
+SMILE_NS_BEGIN
+
+/**
+ * Joins random edges with node attributes and compares the result with a
+ * join through a std::unordered_multimap
+ */
+static void checkJoin( const uint32_t numThreads, const uint32_t radixBits, const uint64_t cacheBytes ) {
+  const uint64_t numNodes = 20000;
+  Table<Edge> edges;
+  Table<KeyValue<uint32_t>> values;
+  std::mt19937_64 random(5);
+  for( uint64_t i = 0; i < 100000; ++i ) {
+    // Some edges point to nodes without attributes
+    edges.append(Edge{random() % (numNodes + 500), random() % numNodes});
+  }
+  std::unordered_multimap<oid_t, uint32_t> expected;
+  for( uint64_t node = 0; node < numNodes; ++node ) {
+    // Every tenth node has two values
+    const uint32_t numValues = node % 10 == 0 ? 2 : 1;
+    for( uint32_t v = 0; v < numValues; ++v ) {
+      const uint32_t value = static_cast<uint32_t>(node*3 + v);
+      values.append(KeyValue<uint32_t>{node, value});
+      expected.emplace(node, value);
+    }
+  }
+
+  RadixJoinConfig config;
+  config.m_numThreads = numThreads;
+  config.m_radixBits = radixBits;
+  config.m_cacheBytes = cacheBytes;
+  std::vector<uint64_t> checksums(numThreads, 0);
+  std::atomic<uint64_t> mismatches(0);
+  uint64_t numMatches = 0;
+  ASSERT_TRUE(radixJoin(edges, EdgeEndpoint::E_TAIL, values, config,
+                        [&]( const uint32_t thread, const uint64_t row, const uint32_t& value ) {
+    const oid_t tail = edges.get(row).m_tail;
+    if( value / 3 != tail ) {
+      ++mismatches;
+    }
+    checksums[thread] += row * 7 + value;
+  }, &numMatches) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(mismatches == 0);
+
+  uint64_t expectedMatches = 0;
+  uint64_t expectedChecksum = 0;
+  for( uint64_t row = 0; row < edges.size(); ++row ) {
+    const auto range = expected.equal_range(edges.get(row).m_tail);
+    for( auto it = range.first; it != range.second; ++it ) {
+      ++expectedMatches;
+      expectedChecksum += row * 7 + it->second;
+    }
+  }
+  uint64_t checksum = 0;
+  for( const uint64_t c : checksums ) {
+    checksum += c;
+  }
+  ASSERT_TRUE(numMatches == expectedMatches);
+  ASSERT_TRUE(checksum == expectedChecksum);
+}
+
+TEST(RadixJoinTest, SingleThread) {
+  checkJoin(1, 0, 256*1024);
+}
+
+TEST(RadixJoinTest, ManyPartitions) {
+  checkJoin(4, 0, 4*1024);
+}
+
+TEST(RadixJoinTest, FixedBits) {
+  checkJoin(3, 5, 256*1024);
+  checkJoin(2, 1, 256*1024);
+}
+
+/**
+ * Tests joining on heads and joining with an empty build side
+ */
+TEST(RadixJoinTest, HeadsAndEmpty) {
+  Table<Edge> edges;
+  for( oid_t i = 0; i < 1000; ++i ) {
+    edges.append(Edge{i, i % 10});
+  }
+  Table<KeyValue<double>> values;
+  values.append(KeyValue<double>{3, 0.5});
+  RadixJoinConfig config;
+  config.m_numThreads = 2;
+  std::vector<double> sums(config.m_numThreads, 0.0);
+  uint64_t numMatches = 0;
+  ASSERT_TRUE(radixJoin(edges, EdgeEndpoint::E_HEAD, values, config,
+                        [&]( const uint32_t thread, const uint64_t, const double& value ) {
+    sums[thread] += value;
+  }, &numMatches) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(numMatches == 100);
+  double sum = 0.0;
+  for( const double s : sums ) {
+    sum += s;
+  }
+  ASSERT_TRUE(sum == 50.0);
+
+  Table<KeyValue<double>> empty;
+  ASSERT_TRUE(radixJoin(edges, EdgeEndpoint::E_HEAD, empty, config,
+                        [&]( const uint32_t, const uint64_t, const double& ) {
+  }, &numMatches) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(numMatches == 0);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
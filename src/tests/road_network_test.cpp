@@ -0,0 +1,144 @@
+
+
+
+#include <gtest/gtest.h>
+#include <routing/road_network.h>
+#include <routing/dijkstra.h>
+#include <fstream>
+
+SMILE_NS_BEGIN
+
+/**
+ * Writes a text file
+ */
+static void writeFile( const std::string& path, const std::string& content ) {
+  std::ofstream file(path, std::ios_base::out | std::ios_base::trunc);
+  file << content;
+}
+
+/**
+ * Tests loading a small graph and its coordinates in the DIMACS formats, and
+ * searching on it
+ */
+TEST(RoadNetworkTest, DimacsLoad) {
+  writeFile("./test.gr",
+            "c a small graph\n"
+            "p sp 4 5\n"
+            "a 1 2 10\n"
+            "a 2 3 20\r\n"
+            "a 1 3 50\n"
+            "c a comment between arcs\n"
+            "a 3 4 5\n"
+            "a 4 1 7");
+  writeFile("./test.co",
+            "p aux sp co 4\n"
+            "v 1 -73530767 41085396\n"
+            "v 2 -73530538 41086098\n"
+            "v 3 -73519366 41048796\n"
+            "v 4 -73519377 41048654\n");
+
+  RoadNetwork network;
+  ASSERT_TRUE(loadDimacsGraph("./test.gr", &network) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(network.m_numNodes == 4);
+  ASSERT_TRUE(network.m_edges.size() == 5);
+  ASSERT_TRUE(network.m_edges[1].m_tail == 1 && network.m_edges[1].m_head == 2);
+  ASSERT_TRUE(network.m_weights[1] == 20);
+  ASSERT_TRUE(loadDimacsCoordinates("./test.co", &network) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(network.m_coordinates[0].m_x == -73530767);
+  ASSERT_TRUE(network.m_coordinates[3].m_y == 41048654);
+
+  RoutingGraph graph;
+  Metric metric("distance");
+  ASSERT_TRUE(network.build(&graph, &metric) == ErrorCode::E_NO_ERROR);
+  Dijkstra dijkstra(&graph);
+  ASSERT_TRUE(dijkstra.run(0, metric) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dijkstra.distance(2) == 30);
+  ASSERT_TRUE(dijkstra.distance(3) == 35);
+
+  // Round trip
+  ASSERT_TRUE(storeDimacs(network, "./test_copy.gr", "./test_copy.co") == ErrorCode::E_NO_ERROR);
+  RoadNetwork copy;
+  ASSERT_TRUE(loadDimacsGraph("./test_copy.gr", &copy) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(loadDimacsCoordinates("./test_copy.co", &copy) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(copy.m_weights == network.m_weights);
+  for( nodeId_t node = 0; node < 4; ++node ) {
+    ASSERT_TRUE(copy.m_coordinates[node].m_x == network.m_coordinates[node].m_x);
+    ASSERT_TRUE(copy.m_coordinates[node].m_y == network.m_coordinates[node].m_y);
+  }
+}
+
+/**
+ * Tests that malformed DIMACS files are rejected
+ */
+TEST(RoadNetworkTest, DimacsErrors) {
+  RoadNetwork network;
+  ASSERT_TRUE(loadDimacsGraph("./unexisting.gr", &network) == ErrorCode::E_STORAGE_INVALID_PATH);
+  writeFile("./test.gr", "a 1 2 10\n");
+  ASSERT_TRUE(loadDimacsGraph("./test.gr", &network) == ErrorCode::E_ROUTING_INVALID_DIMACS_FILE);
+  writeFile("./test.gr", "p sp 2 1\na 1 3 10\n");
+  ASSERT_TRUE(loadDimacsGraph("./test.gr", &network) == ErrorCode::E_ROUTING_INVALID_NODE);
+  writeFile("./test.gr", "p sp 2 1\na 1 2 x\n");
+  ASSERT_TRUE(loadDimacsGraph("./test.gr", &network) == ErrorCode::E_ROUTING_INVALID_DIMACS_FILE);
+  writeFile("./test.gr", "p sp 2 2\na 1 2 10\n");
+  ASSERT_TRUE(loadDimacsGraph("./test.gr", &network) == ErrorCode::E_ROUTING_INVALID_DIMACS_FILE);
+  writeFile("./test.gr", "p sp 2 1\na 1 2 10\n");
+  ASSERT_TRUE(loadDimacsGraph("./test.gr", &network) == ErrorCode::E_NO_ERROR);
+  writeFile("./test.co", "p aux sp co 3\n");
+  ASSERT_TRUE(loadDimacsCoordinates("./test.co", &network) == ErrorCode::E_ROUTING_INVALID_NODE);
+  writeFile("./test.co", "p aux sp co 2\nv 1 0 0\n");
+  ASSERT_TRUE(loadDimacsCoordinates("./test.co", &network) == ErrorCode::E_ROUTING_INVALID_DIMACS_FILE);
+}
+
+/**
+ * Tests that generated networks are reproducible and consistent
+ */
+TEST(RoadNetworkTest, Generators) {
+  RoadGeneratorConfig config;
+  config.m_seed = 42;
+  RoadNetwork grid;
+  ASSERT_TRUE(generateGrid(30, 20, config, &grid) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(grid.m_numNodes == 600);
+  ASSERT_TRUE(grid.m_coordinates.size() == 600);
+  ASSERT_TRUE(grid.m_edges.size() == grid.m_weights.size());
+  // Two way roads, about 10% of the 29*20 + 30*19 roads dropped
+  ASSERT_TRUE(grid.m_edges.size() % 2 == 0);
+  ASSERT_TRUE(grid.m_edges.size() > 2*1000 && grid.m_edges.size() < 2*1150);
+
+  RoadNetwork same;
+  ASSERT_TRUE(generateGrid(30, 20, config, &same) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(same.m_weights == grid.m_weights);
+
+  const size_t numRoads = grid.m_edges.size();
+  ASSERT_TRUE(addHighways(2, config, &grid) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(grid.m_edges.size() > numRoads);
+  for( size_t i = numRoads; i < grid.m_edges.size(); ++i ) {
+    ASSERT_TRUE(grid.m_edges[i].m_tail < grid.m_numNodes);
+    ASSERT_TRUE(grid.m_edges[i].m_head < grid.m_numNodes);
+  }
+
+  config.m_averageDegree = 6.0;
+  RoadNetwork geometric;
+  ASSERT_TRUE(generateGeometric(5000, config, &geometric) == ErrorCode::E_NO_ERROR);
+  const double degree = static_cast<double>(geometric.m_edges.size()) / geometric.m_numNodes;
+  ASSERT_TRUE(degree > 4.5 && degree < 7.0);
+  for( const RoutingEdge& edge : geometric.m_edges ) {
+    ASSERT_TRUE(edge.m_tail != edge.m_head);
+  }
+
+  RoutingGraph graph;
+  Metric metric("distance");
+  ASSERT_TRUE(geometric.build(&graph, &metric) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(graph.numEdges() == geometric.m_edges.size());
+
+  RoadNetwork empty;
+  empty.m_numNodes = 10;
+  ASSERT_TRUE(addHighways(1, config, &empty) == ErrorCode::E_ROUTING_MISSING_COORDINATES);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
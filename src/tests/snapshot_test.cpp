@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <storage/snapshot.h>
+#include <data/immutable_table.h>
+#include <routing/dijkstra.h>
+#include <fstream>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests storing a graph, a metric and a table into a snapshot and opening
+ * them in place. Searches on the opened graph must give the same distances
+ * as on the original one.
+ */
+TEST(SnapshotTest, SnapshotGraph) {
+  const nodeId_t size = 20;
+  std::vector<RoutingEdge> edges;
+  for( nodeId_t i = 0; i < size; ++i ) {
+    for( nodeId_t j = 0; j < size; ++j ) {
+      const nodeId_t node = i*size + j;
+      if( j + 1 < size ) {
+        edges.push_back(RoutingEdge{node, node + 1});
+        edges.push_back(RoutingEdge{node + 1, node});
+      }
+      if( i + 1 < size ) {
+        edges.push_back(RoutingEdge{node, node + size});
+      }
+    }
+  }
+  RoutingGraph graph;
+  ASSERT_TRUE(graph.build(size*size, edges) == ErrorCode::E_NO_ERROR);
+  std::vector<weight_t> weights(graph.numEdges());
+  for( edgeId_t e = 0; e < graph.numEdges(); ++e ) {
+    weights[e] = 1 + (e*7919) % 100;
+  }
+  Metric metric("time");
+  ASSERT_TRUE(metric.assign(graph, weights) == ErrorCode::E_NO_ERROR);
+  Table<uint64_t> table;
+  for( uint64_t i = 0; i < 20000; ++i ) {
+    table.append(i*3);
+  }
+
+  SnapshotWriter writer;
+  ASSERT_TRUE(writer.create("./test.snapshot") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(graph.store(&writer, "roads") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(metric.store(&writer) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(storeTable(&writer, "ids", table) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(writer.addSection<uint32_t>("ids", nullptr, 0) == ErrorCode::E_STORAGE_INVALID_SECTION);
+  ASSERT_TRUE(writer.close() == ErrorCode::E_NO_ERROR);
+
+  Snapshot snapshot;
+  ASSERT_TRUE(snapshot.open("./test.snapshot") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(snapshot.numSections() == 7);
+  ASSERT_TRUE(snapshot.contains("roads.heads"));
+
+  RoutingGraph opened;
+  ASSERT_TRUE(opened.open(snapshot, "roads") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(opened.numNodes() == graph.numNodes());
+  ASSERT_TRUE(opened.numEdges() == graph.numEdges());
+  const char* data = nullptr;
+  uint64_t bytes = 0;
+  uint32_t elementSize = 0;
+  ASSERT_TRUE(snapshot.section("roads.heads", &data, &bytes, &elementSize) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(reinterpret_cast<uintptr_t>(data) % kSnapshotAlignment == 0);
+  ASSERT_TRUE(bytes == graph.numEdges()*sizeof(nodeId_t) && elementSize == sizeof(nodeId_t));
+
+  Metric openedMetric("time");
+  ASSERT_TRUE(openedMetric.open(opened, snapshot) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(openedMetric.size() == metric.size());
+  Metric missing("distance");
+  ASSERT_TRUE(missing.open(opened, snapshot) == ErrorCode::E_STORAGE_UNEXISTING_SECTION);
+
+  Dijkstra expected(&graph);
+  Dijkstra actual(&opened);
+  for( nodeId_t source : {0u, 17u, 399u} ) {
+    ASSERT_TRUE(expected.run(source, metric) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(actual.run(source, openedMetric, SearchDirection::E_FORWARD) == ErrorCode::E_NO_ERROR);
+    for( nodeId_t node = 0; node < graph.numNodes(); ++node ) {
+      ASSERT_TRUE(expected.distance(node) == actual.distance(node));
+    }
+    ASSERT_TRUE(expected.run(source, metric, SearchDirection::E_BACKWARD) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(actual.run(source, openedMetric, SearchDirection::E_BACKWARD) == ErrorCode::E_NO_ERROR);
+    for( nodeId_t node = 0; node < graph.numNodes(); ++node ) {
+      ASSERT_TRUE(expected.distance(node) == actual.distance(node));
+    }
+  }
+
+  std::unique_ptr<ImmutableTable<uint64_t>> ids;
+  ASSERT_TRUE(openTable(snapshot, "ids", &ids) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(ids->size() == table.size());
+  for( uint64_t i = 0; i < table.size(); ++i ) {
+    ASSERT_TRUE(ids->get(i) == table.get(i));
+  }
+  std::unique_ptr<ImmutableTable<uint32_t>> wrongType;
+  ASSERT_TRUE(openTable(snapshot, "ids", &wrongType) == ErrorCode::E_STORAGE_INVALID_SECTION);
+  ASSERT_TRUE(openTable(snapshot, "names", &wrongType) == ErrorCode::E_STORAGE_UNEXISTING_SECTION);
+}
+
+/**
+ * Tests that files that are not snapshots are rejected
+ */
+TEST(SnapshotTest, SnapshotErrors) {
+  Snapshot snapshot;
+  ASSERT_TRUE(snapshot.open("./unexisting.snapshot") == ErrorCode::E_STORAGE_INVALID_PATH);
+  {
+    std::ofstream file("./test.snapshot");
+    file << "this is not a snapshot, but it is long enough to hold a header";
+  }
+  ASSERT_TRUE(snapshot.open("./test.snapshot") == ErrorCode::E_STORAGE_INVALID_SNAPSHOT);
+
+  SnapshotWriter writer;
+  ASSERT_TRUE(writer.beginSection("a", 4) == ErrorCode::E_STORAGE_NOT_OPEN);
+  ASSERT_TRUE(writer.create("./test.snapshot") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(writer.beginSection(std::string(kSnapshotMaxNameLength, 'a'), 4) == ErrorCode::E_STORAGE_INVALID_SECTION);
+  ASSERT_TRUE(writer.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(snapshot.open("./test.snapshot") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(snapshot.numSections() == 0);
+  RoutingGraph graph;
+  ASSERT_TRUE(graph.open(snapshot, "roads") == ErrorCode::E_STORAGE_UNEXISTING_SECTION);
+}
+
+/**
+ * Writes the sections of a graph of 3 nodes and 3 edges, and opens it
+ */
+static ErrorCode openGraph( const std::vector<edgeId_t>& offsets, const std::vector<nodeId_t>& heads,
+                            const std::vector<edgeId_t>& reverseOffsets, const std::vector<nodeId_t>& reverseTails,
+                            const std::vector<edgeId_t>& reverseEdges ) {
+  SnapshotWriter writer;
+  writer.create("./test.snapshot");
+  writer.addSection("roads.offsets", offsets.data(), offsets.size());
+  writer.addSection("roads.heads", heads.data(), heads.size());
+  writer.addSection("roads.reverse_offsets", reverseOffsets.data(), reverseOffsets.size());
+  writer.addSection("roads.reverse_tails", reverseTails.data(), reverseTails.size());
+  writer.addSection("roads.reverse_edges", reverseEdges.data(), reverseEdges.size());
+  writer.close();
+  Snapshot snapshot;
+  const ErrorCode error = snapshot.open("./test.snapshot");
+  if( error != ErrorCode::E_NO_ERROR ) {
+    return error;
+  }
+  RoutingGraph graph;
+  return graph.open(snapshot, "roads");
+}
+
+/**
+ * Tests that graphs with out of range ids or decreasing offsets are rejected
+ * when they are opened
+ */
+TEST(SnapshotTest, SnapshotCorruptedGraph) {
+  // The cycle 0 -> 1 -> 2 -> 0
+  ASSERT_TRUE(openGraph({0, 1, 2, 3}, {1, 2, 0}, {0, 1, 2, 3}, {2, 0, 1}, {2, 0, 1}) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(openGraph({0, 1, 2, 3}, {1, 3, 0}, {0, 1, 2, 3}, {2, 0, 1}, {2, 0, 1}) == ErrorCode::E_STORAGE_INVALID_SECTION);
+  ASSERT_TRUE(openGraph({0, 2, 1, 3}, {1, 2, 0}, {0, 1, 2, 3}, {2, 0, 1}, {2, 0, 1}) == ErrorCode::E_STORAGE_INVALID_SECTION);
+  ASSERT_TRUE(openGraph({0, 1, 2, 3}, {1, 2, 0}, {0, 1, 2, 3}, {2, 7, 1}, {2, 0, 1}) == ErrorCode::E_STORAGE_INVALID_SECTION);
+  ASSERT_TRUE(openGraph({0, 1, 2, 3}, {1, 2, 0}, {0, 3, 2, 3}, {2, 0, 1}, {2, 0, 1}) == ErrorCode::E_STORAGE_INVALID_SECTION);
+  ASSERT_TRUE(openGraph({0, 1, 2, 3}, {1, 2, 0}, {0, 1, 2, 3}, {2, 0, 1}, {2, 3, 1}) == ErrorCode::E_STORAGE_INVALID_SECTION);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
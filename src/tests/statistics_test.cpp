@@ -0,0 +1,112 @@
+
+
+
+#include <gtest/gtest.h>
+#include <data/statistics.h>
+#include <cmath>
+#include <random>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests the distinct count estimates of HyperLogLog sketches, also merged
+ */
+TEST(StatisticsTest, HyperLogLog) {
+  HyperLogLog small;
+  for( uint64_t i = 0; i < 100; ++i ) {
+    small.add(mixStatisticsHash(i % 50));
+  }
+  ASSERT_TRUE(std::fabs(small.estimate() - 50.0) < 2.0);
+
+  HyperLogLog first;
+  HyperLogLog second;
+  for( uint64_t i = 0; i < 1000000; ++i ) {
+    (i % 2 == 0 ? first : second).add(mixStatisticsHash(i % 200000));
+  }
+  first.merge(second);
+  ASSERT_TRUE(std::fabs(first.estimate() - 200000.0) < 200000.0 * 0.05);
+}
+
+/**
+ * Tests the estimates of every condition on a uniform attribute, which is
+ * larger than the sample
+ */
+TEST(StatisticsTest, Uniform) {
+  Table<int32_t> table;
+  std::mt19937 random(5);
+  for( uint32_t i = 0; i < 300000; ++i ) {
+    table.append(static_cast<int32_t>(random() % 1000));
+  }
+  AttributeStatistics statistics;
+  collectStatistics(table, &statistics);
+  ASSERT_TRUE(statistics.m_numRows == 300000);
+  ASSERT_TRUE(std::fabs(statistics.m_numDistinct - 1000.0) < 50.0);
+  ASSERT_TRUE(statistics.m_min == 0.0 && statistics.m_max == 999.0);
+
+  auto near = []( const double estimate, const double expected ) {
+    return std::fabs(estimate - expected) < 0.02;
+  };
+  ASSERT_TRUE(near(statistics.selectivity(Condition::E_EQUALS, 500), 0.001));
+  ASSERT_TRUE(near(statistics.selectivity(Condition::E_DIFFERENT, 500), 0.999));
+  ASSERT_TRUE(near(statistics.selectivity(Condition::E_SMALLER, 250), 0.25));
+  ASSERT_TRUE(near(statistics.selectivity(Condition::E_SMALLER_EQUALS, 250), 0.251));
+  ASSERT_TRUE(near(statistics.selectivity(Condition::E_GREATER, 900), 0.099));
+  ASSERT_TRUE(near(statistics.selectivity(Condition::E_GREATER_EQUALS, 900), 0.1));
+  ASSERT_TRUE(statistics.selectivity(Condition::E_EQUALS, 2000) == 0.0);
+  ASSERT_TRUE(statistics.selectivity(Condition::E_SMALLER, -1) == 0.0);
+  ASSERT_TRUE(statistics.selectivity(Condition::E_SMALLER_EQUALS, 999) == 1.0);
+  ASSERT_TRUE(statistics.selectivity(Condition::E_GREATER, 999) == 0.0);
+  ASSERT_TRUE(std::fabs(statistics.cardinality(Condition::E_SMALLER, 500) - 150000.0) < 6000.0);
+}
+
+/**
+ * Tests the most common values of a skewed attribute, whose statistics are
+ * exact because it fits in the sample
+ */
+TEST(StatisticsTest, Skewed) {
+  StatisticsBuilder<double> builder;
+  for( uint32_t i = 0; i < 10000; ++i ) {
+    // Half of the rows are 7.5, a tenth 1.0 and the rest are distinct
+    builder.add(i % 2 == 0 ? 7.5 : i % 10 == 1 ? 1.0 : 100.0 + i);
+  }
+  AttributeStatistics statistics;
+  builder.finish(&statistics);
+  ASSERT_TRUE(statistics.m_numDistinct == 2.0 + 4000.0);
+  ASSERT_TRUE(statistics.m_mostCommon.size() == 2);
+  ASSERT_TRUE(statistics.m_mostCommon[0].first == 7.5 && statistics.m_mostCommon[0].second == 0.5);
+  ASSERT_TRUE(statistics.m_mostCommon[1].first == 1.0 && statistics.m_mostCommon[1].second == 0.1);
+  ASSERT_TRUE(statistics.selectivity(Condition::E_EQUALS, 7.5) == 0.5);
+  ASSERT_TRUE(std::fabs(statistics.selectivity(Condition::E_EQUALS, 103.0) - 0.4/4000.0) < 1e-9);
+  ASSERT_TRUE(std::fabs(statistics.selectivity(Condition::E_SMALLER, 7.5) - 0.1) < 1e-9);
+  ASSERT_TRUE(std::fabs(statistics.selectivity(Condition::E_SMALLER_EQUALS, 7.5) - 0.6) < 1e-9);
+  ASSERT_TRUE(std::fabs(statistics.selectivity(Condition::E_GREATER, 7.5) - 0.4) < 1e-9);
+}
+
+/**
+ * Tests the statistics of unordered attributes and empty attributes
+ */
+TEST(StatisticsTest, Strings) {
+  Table<std::string> table;
+  for( uint32_t i = 0; i < 5000; ++i ) {
+    table.append("street" + std::to_string(i % 100));
+  }
+  AttributeStatistics statistics;
+  collectStatistics(table, &statistics);
+  ASSERT_TRUE(!statistics.m_ordered);
+  ASSERT_TRUE(statistics.m_numRows == 5000);
+  ASSERT_TRUE(std::fabs(statistics.m_numDistinct - 100.0) < 3.0);
+  ASSERT_TRUE(std::fabs(statistics.selectivity(Condition::E_EQUALS, 0.0) - 1.0/statistics.m_numDistinct) < 1e-9);
+
+  Table<int64_t> empty;
+  collectStatistics(empty, &statistics);
+  ASSERT_TRUE(statistics.m_numRows == 0);
+  ASSERT_TRUE(statistics.selectivity(Condition::E_DIFFERENT, 0.0) == 0.0);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,79 @@
+
+
+
+#include <gtest/gtest.h>
+#include <base/string_pool.h>
+#include <thread>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests interning and looking up strings
+ */
+TEST(StringPoolTest, Intern) {
+  StringPool pool;
+  const strid_t a = pool.intern("Person");
+  const strid_t b = pool.intern(std::string("knows"));
+  ASSERT_TRUE(a != b);
+  ASSERT_TRUE(pool.intern("Person") == a);
+  const char* buffer = "Person,knows";
+  ASSERT_TRUE(pool.intern(buffer, 6) == a);
+  ASSERT_TRUE(pool.intern(buffer + 7, 5) == b);
+  ASSERT_TRUE(pool.get(a) == "Person" && pool.get(b) == "knows");
+  ASSERT_TRUE(pool.find("knows") == b);
+  ASSERT_TRUE(pool.find("City") == kInvalidStringId);
+  ASSERT_TRUE(pool.size() == 2);
+  ASSERT_TRUE(pool.get(pool.intern("")).empty());
+
+  // Enough strings to span several segments of every shard
+  std::vector<strid_t> codes;
+  for( uint32_t i = 0; i < 100000; ++i ) {
+    codes.push_back(pool.intern("value" + std::to_string(i)));
+  }
+  for( uint32_t i = 0; i < 100000; ++i ) {
+    ASSERT_TRUE(pool.get(codes[i]) == "value" + std::to_string(i));
+  }
+  ASSERT_TRUE(pool.size() == 100003);
+}
+
+/**
+ * Tests interning the same strings from several threads, which must agree
+ * on the codes
+ */
+TEST(StringPoolTest, Concurrent) {
+  StringPool pool;
+  const uint32_t numThreads = 4;
+  const uint32_t numStrings = 20000;
+  std::vector<std::vector<strid_t>> codes(numThreads, std::vector<strid_t>(numStrings));
+  std::vector<std::thread> threads;
+  for( uint32_t t = 0; t < numThreads; ++t ) {
+    threads.emplace_back([&, t]() {
+      for( uint32_t i = 0; i < numStrings; ++i ) {
+        // Each thread interns the strings in a different order. The
+        // multipliers are coprime with the number of strings.
+        const uint32_t multipliers[numThreads] = {1, 3, 7, 9};
+        const uint32_t value = (i * multipliers[t]) % numStrings;
+        codes[t][value] = pool.intern("node" + std::to_string(value));
+      }
+    });
+  }
+  for( std::thread& thread : threads ) {
+    thread.join();
+  }
+  ASSERT_TRUE(pool.size() == numStrings);
+  for( uint32_t i = 0; i < numStrings; ++i ) {
+    for( uint32_t t = 1; t < numThreads; ++t ) {
+      ASSERT_TRUE(codes[t][i] == codes[0][i]);
+    }
+    ASSERT_TRUE(pool.get(codes[0][i]) == "node" + std::to_string(i));
+  }
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
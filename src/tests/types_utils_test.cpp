@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <base/types_utils.h>
+#include <clocale>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+SMILE_NS_BEGIN
+
+/**
+ * Parses a null terminated string with a range parser
+ */
+template<typename T>
+ErrorCode parse( const char* str, T* value ) {
+  return parser<T>::parse(str, str + strlen(str), value);
+}
+
+/**
+ * Tests the integer range parsers, including the limits of each type and
+ * numbers long enough to be parsed in blocks of 8 digits.
+ */
+TEST(TypesUtilsTest, TypesUtilsIntegers) {
+  uint64_t u64;
+  ASSERT_TRUE(parse("0", &u64) == ErrorCode::E_NO_ERROR && u64 == 0);
+  ASSERT_TRUE(parse("12345678", &u64) == ErrorCode::E_NO_ERROR && u64 == 12345678);
+  ASSERT_TRUE(parse("1234567890123", &u64) == ErrorCode::E_NO_ERROR && u64 == 1234567890123);
+  ASSERT_TRUE(parse("18446744073709551615", &u64) == ErrorCode::E_NO_ERROR && u64 == std::numeric_limits<uint64_t>::max());
+  ASSERT_TRUE(parse("18446744073709551616", &u64) == ErrorCode::E_PARSE_OUT_OF_RANGE);
+  ASSERT_TRUE(parse("123456789012345678901234", &u64) == ErrorCode::E_PARSE_OUT_OF_RANGE);
+  ASSERT_TRUE(parse("", &u64) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("-1", &u64) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("1234567a9", &u64) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("123456789a", &u64) == ErrorCode::E_PARSE_INVALID_VALUE);
+
+  uint32_t u32;
+  ASSERT_TRUE(parse("4294967295", &u32) == ErrorCode::E_NO_ERROR && u32 == std::numeric_limits<uint32_t>::max());
+  ASSERT_TRUE(parse("4294967296", &u32) == ErrorCode::E_PARSE_OUT_OF_RANGE);
+
+  int32_t i32;
+  ASSERT_TRUE(parse("-2147483648", &i32) == ErrorCode::E_NO_ERROR && i32 == std::numeric_limits<int32_t>::min());
+  ASSERT_TRUE(parse("+2147483647", &i32) == ErrorCode::E_NO_ERROR && i32 == std::numeric_limits<int32_t>::max());
+  ASSERT_TRUE(parse("2147483648", &i32) == ErrorCode::E_PARSE_OUT_OF_RANGE);
+  ASSERT_TRUE(parse("-", &i32) == ErrorCode::E_PARSE_INVALID_VALUE);
+
+  int64_t i64;
+  ASSERT_TRUE(parse("-9223372036854775808", &i64) == ErrorCode::E_NO_ERROR && i64 == std::numeric_limits<int64_t>::min());
+  ASSERT_TRUE(parse("-42", &i64) == ErrorCode::E_NO_ERROR && i64 == -42);
+
+  bool b;
+  ASSERT_TRUE(parse("true", &b) == ErrorCode::E_NO_ERROR && b);
+  ASSERT_TRUE(parse("0", &b) == ErrorCode::E_NO_ERROR && !b);
+  ASSERT_TRUE(parse("yes", &b) == ErrorCode::E_PARSE_INVALID_VALUE);
+
+  // Ranges do not need to be null terminated
+  const char* row = "123,456";
+  ASSERT_TRUE(parser<uint32_t>::parse(row, row + 3, &u32) == ErrorCode::E_NO_ERROR && u32 == 123);
+}
+
+/**
+ * Tests the floating point range parsers against strtod and strtof, both in
+ * the fast path and in the fallback.
+ */
+TEST(TypesUtilsTest, TypesUtilsReals) {
+  const char* values[] = {"0", "-0.0", "1.5", "3.14159", "-2e3", "1E-5", "0.1", "123456.789e-3",
+                          "+7.", "1e22", "1e23", "4.9e-324", "1.7976931348623157e308",
+                          "12345678901234567890123", "0.000000000000000000000000001",
+                          "0.30000000000000004", "-2.2250738585072014e-308"};
+  for( const char* str : values ) {
+    double d;
+    ASSERT_TRUE(parse(str, &d) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(d == strtod(str, nullptr));
+    const float expected = strtof(str, nullptr);
+    float f;
+    if( std::isinf(expected) ) {
+      ASSERT_TRUE(parse(str, &f) == ErrorCode::E_PARSE_OUT_OF_RANGE);
+    } else {
+      ASSERT_TRUE(parse(str, &f) == ErrorCode::E_NO_ERROR);
+      ASSERT_TRUE(f == expected);
+    }
+  }
+
+  double d;
+  ASSERT_TRUE(parse("", &d) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse(".", &d) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("1e", &d) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("1.2.3", &d) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("12a", &d) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("1e400", &d) == ErrorCode::E_PARSE_OUT_OF_RANGE);
+
+  // Only decimal numbers are accepted, also by the fallback
+  const char* invalid[] = {"inf", "-inf", "nan", "infinity", "0x1p3", "0x10", " 1.5", "\t2",
+                           " 0.30000000000000004", "0x1.8p1"};
+  for( const char* str : invalid ) {
+    ASSERT_TRUE(parse(str, &d) == ErrorCode::E_PARSE_INVALID_VALUE);
+    float f;
+    ASSERT_TRUE(parse(str, &f) == ErrorCode::E_PARSE_INVALID_VALUE);
+  }
+
+  // The decimal separator does not depend on the locale of the process
+  if( setlocale(LC_NUMERIC, "de_DE.UTF-8") != nullptr ) {
+    ASSERT_TRUE(parse("0.30000000000000004", &d) == ErrorCode::E_NO_ERROR && d == 0.30000000000000004);
+    ASSERT_TRUE(parse("0,5", &d) == ErrorCode::E_PARSE_INVALID_VALUE);
+    setlocale(LC_NUMERIC, "C");
+  }
+}
+
+/**
+ * Tests the ISO-8601 timestamp parser
+ */
+TEST(TypesUtilsTest, TypesUtilsTimestamps) {
+  timestamp t;
+  ASSERT_TRUE(parse("1970-01-01", &t) == ErrorCode::E_NO_ERROR && t.val == 0);
+  ASSERT_TRUE(parse("2000-03-01T00:00:00", &t) == ErrorCode::E_NO_ERROR && t.val == 951868800);
+  ASSERT_TRUE(parse("2010-12-03T13:45:07.123+0000", &t) == ErrorCode::E_NO_ERROR && t.val == 1291383907);
+  ASSERT_TRUE(parse("2010-12-03 13:45:07Z", &t) == ErrorCode::E_NO_ERROR && t.val == 1291383907);
+  ASSERT_TRUE(parse("2010-12-03T15:45:07+02:00", &t) == ErrorCode::E_NO_ERROR && t.val == 1291383907);
+  ASSERT_TRUE(parse("2010-12-03T10:45:07-0300", &t) == ErrorCode::E_NO_ERROR && t.val == 1291383907);
+  ASSERT_TRUE(parse("2016-02-29", &t) == ErrorCode::E_NO_ERROR && t.val == 1456704000);
+  ASSERT_TRUE(parse("1291383907", &t) == ErrorCode::E_NO_ERROR && t.val == 1291383907);
+
+  ASSERT_TRUE(parse("2015-02-29", &t) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("2010-13-03", &t) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("2010-12-03T24:00:00", &t) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("2010-12-03T13:45", &t) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("2010-12-03T13:45:07+", &t) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("2010-12-03T13:45:07.", &t) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("2010/12/03", &t) == ErrorCode::E_PARSE_INVALID_VALUE);
+  ASSERT_TRUE(parse("1969-12-31", &t) == ErrorCode::E_PARSE_OUT_OF_RANGE);
+
+  ASSERT_TRUE(parseTimestamp(std::string("2010-12-03T13:45:07.000+0000")) == timestamp{1291383907});
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}